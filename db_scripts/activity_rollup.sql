@@ -0,0 +1,24 @@
+/* 동아리별 연간 활동 집계 테이블 추가 (기존 club DB 에 적용) */
+
+USE club;
+
+-- Club_Activity_Rollup 테이블: 활동(start_date 연도 기준), 모임, 참석 인원 수를 동아리·연도별로 유지
+CREATE TABLE Club_Activity_Rollup (
+    club_id INT NOT NULL,
+    year YEAR NOT NULL,
+    activity_count INT NOT NULL DEFAULT 0,
+    gathering_count INT NOT NULL DEFAULT 0,
+    attendee_count INT NOT NULL DEFAULT 0,
+    PRIMARY KEY (club_id, year),
+    INDEX idx_rollup_year (year, activity_count),
+    FOREIGN KEY (club_id) REFERENCES Club(club_id) ON DELETE CASCADE ON UPDATE CASCADE
+);
+
+-- 기존 데이터로 초기화
+INSERT INTO Club_Activity_Rollup (club_id, year, activity_count, gathering_count, attendee_count)
+SELECT a.club_id, YEAR(a.start_date), COUNT(DISTINCT a.act_id), COUNT(DISTINCT g.gathering_id), COUNT(gs.student_id)
+FROM Activity AS a
+LEFT JOIN Gathering AS g ON g.act_id = a.act_id
+LEFT JOIN Gathering_Student AS gs ON gs.gathering_id = g.gathering_id
+WHERE a.club_id IS NOT NULL AND a.pending_delete = 0
+GROUP BY a.club_id, YEAR(a.start_date);
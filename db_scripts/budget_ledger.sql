@@ -0,0 +1,13 @@
+/* 동아리 예산 증감 원장 (기존 club DB 에 적용) */
+
+USE club;
+
+-- Budget_Ledger 테이블: 예산 증감분을 추가만 하고, 주기적으로 Club.budget 에 합산 후 삭제
+CREATE TABLE Budget_Ledger (
+    entry_id BIGINT PRIMARY KEY AUTO_INCREMENT,
+    club_id INT NOT NULL,
+    delta DECIMAL(10, 2) NOT NULL,
+    created_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    INDEX (club_id),
+    FOREIGN KEY (club_id) REFERENCES Club(club_id) ON DELETE CASCADE ON UPDATE CASCADE
+);
@@ -0,0 +1,53 @@
+/* 동아리 회원 수/활동 수 카운터 컬럼과 트리거 추가 (기존 club DB 에 적용) */
+
+USE club;
+
+ALTER TABLE Club
+    ADD COLUMN member_count INT NOT NULL DEFAULT 0,
+    ADD COLUMN activity_count INT NOT NULL DEFAULT 0,
+    ADD INDEX idx_club_member_count (member_count, club_id);
+
+-- 기존 데이터로 카운터 초기화
+UPDATE Club AS c SET
+    c.member_count = (SELECT COUNT(*) FROM Club_Student AS cs WHERE cs.club_id = c.club_id),
+    c.activity_count = (SELECT COUNT(*) FROM Activity AS a WHERE a.club_id = c.club_id AND a.pending_delete = 0);
+
+-- 외래 키 연쇄 삭제(ON DELETE CASCADE)로 지워지는 행에는 트리거가 실행되지 않으므로
+-- 학생 삭제 시의 Club_Student 감소분은 StudentTable 에서 같은 트랜잭션으로 반영함
+DELIMITER //
+
+CREATE TRIGGER club_student_after_insert AFTER INSERT ON Club_Student FOR EACH ROW
+BEGIN
+    UPDATE Club SET member_count = member_count + 1 WHERE club_id = NEW.club_id;
+END//
+
+CREATE TRIGGER club_student_after_delete AFTER DELETE ON Club_Student FOR EACH ROW
+BEGIN
+    UPDATE Club SET member_count = member_count - 1 WHERE club_id = OLD.club_id;
+END//
+
+CREATE TRIGGER activity_after_insert AFTER INSERT ON Activity FOR EACH ROW
+BEGIN
+    IF NEW.pending_delete = 0 THEN
+        UPDATE Club SET activity_count = activity_count + 1 WHERE club_id = NEW.club_id;
+    END IF;
+END//
+
+CREATE TRIGGER activity_after_update AFTER UPDATE ON Activity FOR EACH ROW
+BEGIN
+    IF OLD.pending_delete = 0 AND NOT (NEW.pending_delete = 0 AND NEW.club_id <=> OLD.club_id) THEN
+        UPDATE Club SET activity_count = activity_count - 1 WHERE club_id = OLD.club_id;
+    END IF;
+    IF NEW.pending_delete = 0 AND NOT (OLD.pending_delete = 0 AND NEW.club_id <=> OLD.club_id) THEN
+        UPDATE Club SET activity_count = activity_count + 1 WHERE club_id = NEW.club_id;
+    END IF;
+END//
+
+CREATE TRIGGER activity_after_delete AFTER DELETE ON Activity FOR EACH ROW
+BEGIN
+    IF OLD.pending_delete = 0 THEN
+        UPDATE Club SET activity_count = activity_count - 1 WHERE club_id = OLD.club_id;
+    END IF;
+END//
+
+DELIMITER ;
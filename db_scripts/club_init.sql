@@ -22,6 +22,10 @@ CREATE TABLE Club (
     club_name VARCHAR(100) UNIQUE NOT NULL,
     budget DECIMAL(10, 2) NOT NULL,
     prof_id INT UNIQUE,
+    pending_delete TINYINT(1) NOT NULL DEFAULT 0,
+    member_count INT NOT NULL DEFAULT 0,
+    activity_count INT NOT NULL DEFAULT 0,
+    INDEX idx_club_member_count (member_count, club_id),
     FOREIGN KEY (prof_id) REFERENCES Professor(prof_id) ON DELETE SET NULL
 );
 
@@ -53,6 +57,8 @@ CREATE TABLE Activity (
     act_title VARCHAR(255) NOT NULL,
     start_date DATE NOT NULL,
     end_date DATE,
+    pending_delete TINYINT(1) NOT NULL DEFAULT 0,
+    INDEX idx_activity_club_start (club_id, start_date),
     FOREIGN KEY (club_id) REFERENCES Club(club_id) ON DELETE CASCADE ON UPDATE CASCADE
 );
 
@@ -69,6 +75,7 @@ CREATE TABLE Result (
     result_id INT PRIMARY KEY AUTO_INCREMENT,
     club_id INT,
     year YEAR NOT NULL,
+    UNIQUE KEY uq_result_club_year (club_id, year),
     FOREIGN KEY (club_id) REFERENCES Club(club_id) ON DELETE CASCADE ON UPDATE CASCADE
 );
 
@@ -99,6 +106,28 @@ CREATE TABLE Result_Activity (
     FOREIGN KEY (act_id) REFERENCES Activity(act_id) ON DELETE CASCADE ON UPDATE CASCADE
 );
 
+-- Budget_Ledger 테이블 (예산 증감 원장)
+CREATE TABLE Budget_Ledger (
+    entry_id BIGINT PRIMARY KEY AUTO_INCREMENT,
+    club_id INT NOT NULL,
+    delta DECIMAL(10, 2) NOT NULL,
+    created_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    INDEX (club_id),
+    FOREIGN KEY (club_id) REFERENCES Club(club_id) ON DELETE CASCADE ON UPDATE CASCADE
+);
+
+-- Club_Activity_Rollup 테이블 (동아리별 연간 활동/모임/참석 집계)
+CREATE TABLE Club_Activity_Rollup (
+    club_id INT NOT NULL,
+    year YEAR NOT NULL,
+    activity_count INT NOT NULL DEFAULT 0,
+    gathering_count INT NOT NULL DEFAULT 0,
+    attendee_count INT NOT NULL DEFAULT 0,
+    PRIMARY KEY (club_id, year),
+    INDEX idx_rollup_year (year, activity_count),
+    FOREIGN KEY (club_id) REFERENCES Club(club_id) ON DELETE CASCADE ON UPDATE CASCADE
+);
+
 -- Club과 Equipment의 관계 (1:N)
 CREATE TABLE Club_Equipment (
     club_id INT,
@@ -107,3 +136,44 @@ CREATE TABLE Club_Equipment (
     FOREIGN KEY (club_id) REFERENCES Club(club_id) ON DELETE CASCADE ON UPDATE CASCADE,
     FOREIGN KEY (equip_id) REFERENCES Equipment(equip_id) ON DELETE CASCADE ON UPDATE CASCADE
 );
+
+-- Club.member_count / Club.activity_count 카운터 유지 트리거
+-- 외래 키 연쇄 삭제(ON DELETE CASCADE)로 지워지는 행에는 트리거가 실행되지 않으므로
+-- 학생 삭제 시의 Club_Student 감소분은 StudentTable 에서 같은 트랜잭션으로 반영함
+DELIMITER //
+
+CREATE TRIGGER club_student_after_insert AFTER INSERT ON Club_Student FOR EACH ROW
+BEGIN
+    UPDATE Club SET member_count = member_count + 1 WHERE club_id = NEW.club_id;
+END//
+
+CREATE TRIGGER club_student_after_delete AFTER DELETE ON Club_Student FOR EACH ROW
+BEGIN
+    UPDATE Club SET member_count = member_count - 1 WHERE club_id = OLD.club_id;
+END//
+
+CREATE TRIGGER activity_after_insert AFTER INSERT ON Activity FOR EACH ROW
+BEGIN
+    IF NEW.pending_delete = 0 THEN
+        UPDATE Club SET activity_count = activity_count + 1 WHERE club_id = NEW.club_id;
+    END IF;
+END//
+
+CREATE TRIGGER activity_after_update AFTER UPDATE ON Activity FOR EACH ROW
+BEGIN
+    IF OLD.pending_delete = 0 AND NOT (NEW.pending_delete = 0 AND NEW.club_id <=> OLD.club_id) THEN
+        UPDATE Club SET activity_count = activity_count - 1 WHERE club_id = OLD.club_id;
+    END IF;
+    IF NEW.pending_delete = 0 AND NOT (OLD.pending_delete = 0 AND NEW.club_id <=> OLD.club_id) THEN
+        UPDATE Club SET activity_count = activity_count + 1 WHERE club_id = NEW.club_id;
+    END IF;
+END//
+
+CREATE TRIGGER activity_after_delete AFTER DELETE ON Activity FOR EACH ROW
+BEGIN
+    IF OLD.pending_delete = 0 THEN
+        UPDATE Club SET activity_count = activity_count - 1 WHERE club_id = OLD.club_id;
+    END IF;
+END//
+
+DELIMITER ;
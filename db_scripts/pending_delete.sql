@@ -0,0 +1,6 @@
+/* 비동기 삭제(purge) 대기 표시 컬럼 추가 (club_init.sql 에 이 컬럼이 생기기 전에 만든 club DB 에 반드시 적용) */
+
+USE club;
+
+ALTER TABLE Club ADD COLUMN pending_delete TINYINT(1) NOT NULL DEFAULT 0;
+ALTER TABLE Activity ADD COLUMN pending_delete TINYINT(1) NOT NULL DEFAULT 0;
@@ -0,0 +1,8 @@
+/* 연간 결과 일괄 제출을 위한 제약/인덱스 추가 (기존 club DB 에 적용) */
+
+USE club;
+
+-- 동아리별 연도당 Result 는 하나 (재실행 시 같은 행을 재사용)
+ALTER TABLE Result ADD UNIQUE KEY uq_result_club_year (club_id, year);
+-- 동아리의 연도별 활동을 범위 검색
+ALTER TABLE Activity ADD INDEX idx_activity_club_start (club_id, start_date);
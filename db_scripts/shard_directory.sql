@@ -0,0 +1,11 @@
+/* 동아리 샤드 디렉터리 테이블 추가 (SEV_SHARDS 사용 시 MYSQL_SERVER 의 club DB 에 적용) */
+
+USE club;
+
+-- Club_Shard 테이블: 동아리가 어느 샤드(SEV_SHARDS 목록의 순번, 0부터)에 있는지 기록
+-- 행이 없는 동아리는 (club_id - 1) % 샤드 수 번째 샤드에 있는 것으로 본다
+CREATE TABLE Club_Shard (
+    club_id INT PRIMARY KEY,
+    shard_id INT NOT NULL,
+    INDEX idx_club_shard_shard (shard_id)
+);
@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+
+#include "../utils.h"
+#include "ColumnarSnapshot.h"
+
+/**
+ * @brief Ranges smaller than this are not worth a thread.
+ */
+static constexpr size_t min_rows_per_thread = 65536;
+
+int32_t Dictionary::encode(const std::string &value) {
+    auto [it, inserted] = codes.try_emplace(value, static_cast<int32_t>(values.size()));
+    if (inserted)
+        values.push_back(value);
+    return it->second;
+}
+
+int32_t Dictionary::find(const std::string &value) const {
+    auto it = codes.find(value);
+    return it == codes.end() ? -1 : it->second;
+}
+
+struct ColumnarSnapshot::Delta {
+    bool students_reloaded = false;
+    uint64_t student_checksum = 0;
+    std::vector<int32_t> student_id;
+    std::vector<std::string> student_department;
+    bool clubs_reloaded = false;
+    uint64_t club_checksum = 0;
+    std::vector<int32_t> club_id;
+    std::vector<double> club_budget;
+    bool members_reloaded = false;
+    uint64_t member_checksum = 0;
+    std::vector<int32_t> member_club_id;
+    std::vector<int32_t> member_student_id;
+};
+
+ColumnarSnapshot::ColumnarSnapshot(unsigned threads)
+    : threads(threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads) {}
+
+ColumnarSnapshot::~ColumnarSnapshot() {
+    stop_refresh();
+}
+
+bool ColumnarSnapshot::reload(std::shared_ptr<sql::Connection> conn) {
+    return load(conn, true);
+}
+
+bool ColumnarSnapshot::refresh(std::shared_ptr<sql::Connection> conn) {
+    return load(conn, false);
+}
+
+/**
+ * @brief Returns whether the rows up to a high-water mark differ from the ones loaded, by row count and
+ * BIT_XOR(CRC32(...)) checksum, so that updates and deletes below the mark are noticed as well.
+ * @param marker_query Selects COUNT(*) and the checksum of the rows with key <= ?.
+ */
+static bool rows_changed(sql::Connection &conn, const std::string &marker_query, int high_water, size_t rows,
+                         uint64_t checksum) {
+    std::unique_ptr<sql::PreparedStatement> pstmt(conn.prepareStatement(marker_query));
+    pstmt->setInt(1, high_water);
+    std::unique_ptr<sql::ResultSet> marker(pstmt->executeQuery());
+    Logger(ll_info, "executeQuery: " + marker_query).log();
+    return !marker->next() || static_cast<size_t>(marker->getInt64(1)) != rows || marker->getUInt64(2) != checksum;
+}
+
+bool ColumnarSnapshot::load(std::shared_ptr<sql::Connection> conn, bool full) {
+    std::lock_guard<std::mutex> load_lock(load_mutex);
+
+    int student_from = 0, club_from = 0;
+    size_t students_before = 0, clubs_before = 0, members_before = 0;
+    uint64_t student_checksum_before = 0, club_checksum_before = 0, checksum_before = 0;
+    if (!full) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        student_from = student_high_water;
+        club_from = club_high_water;
+        students_before = student_id.size();
+        clubs_before = club_id.size();
+        members_before = member_club_id.size();
+        student_checksum_before = student_checksum;
+        club_checksum_before = club_checksum;
+        checksum_before = member_checksum;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    Delta delta;
+    try {
+        // Rows below the high-water marks are only appended to while unchanged; an edited department or
+        // budget, a delete or a club marked pending_delete reloads that table.
+        delta.students_reloaded =
+            full || rows_changed(*conn,
+                                 "SELECT COUNT(*), COALESCE(BIT_XOR(CRC32(CONCAT_WS(',', student_id, department))), 0) "
+                                 "FROM Student WHERE student_id <= ?",
+                                 student_from, students_before, student_checksum_before);
+        delta.clubs_reloaded =
+            full || rows_changed(*conn,
+                                 "SELECT COUNT(*), COALESCE(BIT_XOR(CRC32(CONCAT_WS(',', club_id, budget))), 0) "
+                                 "FROM Club WHERE club_id <= ? AND pending_delete = 0",
+                                 club_from, clubs_before, club_checksum_before);
+        if (delta.students_reloaded)
+            student_from = 0;
+        if (delta.clubs_reloaded)
+            club_from = 0;
+        delta.student_checksum = delta.students_reloaded ? 0 : student_checksum_before;
+        delta.club_checksum = delta.clubs_reloaded ? 0 : club_checksum_before;
+
+        {
+            std::string query = "SELECT student_id, department, CRC32(CONCAT_WS(',', student_id, department)) FROM Student "
+                                "WHERE student_id > ? ORDER BY student_id";
+            std::unique_ptr<sql::PreparedStatement> pstmt(conn->prepareStatement(query));
+            pstmt->setInt(1, student_from);
+            std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+            Logger(ll_info, "executeQuery: " + query).log();
+            delta.student_id.reserve(res->rowsCount());
+            delta.student_department.reserve(res->rowsCount());
+            while (res->next()) {
+                delta.student_id.push_back(res->getInt(1));
+                delta.student_department.push_back(res->getString(2));
+                delta.student_checksum ^= res->getUInt64(3);
+            }
+        }
+        {
+            std::string query = "SELECT club_id, budget, CRC32(CONCAT_WS(',', club_id, budget)) FROM Club "
+                                "WHERE club_id > ? AND pending_delete = 0 ORDER BY club_id";
+            std::unique_ptr<sql::PreparedStatement> pstmt(conn->prepareStatement(query));
+            pstmt->setInt(1, club_from);
+            std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+            Logger(ll_info, "executeQuery: " + query).log();
+            while (res->next()) {
+                delta.club_id.push_back(res->getInt(1));
+                delta.club_budget.push_back(static_cast<double>(res->getDouble(2)));
+                delta.club_checksum ^= res->getUInt64(3);
+            }
+        }
+
+        // Club_Student has no increasing key; reload it only when its row count or an order-independent
+        // checksum of its rows changed, so that a join and a leave between two refreshes are noticed too.
+        std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+        std::string marker_query = "SELECT COUNT(*), COALESCE(BIT_XOR(CRC32(CONCAT_WS(',', club_id, student_id))), 0) FROM Club_Student";
+        std::unique_ptr<sql::ResultSet> marker(stmt->executeQuery(marker_query));
+        Logger(ll_info, "executeQuery: " + marker_query).log();
+        if (!marker->next())
+            return false;
+        delta.member_checksum = marker->getUInt64(2);
+        bool reload_members = full || static_cast<size_t>(marker->getInt64(1)) != members_before ||
+                              delta.member_checksum != checksum_before;
+        if (reload_members) {
+            std::string query = "SELECT club_id, student_id FROM Club_Student";
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query));
+            Logger(ll_info, "executeQuery: " + query).log();
+            delta.members_reloaded = true;
+            delta.member_club_id.reserve(res->rowsCount());
+            delta.member_student_id.reserve(res->rowsCount());
+            while (res->next()) {
+                delta.member_club_id.push_back(res->getInt(1));
+                delta.member_student_id.push_back(res->getInt(2));
+            }
+        }
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in ColumnarSnapshot::load: " + std::string(e.what())).log();
+        return false;
+    }
+
+    size_t rows = delta.student_id.size() + delta.club_id.size() + delta.member_club_id.size();
+    apply(delta);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger(ll_info, std::string("ColumnarSnapshot ") + (full ? "reload" : "refresh") + ": " + std::to_string(rows) +
+                        " rows loaded in " + std::to_string(elapsed.count()) + " ms")
+        .log();
+    return true;
+}
+
+void ColumnarSnapshot::apply(Delta &delta) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (delta.students_reloaded) {
+        student_id.clear();
+        student_department.clear();
+        departments = Dictionary();
+        student_high_water = 0;
+    }
+    if (delta.clubs_reloaded) {
+        club_id.clear();
+        club_budget.clear();
+        club_high_water = 0;
+    }
+
+    student_id.insert(student_id.end(), delta.student_id.begin(), delta.student_id.end());
+    for (const std::string &department : delta.student_department)
+        student_department.push_back(departments.encode(department));
+    club_id.insert(club_id.end(), delta.club_id.begin(), delta.club_id.end());
+    club_budget.insert(club_budget.end(), delta.club_budget.begin(), delta.club_budget.end());
+    if (!delta.student_id.empty())
+        student_high_water = delta.student_id.back();
+    if (!delta.club_id.empty())
+        club_high_water = delta.club_id.back();
+    student_checksum = delta.student_checksum;
+    club_checksum = delta.club_checksum;
+
+    if (delta.members_reloaded) {
+        member_club_id = std::move(delta.member_club_id);
+        member_student_id = std::move(delta.member_student_id);
+        member_checksum = delta.member_checksum;
+        int32_t max_club = -1;
+        for (int32_t id : member_club_id)
+            max_club = std::max(max_club, id);
+        member_club_bound = static_cast<size_t>(max_club + 1);
+    }
+
+    // The lookup must cover every student referenced by a membership, known or not.
+    int32_t max_student = student_high_water;
+    for (int32_t id : member_student_id)
+        max_student = std::max(max_student, id);
+    if (delta.students_reloaded)
+        department_of_student.clear();
+    department_of_student.resize(static_cast<size_t>(max_student) + 1, -1);
+    size_t first_new = delta.students_reloaded ? 0 : student_id.size() - delta.student_id.size();
+    for (size_t row = first_new; row < student_id.size(); ++row)
+        department_of_student[student_id[row]] = student_department[row];
+}
+
+unsigned ColumnarSnapshot::parallel_for(size_t n, const std::function<void(size_t, size_t, unsigned)> &fn) const {
+    unsigned parts = static_cast<unsigned>(std::clamp<size_t>(n / min_rows_per_thread, 1, threads));
+    std::vector<std::thread> workers;
+    for (unsigned part = 1; part < parts; ++part)
+        workers.emplace_back(fn, n * part / parts, n * (part + 1) / parts, part);
+    fn(0, n / parts, 0);
+    for (auto &worker : workers)
+        worker.join();
+    return parts;
+}
+
+void ColumnarSnapshot::start_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval) {
+    std::lock_guard<std::mutex> lock(refresh_mutex);
+    if (refresher.joinable())
+        return;
+    refresh_stopping = false;
+    refresher = std::thread([this, conn, interval] {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(refresh_mutex);
+                if (refresh_wake.wait_for(lock, interval, [this] { return refresh_stopping; }))
+                    break;
+            }
+            refresh(conn);
+        }
+    });
+}
+
+void ColumnarSnapshot::stop_refresh() {
+    {
+        std::lock_guard<std::mutex> lock(refresh_mutex);
+        refresh_stopping = true;
+    }
+    refresh_wake.notify_all();
+    if (refresher.joinable())
+        refresher.join();
+}
+
+SnapshotStats ColumnarSnapshot::stats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    SnapshotStats stats;
+    stats.students = student_id.size();
+    stats.clubs = club_id.size();
+    stats.memberships = member_club_id.size();
+    stats.departments = departments.size();
+    stats.student_high_water = student_high_water;
+    stats.club_high_water = club_high_water;
+    return stats;
+}
+
+std::vector<std::pair<std::string, uint64_t>> ColumnarSnapshot::students_per_department() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::vector<uint64_t>> partial(threads, std::vector<uint64_t>(departments.size()));
+    unsigned parts = parallel_for(student_department.size(), [&](size_t begin, size_t end, unsigned part) {
+        kernels::histogram_i32(student_department.data() + begin, nullptr, end - begin, partial[part].data());
+    });
+
+    std::vector<std::pair<std::string, uint64_t>> result;
+    for (size_t code = 0; code < departments.size(); ++code) {
+        uint64_t count = 0;
+        for (unsigned part = 0; part < parts; ++part)
+            count += partial[part][code];
+        result.emplace_back(departments.decode(static_cast<int32_t>(code)), count);
+    }
+    std::sort(result.begin(), result.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+    return result;
+}
+
+uint64_t ColumnarSnapshot::count_students(const std::string &department) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    int32_t code = departments.find(department);
+    if (code < 0)
+        return 0;
+
+    std::vector<uint8_t> mask(student_department.size());
+    std::vector<uint64_t> partial(threads);
+    unsigned parts = parallel_for(student_department.size(), [&](size_t begin, size_t end, unsigned part) {
+        kernels::mask_eq_i32(student_department.data() + begin, end - begin, code, mask.data() + begin);
+        partial[part] = kernels::count_mask(mask.data() + begin, end - begin);
+    });
+
+    uint64_t count = 0;
+    for (unsigned part = 0; part < parts; ++part)
+        count += partial[part];
+    return count;
+}
+
+kernels::SumMinMax ColumnarSnapshot::club_budgets(double min_budget, double max_budget) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<uint8_t> mask(club_budget.size());
+    std::vector<kernels::SumMinMax> partial(threads);
+    unsigned parts = parallel_for(club_budget.size(), [&](size_t begin, size_t end, unsigned part) {
+        kernels::mask_range_f64(club_budget.data() + begin, end - begin, min_budget, max_budget, mask.data() + begin);
+        partial[part] = kernels::sum_min_max_f64(club_budget.data() + begin, mask.data() + begin, end - begin);
+    });
+
+    kernels::SumMinMax total;
+    for (unsigned part = 0; part < parts; ++part) {
+        const kernels::SumMinMax &p = partial[part];
+        if (p.count == 0)
+            continue;
+        total.min = total.count == 0 ? p.min : std::min(total.min, p.min);
+        total.max = total.count == 0 ? p.max : std::max(total.max, p.max);
+        total.sum += p.sum;
+        total.count += p.count;
+    }
+    return total;
+}
+
+std::vector<std::pair<int, uint64_t>> ColumnarSnapshot::member_counts(const std::string &department, size_t limit) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    int32_t code = -1;
+    if (!department.empty()) {
+        code = departments.find(department);
+        if (code < 0)
+            return {};
+    }
+
+    std::vector<uint8_t> mask(department.empty() ? 0 : member_club_id.size());
+    std::vector<std::vector<uint64_t>> partial(threads);
+    unsigned parts = parallel_for(member_club_id.size(), [&](size_t begin, size_t end, unsigned part) {
+        partial[part].assign(member_club_bound, 0);
+        const uint8_t *selected = nullptr;
+        if (!department.empty()) {
+            kernels::mask_lookup_eq_i32(member_student_id.data() + begin, end - begin, department_of_student.data(), code,
+                                        mask.data() + begin);
+            selected = mask.data() + begin;
+        }
+        kernels::histogram_i32(member_club_id.data() + begin, selected, end - begin, partial[part].data());
+    });
+
+    std::vector<std::pair<int, uint64_t>> result;
+    for (size_t club = 0; club < member_club_bound; ++club) {
+        uint64_t count = 0;
+        for (unsigned part = 0; part < parts; ++part)
+            count += partial[part][club];
+        if (count > 0)
+            result.emplace_back(static_cast<int>(club), count);
+    }
+
+    auto larger = [](const auto &a, const auto &b) { return a.second != b.second ? a.second > b.second : a.first < b.first; };
+    if (limit > 0 && limit < result.size()) {
+        std::partial_sort(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(limit), result.end(), larger);
+        result.resize(limit);
+    } else {
+        std::sort(result.begin(), result.end(), larger);
+    }
+    return result;
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+
+#include "Kernels.h"
+
+/**
+ * @brief Dictionary encoding of a low-cardinality string column.
+ */
+class Dictionary {
+public:
+    /**
+     * @brief Returns the code of value, assigning the next code if it is new.
+     */
+    int32_t encode(const std::string &value);
+
+    /**
+     * @brief Returns the code of value, or -1 if it never occurred.
+     */
+    int32_t find(const std::string &value) const;
+
+    /**
+     * @brief Returns the string of a code returned by encode().
+     */
+    const std::string &decode(int32_t code) const { return values[code]; }
+
+    /**
+     * @brief Returns the number of distinct values.
+     */
+    size_t size() const { return values.size(); }
+
+private:
+    std::vector<std::string> values;
+    std::unordered_map<std::string, int32_t> codes;
+};
+
+/**
+ * @brief Row counts and refresh positions of a ColumnarSnapshot.
+ */
+struct SnapshotStats {
+    size_t students = 0;
+    size_t clubs = 0;
+    size_t memberships = 0;
+    size_t departments = 0;
+    int student_high_water = 0;
+    int club_high_water = 0;
+};
+
+/**
+ * @brief Read-only columnar copy of Student, Club and Club_Student for reporting.
+ *
+ * Each table is held as contiguous typed arrays, with Student.department dictionary-encoded.
+ * Reports run as filter/aggregate pipelines over those arrays using the SIMD kernels in
+ * Kernels.h, split across threads, so they never touch the OLTP server.
+ *
+ * refresh() appends Student and Club rows above the primary-key high-water marks. A table whose
+ * rows below the mark changed (an edited department or budget, a delete, a club marked
+ * pending_delete) is reloaded whole, detected like Club_Student by row count and BIT_XOR(CRC32)
+ * checksum. Reports are therefore at most one refresh interval behind the server; budgets are
+ * Club.budget as stored, i.e. without credits still pending in Budget_Ledger.
+ */
+class ColumnarSnapshot {
+public:
+    /**
+     * @brief Constructs an empty snapshot.
+     * @param threads Number of threads per report; 0 means one per core.
+     */
+    explicit ColumnarSnapshot(unsigned threads = 0);
+
+    /**
+     * @brief Stops the refresh thread if it is running.
+     */
+    ~ColumnarSnapshot();
+
+    ColumnarSnapshot(const ColumnarSnapshot &) = delete;
+    ColumnarSnapshot &operator=(const ColumnarSnapshot &) = delete;
+
+    /**
+     * @brief Discards the snapshot and loads all three tables again.
+     * @param conn The connection to read with.
+     * @return True on success; on failure the previous snapshot is kept.
+     */
+    bool reload(std::shared_ptr<sql::Connection> conn);
+
+    /**
+     * @brief Loads rows added since the last load, and reloads tables whose loaded rows changed.
+     * @param conn The connection to read with.
+     * @return True on success; on failure the previous snapshot is kept.
+     */
+    bool refresh(std::shared_ptr<sql::Connection> conn);
+
+    /**
+     * @brief Calls refresh() on a background thread every interval.
+     * @param conn A connection used only by the refresh thread.
+     * @param interval Time between two refreshes.
+     */
+    void start_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval);
+
+    /**
+     * @brief Stops the refresh thread.
+     */
+    void stop_refresh();
+
+    /**
+     * @brief Returns row counts and high-water marks.
+     */
+    SnapshotStats stats() const;
+
+    /**
+     * @brief Counts students per department.
+     * @return (department, students) pairs, largest first.
+     */
+    std::vector<std::pair<std::string, uint64_t>> students_per_department() const;
+
+    /**
+     * @brief Counts the students of one department.
+     * @param department The department name.
+     */
+    uint64_t count_students(const std::string &department) const;
+
+    /**
+     * @brief Aggregates the budgets of clubs whose budget lies in [min_budget, max_budget].
+     * @param min_budget Lower bound, inclusive.
+     * @param max_budget Upper bound, inclusive.
+     */
+    kernels::SumMinMax club_budgets(double min_budget, double max_budget) const;
+
+    /**
+     * @brief Counts members per club, optionally only members of one department.
+     * @param department Only count students of this department; empty counts everyone.
+     * @param limit Return at most this many clubs; 0 means all.
+     * @return (club_id, members) pairs, largest first. Clubs without counted members are omitted.
+     */
+    std::vector<std::pair<int, uint64_t>> member_counts(const std::string &department = "", size_t limit = 0) const;
+
+private:
+    /**
+     * @brief Rows read from the server, not yet applied.
+     */
+    struct Delta;
+
+    bool load(std::shared_ptr<sql::Connection> conn, bool full);
+    void apply(Delta &delta);
+
+    /**
+     * @brief Calls fn(begin, end, part) over up to `threads` contiguous ranges of [0, n).
+     * @return The number of ranges used.
+     */
+    unsigned parallel_for(size_t n, const std::function<void(size_t, size_t, unsigned)> &fn) const;
+
+    unsigned threads;
+
+    /**
+     * @brief Guards every column below.
+     */
+    mutable std::shared_mutex mutex;
+
+    /**
+     * @brief Serializes loads.
+     */
+    std::mutex load_mutex;
+
+    std::vector<int32_t> student_id;
+    std::vector<int32_t> student_department;
+    Dictionary departments;
+
+    /**
+     * @brief Department code by student_id (-1 for unknown IDs), for filtering memberships by department.
+     */
+    std::vector<int32_t> department_of_student;
+
+    std::vector<int32_t> club_id;
+    std::vector<double> club_budget;
+
+    std::vector<int32_t> member_club_id;
+    std::vector<int32_t> member_student_id;
+
+    /**
+     * @brief One more than the largest member_club_id, i.e. the histogram size for member counts.
+     */
+    size_t member_club_bound = 0;
+
+    /**
+     * @brief BIT_XOR of CRC32("club_id,student_id") over the loaded Club_Student rows, compared on refresh.
+     */
+    uint64_t member_checksum = 0;
+
+    /**
+     * @brief BIT_XOR of CRC32("student_id,department") and CRC32("club_id,budget") over the loaded rows.
+     */
+    uint64_t student_checksum = 0;
+    uint64_t club_checksum = 0;
+
+    int student_high_water = 0;
+    int club_high_water = 0;
+
+    std::mutex refresh_mutex;
+    std::condition_variable refresh_wake;
+    bool refresh_stopping = false;
+    std::thread refresher;
+};
@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86 1
+#endif
+
+#include "Kernels.h"
+
+namespace kernels {
+
+namespace scalar {
+
+static void mask_eq_i32(const int32_t *column, size_t n, int32_t value, uint8_t *mask) {
+    for (size_t i = 0; i < n; ++i)
+        mask[i] = column[i] == value;
+}
+
+static void mask_range_f64(const double *column, size_t n, double lo, double hi, uint8_t *mask) {
+    for (size_t i = 0; i < n; ++i)
+        mask[i] = column[i] >= lo && column[i] <= hi;
+}
+
+static void mask_lookup_eq_i32(const int32_t *keys, size_t n, const int32_t *lookup, int32_t value, uint8_t *mask) {
+    for (size_t i = 0; i < n; ++i)
+        mask[i] = lookup[keys[i]] == value;
+}
+
+static size_t count_mask(const uint8_t *mask, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i)
+        count += mask[i];
+    return count;
+}
+
+static SumMinMax sum_min_max_f64(const double *column, const uint8_t *mask, size_t n) {
+    SumMinMax result;
+    for (size_t i = 0; i < n; ++i) {
+        if (!mask[i])
+            continue;
+        double value = column[i];
+        result.min = result.count == 0 ? value : std::min(result.min, value);
+        result.max = result.count == 0 ? value : std::max(result.max, value);
+        result.sum += value;
+        result.count++;
+    }
+    return result;
+}
+
+} // namespace scalar
+
+#ifdef KERNELS_X86
+namespace avx2 {
+
+/**
+ * @brief Maps an 8-bit compare mask to 8 mask bytes (0 or 1), little-endian.
+ */
+static constexpr std::array<uint64_t, 256> expand_bits = [] {
+    std::array<uint64_t, 256> table{};
+    for (unsigned bits = 0; bits < 256; ++bits) {
+        for (unsigned b = 0; b < 8; ++b) {
+            if ((bits >> b) & 1)
+                table[bits] |= uint64_t{1} << (8 * b);
+        }
+    }
+    return table;
+}();
+
+__attribute__((target("avx2"))) static void mask_eq_i32(const int32_t *column, size_t n, int32_t value, uint8_t *mask) {
+    const __m256i needle = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(column + i));
+        unsigned bits = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(values, needle))));
+        __builtin_memcpy(mask + i, &expand_bits[bits], 8);
+    }
+    scalar::mask_eq_i32(column + i, n - i, value, mask + i);
+}
+
+__attribute__((target("avx2"))) static void mask_range_f64(const double *column, size_t n, double lo, double hi, uint8_t *mask) {
+    const __m256d low = _mm256_set1_pd(lo);
+    const __m256d high = _mm256_set1_pd(hi);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d values = _mm256_loadu_pd(column + i);
+        __m256d inside = _mm256_and_pd(_mm256_cmp_pd(values, low, _CMP_GE_OQ), _mm256_cmp_pd(values, high, _CMP_LE_OQ));
+        unsigned bits = static_cast<unsigned>(_mm256_movemask_pd(inside));
+        __builtin_memcpy(mask + i, &expand_bits[bits], 4);
+    }
+    scalar::mask_range_f64(column + i, n - i, lo, hi, mask + i);
+}
+
+__attribute__((target("avx2"))) static void mask_lookup_eq_i32(const int32_t *keys, size_t n, const int32_t *lookup, int32_t value, uint8_t *mask) {
+    const __m256i needle = _mm256_set1_epi32(value);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+        __m256i values = _mm256_i32gather_epi32(lookup, index, 4);
+        unsigned bits = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(values, needle))));
+        __builtin_memcpy(mask + i, &expand_bits[bits], 8);
+    }
+    scalar::mask_lookup_eq_i32(keys + i, n - i, lookup, value, mask + i);
+}
+
+__attribute__((target("avx2"))) static size_t count_mask(const uint8_t *mask, size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i totals = zero;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + i));
+        // Sums each group of 8 bytes into a 64-bit lane.
+        totals = _mm256_add_epi64(totals, _mm256_sad_epu8(bytes, zero));
+    }
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), totals);
+    return static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + scalar::count_mask(mask + i, n - i);
+}
+
+__attribute__((target("avx2"))) static SumMinMax sum_min_max_f64(const double *column, const uint8_t *mask, size_t n) {
+    const __m256d positive = _mm256_set1_pd(__builtin_inf());
+    const __m256d negative = _mm256_set1_pd(-__builtin_inf());
+    __m256d sums = _mm256_setzero_pd();
+    __m256d mins = positive;
+    __m256d maxs = negative;
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32_t bytes;
+        __builtin_memcpy(&bytes, mask + i, sizeof(bytes));
+        if (bytes == 0)
+            continue;
+        // Widen the 4 mask bytes to 4 all-ones/all-zeros 64-bit lanes.
+        __m256i wide = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(static_cast<int>(bytes)));
+        __m256d selected = _mm256_castsi256_pd(_mm256_cmpgt_epi64(wide, _mm256_setzero_si256()));
+        __m256d values = _mm256_loadu_pd(column + i);
+        sums = _mm256_add_pd(sums, _mm256_and_pd(values, selected));
+        mins = _mm256_min_pd(mins, _mm256_blendv_pd(positive, values, selected));
+        maxs = _mm256_max_pd(maxs, _mm256_blendv_pd(negative, values, selected));
+        count += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(_mm256_movemask_pd(selected))));
+    }
+
+    alignas(32) double lane_sums[4], lane_mins[4], lane_maxs[4];
+    _mm256_store_pd(lane_sums, sums);
+    _mm256_store_pd(lane_mins, mins);
+    _mm256_store_pd(lane_maxs, maxs);
+
+    SumMinMax result = scalar::sum_min_max_f64(column + i, mask + i, n - i);
+    if (count > 0) {
+        double min = std::min({lane_mins[0], lane_mins[1], lane_mins[2], lane_mins[3]});
+        double max = std::max({lane_maxs[0], lane_maxs[1], lane_maxs[2], lane_maxs[3]});
+        result.min = result.count == 0 ? min : std::min(result.min, min);
+        result.max = result.count == 0 ? max : std::max(result.max, max);
+        result.sum += lane_sums[0] + lane_sums[1] + lane_sums[2] + lane_sums[3];
+        result.count += count;
+    }
+    return result;
+}
+
+} // namespace avx2
+#endif
+
+bool avx2_enabled() {
+#ifdef KERNELS_X86
+    static const bool enabled = __builtin_cpu_supports("avx2");
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+void mask_eq_i32(const int32_t *column, size_t n, int32_t value, uint8_t *mask) {
+#ifdef KERNELS_X86
+    if (avx2_enabled())
+        return avx2::mask_eq_i32(column, n, value, mask);
+#endif
+    scalar::mask_eq_i32(column, n, value, mask);
+}
+
+void mask_range_f64(const double *column, size_t n, double lo, double hi, uint8_t *mask) {
+#ifdef KERNELS_X86
+    if (avx2_enabled())
+        return avx2::mask_range_f64(column, n, lo, hi, mask);
+#endif
+    scalar::mask_range_f64(column, n, lo, hi, mask);
+}
+
+void mask_lookup_eq_i32(const int32_t *keys, size_t n, const int32_t *lookup, int32_t value, uint8_t *mask) {
+#ifdef KERNELS_X86
+    if (avx2_enabled())
+        return avx2::mask_lookup_eq_i32(keys, n, lookup, value, mask);
+#endif
+    scalar::mask_lookup_eq_i32(keys, n, lookup, value, mask);
+}
+
+size_t count_mask(const uint8_t *mask, size_t n) {
+#ifdef KERNELS_X86
+    if (avx2_enabled())
+        return avx2::count_mask(mask, n);
+#endif
+    return scalar::count_mask(mask, n);
+}
+
+SumMinMax sum_min_max_f64(const double *column, const uint8_t *mask, size_t n) {
+#ifdef KERNELS_X86
+    if (avx2_enabled())
+        return avx2::sum_min_max_f64(column, mask, n);
+#endif
+    return scalar::sum_min_max_f64(column, mask, n);
+}
+
+void histogram_i32(const int32_t *column, const uint8_t *mask, size_t n, uint64_t *counts) {
+    // Scatter-increments do not vectorize; four partial tables would only help with very few buckets.
+    if (mask == nullptr) {
+        for (size_t i = 0; i < n; ++i)
+            counts[column[i]]++;
+    } else {
+        for (size_t i = 0; i < n; ++i)
+            counts[column[i]] += mask[i];
+    }
+}
+
+} // namespace kernels
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Filter and aggregate kernels over contiguous columns.
+ *
+ * Every kernel has an AVX2 implementation, chosen at run time when the CPU supports it,
+ * and a scalar fallback. Selections are byte masks (0 or 1 per row) so that several
+ * filters can be combined before aggregating. Kernels are single-threaded; callers split
+ * columns into ranges to run them in parallel.
+ */
+namespace kernels {
+
+/**
+ * @brief Returns whether the AVX2 implementations are in use.
+ */
+bool avx2_enabled();
+
+/**
+ * @brief Sets mask[i] to (column[i] == value).
+ */
+void mask_eq_i32(const int32_t *column, size_t n, int32_t value, uint8_t *mask);
+
+/**
+ * @brief Sets mask[i] to (lo <= column[i] && column[i] <= hi).
+ */
+void mask_range_f64(const double *column, size_t n, double lo, double hi, uint8_t *mask);
+
+/**
+ * @brief Sets mask[i] to (lookup[keys[i]] == value). Keys must index into lookup.
+ * Used to filter one table's rows by a column of another, e.g. members by their student's department.
+ */
+void mask_lookup_eq_i32(const int32_t *keys, size_t n, const int32_t *lookup, int32_t value, uint8_t *mask);
+
+/**
+ * @brief Returns the number of set rows in mask.
+ */
+size_t count_mask(const uint8_t *mask, size_t n);
+
+/**
+ * @brief Aggregates of the selected rows of a double column.
+ */
+struct SumMinMax {
+    size_t count = 0;
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+};
+
+/**
+ * @brief Returns count, sum, min and max of column over the rows set in mask.
+ */
+SumMinMax sum_min_max_f64(const double *column, const uint8_t *mask, size_t n);
+
+/**
+ * @brief Adds one to counts[column[i]] for each row set in mask (or each row when mask is null).
+ * Values must be in [0, number of counts).
+ */
+void histogram_i32(const int32_t *column, const uint8_t *mask, size_t n, uint64_t *counts);
+
+} // namespace kernels
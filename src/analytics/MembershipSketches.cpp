@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+
+#include "../utils.h"
+#include "MembershipSketches.h"
+
+/**
+ * @brief File header; bump the digit when the layout changes.
+ */
+static const char sketch_magic[8] = {'S', 'E', 'V', 'S', 'K', 'T', '0', '1'};
+
+template <typename T>
+static void write_pod(std::ostream &out, const T &value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool read_pod(std::istream &in, T &value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+MembershipSketches::MembershipSketches(std::string path) : path(path) {}
+
+MembershipSketches::~MembershipSketches() {
+    stop_autosave();
+    bool pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = dirty;
+    }
+    if (pending)
+        save();
+}
+
+void MembershipSketches::add_membership(Sketches &sketches, int club_id, int student_id) {
+    uint64_t student = static_cast<uint64_t>(student_id);
+    sketches.all_members.add(student);
+    sketches.club_members.try_emplace(club_id, group_precision).first->second.add(student);
+    sketches.club_frequency.add(static_cast<uint64_t>(club_id));
+    sketches.club_heavy_hitters.add(static_cast<uint64_t>(club_id));
+}
+
+void MembershipSketches::add_attendance(Sketches &sketches, const std::string &department, int year, int student_id) {
+    uint64_t student = static_cast<uint64_t>(student_id);
+    sketches.department_participants.try_emplace(department, group_precision).first->second.add(student);
+    sketches.year_participants.try_emplace(year, group_precision).first->second.add(student);
+}
+
+bool MembershipSketches::load() {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+
+    char magic[sizeof(sketch_magic)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), sketch_magic)) {
+        Logger(ll_warning, "Ignoring sketch file with unknown format: " + path).log();
+        return false;
+    }
+
+    Sketches next;
+    bool ok = next.all_members.read(in);
+    uint64_t count = 0;
+    ok = ok && read_pod(in, count);
+    for (uint64_t i = 0; ok && i < count; ++i) {
+        int32_t club_id;
+        HyperLogLog hll;
+        ok = read_pod(in, club_id) && hll.read(in);
+        next.club_members.emplace(club_id, std::move(hll));
+    }
+    ok = ok && read_pod(in, count);
+    for (uint64_t i = 0; ok && i < count; ++i) {
+        uint32_t length;
+        ok = read_pod(in, length) && length <= 1024;
+        std::string department(ok ? length : 0, '\0');
+        HyperLogLog hll;
+        ok = ok && in.read(department.data(), length) && hll.read(in);
+        next.department_participants.emplace(std::move(department), std::move(hll));
+    }
+    ok = ok && read_pod(in, count);
+    for (uint64_t i = 0; ok && i < count; ++i) {
+        int32_t year;
+        HyperLogLog hll;
+        ok = read_pod(in, year) && hll.read(in);
+        next.year_participants.emplace(year, std::move(hll));
+    }
+    ok = ok && next.club_frequency.read(in) && next.club_heavy_hitters.read(in);
+
+    if (!ok) {
+        Logger(ll_warning, "Ignoring truncated sketch file: " + path).log();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    sketches = std::move(next);
+    dirty = false;
+    Logger(ll_info, "Loaded membership sketches from " + path).log();
+    return true;
+}
+
+bool MembershipSketches::save() {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            Logger(ll_error, "Cannot write sketch file: " + temporary).log();
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        out.write(sketch_magic, sizeof(sketch_magic));
+        sketches.all_members.write(out);
+        write_pod(out, static_cast<uint64_t>(sketches.club_members.size()));
+        for (const auto &[club_id, hll] : sketches.club_members) {
+            write_pod(out, static_cast<int32_t>(club_id));
+            hll.write(out);
+        }
+        write_pod(out, static_cast<uint64_t>(sketches.department_participants.size()));
+        for (const auto &[department, hll] : sketches.department_participants) {
+            write_pod(out, static_cast<uint32_t>(department.size()));
+            out.write(department.data(), static_cast<std::streamsize>(department.size()));
+            hll.write(out);
+        }
+        write_pod(out, static_cast<uint64_t>(sketches.year_participants.size()));
+        for (const auto &[year, hll] : sketches.year_participants) {
+            write_pod(out, static_cast<int32_t>(year));
+            hll.write(out);
+        }
+        sketches.club_frequency.write(out);
+        sketches.club_heavy_hitters.write(out);
+        dirty = false;
+
+        if (!out.flush()) {
+            Logger(ll_error, "Cannot write sketch file: " + temporary).log();
+            dirty = true;
+            return false;
+        }
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        Logger(ll_error, "Cannot replace sketch file: " + path).log();
+        return false;
+    }
+    return true;
+}
+
+bool MembershipSketches::rebuild(std::shared_ptr<sql::Connection> conn) {
+    std::lock_guard<std::mutex> rebuild_lock(rebuild_mutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        journal.clear();
+        journaling = true;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    Sketches next;
+    size_t rows = 0;
+    try {
+        std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+        {
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT club_id, student_id FROM Club_Student"));
+            while (res->next()) {
+                add_membership(next, res->getInt(1), res->getInt(2));
+                rows++;
+            }
+        }
+        {
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                "SELECT s.department, YEAR(a.start_date), gs.student_id FROM Gathering_Student AS gs "
+                "JOIN Gathering AS g ON g.gathering_id = gs.gathering_id "
+                "JOIN Activity AS a ON a.act_id = g.act_id "
+                "JOIN Student AS s ON s.student_id = gs.student_id"));
+            while (res->next()) {
+                add_attendance(next, res->getString(1), res->getInt(2), res->getInt(3));
+                rows++;
+            }
+        }
+        Logger(ll_info, "executeQuery: MembershipSketches scan of Club_Student, Gathering_Student").log();
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in MembershipSketches::rebuild: " + std::string(e.what())).log();
+        std::lock_guard<std::mutex> lock(mutex);
+        journaling = false;
+        journal.clear();
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Change &change : journal) {
+            if (change.club_id >= 0) {
+                add_membership(next, change.club_id, change.student_id);
+            } else {
+                add_attendance(next, change.department, change.year, change.student_id);
+            }
+        }
+        journal.clear();
+        journaling = false;
+        sketches = std::move(next);
+        dirty = true;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger(ll_info, "MembershipSketches: " + std::to_string(rows) + " rows sketched in " +
+                        std::to_string(elapsed.count()) + " ms")
+        .log();
+    return save();
+}
+
+void MembershipSketches::record_membership(int club_id, int student_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    add_membership(sketches, club_id, student_id);
+    dirty = true;
+    if (journaling)
+        journal.push_back(Change{club_id, "", 0, student_id});
+}
+
+void MembershipSketches::record_attendance(const std::string &department, int year, int student_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    add_attendance(sketches, department, year, student_id);
+    dirty = true;
+    if (journaling)
+        journal.push_back(Change{-1, department, year, student_id});
+}
+
+bool MembershipSketches::record_club_roster(std::shared_ptr<sql::Connection> conn, int club_id, uint64_t joins) {
+    std::vector<int> students;
+    try {
+        std::string query = "SELECT student_id FROM Club_Student WHERE club_id = ?";
+        std::unique_ptr<sql::PreparedStatement> pstmt(conn->prepareStatement(query));
+        pstmt->setInt(1, club_id);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        Logger(ll_info, "executeQuery: " + query).log();
+        while (res->next())
+            students.push_back(res->getInt(1));
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in MembershipSketches::record_club_roster: " + std::string(e.what())).log();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &club = sketches.club_members.try_emplace(club_id, group_precision).first->second;
+    for (int student_id : students) {
+        sketches.all_members.add(static_cast<uint64_t>(student_id));
+        club.add(static_cast<uint64_t>(student_id));
+    }
+    sketches.club_frequency.add(static_cast<uint64_t>(club_id), joins);
+    sketches.club_heavy_hitters.add(static_cast<uint64_t>(club_id), joins);
+    dirty = true;
+    // A rebuild in progress may have scanned this club already. Replaying the roster is idempotent for
+    // the distinct counters; the join frequencies may count it twice, which stays within their overestimate.
+    if (journaling) {
+        for (int student_id : students)
+            journal.push_back(Change{club_id, "", 0, student_id});
+    }
+    return true;
+}
+
+bool MembershipSketches::record_attendee(std::shared_ptr<sql::Connection> conn, int gathering_id, int student_id) {
+    try {
+        std::string query = "SELECT s.department, YEAR(a.start_date) FROM Student AS s, Gathering AS g "
+                            "JOIN Activity AS a ON a.act_id = g.act_id "
+                            "WHERE s.student_id = ? AND g.gathering_id = ?";
+        std::unique_ptr<sql::PreparedStatement> pstmt(conn->prepareStatement(query));
+        pstmt->setInt(1, student_id);
+        pstmt->setInt(2, gathering_id);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        Logger(ll_info, "executeQuery: " + query).log();
+        if (res->next())
+            record_attendance(res->getString(1), res->getInt(2), student_id);
+        return true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in MembershipSketches::record_attendee: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+bool MembershipSketches::record_gathering_roster(std::shared_ptr<sql::Connection> conn, int gathering_id) {
+    std::vector<Change> attendees;
+    try {
+        std::string query = "SELECT s.department, YEAR(a.start_date), gs.student_id FROM Gathering_Student AS gs "
+                            "JOIN Gathering AS g ON g.gathering_id = gs.gathering_id "
+                            "JOIN Activity AS a ON a.act_id = g.act_id "
+                            "JOIN Student AS s ON s.student_id = gs.student_id "
+                            "WHERE gs.gathering_id = ?";
+        std::unique_ptr<sql::PreparedStatement> pstmt(conn->prepareStatement(query));
+        pstmt->setInt(1, gathering_id);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        Logger(ll_info, "executeQuery: " + query).log();
+        while (res->next())
+            attendees.push_back(Change{-1, res->getString(1), res->getInt(2), res->getInt(3)});
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in MembershipSketches::record_gathering_roster: " + std::string(e.what())).log();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Change &attendee : attendees)
+        add_attendance(sketches, attendee.department, attendee.year, attendee.student_id);
+    dirty = dirty || !attendees.empty();
+    if (journaling)
+        journal.insert(journal.end(), attendees.begin(), attendees.end());
+    return true;
+}
+
+void MembershipSketches::start_autosave(std::chrono::seconds interval) {
+    std::lock_guard<std::mutex> lock(autosave_mutex);
+    if (autosaver.joinable())
+        return;
+    autosave_stopping = false;
+    autosaver = std::thread([this, interval] {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(autosave_mutex);
+                if (autosave_wake.wait_for(lock, interval, [this] { return autosave_stopping; }))
+                    break;
+            }
+            bool pending;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending = dirty;
+            }
+            if (pending)
+                save();
+        }
+    });
+}
+
+void MembershipSketches::stop_autosave() {
+    {
+        std::lock_guard<std::mutex> lock(autosave_mutex);
+        autosave_stopping = true;
+    }
+    autosave_wake.notify_all();
+    if (autosaver.joinable())
+        autosaver.join();
+}
+
+Estimate MembershipSketches::distinct_members() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sketches.all_members.estimate();
+}
+
+Estimate MembershipSketches::distinct_members(const std::vector<int> &club_ids) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    HyperLogLog merged(group_precision);
+    for (int club_id : club_ids) {
+        auto it = sketches.club_members.find(club_id);
+        if (it != sketches.club_members.end())
+            merged.merge(it->second);
+    }
+    return merged.estimate();
+}
+
+Estimate MembershipSketches::distinct_participants_by_department(const std::string &department) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sketches.department_participants.find(department);
+    return it == sketches.department_participants.end() ? Estimate{} : it->second.estimate();
+}
+
+Estimate MembershipSketches::distinct_participants_by_year(int year) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sketches.year_participants.find(year);
+    return it == sketches.year_participants.end() ? Estimate{} : it->second.estimate();
+}
+
+Estimate MembershipSketches::club_joins(int club_id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sketches.club_frequency.estimate(static_cast<uint64_t>(club_id));
+}
+
+std::vector<std::pair<int, Estimate>> MembershipSketches::most_joined_clubs(size_t k) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::pair<int, Estimate>> clubs;
+    for (const SpaceSaving::Entry &entry : sketches.club_heavy_hitters.top(k))
+        clubs.emplace_back(static_cast<int>(entry.item),
+                           Estimate{static_cast<double>(entry.count), static_cast<double>(entry.error)});
+    return clubs;
+}
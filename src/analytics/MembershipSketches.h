@@ -0,0 +1,199 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+
+#include "Sketches.h"
+
+/**
+ * @brief Approximate membership and participation figures, kept as mergeable sketches.
+ *
+ * - distinct students per club (HyperLogLog), mergeable into "distinct students across clubs";
+ * - distinct students per department and per year taking part in activities (HyperLogLog over
+ *   Gathering_Student joined with Student and Activity);
+ * - club popularity: Count-Min frequencies and Space-Saving heavy hitters over joins.
+ *
+ * The sketches are built from one streaming scan, persisted to a local file, and updated
+ * incrementally by the membership and attendance writes, so figures are available instantly
+ * at startup. Like the sketches themselves they are insert-only: they count everyone who ever
+ * joined, and leaving a club does not decrease them until the next rebuild.
+ */
+class MembershipSketches {
+public:
+    /**
+     * @brief Precision of the per-club, per-department and per-year distinct counters (about 1.6% error).
+     */
+    static constexpr unsigned group_precision = 12;
+
+    /**
+     * @brief Precision of the all-clubs distinct counter (about 0.8% error).
+     */
+    static constexpr unsigned total_precision = 14;
+
+    /**
+     * @param path The file the sketches are persisted to.
+     */
+    explicit MembershipSketches(std::string path);
+
+    /**
+     * @brief Saves pending changes and stops the autosave thread.
+     */
+    ~MembershipSketches();
+
+    MembershipSketches(const MembershipSketches &) = delete;
+    MembershipSketches &operator=(const MembershipSketches &) = delete;
+
+    /**
+     * @brief Loads the sketches from the file.
+     * @return False if the file is missing or unreadable (the sketches are left empty).
+     */
+    bool load();
+
+    /**
+     * @brief Writes the sketches to the file (through a temporary file, so a crash never leaves it torn).
+     * @return True on success.
+     */
+    bool save();
+
+    /**
+     * @brief Discards the sketches and rebuilds them from a streaming scan of Club_Student and Gathering_Student.
+     * @param conn The connection to scan with.
+     * @return True on success; on failure the previous sketches are kept.
+     */
+    bool rebuild(std::shared_ptr<sql::Connection> conn);
+
+    /**
+     * @brief Records that a student joined a club.
+     */
+    void record_membership(int club_id, int student_id);
+
+    /**
+     * @brief Records that a student joined a gathering.
+     * @param department The student's department.
+     * @param year The year the gathering's activity starts.
+     * @param student_id The ID of the student.
+     */
+    void record_attendance(const std::string &department, int year, int student_id);
+
+    /**
+     * @brief Records a set-based membership change by re-reading the club's roster.
+     * Distinct counters are idempotent, so re-adding current members is harmless.
+     * @param conn The connection to read with.
+     * @param club_id The ID of the club.
+     * @param joins The number of rows the change inserted, added to the club's join frequency.
+     * @return True on success.
+     */
+    bool record_club_roster(std::shared_ptr<sql::Connection> conn, int club_id, uint64_t joins);
+
+    /**
+     * @brief Records that a student joined a gathering, looking up the department and year.
+     * Does not need the Gathering_Student row, so it also works before a write-behind flush.
+     * @return True on success.
+     */
+    bool record_attendee(std::shared_ptr<sql::Connection> conn, int gathering_id, int student_id);
+
+    /**
+     * @brief Records the attendees of a gathering with their departments and the activity's year.
+     * @param conn The connection to read with.
+     * @param gathering_id The ID of the gathering.
+     * @return True on success.
+     */
+    bool record_gathering_roster(std::shared_ptr<sql::Connection> conn, int gathering_id);
+
+    /**
+     * @brief Saves every interval if something changed.
+     */
+    void start_autosave(std::chrono::seconds interval);
+
+    /**
+     * @brief Stops the autosave thread.
+     */
+    void stop_autosave();
+
+    /**
+     * @brief Distinct students who are (or were) members of any club.
+     */
+    Estimate distinct_members() const;
+
+    /**
+     * @brief Distinct students who are (or were) members of one of the given clubs.
+     */
+    Estimate distinct_members(const std::vector<int> &club_ids) const;
+
+    /**
+     * @brief Distinct students of a department who attended a gathering.
+     */
+    Estimate distinct_participants_by_department(const std::string &department) const;
+
+    /**
+     * @brief Distinct students who attended a gathering of an activity starting in year.
+     */
+    Estimate distinct_participants_by_year(int year) const;
+
+    /**
+     * @brief Estimated number of joins of a club.
+     */
+    Estimate club_joins(int club_id) const;
+
+    /**
+     * @brief The most-joined clubs, largest first.
+     * @return (club_id, joins) pairs; joins.error is the Space-Saving overestimate bound.
+     */
+    std::vector<std::pair<int, Estimate>> most_joined_clubs(size_t k) const;
+
+private:
+    /**
+     * @brief Every sketch, so that a rebuild can replace them all at once.
+     */
+    struct Sketches {
+        HyperLogLog all_members{total_precision};
+        std::map<int, HyperLogLog> club_members;
+        std::map<std::string, HyperLogLog> department_participants;
+        std::map<int, HyperLogLog> year_participants;
+        CountMinSketch club_frequency;
+        SpaceSaving club_heavy_hitters;
+    };
+
+    /**
+     * @brief A write recorded while a rebuild is scanning; club_id < 0 means attendance.
+     */
+    struct Change {
+        int club_id;
+        std::string department;
+        int year;
+        int student_id;
+    };
+
+    static void add_membership(Sketches &sketches, int club_id, int student_id);
+    static void add_attendance(Sketches &sketches, const std::string &department, int year, int student_id);
+
+    std::string path;
+
+    /**
+     * @brief Guards sketches, dirty and the journal.
+     */
+    mutable std::mutex mutex;
+    Sketches sketches;
+    bool dirty = false;
+
+    /**
+     * @brief Serializes rebuilds.
+     */
+    std::mutex rebuild_mutex;
+    std::vector<Change> journal;
+    bool journaling = false;
+
+    std::mutex autosave_mutex;
+    std::condition_variable autosave_wake;
+    bool autosave_stopping = false;
+    std::thread autosaver;
+};
@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "Sketches.h"
+
+template <typename T>
+static void write_pod(std::ostream &out, const T &value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool read_pod(std::istream &in, T &value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+uint64_t sketch_hash(uint64_t key, uint64_t seed) {
+    // splitmix64 finalizer.
+    uint64_t z = key + seed * 0x9E3779B97F4A7C15ull + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+HyperLogLog::HyperLogLog(unsigned precision) : bits(std::clamp(precision, 4u, 18u)), registers(size_t{1} << bits) {}
+
+void HyperLogLog::add(uint64_t item) {
+    uint64_t hash = sketch_hash(item);
+    size_t index = static_cast<size_t>(hash >> (64 - bits));
+    uint64_t rest = hash << bits;
+    uint8_t rank = static_cast<uint8_t>(std::min<int>(std::countl_zero(rest), static_cast<int>(64 - bits)) + 1);
+    registers[index] = std::max(registers[index], rank);
+}
+
+bool HyperLogLog::merge(const HyperLogLog &other) {
+    if (other.bits != bits)
+        return false;
+    for (size_t i = 0; i < registers.size(); ++i)
+        registers[i] = std::max(registers[i], other.registers[i]);
+    return true;
+}
+
+Estimate HyperLogLog::estimate() const {
+    double m = static_cast<double>(registers.size());
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t reg : registers) {
+        sum += std::ldexp(1.0, -static_cast<int>(reg));
+        zeros += reg == 0;
+    }
+
+    double alpha = 0.7213 / (1 + 1.079 / m);
+    double value = alpha * m * m / sum;
+    // Small cardinalities: linear counting over empty registers is more accurate.
+    if (value <= 2.5 * m && zeros > 0)
+        value = m * std::log(m / static_cast<double>(zeros));
+
+    return Estimate{value, value * 1.04 / std::sqrt(m)};
+}
+
+void HyperLogLog::write(std::ostream &out) const {
+    write_pod(out, static_cast<uint32_t>(bits));
+    out.write(reinterpret_cast<const char *>(registers.data()), static_cast<std::streamsize>(registers.size()));
+}
+
+bool HyperLogLog::read(std::istream &in) {
+    uint32_t precision;
+    if (!read_pod(in, precision) || precision < 4 || precision > 18)
+        return false;
+    bits = precision;
+    registers.assign(size_t{1} << bits, 0);
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(registers.data()), static_cast<std::streamsize>(registers.size())));
+}
+
+CountMinSketch::CountMinSketch(double epsilon, double delta)
+    : width(static_cast<uint32_t>(std::ceil(std::exp(1.0) / epsilon))),
+      depth(static_cast<uint32_t>(std::ceil(std::log(1.0 / delta)))), delta(delta),
+      counters(static_cast<size_t>(width) * depth) {}
+
+void CountMinSketch::add(uint64_t item, uint64_t count) {
+    for (uint32_t row = 0; row < depth; ++row)
+        counters[static_cast<size_t>(row) * width + sketch_hash(item, row + 1) % width] += count;
+    count_total += count;
+}
+
+bool CountMinSketch::merge(const CountMinSketch &other) {
+    if (other.width != width || other.depth != depth)
+        return false;
+    for (size_t i = 0; i < counters.size(); ++i)
+        counters[i] += other.counters[i];
+    count_total += other.count_total;
+    return true;
+}
+
+Estimate CountMinSketch::estimate(uint64_t item) const {
+    uint64_t value = UINT64_MAX;
+    for (uint32_t row = 0; row < depth; ++row)
+        value = std::min(value, counters[static_cast<size_t>(row) * width + sketch_hash(item, row + 1) % width]);
+    // width = ceil(e / epsilon), so epsilon * total = e * total / width.
+    double error = std::exp(1.0) * static_cast<double>(count_total) / width;
+    return Estimate{static_cast<double>(value), error};
+}
+
+void CountMinSketch::write(std::ostream &out) const {
+    write_pod(out, width);
+    write_pod(out, depth);
+    write_pod(out, delta);
+    write_pod(out, count_total);
+    out.write(reinterpret_cast<const char *>(counters.data()), static_cast<std::streamsize>(counters.size() * sizeof(uint64_t)));
+}
+
+bool CountMinSketch::read(std::istream &in) {
+    if (!read_pod(in, width) || !read_pod(in, depth) || !read_pod(in, delta) || !read_pod(in, count_total))
+        return false;
+    if (width == 0 || depth == 0 || static_cast<uint64_t>(width) * depth > (uint64_t{1} << 28))
+        return false;
+    counters.assign(static_cast<size_t>(width) * depth, 0);
+    return static_cast<bool>(
+        in.read(reinterpret_cast<char *>(counters.data()), static_cast<std::streamsize>(counters.size() * sizeof(uint64_t))));
+}
+
+SpaceSaving::SpaceSaving(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+void SpaceSaving::add(uint64_t item, uint64_t count) {
+    auto it = entries.find(item);
+    if (it != entries.end()) {
+        it->second.count += count;
+        return;
+    }
+    if (entries.size() < capacity) {
+        entries.emplace(item, Entry{item, count, 0});
+        return;
+    }
+
+    // Replace the smallest counter; the newcomer inherits its count as error.
+    auto smallest = std::min_element(entries.begin(), entries.end(),
+                                     [](const auto &a, const auto &b) { return a.second.count < b.second.count; });
+    uint64_t floor = smallest->second.count;
+    entries.erase(smallest);
+    entries.emplace(item, Entry{item, floor + count, floor});
+}
+
+void SpaceSaving::merge(const SpaceSaving &other) {
+    auto minimum = [](const SpaceSaving &summary) -> uint64_t {
+        if (summary.entries.size() < summary.capacity)
+            return 0;
+        uint64_t floor = UINT64_MAX;
+        for (const auto &[item, entry] : summary.entries)
+            floor = std::min(floor, entry.count);
+        return floor;
+    };
+    uint64_t own_floor = minimum(*this);
+    uint64_t other_floor = minimum(other);
+
+    for (auto &[item, entry] : entries) {
+        if (!other.entries.count(item)) {
+            entry.count += other_floor;
+            entry.error += other_floor;
+        }
+    }
+    for (const auto &[item, entry] : other.entries) {
+        auto it = entries.find(item);
+        if (it != entries.end()) {
+            it->second.count += entry.count;
+            it->second.error += entry.error;
+        } else {
+            entries.emplace(item, Entry{item, entry.count + own_floor, entry.error + own_floor});
+        }
+    }
+    evict_to_capacity();
+}
+
+void SpaceSaving::evict_to_capacity() {
+    if (entries.size() <= capacity)
+        return;
+    std::vector<Entry> kept = top(capacity);
+    entries.clear();
+    for (const Entry &entry : kept)
+        entries.emplace(entry.item, entry);
+}
+
+std::vector<SpaceSaving::Entry> SpaceSaving::top(size_t k) const {
+    std::vector<Entry> result;
+    result.reserve(entries.size());
+    for (const auto &[item, entry] : entries)
+        result.push_back(entry);
+    auto larger = [](const Entry &a, const Entry &b) { return a.count != b.count ? a.count > b.count : a.item < b.item; };
+    if (k < result.size()) {
+        std::partial_sort(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(k), result.end(), larger);
+        result.resize(k);
+    } else {
+        std::sort(result.begin(), result.end(), larger);
+    }
+    return result;
+}
+
+void SpaceSaving::write(std::ostream &out) const {
+    write_pod(out, static_cast<uint64_t>(capacity));
+    write_pod(out, static_cast<uint64_t>(entries.size()));
+    for (const auto &[item, entry] : entries) {
+        write_pod(out, entry.item);
+        write_pod(out, entry.count);
+        write_pod(out, entry.error);
+    }
+}
+
+bool SpaceSaving::read(std::istream &in) {
+    uint64_t stored_capacity, size;
+    if (!read_pod(in, stored_capacity) || !read_pod(in, size) || stored_capacity == 0 || size > stored_capacity)
+        return false;
+    capacity = static_cast<size_t>(stored_capacity);
+    entries.clear();
+    for (uint64_t i = 0; i < size; ++i) {
+        Entry entry;
+        if (!read_pod(in, entry.item) || !read_pod(in, entry.count) || !read_pod(in, entry.error))
+            return false;
+        entries.emplace(entry.item, entry);
+    }
+    return true;
+}
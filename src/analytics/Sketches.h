@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Stable 64-bit mix of a key, so that sketches written to disk stay valid across runs.
+ */
+uint64_t sketch_hash(uint64_t key, uint64_t seed = 0);
+
+/**
+ * @brief An approximate value with its error bound.
+ */
+struct Estimate {
+    double value = 0;
+
+    /**
+     * @brief For distinct counts one standard error; for frequencies the additive bound that holds with probability 1 - delta.
+     */
+    double error = 0;
+};
+
+/**
+ * @brief HyperLogLog distinct counter with 2^precision one-byte registers.
+ * Mergeable with other counters of the same precision; relative standard error is 1.04 / sqrt(2^precision).
+ */
+class HyperLogLog {
+public:
+    explicit HyperLogLog(unsigned precision = 12);
+
+    /**
+     * @brief Adds an item; adding the same item again has no effect.
+     */
+    void add(uint64_t item);
+
+    /**
+     * @brief Folds other into this counter. Both must have the same precision.
+     * @return False if the precisions differ (nothing is merged).
+     */
+    bool merge(const HyperLogLog &other);
+
+    /**
+     * @brief Returns the estimated number of distinct items.
+     */
+    Estimate estimate() const;
+
+    unsigned precision() const { return bits; }
+
+    void write(std::ostream &out) const;
+    bool read(std::istream &in);
+
+private:
+    unsigned bits;
+    std::vector<uint8_t> registers;
+};
+
+/**
+ * @brief Count-Min sketch of item frequencies.
+ * Estimates never undercount; with probability 1 - delta they overcount by at most epsilon * total.
+ */
+class CountMinSketch {
+public:
+    /**
+     * @param epsilon Additive error as a fraction of the total count.
+     * @param delta Probability that the bound does not hold.
+     */
+    explicit CountMinSketch(double epsilon = 0.001, double delta = 0.01);
+
+    void add(uint64_t item, uint64_t count = 1);
+
+    /**
+     * @brief Folds other into this sketch. Both must have the same dimensions.
+     * @return False if the dimensions differ (nothing is merged).
+     */
+    bool merge(const CountMinSketch &other);
+
+    /**
+     * @brief Returns the estimated count of item with its error bound.
+     */
+    Estimate estimate(uint64_t item) const;
+
+    uint64_t total() const { return count_total; }
+
+    void write(std::ostream &out) const;
+    bool read(std::istream &in);
+
+private:
+    uint32_t width;
+    uint32_t depth;
+    double delta;
+    uint64_t count_total = 0;
+    std::vector<uint64_t> counters;
+};
+
+/**
+ * @brief Space-Saving heavy-hitter summary keeping at most capacity counters.
+ * Any item occurring more than total / capacity times is guaranteed to be kept.
+ */
+class SpaceSaving {
+public:
+    /**
+     * @brief A monitored item; its true count lies in [count - error, count].
+     */
+    struct Entry {
+        uint64_t item;
+        uint64_t count;
+        uint64_t error;
+    };
+
+    explicit SpaceSaving(size_t capacity = 256);
+
+    void add(uint64_t item, uint64_t count = 1);
+
+    /**
+     * @brief Folds other into this summary (counts of items missing on one side take that side's minimum as error).
+     */
+    void merge(const SpaceSaving &other);
+
+    /**
+     * @brief Returns up to k entries with the highest counts, largest first.
+     */
+    std::vector<Entry> top(size_t k) const;
+
+    void write(std::ostream &out) const;
+    bool read(std::istream &in);
+
+private:
+    void evict_to_capacity();
+
+    size_t capacity;
+    std::unordered_map<uint64_t, Entry> entries;
+};
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+
+#include "../utils.h"
+#include "ActivityIntervalIndex.h"
+
+ActivityIntervalIndex::~ActivityIntervalIndex() {
+    stop_refresh();
+}
+
+bool ActivityIntervalIndex::entry_less(const Entry &a, const Entry &b) {
+    return a.start != b.start ? a.start < b.start : a.act_id < b.act_id;
+}
+
+int ActivityIntervalIndex::fill_max_end(ClubTree &tree, size_t lo, size_t hi) {
+    if (lo >= hi)
+        return std::numeric_limits<int>::min();
+    size_t mid = lo + (hi - lo) / 2;
+    int max_end = std::max({tree.entries[mid].end, fill_max_end(tree, lo, mid), fill_max_end(tree, mid + 1, hi)});
+    tree.max_end[mid] = max_end;
+    return max_end;
+}
+
+void ActivityIntervalIndex::collect(const ClubTree &tree, DayWindow window, std::vector<int> &out) {
+    // Explicit stack of [lo, hi) subtrees; depth is bounded by log2(n).
+    std::pair<size_t, size_t> stack[64];
+    size_t top = 0;
+    stack[top++] = {0, tree.entries.size()};
+
+    while (top > 0) {
+        auto [lo, hi] = stack[--top];
+        if (lo >= hi)
+            continue;
+        size_t mid = lo + (hi - lo) / 2;
+        // Nothing below ends late enough to reach the window.
+        if (tree.max_end[mid] < window.from)
+            continue;
+
+        stack[top++] = {lo, mid};
+        const Entry &entry = tree.entries[mid];
+        // Entries from here to the right start after the window.
+        if (entry.start > window.to)
+            continue;
+        if (entry.end >= window.from)
+            out.push_back(entry.act_id);
+        stack[top++] = {mid + 1, hi};
+    }
+}
+
+void ActivityIntervalIndex::insert_entry(State &state, int act_id, int club_id, int start, int end) {
+    ClubTree &tree = state.clubs[club_id];
+    Entry entry{start, end, act_id};
+    auto position = std::lower_bound(tree.entries.begin(), tree.entries.end(), entry, entry_less);
+    tree.entries.insert(position, entry);
+    tree.max_end.resize(tree.entries.size());
+    fill_max_end(tree, 0, tree.entries.size());
+    state.location_of[act_id] = Location{club_id, start};
+}
+
+void ActivityIntervalIndex::remove_entry(State &state, int act_id) {
+    auto location = state.location_of.find(act_id);
+    if (location == state.location_of.end())
+        return;
+
+    auto club = state.clubs.find(location->second.club_id);
+    ClubTree &tree = club->second;
+    Entry key{location->second.start, 0, act_id};
+    auto position = std::lower_bound(tree.entries.begin(), tree.entries.end(), key, entry_less);
+    if (position != tree.entries.end() && position->act_id == act_id)
+        tree.entries.erase(position);
+    state.location_of.erase(location);
+
+    if (tree.entries.empty()) {
+        state.clubs.erase(club);
+    } else {
+        tree.max_end.resize(tree.entries.size());
+        fill_max_end(tree, 0, tree.entries.size());
+    }
+}
+
+bool ActivityIntervalIndex::build(std::shared_ptr<sql::Connection> conn) {
+    std::lock_guard<std::mutex> build_lock(build_mutex);
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        journal.clear();
+        journaling = true;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    State next;
+    size_t rows = 0;
+    try {
+        std::string query = "SELECT act_id, club_id, start_date, end_date FROM Activity "
+                            "WHERE pending_delete = 0 AND club_id IS NOT NULL";
+        std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query));
+        Logger(ll_info, "executeQuery: " + query).log();
+
+        next.location_of.reserve(res->rowsCount());
+        while (res->next()) {
+            std::optional<int> start = date_to_days(res->getString(3));
+            if (!start)
+                continue;
+            std::optional<int> end = res->isNull(4) ? open_end : date_to_days(res->getString(4));
+            int act_id = res->getInt(1);
+            int club_id = res->getInt(2);
+            next.clubs[club_id].entries.push_back(Entry{*start, end.value_or(open_end), act_id});
+            next.location_of[act_id] = Location{club_id, *start};
+            rows++;
+        }
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in ActivityIntervalIndex::build: " + std::string(e.what())).log();
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        journaling = false;
+        journal.clear();
+        return false;
+    }
+
+    for (auto &[club_id, tree] : next.clubs) {
+        std::sort(tree.entries.begin(), tree.entries.end(), entry_less);
+        tree.max_end.resize(tree.entries.size());
+        fill_max_end(tree, 0, tree.entries.size());
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        for (const Change &change : journal) {
+            remove_entry(next, change.act_id);
+            if (!change.erased)
+                insert_entry(next, change.act_id, change.club_id, change.start, change.end);
+        }
+        journal.clear();
+        journaling = false;
+        state = std::move(next);
+        built = true;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger(ll_info, "ActivityIntervalIndex: " + std::to_string(rows) + " activities indexed in " +
+                        std::to_string(elapsed.count()) + " ms")
+        .log();
+    return true;
+}
+
+void ActivityIntervalIndex::upsert(int act_id, int club_id, int start_day, int end_day) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    remove_entry(state, act_id);
+    insert_entry(state, act_id, club_id, start_day, end_day);
+    if (journaling)
+        journal.push_back(Change{act_id, false, club_id, start_day, end_day});
+}
+
+void ActivityIntervalIndex::erase(int act_id) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    remove_entry(state, act_id);
+    if (journaling)
+        journal.push_back(Change{act_id, true, 0, 0, 0});
+}
+
+void ActivityIntervalIndex::erase_club(int club_id) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto club = state.clubs.find(club_id);
+    if (club == state.clubs.end())
+        return;
+    for (const Entry &entry : club->second.entries) {
+        state.location_of.erase(entry.act_id);
+        if (journaling)
+            journal.push_back(Change{entry.act_id, true, 0, 0, 0});
+    }
+    state.clubs.erase(club);
+}
+
+void ActivityIntervalIndex::collect_all(DayWindow window, int club_id, std::vector<int> &out) const {
+    if (club_id != all_clubs) {
+        auto club = state.clubs.find(club_id);
+        if (club != state.clubs.end())
+            collect(club->second, window, out);
+    } else {
+        for (const auto &[id, tree] : state.clubs)
+            collect(tree, window, out);
+    }
+    std::sort(out.begin(), out.end());
+}
+
+std::vector<int> ActivityIntervalIndex::overlapping(DayWindow window, int club_id) const {
+    std::vector<int> ids;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    collect_all(window, club_id, ids);
+    return ids;
+}
+
+std::vector<std::vector<int>> ActivityIntervalIndex::overlapping_batch(std::span<const DayWindow> windows, int club_id) const {
+    std::vector<std::vector<int>> results(windows.size());
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (size_t i = 0; i < windows.size(); ++i)
+        collect_all(windows[i], club_id, results[i]);
+    return results;
+}
+
+bool ActivityIntervalIndex::ready() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return built;
+}
+
+size_t ActivityIntervalIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return state.location_of.size();
+}
+
+void ActivityIntervalIndex::start_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval) {
+    std::lock_guard<std::mutex> lock(refresh_mutex);
+    if (refresher.joinable())
+        return;
+    refresh_stopping = false;
+    refresher = std::thread(&ActivityIntervalIndex::run_refresh, this, conn, interval);
+}
+
+void ActivityIntervalIndex::stop_refresh() {
+    {
+        std::lock_guard<std::mutex> lock(refresh_mutex);
+        refresh_stopping = true;
+    }
+    refresh_wake.notify_all();
+    if (refresher.joinable())
+        refresher.join();
+}
+
+void ActivityIntervalIndex::run_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(refresh_mutex);
+            if (refresh_wake.wait_for(lock, interval, [this] { return refresh_stopping; }))
+                break;
+        }
+        build(conn);
+    }
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cppconn/connection.h>
+
+/**
+ * @brief A closed range of day numbers (see date_to_days).
+ */
+struct DayWindow {
+    int from;
+    int to;
+};
+
+/**
+ * @brief In-memory interval index over Activity periods, partitioned by club.
+ *
+ * Each club keeps its activities sorted by start day, laid out as an implicit balanced
+ * binary tree in which every node also stores the largest end day of its subtree. An
+ * overlap query descends only into subtrees that can still contain a match, so it costs
+ * O(log n + k) per club. A NULL end_date is treated as open-ended.
+ *
+ * The index is loaded from Activity, kept current by ActivityTable's write paths through
+ * upsert()/erase(), and optionally reloaded periodically to pick up writes made by other clients.
+ */
+class ActivityIntervalIndex {
+public:
+    /**
+     * @brief Matches every club in queries.
+     */
+    static constexpr int all_clubs = -1;
+
+    /**
+     * @brief Day number used for activities without an end date.
+     */
+    static constexpr int open_end = std::numeric_limits<int>::max();
+
+    /**
+     * @brief Above this many matches a window is not selective; callers should let the server evaluate it
+     * rather than bind every ID into one IN list.
+     */
+    static constexpr size_t max_selective_matches = 5000;
+
+    ActivityIntervalIndex() = default;
+
+    /**
+     * @brief Stops the refresh thread if it is running.
+     */
+    ~ActivityIntervalIndex();
+
+    ActivityIntervalIndex(const ActivityIntervalIndex &) = delete;
+    ActivityIntervalIndex &operator=(const ActivityIntervalIndex &) = delete;
+
+    /**
+     * @brief Reloads the index from Activity (rows pending deletion are skipped).
+     * @param conn The connection to scan with.
+     * @return True if the index was reloaded, false if the scan failed (the old index is kept).
+     */
+    bool build(std::shared_ptr<sql::Connection> conn);
+
+    /**
+     * @brief Records that an activity was created or its club or period changed.
+     * @param act_id The ID of the activity.
+     * @param club_id The club the activity belongs to.
+     * @param start_day First day of the activity.
+     * @param end_day Last day of the activity, or open_end.
+     */
+    void upsert(int act_id, int club_id, int start_day, int end_day);
+
+    /**
+     * @brief Records that an activity was deleted.
+     * @param act_id The ID of the activity.
+     */
+    void erase(int act_id);
+
+    /**
+     * @brief Records that a club and therefore all of its activities were deleted.
+     * @param club_id The ID of the club.
+     */
+    void erase_club(int club_id);
+
+    /**
+     * @brief Finds activities whose period overlaps window (both ends inclusive).
+     * @param window The days to look for.
+     * @param club_id The club to search, or all_clubs.
+     * @return Matching activity IDs in ascending order.
+     */
+    std::vector<int> overlapping(DayWindow window, int club_id = all_clubs) const;
+
+    /**
+     * @brief Answers several windows against one consistent state of the index, e.g. the days of a calendar view.
+     * @param windows The windows to look for.
+     * @param club_id The club to search, or all_clubs.
+     * @return For each window, the matching activity IDs in ascending order.
+     */
+    std::vector<std::vector<int>> overlapping_batch(std::span<const DayWindow> windows, int club_id = all_clubs) const;
+
+    /**
+     * @brief Returns whether build() has completed at least once.
+     */
+    bool ready() const;
+
+    /**
+     * @brief Returns the number of indexed activities.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Reloads the index on a background thread every interval.
+     * @param conn A connection used only by the refresh thread.
+     * @param interval Time between two reloads.
+     */
+    void start_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval);
+
+    /**
+     * @brief Stops the refresh thread.
+     */
+    void stop_refresh();
+
+private:
+    struct Entry {
+        int start;
+        int end;
+        int act_id;
+    };
+
+    /**
+     * @brief One club's activities sorted by (start, act_id); max_end[i] is the largest end
+     * in the subtree rooted at i, where the root of [lo, hi) is (lo + hi) / 2.
+     */
+    struct ClubTree {
+        std::vector<Entry> entries;
+        std::vector<int> max_end;
+    };
+
+    struct Location {
+        int club_id;
+        int start;
+    };
+
+    /**
+     * @brief A local write recorded while a build is scanning.
+     */
+    struct Change {
+        int act_id;
+        bool erased;
+        int club_id;
+        int start;
+        int end;
+    };
+
+    /**
+     * @brief Everything a build replaces at once.
+     */
+    struct State {
+        std::unordered_map<int, ClubTree> clubs;
+        std::unordered_map<int, Location> location_of;
+    };
+
+    static bool entry_less(const Entry &a, const Entry &b);
+    static int fill_max_end(ClubTree &tree, size_t lo, size_t hi);
+    static void collect(const ClubTree &tree, DayWindow window, std::vector<int> &out);
+    static void insert_entry(State &state, int act_id, int club_id, int start, int end);
+    static void remove_entry(State &state, int act_id);
+    void collect_all(DayWindow window, int club_id, std::vector<int> &out) const;
+    void run_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval);
+
+    /**
+     * @brief Guards state, built and the journal.
+     */
+    mutable std::shared_mutex mutex;
+    State state;
+    bool built = false;
+
+    /**
+     * @brief Serializes builds.
+     */
+    std::mutex build_mutex;
+
+    /**
+     * @brief Local writes since the running build started; replayed onto the new state before it is swapped in.
+     */
+    std::vector<Change> journal;
+    bool journaling = false;
+
+    std::mutex refresh_mutex;
+    std::condition_variable refresh_wake;
+    bool refresh_stopping = false;
+    std::thread refresher;
+};
@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+
+#include "../utils.h"
+#include "MembershipGraph.h"
+
+/**
+ * @brief Reads (owner, student) pairs and builds both adjacency directions at once.
+ */
+static void load_pairs(sql::ResultSet &res, std::unordered_map<int, RoaringBitmap> &owners,
+                       std::unordered_map<int, RoaringBitmap> &students) {
+    std::unordered_map<int, std::vector<uint32_t>> by_owner, by_student;
+    while (res.next()) {
+        int owner_id = res.getInt(1);
+        int student_id = res.getInt(2);
+        by_owner[owner_id].push_back(static_cast<uint32_t>(student_id));
+        by_student[student_id].push_back(static_cast<uint32_t>(owner_id));
+    }
+    for (auto &[id, values] : by_owner)
+        owners[id] = RoaringBitmap::from_values(std::move(values));
+    for (auto &[id, values] : by_student)
+        students[id] = RoaringBitmap::from_values(std::move(values));
+}
+
+MembershipGraph::~MembershipGraph() {
+    stop_refresh();
+}
+
+void MembershipGraph::link(std::unordered_map<int, RoaringBitmap> &owners, std::unordered_map<int, RoaringBitmap> &students,
+                           int owner_id, int student_id, bool added) {
+    if (added) {
+        owners[owner_id].add(static_cast<uint32_t>(student_id));
+        students[student_id].add(static_cast<uint32_t>(owner_id));
+        return;
+    }
+
+    auto owner = owners.find(owner_id);
+    if (owner != owners.end()) {
+        owner->second.remove(static_cast<uint32_t>(student_id));
+        if (owner->second.empty())
+            owners.erase(owner);
+    }
+    auto student = students.find(student_id);
+    if (student != students.end()) {
+        student->second.remove(static_cast<uint32_t>(owner_id));
+        if (student->second.empty())
+            students.erase(student);
+    }
+}
+
+void MembershipGraph::replace_owner(std::unordered_map<int, RoaringBitmap> &owners,
+                                    std::unordered_map<int, RoaringBitmap> &students, int owner_id,
+                                    const RoaringBitmap &roster) {
+    auto old = owners.find(owner_id);
+    if (old != owners.end()) {
+        for (uint32_t student_id : old->second.to_vector())
+            link(owners, students, owner_id, static_cast<int>(student_id), false);
+    }
+    for (uint32_t student_id : roster.to_vector())
+        link(owners, students, owner_id, static_cast<int>(student_id), true);
+}
+
+std::vector<int> MembershipGraph::to_ids(const RoaringBitmap &bitmap) {
+    std::vector<uint32_t> values = bitmap.to_vector();
+    return std::vector<int>(values.begin(), values.end());
+}
+
+const RoaringBitmap &MembershipGraph::roster(const std::unordered_map<int, RoaringBitmap> &map, int id) const {
+    static const RoaringBitmap empty;
+    auto it = map.find(id);
+    return it == map.end() ? empty : it->second;
+}
+
+bool MembershipGraph::build(std::shared_ptr<sql::Connection> conn) {
+    std::lock_guard<std::mutex> build_lock(build_mutex);
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        journal.clear();
+        journaling = true;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    Graph next;
+    try {
+        std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+        {
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT club_id, student_id FROM Club_Student"));
+            load_pairs(*res, next.club_students, next.student_clubs);
+        }
+        {
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT gathering_id, student_id FROM Gathering_Student"));
+            load_pairs(*res, next.gathering_students, next.student_gatherings);
+        }
+        {
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                "SELECT g.gathering_id, a.club_id FROM Gathering AS g JOIN Activity AS a ON a.act_id = g.act_id "
+                "WHERE a.pending_delete = 0"));
+            while (res->next())
+                next.gathering_club[res->getInt(1)] = res->getInt(2);
+        }
+        Logger(ll_info, "executeQuery: MembershipGraph scan of Club_Student, Gathering_Student, Gathering").log();
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in MembershipGraph::build: " + std::string(e.what())).log();
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        journaling = false;
+        journal.clear();
+        return false;
+    }
+
+    size_t clubs = next.club_students.size(), gatherings = next.gathering_students.size();
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        for (const Change &change : journal) {
+            if (change.club) {
+                link(next.club_students, next.student_clubs, change.owner_id, change.student_id, change.added);
+            } else {
+                link(next.gathering_students, next.student_gatherings, change.owner_id, change.student_id, change.added);
+            }
+        }
+        journal.clear();
+        journaling = false;
+        graph = std::move(next);
+        built = true;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger(ll_info, "MembershipGraph: " + std::to_string(clubs) + " clubs, " + std::to_string(gatherings) +
+                        " gatherings loaded in " + std::to_string(elapsed.count()) + " ms")
+        .log();
+    return true;
+}
+
+void MembershipGraph::record(bool club, bool added, int owner_id, int student_id) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (club) {
+        link(graph.club_students, graph.student_clubs, owner_id, student_id, added);
+    } else {
+        link(graph.gathering_students, graph.student_gatherings, owner_id, student_id, added);
+    }
+    if (journaling)
+        journal.push_back(Change{club, added, owner_id, student_id});
+}
+
+void MembershipGraph::add_member(int club_id, int student_id) {
+    record(true, true, club_id, student_id);
+}
+
+void MembershipGraph::remove_member(int club_id, int student_id) {
+    record(true, false, club_id, student_id);
+}
+
+void MembershipGraph::add_attendee(int gathering_id, int student_id) {
+    record(false, true, gathering_id, student_id);
+}
+
+void MembershipGraph::remove_attendee(int gathering_id, int student_id) {
+    record(false, false, gathering_id, student_id);
+}
+
+bool MembershipGraph::reload_club(std::shared_ptr<sql::Connection> conn, int club_id) {
+    // Waiting for a running build means the reloaded roster lands on top of it, not underneath.
+    std::lock_guard<std::mutex> build_lock(build_mutex);
+    try {
+        std::string query = "SELECT student_id FROM Club_Student WHERE club_id = ?";
+        std::unique_ptr<sql::PreparedStatement> pstmt(conn->prepareStatement(query));
+        pstmt->setInt(1, club_id);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        Logger(ll_info, "executeQuery: " + query).log();
+
+        std::vector<uint32_t> students;
+        while (res->next())
+            students.push_back(static_cast<uint32_t>(res->getInt(1)));
+        RoaringBitmap roster = RoaringBitmap::from_values(std::move(students));
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        replace_owner(graph.club_students, graph.student_clubs, club_id, roster);
+        return true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in MembershipGraph::reload_club: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+bool MembershipGraph::reload_gathering(std::shared_ptr<sql::Connection> conn, int gathering_id) {
+    std::lock_guard<std::mutex> build_lock(build_mutex);
+    try {
+        int club_id = -1;
+        {
+            std::string query = "SELECT a.club_id FROM Gathering AS g JOIN Activity AS a ON a.act_id = g.act_id "
+                                "WHERE g.gathering_id = ?";
+            std::unique_ptr<sql::PreparedStatement> pstmt(conn->prepareStatement(query));
+            pstmt->setInt(1, gathering_id);
+            std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+            if (res->next())
+                club_id = res->getInt(1);
+        }
+
+        std::string query = "SELECT student_id FROM Gathering_Student WHERE gathering_id = ?";
+        std::unique_ptr<sql::PreparedStatement> pstmt(conn->prepareStatement(query));
+        pstmt->setInt(1, gathering_id);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        Logger(ll_info, "executeQuery: " + query).log();
+
+        std::vector<uint32_t> students;
+        while (res->next())
+            students.push_back(static_cast<uint32_t>(res->getInt(1)));
+        RoaringBitmap roster = RoaringBitmap::from_values(std::move(students));
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        replace_owner(graph.gathering_students, graph.student_gatherings, gathering_id, roster);
+        if (club_id != -1) {
+            graph.gathering_club[gathering_id] = club_id;
+        } else {
+            graph.gathering_club.erase(gathering_id);
+        }
+        return true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in MembershipGraph::reload_gathering: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+void MembershipGraph::drop_club(int club_id) {
+    std::lock_guard<std::mutex> build_lock(build_mutex);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    replace_owner(graph.club_students, graph.student_clubs, club_id, RoaringBitmap());
+    for (auto it = graph.gathering_club.begin(); it != graph.gathering_club.end();) {
+        if (it->second == club_id) {
+            replace_owner(graph.gathering_students, graph.student_gatherings, it->first, RoaringBitmap());
+            it = graph.gathering_club.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool MembershipGraph::ready() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return built;
+}
+
+RoaringBitmap MembershipGraph::club_members(int club_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return roster(graph.club_students, club_id);
+}
+
+RoaringBitmap MembershipGraph::gathering_attendees(int gathering_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return roster(graph.gathering_students, gathering_id);
+}
+
+std::vector<int> MembershipGraph::common_members(int club_a, int club_b) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return to_ids(RoaringBitmap::intersect(roster(graph.club_students, club_a), roster(graph.club_students, club_b)));
+}
+
+uint64_t MembershipGraph::overlap_count(int club_a, int club_b) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return RoaringBitmap::intersect_cardinality(roster(graph.club_students, club_a), roster(graph.club_students, club_b));
+}
+
+std::vector<int> MembershipGraph::either_members(int club_a, int club_b) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return to_ids(RoaringBitmap::unite(roster(graph.club_students, club_a), roster(graph.club_students, club_b)));
+}
+
+std::vector<int> MembershipGraph::exclusive_members(int club_a, int club_b) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return to_ids(RoaringBitmap::difference(roster(graph.club_students, club_a), roster(graph.club_students, club_b)));
+}
+
+std::vector<int> MembershipGraph::members_without_gathering(int club_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    RoaringBitmap attended;
+    for (const auto &[gathering_id, owner] : graph.gathering_club) {
+        if (owner == club_id)
+            attended.unite_with(roster(graph.gathering_students, gathering_id));
+    }
+    return to_ids(RoaringBitmap::difference(roster(graph.club_students, club_id), attended));
+}
+
+std::vector<int> MembershipGraph::students_in_clubs(size_t min_clubs) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<int> students;
+    for (const auto &[student_id, clubs] : graph.student_clubs) {
+        if (clubs.cardinality() >= min_clubs)
+            students.push_back(student_id);
+    }
+    std::sort(students.begin(), students.end());
+    return students;
+}
+
+std::vector<std::pair<int, uint64_t>> MembershipGraph::top_overlaps(int club_id, size_t k) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const RoaringBitmap &members = roster(graph.club_students, club_id);
+    std::vector<std::pair<int, uint64_t>> overlaps;
+    for (const auto &[other_id, other] : graph.club_students) {
+        if (other_id == club_id)
+            continue;
+        uint64_t shared = RoaringBitmap::intersect_cardinality(members, other);
+        if (shared > 0)
+            overlaps.emplace_back(other_id, shared);
+    }
+
+    auto larger = [](const auto &a, const auto &b) { return a.second != b.second ? a.second > b.second : a.first < b.first; };
+    if (k < overlaps.size()) {
+        std::partial_sort(overlaps.begin(), overlaps.begin() + static_cast<std::ptrdiff_t>(k), overlaps.end(), larger);
+        overlaps.resize(k);
+    } else {
+        std::sort(overlaps.begin(), overlaps.end(), larger);
+    }
+    return overlaps;
+}
+
+std::vector<int> MembershipGraph::clubs_of(int student_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return to_ids(roster(graph.student_clubs, student_id));
+}
+
+std::vector<int> MembershipGraph::gatherings_of(int student_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return to_ids(roster(graph.student_gatherings, student_id));
+}
+
+std::vector<int> MembershipGraph::co_members(int student_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    RoaringBitmap peers;
+    for (uint32_t club_id : roster(graph.student_clubs, student_id).to_vector())
+        peers.unite_with(roster(graph.club_students, static_cast<int>(club_id)));
+    peers.remove(static_cast<uint32_t>(student_id));
+    return to_ids(peers);
+}
+
+void MembershipGraph::start_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval) {
+    std::lock_guard<std::mutex> lock(refresh_mutex);
+    if (refresher.joinable())
+        return;
+    refresh_stopping = false;
+    refresher = std::thread(&MembershipGraph::run_refresh, this, conn, interval);
+}
+
+void MembershipGraph::stop_refresh() {
+    {
+        std::lock_guard<std::mutex> lock(refresh_mutex);
+        refresh_stopping = true;
+    }
+    refresh_wake.notify_all();
+    if (refresher.joinable())
+        refresher.join();
+}
+
+void MembershipGraph::run_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(refresh_mutex);
+            if (refresh_wake.wait_for(lock, interval, [this] { return refresh_stopping; }))
+                break;
+        }
+        build(conn);
+    }
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+
+#include "RoaringBitmap.h"
+
+/**
+ * @brief In-memory bipartite graph of students and the clubs/gatherings they belong to.
+ *
+ * Every club and gathering keeps its students as a RoaringBitmap, and every student keeps
+ * the clubs and gatherings they belong to, so rosters can be compared with bitmap
+ * intersection, union and difference instead of joins over Club_Student and Gathering_Student.
+ *
+ * The graph is built from both tables, kept current by ClubTable/GatheringTable writes, and
+ * optionally rebuilt periodically to pick up writes made by other clients.
+ */
+class MembershipGraph {
+public:
+    MembershipGraph() = default;
+
+    /**
+     * @brief Stops the refresh thread if it is running.
+     */
+    ~MembershipGraph();
+
+    MembershipGraph(const MembershipGraph &) = delete;
+    MembershipGraph &operator=(const MembershipGraph &) = delete;
+
+    /**
+     * @brief Rebuilds the graph from Club_Student, Gathering_Student and Gathering.
+     * Local writes made while the scan runs are replayed onto the new graph before it is swapped in.
+     * @param conn The connection to scan with.
+     * @return True if the graph was rebuilt, false if the scan failed (the old graph is kept).
+     */
+    bool build(std::shared_ptr<sql::Connection> conn);
+
+    /**
+     * @brief Records that a student joined a club.
+     */
+    void add_member(int club_id, int student_id);
+
+    /**
+     * @brief Records that a student left a club.
+     */
+    void remove_member(int club_id, int student_id);
+
+    /**
+     * @brief Records that a student joined a gathering.
+     */
+    void add_attendee(int gathering_id, int student_id);
+
+    /**
+     * @brief Records that a student left a gathering.
+     */
+    void remove_attendee(int gathering_id, int student_id);
+
+    /**
+     * @brief Re-reads one club's roster after a set-based change.
+     * @param conn The connection to read with.
+     * @param club_id The ID of the club.
+     * @return True on success.
+     */
+    bool reload_club(std::shared_ptr<sql::Connection> conn, int club_id);
+
+    /**
+     * @brief Re-reads one gathering's attendees (and owning club) after a set-based change.
+     * @param conn The connection to read with.
+     * @param gathering_id The ID of the gathering.
+     * @return True on success.
+     */
+    bool reload_gathering(std::shared_ptr<sql::Connection> conn, int gathering_id);
+
+    /**
+     * @brief Records that a club was deleted, with its memberships and its gatherings.
+     */
+    void drop_club(int club_id);
+
+    /**
+     * @brief Returns whether build() has completed at least once.
+     */
+    bool ready() const;
+
+    /**
+     * @brief Returns the students of a club.
+     */
+    RoaringBitmap club_members(int club_id) const;
+
+    /**
+     * @brief Returns the students of a gathering.
+     */
+    RoaringBitmap gathering_attendees(int gathering_id) const;
+
+    /**
+     * @brief Returns students who are members of both clubs, in ascending order.
+     */
+    std::vector<int> common_members(int club_a, int club_b) const;
+
+    /**
+     * @brief Returns the number of students who are members of both clubs.
+     */
+    uint64_t overlap_count(int club_a, int club_b) const;
+
+    /**
+     * @brief Returns students who are members of either club, in ascending order.
+     */
+    std::vector<int> either_members(int club_a, int club_b) const;
+
+    /**
+     * @brief Returns members of club_a who are not members of club_b, in ascending order.
+     */
+    std::vector<int> exclusive_members(int club_a, int club_b) const;
+
+    /**
+     * @brief Returns members of a club who attend none of that club's gatherings, in ascending order.
+     */
+    std::vector<int> members_without_gathering(int club_id) const;
+
+    /**
+     * @brief Returns students who are members of at least min_clubs clubs, in ascending order.
+     */
+    std::vector<int> students_in_clubs(size_t min_clubs) const;
+
+    /**
+     * @brief Returns the k clubs sharing the most members with club_id.
+     * @return (club_id, shared members) pairs, largest first; clubs sharing nobody are omitted.
+     */
+    std::vector<std::pair<int, uint64_t>> top_overlaps(int club_id, size_t k) const;
+
+    /**
+     * @brief Returns the clubs a student belongs to, in ascending order.
+     */
+    std::vector<int> clubs_of(int student_id) const;
+
+    /**
+     * @brief Returns the gatherings a student attends, in ascending order.
+     */
+    std::vector<int> gatherings_of(int student_id) const;
+
+    /**
+     * @brief Returns students sharing at least one club with student_id (excluding the student), in ascending order.
+     */
+    std::vector<int> co_members(int student_id) const;
+
+    /**
+     * @brief Rebuilds the graph on a background thread every interval.
+     * @param conn A connection used only by the refresh thread.
+     * @param interval Time between two rebuilds.
+     */
+    void start_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval);
+
+    /**
+     * @brief Stops the refresh thread.
+     */
+    void stop_refresh();
+
+private:
+    /**
+     * @brief Both directions of both memberships, plus which club owns each gathering.
+     */
+    struct Graph {
+        std::unordered_map<int, RoaringBitmap> club_students;
+        std::unordered_map<int, RoaringBitmap> gathering_students;
+        std::unordered_map<int, RoaringBitmap> student_clubs;
+        std::unordered_map<int, RoaringBitmap> student_gatherings;
+        std::unordered_map<int, int> gathering_club;
+    };
+
+    /**
+     * @brief A local write recorded while a build is scanning.
+     */
+    struct Change {
+        bool club;
+        bool added;
+        int owner_id;
+        int student_id;
+    };
+
+    static void link(std::unordered_map<int, RoaringBitmap> &owners, std::unordered_map<int, RoaringBitmap> &students,
+                     int owner_id, int student_id, bool added);
+    static void replace_owner(std::unordered_map<int, RoaringBitmap> &owners,
+                              std::unordered_map<int, RoaringBitmap> &students, int owner_id, const RoaringBitmap &roster);
+    static std::vector<int> to_ids(const RoaringBitmap &bitmap);
+    const RoaringBitmap &roster(const std::unordered_map<int, RoaringBitmap> &map, int id) const;
+    void record(bool club, bool added, int owner_id, int student_id);
+    void run_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval);
+
+    /**
+     * @brief Guards graph, built and the journal.
+     */
+    mutable std::shared_mutex mutex;
+    Graph graph;
+    bool built = false;
+
+    /**
+     * @brief Serializes builds.
+     */
+    std::mutex build_mutex;
+    std::vector<Change> journal;
+    bool journaling = false;
+
+    std::mutex refresh_mutex;
+    std::condition_variable refresh_wake;
+    bool refresh_stopping = false;
+    std::thread refresher;
+};
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "RoaringBitmap.h"
+
+/**
+ * @brief 64-bit words of a bitmap container.
+ */
+static constexpr size_t bitmap_words = 65536 / 64;
+
+static inline uint16_t high_bits(uint32_t value) { return static_cast<uint16_t>(value >> 16); }
+static inline uint16_t low_bits(uint32_t value) { return static_cast<uint16_t>(value & 0xFFFF); }
+
+void RoaringBitmap::to_bitmap(Container &container) {
+    container.bits.assign(bitmap_words, 0);
+    for (uint16_t low : container.array)
+        container.bits[low >> 6] |= uint64_t{1} << (low & 63);
+    container.array.clear();
+    container.array.shrink_to_fit();
+    container.is_bitmap = true;
+}
+
+void RoaringBitmap::to_array(Container &container) {
+    container.array.clear();
+    container.array.reserve(container.cardinality);
+    for (size_t word = 0; word < bitmap_words; ++word) {
+        uint64_t bits = container.bits[word];
+        while (bits != 0) {
+            container.array.push_back(static_cast<uint16_t>(word * 64 + static_cast<size_t>(std::countr_zero(bits))));
+            bits &= bits - 1;
+        }
+    }
+    container.bits.clear();
+    container.bits.shrink_to_fit();
+    container.is_bitmap = false;
+}
+
+void RoaringBitmap::normalize(Container &container) {
+    if (container.is_bitmap && container.cardinality <= array_limit) {
+        to_array(container);
+    } else if (!container.is_bitmap && container.cardinality > array_limit) {
+        to_bitmap(container);
+    }
+}
+
+bool RoaringBitmap::contains(const Container &container, uint16_t low) {
+    if (container.is_bitmap)
+        return (container.bits[low >> 6] >> (low & 63)) & 1;
+    return std::binary_search(container.array.begin(), container.array.end(), low);
+}
+
+RoaringBitmap::Container *RoaringBitmap::find(uint16_t key) {
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [](const Container &c, uint16_t k) { return c.key < k; });
+    return it != containers.end() && it->key == key ? &*it : nullptr;
+}
+
+const RoaringBitmap::Container *RoaringBitmap::find(uint16_t key) const {
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [](const Container &c, uint16_t k) { return c.key < k; });
+    return it != containers.end() && it->key == key ? &*it : nullptr;
+}
+
+bool RoaringBitmap::add(uint32_t value) {
+    uint16_t key = high_bits(value), low = low_bits(value);
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [](const Container &c, uint16_t k) { return c.key < k; });
+    if (it == containers.end() || it->key != key) {
+        Container container;
+        container.key = key;
+        it = containers.insert(it, std::move(container));
+    }
+
+    Container &container = *it;
+    if (container.is_bitmap) {
+        uint64_t &word = container.bits[low >> 6];
+        uint64_t bit = uint64_t{1} << (low & 63);
+        if (word & bit)
+            return false;
+        word |= bit;
+    } else {
+        auto position = std::lower_bound(container.array.begin(), container.array.end(), low);
+        if (position != container.array.end() && *position == low)
+            return false;
+        container.array.insert(position, low);
+    }
+    container.cardinality++;
+    normalize(container);
+    return true;
+}
+
+bool RoaringBitmap::remove(uint32_t value) {
+    uint16_t key = high_bits(value), low = low_bits(value);
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [](const Container &c, uint16_t k) { return c.key < k; });
+    if (it == containers.end() || it->key != key)
+        return false;
+
+    Container &container = *it;
+    if (container.is_bitmap) {
+        uint64_t &word = container.bits[low >> 6];
+        uint64_t bit = uint64_t{1} << (low & 63);
+        if (!(word & bit))
+            return false;
+        word &= ~bit;
+    } else {
+        auto position = std::lower_bound(container.array.begin(), container.array.end(), low);
+        if (position == container.array.end() || *position != low)
+            return false;
+        container.array.erase(position);
+    }
+    container.cardinality--;
+    if (container.cardinality == 0) {
+        containers.erase(it);
+    } else {
+        normalize(container);
+    }
+    return true;
+}
+
+bool RoaringBitmap::contains(uint32_t value) const {
+    const Container *container = find(high_bits(value));
+    return container != nullptr && contains(*container, low_bits(value));
+}
+
+uint64_t RoaringBitmap::cardinality() const {
+    uint64_t total = 0;
+    for (const Container &container : containers)
+        total += container.cardinality;
+    return total;
+}
+
+std::vector<uint32_t> RoaringBitmap::to_vector() const {
+    std::vector<uint32_t> values;
+    values.reserve(cardinality());
+    for (const Container &container : containers) {
+        uint32_t base = static_cast<uint32_t>(container.key) << 16;
+        if (container.is_bitmap) {
+            for (size_t word = 0; word < bitmap_words; ++word) {
+                uint64_t bits = container.bits[word];
+                while (bits != 0) {
+                    values.push_back(base | static_cast<uint32_t>(word * 64 + static_cast<size_t>(std::countr_zero(bits))));
+                    bits &= bits - 1;
+                }
+            }
+        } else {
+            for (uint16_t low : container.array)
+                values.push_back(base | low);
+        }
+    }
+    return values;
+}
+
+RoaringBitmap RoaringBitmap::from_values(std::vector<uint32_t> values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    RoaringBitmap bitmap;
+    for (size_t begin = 0; begin < values.size();) {
+        uint16_t key = high_bits(values[begin]);
+        size_t end = begin;
+        while (end < values.size() && high_bits(values[end]) == key)
+            ++end;
+
+        Container container;
+        container.key = key;
+        container.cardinality = static_cast<uint32_t>(end - begin);
+        container.array.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i)
+            container.array.push_back(low_bits(values[i]));
+        normalize(container);
+        bitmap.containers.push_back(std::move(container));
+        begin = end;
+    }
+    return bitmap;
+}
+
+RoaringBitmap::Container RoaringBitmap::intersect(const Container &a, const Container &b) {
+    Container result;
+    result.key = a.key;
+    if (a.is_bitmap && b.is_bitmap) {
+        result.is_bitmap = true;
+        result.bits.resize(bitmap_words);
+        for (size_t word = 0; word < bitmap_words; ++word) {
+            result.bits[word] = a.bits[word] & b.bits[word];
+            result.cardinality += static_cast<uint32_t>(std::popcount(result.bits[word]));
+        }
+        normalize(result);
+    } else if (a.is_bitmap || b.is_bitmap) {
+        const Container &array = a.is_bitmap ? b : a;
+        const Container &bitmap = a.is_bitmap ? a : b;
+        for (uint16_t low : array.array) {
+            if ((bitmap.bits[low >> 6] >> (low & 63)) & 1)
+                result.array.push_back(low);
+        }
+        result.cardinality = static_cast<uint32_t>(result.array.size());
+    } else {
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(result.array));
+        result.cardinality = static_cast<uint32_t>(result.array.size());
+    }
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::unite(const Container &a, const Container &b) {
+    Container result;
+    result.key = a.key;
+    if (!a.is_bitmap && !b.is_bitmap) {
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), std::back_inserter(result.array));
+        result.cardinality = static_cast<uint32_t>(result.array.size());
+        normalize(result);
+        return result;
+    }
+
+    result.is_bitmap = true;
+    const Container &bitmap = a.is_bitmap ? a : b;
+    const Container &other = a.is_bitmap ? b : a;
+    result.bits = bitmap.bits;
+    if (other.is_bitmap) {
+        for (size_t word = 0; word < bitmap_words; ++word)
+            result.bits[word] |= other.bits[word];
+    } else {
+        for (uint16_t low : other.array)
+            result.bits[low >> 6] |= uint64_t{1} << (low & 63);
+    }
+    for (uint64_t word : result.bits)
+        result.cardinality += static_cast<uint32_t>(std::popcount(word));
+    return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::difference(const Container &a, const Container &b) {
+    Container result;
+    result.key = a.key;
+    if (!a.is_bitmap) {
+        for (uint16_t low : a.array) {
+            if (!contains(b, low))
+                result.array.push_back(low);
+        }
+        result.cardinality = static_cast<uint32_t>(result.array.size());
+        return result;
+    }
+
+    result.is_bitmap = true;
+    result.bits = a.bits;
+    if (b.is_bitmap) {
+        for (size_t word = 0; word < bitmap_words; ++word)
+            result.bits[word] &= ~b.bits[word];
+    } else {
+        for (uint16_t low : b.array)
+            result.bits[low >> 6] &= ~(uint64_t{1} << (low & 63));
+    }
+    for (uint64_t word : result.bits)
+        result.cardinality += static_cast<uint32_t>(std::popcount(word));
+    normalize(result);
+    return result;
+}
+
+uint32_t RoaringBitmap::intersect_cardinality(const Container &a, const Container &b) {
+    uint32_t count = 0;
+    if (a.is_bitmap && b.is_bitmap) {
+        for (size_t word = 0; word < bitmap_words; ++word)
+            count += static_cast<uint32_t>(std::popcount(a.bits[word] & b.bits[word]));
+    } else if (a.is_bitmap || b.is_bitmap) {
+        const Container &array = a.is_bitmap ? b : a;
+        const Container &bitmap = a.is_bitmap ? a : b;
+        for (uint16_t low : array.array)
+            count += (bitmap.bits[low >> 6] >> (low & 63)) & 1;
+    } else {
+        auto i = a.array.begin(), j = b.array.begin();
+        while (i != a.array.end() && j != b.array.end()) {
+            if (*i < *j) {
+                ++i;
+            } else if (*j < *i) {
+                ++j;
+            } else {
+                ++count;
+                ++i;
+                ++j;
+            }
+        }
+    }
+    return count;
+}
+
+RoaringBitmap RoaringBitmap::intersect(const RoaringBitmap &a, const RoaringBitmap &b) {
+    RoaringBitmap result;
+    size_t i = 0, j = 0;
+    while (i < a.containers.size() && j < b.containers.size()) {
+        if (a.containers[i].key < b.containers[j].key) {
+            ++i;
+        } else if (b.containers[j].key < a.containers[i].key) {
+            ++j;
+        } else {
+            Container container = intersect(a.containers[i++], b.containers[j++]);
+            if (container.cardinality > 0)
+                result.containers.push_back(std::move(container));
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::unite(const RoaringBitmap &a, const RoaringBitmap &b) {
+    RoaringBitmap result;
+    size_t i = 0, j = 0;
+    while (i < a.containers.size() || j < b.containers.size()) {
+        if (j == b.containers.size() || (i < a.containers.size() && a.containers[i].key < b.containers[j].key)) {
+            result.containers.push_back(a.containers[i++]);
+        } else if (i == a.containers.size() || b.containers[j].key < a.containers[i].key) {
+            result.containers.push_back(b.containers[j++]);
+        } else {
+            result.containers.push_back(unite(a.containers[i++], b.containers[j++]));
+        }
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::difference(const RoaringBitmap &a, const RoaringBitmap &b) {
+    RoaringBitmap result;
+    size_t j = 0;
+    for (const Container &container : a.containers) {
+        while (j < b.containers.size() && b.containers[j].key < container.key)
+            ++j;
+        if (j == b.containers.size() || b.containers[j].key != container.key) {
+            result.containers.push_back(container);
+            continue;
+        }
+        Container remaining = difference(container, b.containers[j]);
+        if (remaining.cardinality > 0)
+            result.containers.push_back(std::move(remaining));
+    }
+    return result;
+}
+
+uint64_t RoaringBitmap::intersect_cardinality(const RoaringBitmap &a, const RoaringBitmap &b) {
+    uint64_t count = 0;
+    size_t i = 0, j = 0;
+    while (i < a.containers.size() && j < b.containers.size()) {
+        if (a.containers[i].key < b.containers[j].key) {
+            ++i;
+        } else if (b.containers[j].key < a.containers[i].key) {
+            ++j;
+        } else {
+            count += intersect_cardinality(a.containers[i++], b.containers[j++]);
+        }
+    }
+    return count;
+}
+
+void RoaringBitmap::unite_with(const RoaringBitmap &other) {
+    if (containers.empty()) {
+        containers = other.containers;
+        return;
+    }
+    *this = unite(*this, other);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Compressed set of 32-bit integers in the style of Roaring bitmaps.
+ *
+ * Values are split by their high 16 bits into containers. A container holds its low
+ * 16 bits either as a sorted array (up to array_limit values) or as a 65536-bit bitmap,
+ * whichever is smaller, so sparse and dense sets both stay compact and set operations
+ * work container by container on sorted arrays or 64-bit words.
+ */
+class RoaringBitmap {
+public:
+    /**
+     * @brief Containers with more values than this switch to the bitmap form.
+     */
+    static constexpr size_t array_limit = 4096;
+
+    /**
+     * @brief Adds value. Returns true if it was not present.
+     */
+    bool add(uint32_t value);
+
+    /**
+     * @brief Removes value. Returns true if it was present.
+     */
+    bool remove(uint32_t value);
+
+    /**
+     * @brief Returns whether value is present.
+     */
+    bool contains(uint32_t value) const;
+
+    /**
+     * @brief Returns the number of values.
+     */
+    uint64_t cardinality() const;
+
+    /**
+     * @brief Returns whether the set is empty.
+     */
+    bool empty() const { return containers.empty(); }
+
+    /**
+     * @brief Returns the values in ascending order.
+     */
+    std::vector<uint32_t> to_vector() const;
+
+    /**
+     * @brief Builds a bitmap from values in any order.
+     */
+    static RoaringBitmap from_values(std::vector<uint32_t> values);
+
+    /**
+     * @brief Returns the intersection of a and b.
+     */
+    static RoaringBitmap intersect(const RoaringBitmap &a, const RoaringBitmap &b);
+
+    /**
+     * @brief Returns the union of a and b.
+     */
+    static RoaringBitmap unite(const RoaringBitmap &a, const RoaringBitmap &b);
+
+    /**
+     * @brief Returns the values of a that are not in b.
+     */
+    static RoaringBitmap difference(const RoaringBitmap &a, const RoaringBitmap &b);
+
+    /**
+     * @brief Returns the size of the intersection of a and b without building it.
+     */
+    static uint64_t intersect_cardinality(const RoaringBitmap &a, const RoaringBitmap &b);
+
+    /**
+     * @brief Adds every value of other to this set.
+     */
+    void unite_with(const RoaringBitmap &other);
+
+private:
+    struct Container {
+        uint16_t key = 0;
+        bool is_bitmap = false;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> array;
+        std::vector<uint64_t> bits;
+    };
+
+    static void to_bitmap(Container &container);
+    static void to_array(Container &container);
+    static void normalize(Container &container);
+    static Container intersect(const Container &a, const Container &b);
+    static Container unite(const Container &a, const Container &b);
+    static Container difference(const Container &a, const Container &b);
+    static uint32_t intersect_cardinality(const Container &a, const Container &b);
+    static bool contains(const Container &container, uint16_t low);
+
+    Container *find(uint16_t key);
+    const Container *find(uint16_t key) const;
+
+    /**
+     * @brief Containers sorted by key; empty containers are removed.
+     */
+    std::vector<Container> containers;
+};
@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+
+#include "../utils.h"
+#include "TrigramIndex.h"
+
+/**
+ * @brief Packs the three bytes starting at text[i] into one gram key.
+ */
+static inline uint32_t gram_at(const std::string &text, size_t i) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(text[i + 2]));
+}
+
+TrigramIndex::TrigramIndex(std::string table, std::string id_column, std::string text_column)
+    : table(table), id_column(id_column), text_column(text_column), snapshot(std::make_unique<Snapshot>()) {
+    snapshot->shards.resize(1);
+}
+
+TrigramIndex::~TrigramIndex() {
+    stop_refresh();
+}
+
+/**
+ * @brief What U+00C0..U+017F compare equal to under the tables' accent- and case-insensitive
+ * collation (utf8mb4_0900_ai_ci), e.g. "É" to "e" and "ß" to "ss"; nullptr for letters that are
+ * not plain variants of ASCII there (Ð, Ø, Þ, ı, Ł, ...) and for × and ÷.
+ */
+static const char *const latin_folds[] = {
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    nullptr, "n", "o", "o", "o", "o", "o", nullptr, nullptr, "u", "u", "u", "u", "y", nullptr, "ss",
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    nullptr, "n", "o", "o", "o", "o", "o", nullptr, nullptr, "u", "u", "u", "u", "y", nullptr, "y",
+    "a", "a", "a", "a", "a", "a", "c", "c", "c", "c", "c", "c", "c", "c", "d", "d",
+    nullptr, nullptr, "e", "e", "e", "e", "e", "e", "e", "e", "e", "e", "g", "g", "g", "g",
+    "g", "g", "g", "g", "h", "h", nullptr, nullptr, "i", "i", "i", "i", "i", "i", "i", "i",
+    "i", nullptr, "ij", "ij", "j", "j", "k", "k", nullptr, "l", "l", "l", "l", "l", "l", nullptr,
+    nullptr, nullptr, nullptr, "n", "n", "n", "n", "n", "n", nullptr, nullptr, nullptr, "o", "o", "o", "o",
+    "o", "o", "oe", "oe", "r", "r", "r", "r", "r", "r", "s", "s", "s", "s", "s", "s",
+    "s", "s", "t", "t", "t", "t", nullptr, nullptr, "u", "u", "u", "u", "u", "u", "u", "u",
+    "u", "u", "u", "u", "w", "w", "y", "y", "y", "z", "z", "z", "z", "z", "z", "s",
+};
+
+/**
+ * @brief Decodes the UTF-8 sequence at text[i]. An invalid or truncated sequence consumes one byte.
+ * @param cp Set to the code point, or U+FFFD for an invalid sequence.
+ * @return Number of bytes consumed.
+ */
+static size_t decode_utf8(const std::string &text, size_t i, uint32_t &cp) {
+    unsigned char lead = static_cast<unsigned char>(text[i]);
+    size_t length = lead < 0x80 ? 1 : lead >= 0xF8 ? 0 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+    if (length == 0 || i + length > text.size()) {
+        cp = 0xFFFD;
+        return 1;
+    }
+    cp = length == 1 ? lead : lead & (0x7F >> length);
+    for (size_t k = 1; k < length; ++k) {
+        unsigned char byte = static_cast<unsigned char>(text[i + k]);
+        if ((byte & 0xC0) != 0x80) {
+            cp = 0xFFFD;
+            return 1;
+        }
+        cp = (cp << 6) | (byte & 0x3F);
+    }
+    return length;
+}
+
+bool TrigramIndex::fold_into(const std::string &text, std::string &folded) {
+    bool exact = true;
+    folded.reserve(folded.size() + text.size());
+    for (size_t i = 0; i < text.size();) {
+        uint32_t cp;
+        size_t length = decode_utf8(text, i, cp);
+        if (cp < 0x80) {
+            folded += static_cast<char>(cp >= 'A' && cp <= 'Z' ? cp - 'A' + 'a' : cp);
+        } else if (cp >= 0xC0 && cp < 0x180 && latin_folds[cp - 0xC0]) {
+            folded += latin_folds[cp - 0xC0];
+        } else if (cp >= 0xFF01 && cp <= 0xFF5E) {
+            // Full-width forms compare equal to their ASCII counterparts.
+            uint32_t ascii = cp - 0xFF01 + 0x21;
+            folded += static_cast<char>(ascii >= 'A' && ascii <= 'Z' ? ascii - 'A' + 'a' : ascii);
+        } else if (cp == 0x3000) {
+            folded += ' ';
+        } else if (cp >= 0x0300 && cp <= 0x036F) {
+            // Combining accents are ignored by the collation.
+        } else {
+            // Hangul syllables have no case or accent variants and compare byte for byte.
+            folded.append(text, i, length);
+            exact = exact && cp >= 0xAC00 && cp <= 0xD7A3;
+        }
+        i += length;
+    }
+    return exact;
+}
+
+std::string TrigramIndex::fold(const std::string &text) {
+    std::string folded;
+    fold_into(text, folded);
+    return folded;
+}
+
+bool TrigramIndex::covers(const std::string &pattern) {
+    std::string folded;
+    return is_literal(pattern) && fold_into(pattern, folded);
+}
+
+void TrigramIndex::add_slot(Snapshot &snapshot, int id, const std::string &folded) {
+    uint32_t slot = static_cast<uint32_t>(snapshot.ids.size());
+    snapshot.ids.push_back(id);
+    snapshot.texts.push_back(folded);
+    snapshot.live.push_back(true);
+    snapshot.slot_of[id] = slot;
+    snapshot.live_count++;
+
+    size_t shard_count = snapshot.shards.size();
+    for (size_t i = 0; i + 3 <= folded.size(); ++i) {
+        uint32_t gram = gram_at(folded, i);
+        auto &postings = snapshot.shards[gram % shard_count][gram];
+        // New slots are always the largest, so appending keeps the list sorted.
+        if (postings.empty() || postings.back() != slot)
+            postings.push_back(slot);
+    }
+}
+
+void TrigramIndex::erase_slot(Snapshot &snapshot, int id) {
+    auto it = snapshot.slot_of.find(id);
+    if (it == snapshot.slot_of.end())
+        return;
+    snapshot.live[it->second] = false;
+    snapshot.live_count--;
+    snapshot.slot_of.erase(it);
+}
+
+bool TrigramIndex::build(std::shared_ptr<sql::Connection> conn, unsigned threads) {
+    std::lock_guard<std::mutex> build_lock(build_mutex);
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        journal.clear();
+        journaling = true;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    auto next = std::make_unique<Snapshot>();
+    try {
+        std::string query = "SELECT " + id_column + ", " + text_column + " FROM " + table;
+        std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query));
+        Logger(ll_info, "executeQuery: " + query).log();
+
+        next->ids.reserve(res->rowsCount());
+        next->texts.reserve(res->rowsCount());
+        while (res->next()) {
+            next->ids.push_back(res->getInt(1));
+            std::string text = res->getString(2);
+            next->texts.push_back(fold(text));
+        }
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in TrigramIndex::build: " + std::string(e.what())).log();
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        journaling = false;
+        journal.clear();
+        return false;
+    }
+
+    size_t rows = next->ids.size();
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, rows / 4096)));
+    if (threads == 0)
+        threads = 1;
+
+    // Phase 1: each thread indexes a contiguous slot range into its own shard maps.
+    std::vector<std::vector<PostingShard>> local(threads, std::vector<PostingShard>(threads));
+    {
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                size_t begin = rows * t / threads;
+                size_t end = rows * (t + 1) / threads;
+                for (size_t slot = begin; slot < end; ++slot) {
+                    const std::string &text = next->texts[slot];
+                    for (size_t i = 0; i + 3 <= text.size(); ++i) {
+                        uint32_t gram = gram_at(text, i);
+                        auto &postings = local[t][gram % threads][gram];
+                        if (postings.empty() || postings.back() != slot)
+                            postings.push_back(static_cast<uint32_t>(slot));
+                    }
+                }
+            });
+        }
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    // Phase 2: each thread merges one shard; slot ranges ascend with t, so concatenation stays sorted.
+    next->shards.resize(threads);
+    {
+        std::vector<std::thread> workers;
+        for (unsigned s = 0; s < threads; ++s) {
+            workers.emplace_back([&, s] {
+                PostingShard &shard = next->shards[s];
+                for (unsigned t = 0; t < threads; ++t) {
+                    for (auto &[gram, postings] : local[t][s]) {
+                        auto &merged = shard[gram];
+                        if (merged.empty()) {
+                            merged = std::move(postings);
+                        } else {
+                            merged.insert(merged.end(), postings.begin(), postings.end());
+                        }
+                    }
+                    local[t][s].clear();
+                }
+            });
+        }
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    next->live.assign(rows, true);
+    next->slot_of.reserve(rows);
+    for (size_t slot = 0; slot < rows; ++slot)
+        next->slot_of[next->ids[slot]] = static_cast<uint32_t>(slot);
+    next->live_count = rows;
+
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        for (const auto &[id, text] : journal) {
+            erase_slot(*next, id);
+            if (text)
+                add_slot(*next, id, fold(*text));
+        }
+        journal.clear();
+        journaling = false;
+        snapshot = std::move(next);
+    }
+    built.store(true, std::memory_order_release);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger(ll_info, "TrigramIndex " + table + "." + text_column + ": " + std::to_string(rows) + " rows indexed in " +
+                        std::to_string(elapsed.count()) + " ms")
+        .log();
+    return true;
+}
+
+void TrigramIndex::upsert(int id, const std::string &text) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    erase_slot(*snapshot, id);
+    add_slot(*snapshot, id, fold(text));
+    if (journaling)
+        journal.emplace_back(id, text);
+}
+
+void TrigramIndex::erase(int id) {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    erase_slot(*snapshot, id);
+    if (journaling)
+        journal.emplace_back(id, std::nullopt);
+}
+
+std::vector<int> TrigramIndex::search(const std::string &pattern) const {
+    std::string needle = fold(pattern);
+    std::vector<int> found;
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const Snapshot &current = *snapshot;
+
+    if (needle.size() < 3) {
+        // Too short for a gram: verify every live row.
+        for (size_t slot = 0; slot < current.ids.size(); ++slot) {
+            if (current.live[slot] && current.texts[slot].find(needle) != std::string::npos)
+                found.push_back(current.ids[slot]);
+        }
+        std::sort(found.begin(), found.end());
+        return found;
+    }
+
+    std::unordered_set<uint32_t> grams;
+    for (size_t i = 0; i + 3 <= needle.size(); ++i)
+        grams.insert(gram_at(needle, i));
+
+    std::vector<const std::vector<uint32_t> *> lists;
+    size_t shard_count = current.shards.size();
+    for (uint32_t gram : grams) {
+        const PostingShard &shard = current.shards[gram % shard_count];
+        auto it = shard.find(gram);
+        if (it == shard.end())
+            return found;
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](auto *a, auto *b) { return a->size() < b->size(); });
+
+    std::vector<uint32_t> candidates = *lists[0];
+    std::vector<uint32_t> narrowed;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+        const std::vector<uint32_t> &other = *lists[i];
+        narrowed.clear();
+        if (other.size() > candidates.size() * 16) {
+            // Much longer list: binary-search each candidate instead of walking it.
+            auto from = other.begin();
+            for (uint32_t slot : candidates) {
+                from = std::lower_bound(from, other.end(), slot);
+                if (from == other.end())
+                    break;
+                if (*from == slot)
+                    narrowed.push_back(slot);
+            }
+        } else {
+            std::set_intersection(candidates.begin(), candidates.end(), other.begin(), other.end(),
+                                  std::back_inserter(narrowed));
+        }
+        candidates.swap(narrowed);
+    }
+
+    for (uint32_t slot : candidates) {
+        if (current.live[slot] && current.texts[slot].find(needle) != std::string::npos)
+            found.push_back(current.ids[slot]);
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+size_t TrigramIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return snapshot->live_count;
+}
+
+void TrigramIndex::start_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval) {
+    std::lock_guard<std::mutex> lock(refresh_mutex);
+    if (refresher.joinable())
+        return;
+    refresh_stopping = false;
+    refresher = std::thread(&TrigramIndex::run_refresh, this, conn, interval);
+}
+
+void TrigramIndex::stop_refresh() {
+    {
+        std::lock_guard<std::mutex> lock(refresh_mutex);
+        refresh_stopping = true;
+    }
+    refresh_wake.notify_all();
+    if (refresher.joinable())
+        refresher.join();
+}
+
+void TrigramIndex::run_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(refresh_mutex);
+            if (refresh_wake.wait_for(lock, interval, [this] { return refresh_stopping; }))
+                break;
+        }
+        build(conn);
+    }
+}
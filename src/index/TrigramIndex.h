@@ -0,0 +1,174 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+
+/**
+ * @brief In-memory trigram index answering substring (LIKE '%x%') searches over one text column.
+ *
+ * Every indexed text is split into overlapping 3-byte grams; each gram keeps a sorted
+ * posting list of the rows containing it. A search intersects the posting lists of the
+ * pattern's grams, smallest first, and verifies the survivors with an exact substring
+ * match. Matching folds case, Latin accents and full-width forms the way the tables'
+ * utf8mb4_0900_ai_ci collation does; covers() tells which patterns it answers exactly.
+ *
+ * The index is built from a full scan (in parallel), kept current by the owning table's
+ * write paths through upsert()/erase(), and optionally rebuilt periodically to pick up
+ * writes made by other clients.
+ */
+class TrigramIndex {
+public:
+    /**
+     * @brief Above this many matches a search is not selective; callers should let the server evaluate the LIKE instead.
+     */
+    static constexpr size_t max_selective_matches = 5000;
+
+    /**
+     * @brief Returns whether pattern is a plain substring, i.e. contains no LIKE wildcard the index cannot evaluate.
+     * @param pattern The search text.
+     */
+    static bool is_literal(const std::string &pattern) { return pattern.find_first_of("%_\\") == std::string::npos; }
+
+    /**
+     * @brief Returns whether search(pattern) finds the same rows as LIKE '%pattern%' on the server: the pattern
+     * is literal and made only of ASCII, Hangul syllables and characters fold() maps the way the collation does.
+     * Callers should let the server evaluate other patterns.
+     * @param pattern The search text.
+     */
+    static bool covers(const std::string &pattern);
+
+    /**
+     * @brief Constructs an empty index over table.text_column keyed by id_column.
+     * @param table The table to scan.
+     * @param id_column Integer primary key column.
+     * @param text_column The text column to index.
+     */
+    TrigramIndex(std::string table, std::string id_column, std::string text_column);
+
+    /**
+     * @brief Stops the refresh thread if it is running.
+     */
+    ~TrigramIndex();
+
+    TrigramIndex(const TrigramIndex &) = delete;
+    TrigramIndex &operator=(const TrigramIndex &) = delete;
+
+    /**
+     * @brief Rebuilds the index from a full scan of the table.
+     * Local writes made while the scan runs are replayed onto the new index before it is swapped in.
+     * @param conn The connection to scan with.
+     * @param threads Number of threads building posting lists; 0 means one per core.
+     * @return True if the index was rebuilt, false if the scan failed (the old index is kept).
+     */
+    bool build(std::shared_ptr<sql::Connection> conn, unsigned threads = 0);
+
+    /**
+     * @brief Records that a row was inserted or its text changed.
+     * @param id The primary key of the row.
+     * @param text The new text.
+     */
+    void upsert(int id, const std::string &text);
+
+    /**
+     * @brief Records that a row was deleted.
+     * @param id The primary key of the row.
+     */
+    void erase(int id);
+
+    /**
+     * @brief Finds rows whose text contains pattern.
+     * @param pattern The substring to look for, without LIKE wildcards.
+     * @return Matching primary keys in ascending order.
+     */
+    std::vector<int> search(const std::string &pattern) const;
+
+    /**
+     * @brief Returns whether build() has completed at least once.
+     */
+    bool ready() const { return built.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Returns the number of live rows in the index.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Rebuilds the index on a background thread every interval.
+     * @param conn A connection used only by the refresh thread.
+     * @param interval Time between two rebuilds.
+     */
+    void start_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval);
+
+    /**
+     * @brief Stops the refresh thread.
+     */
+    void stop_refresh();
+
+private:
+    /**
+     * @brief Posting lists split by gram so that shards can be merged in parallel.
+     */
+    using PostingShard = std::unordered_map<uint32_t, std::vector<uint32_t>>;
+
+    /**
+     * @brief One immutable-layout generation of the index. Rows live in slots; an update
+     * appends a new slot and retires the old one, so posting lists stay sorted by slot.
+     */
+    struct Snapshot {
+        std::vector<int> ids;
+        std::vector<std::string> texts;
+        std::vector<bool> live;
+        std::unordered_map<int, uint32_t> slot_of;
+        std::vector<PostingShard> shards;
+        size_t live_count = 0;
+    };
+
+    /**
+     * @brief Appends text folded for matching to folded.
+     * @return False if text has characters the collation may match differently than their bytes.
+     */
+    static bool fold_into(const std::string &text, std::string &folded);
+    static std::string fold(const std::string &text);
+    static void add_slot(Snapshot &snapshot, int id, const std::string &folded);
+    static void erase_slot(Snapshot &snapshot, int id);
+    void run_refresh(std::shared_ptr<sql::Connection> conn, std::chrono::seconds interval);
+
+    std::string table;
+    std::string id_column;
+    std::string text_column;
+
+    /**
+     * @brief Guards snapshot and journal.
+     */
+    mutable std::shared_mutex mutex;
+    std::unique_ptr<Snapshot> snapshot;
+
+    /**
+     * @brief Serializes builds.
+     */
+    std::mutex build_mutex;
+
+    /**
+     * @brief Local writes since the running build started; no text means erase.
+     */
+    std::vector<std::pair<int, std::optional<std::string>>> journal;
+    bool journaling = false;
+    std::atomic<bool> built{false};
+
+    std::mutex refresh_mutex;
+    std::condition_variable refresh_wake;
+    bool refresh_stopping = false;
+    std::thread refresher;
+};
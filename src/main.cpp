@@ -5,14 +5,37 @@
 
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <vector>
 
+#include "analytics/ColumnarSnapshot.h"
+#include "analytics/MembershipSketches.h"
+#include "index/ActivityIntervalIndex.h"
+#include "index/MembershipGraph.h"
+#include "index/TrigramIndex.h"
+#include "render/TableRenderer.h"
+#include "service/ActivityRollup.h"
+#include "service/BudgetLedgerCompactor.h"
+#include "service/CascadePurger.h"
+#include "service/ClubCounterReconciler.h"
 #include "service/ClubStudentTable.h"
 #include "service/ClubTable.h"
 #include "service/GatheringTable.h"
+#include "service/ConnectionPool.h"
 #include "service/ProfessorTable.h"
+#include "service/QueryDigest.h"
+#include "service/ReplicaSet.h"
+#include "service/ResultBatchJob.h"
+#include "service/ResultTable.h"
+#include "service/ShardMap.h"
+#include "service/SlowQueryLog.h"
 #include "service/StudentTable.h"
+#include "service/WriteBehindQueue.h"
+#include "storage/MySqlBackend.h"
+#include "trace/AllocStats.h"
+#include "trace/Tracer.h"
 #include "utils.h"
+#include "workload/WorkloadLog.h"
 
 static Logger wrong_input_log = Logger(ll_error, "Incorrect Input");
 
@@ -30,6 +53,7 @@ void student_menu(StudentTable &student_table) {
             break;
 
         if (query_num == 0) {
+            TraceSpan span("menu", "student_menu: basic_show");
             student_table.basic_show();
         } else if (query_num == 1) {
             int search_option;
@@ -43,6 +67,7 @@ void student_menu(StudentTable &student_table) {
             }
 
             if (search_option == 0) {
+                TraceSpan span("menu", "student_menu: read_all_student");
                 auto search_res = student_table.read_all_student();
                 if (search_res)
                     print_result_set(search_res);
@@ -52,6 +77,7 @@ void student_menu(StudentTable &student_table) {
                 std::cout << "name = ";
                 std::getline(std::cin, student_name);
 
+                TraceSpan span("menu", "student_menu: read_student_by_field");
                 auto search_res = student_table.read_student_by_field("name", student_name);
                 if (search_res)
                     print_result_set(search_res);
@@ -65,6 +91,7 @@ void student_menu(StudentTable &student_table) {
             std::cout << "department = ";
             std::getline(std::cin, dep);
 
+            TraceSpan span("menu", "student_menu: create_student");
             student_table.create_student(student_name, dep);
         } else if (query_num == 3) {
             int id;
@@ -77,6 +104,7 @@ void student_menu(StudentTable &student_table) {
                 continue;
             }
 
+            TraceSpan span("menu", "student_menu: delete_student_by_id");
             student_table.delete_student_by_id(id);
         } else if (query_num == 4) {
             int id;
@@ -94,6 +122,7 @@ void student_menu(StudentTable &student_table) {
             std::cout << "New Name = ";
             std::getline(std::cin, new_name);
 
+            TraceSpan span("menu", "student_menu: update_student_name");
             student_table.update_student_name(id, new_name);
         }
     }
@@ -102,7 +131,7 @@ void student_menu(StudentTable &student_table) {
 void club_members_menu(ClubTable &club_table, GatheringTable &gathering_table, int club_id) {
     while (true) {
         int query_num;
-        std::cout << "\n\n<< Members >>\n1. Search  2. Add  3. Delete  4. Return to back" << std::endl;
+        std::cout << "\n\n<< Members >>\n1. Search  2. Add  3. Delete  4. Return to back  5. Add by department  6. Sync roster" << std::endl;
         std::cin >> query_num;
 
         if (std::cin.fail()) {
@@ -124,6 +153,7 @@ void club_members_menu(ClubTable &club_table, GatheringTable &gathering_table, i
             }
 
             if (search_option == 0) {
+                TraceSpan span("menu", "club_members_menu: read_members_by_club_id");
                 auto search_res = club_table.read_members_by_club_id(club_id);
                 if (search_res) {
                     print_result_set(search_res);
@@ -134,6 +164,7 @@ void club_members_menu(ClubTable &club_table, GatheringTable &gathering_table, i
                 std::cout << "Search for Name = ";
                 std::getline(std::cin, search_name);
 
+                TraceSpan span("menu", "club_members_menu: read_members_by_name_in_club");
                 auto search_res = club_table.read_members_by_name_in_club(club_id, search_name);
                 if (search_res) {
                     print_result_set(search_res);
@@ -150,6 +181,7 @@ void club_members_menu(ClubTable &club_table, GatheringTable &gathering_table, i
                 continue;
             }
 
+            TraceSpan span("menu", "club_members_menu: add_member");
             club_table.add_member(club_id, student_id);
         } else if (query_num == 3) {
             int student_id;
@@ -162,7 +194,35 @@ void club_members_menu(ClubTable &club_table, GatheringTable &gathering_table, i
                 continue;
             }
 
+            TraceSpan span("menu", "club_members_menu: delete_member");
             club_table.delete_member(club_id, student_id);
+        } else if (query_num == 5) {
+            clear_cin_buffer();
+            std::string department;
+            std::cout << "department = ";
+            std::getline(std::cin, department);
+
+            TraceSpan span("menu", "club_members_menu: add_members_by_department");
+            club_table.add_members_by_department(club_id, department);
+        } else if (query_num == 6) {
+            clear_cin_buffer();
+            std::string line;
+            std::cout << "student_ids (space separated) = ";
+            std::getline(std::cin, line);
+
+            std::istringstream ids_stream(line);
+            std::vector<int> student_ids;
+            int student_id;
+            while (ids_stream >> student_id) {
+                student_ids.push_back(student_id);
+            }
+            if (!ids_stream.eof() || student_ids.empty()) {
+                wrong_input_log.log();
+                continue;
+            }
+
+            TraceSpan span("menu", "club_members_menu: sync_members");
+            club_table.sync_members(club_id, student_ids);
         }
     }
 }
@@ -170,10 +230,10 @@ void club_members_menu(ClubTable &club_table, GatheringTable &gathering_table, i
 void gathering_menu(GatheringTable &gathering_table, int gathering_id) {
     while (true) {
         int option;
-        std::cout << "\n\n << Gathering >>\nChoose an option: 1. Add Member  2. Remove Member  3. View Members  4. Return to Back" << std::endl;
+        std::cout << "\n\n << Gathering >>\nChoose an option: 1. Add Member  2. Remove Member  3. View Members  4. Return to Back  5. Add All Club Members  6. Check Conflicts" << std::endl;
         std::cin >> option;
 
-        if (std::cin.fail() || option < 1 || option > 4) {
+        if (std::cin.fail() || option < 1 || option > 6) {
             clear_cin_error();
             wrong_input_log.log();
             continue;
@@ -192,7 +252,9 @@ void gathering_menu(GatheringTable &gathering_table, int gathering_id) {
                 continue;
             }
 
-            gathering_table.add_student_to_gathering(student_id, gathering_id);
+            TraceSpan span("menu", "gathering_menu: add_student_to_gathering");
+            if (!gathering_table.add_student_to_gathering(student_id, gathering_id))
+                std::cout << "Student was not added to the gathering." << std::endl;
         } else if (option == 2) {
             int student_id;
             std::cout << "Enter student_id to remove: ";
@@ -204,14 +266,41 @@ void gathering_menu(GatheringTable &gathering_table, int gathering_id) {
                 continue;
             }
 
+            TraceSpan span("menu", "gathering_menu: delete_student_from_gathering");
             gathering_table.delete_student_from_gathering(student_id, gathering_id);
         } else if (option == 3) {
+            TraceSpan span("menu", "gathering_menu: read_all_students_from_gathering");
             auto students = gathering_table.read_all_students_from_gathering(gathering_id);
             if (students) {
                 print_result_set(students);
             } else {
                 std::cout << "No students found for the given gathering." << std::endl;
             }
+        } else if (option == 5) {
+            TraceSpan span("menu", "gathering_menu: add_all_club_members");
+            int added = gathering_table.add_all_club_members(gathering_id);
+            if (added >= 0)
+                std::cout << added << " students added to the gathering." << std::endl;
+        } else if (option == 6) {
+            int student_id;
+            std::cout << "Enter student_id to check: ";
+            std::cin >> student_id;
+
+            if (std::cin.fail()) {
+                clear_cin_error();
+                wrong_input_log.log();
+                continue;
+            }
+
+            TraceSpan span("menu", "gathering_menu: find_conflicts");
+            auto conflicts = gathering_table.find_conflicts(student_id);
+            if (!conflicts)
+                continue;
+            if (conflicts->empty())
+                std::cout << "No schedule conflicts." << std::endl;
+            for (const auto &conflict : *conflicts)
+                std::cout << "Gathering " << conflict.first_gathering_id << " overlaps gathering "
+                          << conflict.second_gathering_id << std::endl;
         }
     }
 }
@@ -242,6 +331,7 @@ void club_activities_menu(ClubTable &club_table, GatheringTable &gathering_table
             }
 
             if (search_option == 0) {
+                TraceSpan span("menu", "club_activities_menu: read_activities_by_club");
                 auto search_res = club_table.read_activities_by_club(club_id);
                 if (search_res) {
                     print_result_set(search_res);
@@ -257,6 +347,7 @@ void club_activities_menu(ClubTable &club_table, GatheringTable &gathering_table
                     continue;
                 }
 
+                TraceSpan span("menu", "club_activities_menu: read_activity_by_id");
                 auto search_res = club_table.read_activity_by_id(club_id, act_id);
                 if (search_res) {
                     print_result_set(search_res);
@@ -267,6 +358,7 @@ void club_activities_menu(ClubTable &club_table, GatheringTable &gathering_table
                 std::cout << "activity_title = ";
                 std::getline(std::cin, act_title);
 
+                TraceSpan span("menu", "club_activities_menu: read_activity_by_title");
                 auto search_res = club_table.read_activity_by_title(club_id, act_title);
                 if (search_res) {
                     print_result_set(search_res);
@@ -280,6 +372,7 @@ void club_activities_menu(ClubTable &club_table, GatheringTable &gathering_table
                 std::cout << "To date (YYYY-MM-DD) = ";
                 std::getline(std::cin, to_date);
 
+                TraceSpan span("menu", "club_activities_menu: read_activity_by_period");
                 auto search_res = club_table.read_activity_by_period(club_id, from_date, to_date);
                 if (search_res) {
                     print_result_set(search_res);
@@ -298,6 +391,7 @@ void club_activities_menu(ClubTable &club_table, GatheringTable &gathering_table
             std::cout << "end_date (YYYY-MM-DD, default: 2099-12-31) = ";
             std::getline(std::cin, end_date);
 
+            TraceSpan span("menu", "club_activities_menu: create_activity_for_club");
             club_table.create_activity_for_club(club_id, act_title, start_date, end_date);
 
         } else if (query_num == 3) {
@@ -328,6 +422,7 @@ void club_activities_menu(ClubTable &club_table, GatheringTable &gathering_table
                 updates[field_to_update] = new_value;
             }
 
+            TraceSpan span("menu", "club_activities_menu: update_activity_for_club");
             club_table.update_activity_for_club(club_id, act_id, updates);
 
         } else if (query_num == 4) {
@@ -341,6 +436,7 @@ void club_activities_menu(ClubTable &club_table, GatheringTable &gathering_table
                 continue;
             }
 
+            TraceSpan span("menu", "club_activities_menu: delete_activity_for_club");
             club_table.delete_activity_for_club(club_id, act_id);
         } else if (query_num == 5) {
             int activity_id;
@@ -353,13 +449,20 @@ void club_activities_menu(ClubTable &club_table, GatheringTable &gathering_table
                 continue;
             }
 
-            if (!club_table.validate_activity_belongs_to_club(club_id, activity_id)) {
+            std::unique_ptr<DbResult> gatherings;
+            {
+                TraceSpan span("menu", "club_activities_menu: read_gathering_by_act_id");
+                if (club_table.validate_activity_belongs_to_club(club_id, activity_id))
+                    gatherings = gathering_table.read_gathering_by_act_id(activity_id);
+                else
+                    activity_id = -1;
+            }
+            if (activity_id == -1) {
                 std::cout << "The activity does not belong to this club. Please enter a valid activity." << std::endl;
                 continue;
             }
 
-            auto gatherings = gathering_table.read_gathering_by_act_id(activity_id);
-            if (!gatherings || gatherings->rowsCount() == 0) {
+            if (!gatherings || gatherings->rows_count() == 0) {
                 std::cout << "No gatherings found for this activity." << std::endl;
                 char create_option;
                 std::cout << "Would you like to create a new gathering? (y/n): ";
@@ -371,18 +474,19 @@ void club_activities_menu(ClubTable &club_table, GatheringTable &gathering_table
                     std::cout << "Enter gathering name: ";
                     std::getline(std::cin, gathering_name);
 
+                    TraceSpan span("menu", "club_activities_menu: create_gathering");
                     gathering_table.create_gathering(activity_id, gathering_name);
                 }
             } else {
                 gatherings->next();
-                int gathering_id = gatherings->getInt("gathering_id");
+                int gathering_id = gatherings->get_int(gatherings->column_index("gathering_id"));
                 gathering_menu(gathering_table, gathering_id);
             }
         }
     }
 }
 
-void club_manage_menu(ClubTable &club_table, GatheringTable &gathering_table, int club_id) {
+void club_manage_menu(ClubTable &club_table, GatheringTable &gathering_table, ResultTable &result_table, int club_id) {
     while (true) {
         int query_num;
         std::cout << "1. Manage\t2. Submit Result\t4. Return to Back" << std::endl;
@@ -395,7 +499,27 @@ void club_manage_menu(ClubTable &club_table, GatheringTable &gathering_table, in
         if (query_num == 4)
             break;
 
-        if (query_num == 1) {
+        if (query_num == 2) {
+            int year;
+            std::cout << "year = ";
+            std::cin >> year;
+
+            if (std::cin.fail()) {
+                clear_cin_error();
+                wrong_input_log.log();
+                continue;
+            }
+
+            TraceSpan span("menu", "club_manage_menu: submit_result");
+            auto submission = result_table.submit_result(club_id, year);
+            if (submission) {
+                std::cout << "Result " << submission->result_id << " submitted, " << submission->linked_activities
+                          << " activities linked" << std::endl;
+                auto activities = result_table.read_result_activities(submission->result_id);
+                if (activities)
+                    print_result_set(activities);
+            }
+        } else if (query_num == 1) {
             while (true) {
                 std::cout << "1. Members  2. Activities  3. Details  4. Return to Back" << std::endl;
                 int info_option;
@@ -413,15 +537,21 @@ void club_manage_menu(ClubTable &club_table, GatheringTable &gathering_table, in
                 } else if (info_option == 2) {
                     club_activities_menu(club_table, gathering_table, club_id);
                 } else if (info_option == 3) {
-                    auto search_res = club_table.read_club_by_id(club_id);
-                    if (search_res)
-                        print_result_set(search_res);
+                    {
+                        TraceSpan span("menu", "club_manage_menu: read_club_by_id");
+                        auto search_res = club_table.read_club_by_id(club_id);
+                        if (search_res)
+                            print_result_set(search_res);
+                        auto yearly_res = club_table.read_yearly_activity(club_id);
+                        if (yearly_res)
+                            print_result_set(yearly_res);
+                    }
 
-                    std::cout << "Update for: 1. Name  2. Budget  3. Professor ID  4. Return to back" << std::endl;
+                    std::cout << "Update for: 1. Name  2. Budget  3. Professor ID  4. Return to back  5. Adjust Budget (+/-)" << std::endl;
                     int update_option;
                     std::cin >> update_option;
 
-                    if (std::cin.fail() || update_option < 1 || update_option > 4) {
+                    if (std::cin.fail() || update_option < 1 || update_option > 5) {
                         clear_cin_error();
                         wrong_input_log.log();
                         continue;
@@ -437,6 +567,7 @@ void club_manage_menu(ClubTable &club_table, GatheringTable &gathering_table, in
                         std::cout << "New Name = ";
                         std::getline(std::cin, new_name);
 
+                        TraceSpan span("menu", "club_manage_menu: update_club_name");
                         club_table.update_club_name(club_id, new_name);
                     } else if (update_option == 2) {
                         double new_budget;
@@ -449,6 +580,7 @@ void club_manage_menu(ClubTable &club_table, GatheringTable &gathering_table, in
                             continue;
                         }
 
+                        TraceSpan span("menu", "club_manage_menu: update_club_budget");
                         club_table.update_club_budget(club_id, new_budget);
                     } else if (update_option == 3) {
                         int new_prof_id;
@@ -461,7 +593,25 @@ void club_manage_menu(ClubTable &club_table, GatheringTable &gathering_table, in
                             continue;
                         }
 
+                        TraceSpan span("menu", "club_manage_menu: update_club_prof_id");
                         club_table.update_club_prof_id(club_id, new_prof_id);
+                    } else if (update_option == 5) {
+                        double delta;
+                        std::cout << "Amount to add (negative to spend) = ";
+                        std::cin >> delta;
+
+                        if (std::cin.fail()) {
+                            clear_cin_error();
+                            wrong_input_log.log();
+                            continue;
+                        }
+
+                        TraceSpan span("menu", "club_manage_menu: adjust_budget");
+                        if (club_table.adjust_budget(club_id, delta)) {
+                            auto budget_res = club_table.read_effective_budget(club_id);
+                            if (budget_res)
+                                print_result_set(budget_res);
+                        }
                     }
                 }
             }
@@ -469,10 +619,10 @@ void club_manage_menu(ClubTable &club_table, GatheringTable &gathering_table, in
     }
 }
 
-void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
+void club_menu(ClubTable &club_table, GatheringTable &gathering_table, ResultTable &result_table) {
     while (true) {
         int query_num;
-        std::cout << "0. info  1. search  2. create  3. delete  4. manage a club  5. Return to Menu" << std::endl;
+        std::cout << "0. info  1. search  2. create  3. delete  4. manage a club  5. Return to Menu  6. largest clubs" << std::endl;
         std::cin >> query_num;
 
         if (std::cin.fail()) {
@@ -482,7 +632,13 @@ void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
         if (query_num == 5)
             break;
 
-        if (query_num == 0) {
+        if (query_num == 6) {
+            TraceSpan span("menu", "club_menu: read_largest_clubs");
+            auto res = club_table.read_largest_clubs(10);
+            if (res)
+                print_result_set(res);
+        } else if (query_num == 0) {
+            TraceSpan span("menu", "club_menu: basic_show");
             club_table.basic_show();
         } else if (query_num == 1) {
             int search_option;
@@ -496,6 +652,7 @@ void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
             }
 
             if (search_option == 0) {
+                TraceSpan span("menu", "club_menu: read_all_club");
                 auto search_res = club_table.read_all_club();
                 if (search_res)
                     print_result_set(search_res);
@@ -510,6 +667,7 @@ void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
                     continue;
                 }
 
+                TraceSpan span("menu", "club_menu: read_club_by_id");
                 auto search_res = club_table.read_club_by_id(club_id);
                 if (search_res)
                     print_result_set(search_res);
@@ -518,6 +676,7 @@ void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
                 std::cout << "club_name = ";
                 std::cin >> club_name;
 
+                TraceSpan span("menu", "club_menu: read_club_by_name");
                 auto search_res = club_table.read_club_by_name(club_name);
                 if (search_res)
                     print_result_set(search_res);
@@ -532,6 +691,7 @@ void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
                     continue;
                 }
 
+                TraceSpan span("menu", "club_menu: read_club_by_prof_id");
                 auto search_res = club_table.read_club_by_prof_id(prof_id);
                 if (search_res)
                     print_result_set(search_res);
@@ -546,6 +706,7 @@ void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
                     continue;
                 }
 
+                TraceSpan span("menu", "club_menu: read_club_by_location_id");
                 auto search_res = club_table.read_club_by_location_id(loc_id);
                 if (search_res)
                     print_result_set(search_res);
@@ -554,6 +715,7 @@ void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
                 std::cout << "loc_name = ";
                 std::cin >> loc_name;
 
+                TraceSpan span("menu", "club_menu: read_club_by_location_name");
                 auto search_res = club_table.read_club_by_location_name(loc_name);
                 if (search_res)
                     print_result_set(search_res);
@@ -586,6 +748,7 @@ void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
                 continue;
             }
 
+            TraceSpan span("menu", "club_menu: create_club");
             club_table.create_club(club_name, budget, prof_id);
         } else if (query_num == 3) {
             int club_id;
@@ -598,6 +761,7 @@ void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
                 continue;
             }
 
+            TraceSpan span("menu", "club_menu: delete_club");
             club_table.delete_club(club_id);
         } else if (query_num == 4) {
             int club_id;
@@ -610,11 +774,126 @@ void club_menu(ClubTable &club_table, GatheringTable &gathering_table) {
                 continue;
             }
 
-            auto res = club_table.read_club_by_id(club_id);
-            if (res && res->rowsCount()) {
-                club_manage_menu(club_table, gathering_table, club_id);
+            bool found;
+            {
+                TraceSpan span("menu", "club_menu: read_club_by_id");
+                auto res = club_table.read_club_by_id(club_id);
+                found = res && res->rows_count();
+            }
+            if (found) {
+                club_manage_menu(club_table, gathering_table, result_table, club_id);
+            } else {
+                wrong_input_log.log();
+            }
+        }
+    }
+}
+
+void result_menu(ResultTable &result_table, ResultBatchJob &batch_job, ActivityRollup *activity_rollup) {
+    while (true) {
+        int query_num;
+        std::cout << "1. Submit for all clubs  2. Submit for clubs  3. Results of a club  4. Activities of a result  "
+                  << "5. delete  6. Return to Menu  7. Year summary  8. Rebuild rollup" << std::endl;
+        std::cin >> query_num;
+
+        if (std::cin.fail()) {
+            clear_cin_error();
+            wrong_input_log.log();
+            continue;
+        }
+
+        if (query_num == 6)
+            break;
+
+        if (query_num == 8) {
+            if (activity_rollup) {
+                TraceSpan span("menu", "result_menu: rebuild");
+                RollupRebuildSummary summary = activity_rollup->rebuild();
+                std::cout << summary.rows << " rows in " << summary.partitions << " partitions, " << summary.failed_partitions
+                          << " failed (" << summary.elapsed.count() << " ms)" << std::endl;
+            } else {
+                std::cout << "Activity rollup is disabled (set SEV_ACTIVITY_ROLLUP=1)." << std::endl;
+            }
+        } else if (query_num == 7) {
+            int year;
+            std::cout << "year = ";
+            std::cin >> year;
+
+            if (std::cin.fail()) {
+                clear_cin_error();
+                wrong_input_log.log();
+                continue;
+            }
+
+            TraceSpan span("menu", "result_menu: read_year_summary");
+            auto res = result_table.read_year_summary(year, 20);
+            if (res)
+                print_result_set(res);
+        } else if (query_num == 1 || query_num == 2) {
+            int year;
+            std::cout << "year = ";
+            std::cin >> year;
+
+            if (std::cin.fail()) {
+                clear_cin_error();
+                wrong_input_log.log();
+                continue;
+            }
+
+            ResultBatchSummary summary;
+            if (query_num == 1) {
+                TraceSpan span("menu", "result_menu: run_all");
+                summary = batch_job.run_all(year);
             } else {
+                clear_cin_buffer();
+                std::string line;
+                std::cout << "club_ids (space separated) = ";
+                std::getline(std::cin, line);
+
+                std::vector<int> club_ids;
+                std::istringstream ids(line);
+                for (int club_id; ids >> club_id;)
+                    club_ids.push_back(club_id);
+                TraceSpan span("menu", "result_menu: run");
+                summary = batch_job.run(year, club_ids);
+            }
+            std::cout << summary.submitted << "/" << summary.clubs << " clubs submitted, " << summary.linked_activities
+                      << " activities linked, " << summary.failed << " failed (" << summary.elapsed.count() << " ms)"
+                      << std::endl;
+        } else if (query_num == 3) {
+            int club_id;
+            std::cout << "club_id = ";
+            std::cin >> club_id;
+
+            if (std::cin.fail()) {
+                clear_cin_error();
                 wrong_input_log.log();
+                continue;
+            }
+
+            TraceSpan span("menu", "result_menu: read_results_by_club");
+            auto res = result_table.read_results_by_club(club_id);
+            if (res)
+                print_result_set(res);
+        } else if (query_num == 4 || query_num == 5) {
+            int result_id;
+            std::cout << "result_id = ";
+            std::cin >> result_id;
+
+            if (std::cin.fail()) {
+                clear_cin_error();
+                wrong_input_log.log();
+                continue;
+            }
+
+            if (query_num == 4) {
+                TraceSpan span("menu", "result_menu: read_result_activities");
+                auto res = result_table.read_result_activities(result_id);
+                if (res)
+                    print_result_set(res);
+            } else {
+                TraceSpan span("menu", "result_menu: delete_result");
+                result_table.delete_result(result_id);
             }
         }
     }
@@ -634,6 +913,7 @@ void professor_menu(ProfessorTable &professor_table) {
             break;
 
         if (query_num == 0) {
+            TraceSpan span("menu", "professor_menu: basic_show");
             professor_table.basic_show();
         } else if (query_num == 1) {
             int search_option;
@@ -647,6 +927,7 @@ void professor_menu(ProfessorTable &professor_table) {
             }
 
             if (search_option == 0) {
+                TraceSpan span("menu", "professor_menu: read_all_professor");
                 auto search_res = professor_table.read_all_professor();
                 if (search_res)
                     print_result_set(search_res);
@@ -661,6 +942,7 @@ void professor_menu(ProfessorTable &professor_table) {
                     continue;
                 }
 
+                TraceSpan span("menu", "professor_menu: read_professor_by_id");
                 auto search_res = professor_table.read_professor_by_id(prof_id);
                 if (search_res)
                     print_result_set(search_res);
@@ -675,6 +957,7 @@ void professor_menu(ProfessorTable &professor_table) {
                     continue;
                 }
 
+                TraceSpan span("menu", "professor_menu: read_professor_by_club_id");
                 auto search_res = professor_table.read_professor_by_club_id(club_id);
                 if (search_res)
                     print_result_set(search_res);
@@ -686,6 +969,7 @@ void professor_menu(ProfessorTable &professor_table) {
             std::cout << "name = ";
             std::getline(std::cin, name);
 
+            TraceSpan span("menu", "professor_menu: create_professor");
             professor_table.create_professor(name);
         } else if (query_num == 3) {
             int prof_id;
@@ -698,6 +982,7 @@ void professor_menu(ProfessorTable &professor_table) {
                 continue;
             }
 
+            TraceSpan span("menu", "professor_menu: delete_professor");
             professor_table.delete_professor(prof_id);
         } else if (query_num == 4) {
             int prof_id;
@@ -715,37 +1000,539 @@ void professor_menu(ProfessorTable &professor_table) {
             std::cout << "New Name = ";
             std::getline(std::cin, new_name);
 
+            TraceSpan span("menu", "professor_menu: update_professor_name");
             professor_table.update_professor_name(prof_id, new_name);
         }
     }
 }
 
-int main() {
+/**
+ * @brief Prints a sketch estimate as "value ± error".
+ */
+static void print_estimate(const std::string &label, Estimate estimate) {
+    std::cout << label << "\t~" << static_cast<long long>(estimate.value + 0.5) << " (± "
+              << static_cast<long long>(estimate.error + 0.5) << ")" << std::endl;
+}
+
+void sketch_menu(MembershipSketches &sketches, std::shared_ptr<sql::Connection> con) {
+    while (true) {
+        int query_num;
+        std::cout << "\n\n<< Estimates >>\n"
+                  << "1. Distinct members  2. Most joined clubs  3. Participants by department  "
+                  << "4. Participants by year  5. Rebuild sketches  6. Return to back" << std::endl;
+        std::cin >> query_num;
+
+        if (std::cin.fail()) {
+            clear_cin_error();
+            wrong_input_log.log();
+            continue;
+        }
+
+        if (query_num == 6)
+            break;
+
+        if (query_num == 1) {
+            TraceSpan span("menu", "sketch_menu: distinct_members");
+            print_estimate("all clubs", sketches.distinct_members());
+        } else if (query_num == 2) {
+            TraceSpan span("menu", "sketch_menu: most_joined_clubs");
+            for (const auto &[club_id, joins] : sketches.most_joined_clubs(10))
+                print_estimate("club " + std::to_string(club_id), joins);
+        } else if (query_num == 3) {
+            clear_cin_buffer();
+            std::string department;
+            std::cout << "department = ";
+            std::getline(std::cin, department);
+            TraceSpan span("menu", "sketch_menu: distinct_participants_by_department");
+            print_estimate(department, sketches.distinct_participants_by_department(department));
+        } else if (query_num == 4) {
+            int year;
+            std::cout << "year = ";
+            std::cin >> year;
+
+            if (std::cin.fail()) {
+                clear_cin_error();
+                wrong_input_log.log();
+                continue;
+            }
+            TraceSpan span("menu", "sketch_menu: distinct_participants_by_year");
+            print_estimate(std::to_string(year), sketches.distinct_participants_by_year(year));
+        } else if (query_num == 5) {
+            TraceSpan span("menu", "sketch_menu: rebuild");
+            sketches.rebuild(con);
+        }
+    }
+}
+
+void analytics_menu(ColumnarSnapshot &snapshot, MembershipSketches *sketches, std::shared_ptr<sql::Connection> con) {
+    while (true) {
+        int query_num;
+        SnapshotStats stats = snapshot.stats();
+        std::cout << "\n\n<< Analytics >> (" << stats.students << " students, " << stats.clubs << " clubs, "
+                  << stats.memberships << " memberships)\n"
+                  << "1. Students per department  2. Budget range  3. Largest clubs  4. Reload snapshot  "
+                  << "5. Estimates  6. Return to back" << std::endl;
+        std::cin >> query_num;
+
+        if (std::cin.fail()) {
+            clear_cin_error();
+            wrong_input_log.log();
+            continue;
+        }
+
+        if (query_num == 6)
+            break;
+
+        if (query_num == 1) {
+            TraceSpan span("menu", "analytics_menu: students_per_department");
+            for (const auto &[department, count] : snapshot.students_per_department())
+                std::cout << department << "\t" << count << std::endl;
+        } else if (query_num == 2) {
+            double min_budget, max_budget;
+            std::cout << "min budget = ";
+            std::cin >> min_budget;
+            std::cout << "max budget = ";
+            std::cin >> max_budget;
+
+            if (std::cin.fail()) {
+                clear_cin_error();
+                wrong_input_log.log();
+                continue;
+            }
+
+            TraceSpan span("menu", "analytics_menu: club_budgets");
+            kernels::SumMinMax budgets = snapshot.club_budgets(min_budget, max_budget);
+            std::cout << budgets.count << " clubs, total " << budgets.sum;
+            if (budgets.count > 0)
+                std::cout << ", min " << budgets.min << ", max " << budgets.max << ", avg " << budgets.sum / budgets.count;
+            std::cout << std::endl;
+        } else if (query_num == 3) {
+            clear_cin_buffer();
+            std::string department;
+            std::cout << "department (empty for all) = ";
+            std::getline(std::cin, department);
+
+            TraceSpan span("menu", "analytics_menu: member_counts");
+            for (const auto &[club_id, count] : snapshot.member_counts(department, 10))
+                std::cout << "club " << club_id << "\t" << count << " members" << std::endl;
+        } else if (query_num == 4) {
+            TraceSpan span("menu", "analytics_menu: reload");
+            snapshot.reload(con);
+        } else if (query_num == 5) {
+            if (sketches) {
+                sketch_menu(*sketches, con);
+            } else {
+                std::cout << "Membership sketches are disabled (set SEV_SKETCHES)." << std::endl;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Opens a new connection to the server given by the MYSQL_* environment variables.
+ * Exits the process if the connection fails.
+ */
+void print_slow_queries(const SlowQueryLog &slow_query_log) {
+    SlowQueryStats stats = slow_query_log.stats();
+    std::cout << stats.recorded << " slow statements in " << slow_query_log.file() << ", " << stats.dropped
+              << " dropped, " << stats.explain_failures << " not explained" << std::endl;
+
+    int rank = 1;
+    for (const auto &offender : SlowQueryLog::summarize(slow_query_log.file(), 10)) {
+        std::cout << rank++ << ". " << offender.count << " times, total " << offender.total_ms << " ms, max "
+                  << offender.max_ms << " ms, " << offender.rows << " rows, " << offender.caller << "\n   "
+                  << offender.sql << "\n   plan: " << offender.plan << std::endl;
+    }
+}
+
+void print_query_digests(const QueryDigestTable &digests) {
+    std::vector<QueryDigestStats> all = digests.snapshot();
+    std::cout << all.size() << " statement shapes, " << digests.overflow() << " executions over capacity" << std::endl;
+
+    int rank = 1;
+    for (const auto &stats : all) {
+        if (rank > 20)
+            break;
+        std::cout << rank++ << ". " << stats.count << " times, " << stats.errors << " errors, total "
+                  << stats.total_us / 1000.0 << " ms, avg " << stats.avg_us() / 1000.0 << " ms, max "
+                  << stats.max_us / 1000.0 << " ms, " << stats.rows << " rows";
+        if (stats.sampled)
+            std::cout << ", " << stats.examined_per_row() << " examined per row";
+        std::cout << "\n   " << stats.text << std::endl;
+    }
+}
+
+void print_replicas(const ReplicaSet &replicas) {
+    for (const auto &replica : replicas.status()) {
+        std::cout << replica.server << ": ";
+        if (replica.healthy)
+            std::cout << replica.lag_seconds << "s behind";
+        else
+            std::cout << "unavailable (" << replica.error << ")";
+        std::cout << ", " << replica.reads << " reads, " << replica.failures << " failures" << std::endl;
+    }
+    std::cout << replicas.primary_reads() << " reads stayed on the primary" << std::endl;
+}
+
+void print_shards(const ShardMap &shards) {
+    size_t shard = 0;
+    for (const auto &status : shards.status()) {
+        std::cout << shard++ << ". " << status.server << ": " << status.routed << " club-scoped calls, " << status.scatters
+                  << " cross-shard reads, " << status.failures << " failures" << std::endl;
+    }
+}
+
+void print_coalescing() {
+    SingleFlightStats stats = BasicTable::coalescing_stats();
+    std::cout << stats.executed << " reads ran a query, " << stats.coalesced << " shared a concurrent identical read" << std::endl;
+}
+
+void diagnostics_menu(SlowQueryLog *slow_query_log, QueryDigestTable *digests, ReplicaSet *replicas, ShardMap *shards) {
+    while (true) {
+        int query_num;
+        std::cout << "1. Slow queries  2. Query digests  3. Dump digests as JSON  4. Return to Menu  5. Allocations  6. Replicas  7. Shards  8. Coalescing" << std::endl;
+        std::cin >> query_num;
+
+        if (std::cin.fail()) {
+            clear_cin_error();
+            wrong_input_log.log();
+            continue;
+        }
+
+        if (query_num == 4)
+            break;
+
+        if (query_num == 1) {
+            if (slow_query_log) {
+                print_slow_queries(*slow_query_log);
+            } else {
+                std::cout << "Slow query log is disabled (set SEV_SLOW_QUERY)." << std::endl;
+            }
+        } else if (query_num == 2 || query_num == 3) {
+            if (!digests) {
+                std::cout << "Query digests are disabled (set SEV_QUERY_DIGESTS=1)." << std::endl;
+                continue;
+            }
+            if (query_num == 2) {
+                print_query_digests(*digests);
+            } else {
+                clear_cin_buffer();
+                std::string path;
+                std::cout << "file = ";
+                std::getline(std::cin, path);
+                if (digests->write_json(path))
+                    std::cout << "Written to " << path << std::endl;
+            }
+        } else if (query_num == 5) {
+            if (!AllocStats::compiled) {
+                std::cout << "Allocation accounting is not compiled in (build with make ALLOC_STATS=1)." << std::endl;
+                continue;
+            }
+            AllocStats::print("service");
+        } else if (query_num == 6) {
+            if (replicas) {
+                print_replicas(*replicas);
+            } else {
+                std::cout << "Read replicas are disabled (set SEV_REPLICAS)." << std::endl;
+            }
+        } else if (query_num == 7) {
+            if (shards) {
+                print_shards(*shards);
+            } else {
+                std::cout << "Sharding is disabled (set SEV_SHARDS)." << std::endl;
+            }
+        } else if (query_num == 8) {
+            print_coalescing();
+        }
+    }
+}
+
+/**
+ * @brief Opens a connection to server with the MYSQL_USER, MYSQL_PASSWORD and MYSQL_DATABASE credentials.
+ * @throws sql::SQLException if the connection fails.
+ */
+std::shared_ptr<sql::Connection> connect_server(const std::string &server) {
     sql::Driver *driver = get_driver_instance();
 
-    const std::string server = std::getenv("MYSQL_SERVER");
     const std::string user = std::getenv("MYSQL_USER");
     const std::string password = std::getenv("MYSQL_PASSWORD");
     const std::string database = std::getenv("MYSQL_DATABASE");
 
+    std::shared_ptr<sql::Connection> con(driver->connect("tcp://" + server, user, password));
+    con->setSchema(database);
+    return con;
+}
+
+std::shared_ptr<sql::Connection> connect_mysql() {
+    const std::string server = std::getenv("MYSQL_SERVER");
+
     std::shared_ptr<sql::Connection> con;
 
     try {
-        con = std::shared_ptr<sql::Connection>(driver->connect("tcp://" + server, user, password));
-        con->setSchema(database);
+        con = connect_server(server);
         Logger(ll_info, "Successfully Connected to MySQL").log();
     } catch (sql::SQLException &e) {
         Logger(ll_critical, std::string(e.what())).log();
         exit(EXIT_FAILURE);
     }
+    return con;
+}
+
+/**
+ * @brief Checks that the database has the pending_delete columns every read filters on.
+ * Databases created before db_scripts/pending_delete.sql need that script applied once.
+ * @return True if both columns exist.
+ */
+bool check_schema(sql::Connection &conn) {
+    try {
+        for (const char *table : {"Club", "Activity"}) {
+            std::string query = std::string("SHOW COLUMNS FROM ") + table + " LIKE 'pending_delete'";
+            if (!BasicTable::execute_query(conn, query)->next()) {
+                Logger(ll_critical, std::string(table) + ".pending_delete is missing; apply db_scripts/pending_delete.sql to upgrade the database").log();
+                return false;
+            }
+        }
+        return true;
+    } catch (sql::SQLException &e) {
+        Logger(ll_critical, "Error in check_schema: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+int main() {
+    // SEV_TRACE=<file> records menu actions, service calls and statements as a Chrome trace written on exit.
+    const char *trace_file = std::getenv("SEV_TRACE");
+    if (trace_file) {
+        Tracer::enable();
+        Tracer::set_thread_name("main");
+    }
+
+    std::shared_ptr<sql::Connection> con = connect_mysql();
 
     Logger(ll_info, "Initiation").log();
 
-    StudentTable student_table(con);
-    ClubTable club_table(con);
-    ClubStudentTable club_student_table(con);
-    ProfessorTable professor_table(con);
-    GatheringTable gathering_table(con);
+    std::shared_ptr<DbConnection> db = std::make_shared<MySqlConnection>(con);
+    StudentTable student_table(db);
+    ClubTable club_table(db);
+    ClubStudentTable club_student_table(db);
+    ProfessorTable professor_table(db);
+    GatheringTable gathering_table(db);
+    ResultTable result_table(db);
+
+    // SEV_SHARDS=<host:port>,... splits clubs and everything they own over these databases by club_id; the
+    // MYSQL_SERVER database keeps the shard directory and the shared tables (see README). SEV_SHARD_PLACEMENT_TTL=<ms>
+    // sets how long a club's placement is cached (default 5000).
+    std::shared_ptr<ShardMap> shards;
+    if (const char *shard_list = std::getenv("SEV_SHARDS")) {
+        // These keep state or connections of their own that would not follow a club to its shard.
+        for (const char *unsupported : {"SEV_WRITE_BEHIND", "SEV_BUDGET_LEDGER", "SEV_ASYNC_PURGE", "SEV_SEARCH_INDEX",
+                                        "SEV_PERIOD_INDEX", "SEV_CLUB_COUNTERS", "SEV_ACTIVITY_ROLLUP", "SEV_MEMBERSHIP_GRAPH",
+                                        "SEV_ANALYTICS", "SEV_SKETCHES", "SEV_REPLICAS"}) {
+            if (std::getenv(unsupported)) {
+                Logger(ll_critical, std::string(unsupported) + " cannot be combined with SEV_SHARDS").log();
+                return EXIT_FAILURE;
+            }
+        }
+        std::vector<std::string> servers;
+        std::istringstream list(shard_list);
+        for (std::string server; std::getline(list, server, ',');) {
+            if (!server.empty())
+                servers.push_back(server);
+        }
+        if (servers.empty()) {
+            Logger(ll_critical, "SEV_SHARDS names no shard").log();
+            return EXIT_FAILURE;
+        }
+        ShardOptions options;
+        if (const char *ttl = std::getenv("SEV_SHARD_PLACEMENT_TTL"))
+            options.placement_ttl = std::chrono::milliseconds(std::max(0, std::atoi(ttl)));
+        try {
+            shards = std::make_shared<ShardMap>(servers, connect_server, connect_mysql(), options);
+        } catch (sql::SQLException &e) {
+            Logger(ll_critical, "Cannot connect to a shard: " + std::string(e.what())).log();
+            return EXIT_FAILURE;
+        }
+        BasicTable::set_shard_map(shards);
+    }
+
+    if (shards) {
+        for (size_t shard = 0; shard < shards->size(); ++shard) {
+            if (!check_schema(*shards->connection(shard)))
+                return EXIT_FAILURE;
+        }
+    } else if (!check_schema(*con)) {
+        return EXIT_FAILURE;
+    }
+
+    // SEV_POOL_SIZE=<n> sets how many connections batch jobs run on in parallel (default 4).
+    size_t pool_size = 4;
+    if (const char *size = std::getenv("SEV_POOL_SIZE"))
+        pool_size = static_cast<size_t>(std::max(1, std::atoi(size)));
+    // Pooled connections are opened on worker threads, so a failure must throw rather than exit.
+    auto pool = std::make_shared<ConnectionPool>([server = std::string(std::getenv("MYSQL_SERVER"))] { return connect_server(server); },
+                                                 pool_size);
+    ResultBatchJob result_batch_job(pool);
+    result_batch_job.set_shard_map(shards);
+
+    // SEV_WRITE_BEHIND=await|async batches membership and attendance writes on a separate connection.
+    std::shared_ptr<WriteBehindQueue> write_queue;
+    if (const char *write_behind = std::getenv("SEV_WRITE_BEHIND")) {
+        WriteBehindOptions options;
+        if (std::string(write_behind) == "async")
+            options.durability = WriteDurability::fire_and_forget;
+        write_queue = std::make_shared<WriteBehindQueue>(connect_mysql(), options);
+        club_table.set_write_queue(write_queue);
+        gathering_table.set_write_queue(write_queue);
+    }
+
+    // SEV_BUDGET_LEDGER=1 records budget credits in Budget_Ledger and compacts them in the background.
+    std::unique_ptr<BudgetLedgerCompactor> ledger_compactor;
+    if (std::getenv("SEV_BUDGET_LEDGER")) {
+        club_table.set_budget_ledger(true);
+        ledger_compactor = std::make_unique<BudgetLedgerCompactor>(connect_mysql());
+        ledger_compactor->start(std::chrono::seconds(5));
+    }
+
+    // SEV_ASYNC_PURGE=1 deletes clubs and activities in the background in small chunks.
+    std::shared_ptr<CascadePurger> purger;
+    if (std::getenv("SEV_ASYNC_PURGE")) {
+        purger = std::make_shared<CascadePurger>(connect_mysql());
+        purger->resume_pending();
+        club_table.set_purger(purger);
+    }
+
+    // SEV_SEARCH_INDEX=1 answers name/title substring searches from in-memory trigram indexes.
+    std::vector<std::shared_ptr<TrigramIndex>> search_indexes;
+    if (std::getenv("SEV_SEARCH_INDEX")) {
+        auto student_names = std::make_shared<TrigramIndex>("Student", "student_id", "name");
+        auto club_names = std::make_shared<TrigramIndex>("Club", "club_id", "club_name");
+        auto activity_titles = std::make_shared<TrigramIndex>("Activity", "act_id", "act_title");
+        auto gathering_names = std::make_shared<TrigramIndex>("Gathering", "gathering_id", "gathering_name");
+        search_indexes = {student_names, club_names, activity_titles, gathering_names};
+
+        for (const auto &index : search_indexes) {
+            index->build(con);
+            index->start_refresh(connect_mysql(), std::chrono::seconds(60));
+        }
+        student_table.set_name_index(student_names);
+        club_table.set_search_indexes(club_names, student_names, activity_titles);
+        gathering_table.set_name_index(gathering_names);
+    }
+
+    // SEV_PERIOD_INDEX=1 answers activity period searches from an in-memory interval index.
+    std::shared_ptr<ActivityIntervalIndex> period_index;
+    if (std::getenv("SEV_PERIOD_INDEX")) {
+        period_index = std::make_shared<ActivityIntervalIndex>();
+        period_index->build(con);
+        period_index->start_refresh(connect_mysql(), std::chrono::seconds(60));
+        club_table.set_period_index(period_index);
+    }
+
+    // SEV_CONFLICT_CHECK=1 refuses to add a student to a gathering that overlaps their schedule.
+    if (std::getenv("SEV_CONFLICT_CHECK"))
+        gathering_table.set_conflict_check(true);
+
+    // SEV_CLUB_COUNTERS=1 reads member/activity counts from Club counter columns, reconciled at startup.
+    if (std::getenv("SEV_CLUB_COUNTERS")) {
+        club_table.set_club_counters(true);
+        student_table.set_club_counters(true);
+        ClubCounterReconciler(pool).reconcile();
+    }
+
+    // SEV_ACTIVITY_ROLLUP=1 keeps Club_Activity_Rollup current and reads yearly figures from it.
+    std::unique_ptr<ActivityRollup> activity_rollup;
+    if (std::getenv("SEV_ACTIVITY_ROLLUP")) {
+        activity_rollup = std::make_unique<ActivityRollup>(pool);
+        club_table.set_activity_rollup(true);
+        gathering_table.set_activity_rollup(true);
+        student_table.set_activity_rollup(true);
+        result_table.set_activity_rollup(true);
+        result_batch_job.set_activity_rollup(true);
+    }
+
+    // SEV_MEMBERSHIP_GRAPH=1 keeps club and gathering rosters as in-memory bitmaps for set queries.
+    std::shared_ptr<MembershipGraph> membership_graph;
+    if (std::getenv("SEV_MEMBERSHIP_GRAPH")) {
+        membership_graph = std::make_shared<MembershipGraph>();
+        membership_graph->build(con);
+        membership_graph->start_refresh(connect_mysql(), std::chrono::seconds(60));
+        club_table.set_membership_graph(membership_graph);
+        gathering_table.set_membership_graph(membership_graph);
+    }
+
+    // SEV_ANALYTICS=1 keeps a columnar snapshot of Student, Club and Club_Student for reports.
+    std::unique_ptr<ColumnarSnapshot> snapshot;
+    if (std::getenv("SEV_ANALYTICS")) {
+        snapshot = std::make_unique<ColumnarSnapshot>();
+        snapshot->reload(con);
+        snapshot->start_refresh(connect_mysql(), std::chrono::seconds(30));
+    }
+
+    // SEV_SKETCHES=<file> keeps approximate membership figures as sketches persisted to that file.
+    std::shared_ptr<MembershipSketches> sketches;
+    if (const char *sketch_file = std::getenv("SEV_SKETCHES")) {
+        sketches = std::make_shared<MembershipSketches>(sketch_file);
+        if (!sketches->load())
+            sketches->rebuild(con);
+        sketches->start_autosave(std::chrono::seconds(30));
+        club_table.set_membership_sketches(sketches);
+        gathering_table.set_membership_sketches(sketches);
+    }
+
+    // SEV_SLOW_QUERY=<file> records statements slower than SEV_SLOW_QUERY_MS (default 100) with their plans.
+    std::shared_ptr<SlowQueryLog> slow_query_log;
+    if (const char *slow_query_file = std::getenv("SEV_SLOW_QUERY")) {
+        SlowQueryOptions options;
+        if (const char *ms = std::getenv("SEV_SLOW_QUERY_MS"))
+            options.threshold = std::chrono::milliseconds(std::max(0, std::atoi(ms)));
+        slow_query_log = std::make_shared<SlowQueryLog>(connect_mysql(), slow_query_file, options);
+        BasicTable::set_slow_query_log(slow_query_log);
+    }
+
+    // SEV_QUERY_DIGESTS=1 aggregates latency, rows and errors per statement shape (8. Diagnostics).
+    std::shared_ptr<QueryDigestTable> query_digests;
+    if (std::getenv("SEV_QUERY_DIGESTS")) {
+        query_digests = std::make_shared<QueryDigestTable>();
+        BasicTable::set_query_digests(query_digests);
+    }
+
+    // SEV_REPLICAS=<host:port>,... sends reads to replicas lagging at most SEV_REPLICA_MAX_LAG seconds (default 2);
+    // SEV_READ_YOUR_WRITES=<ms> keeps reads on the primary that long after a write (default 2000), =gtid waits for replicas to apply it.
+    std::shared_ptr<ReplicaSet> replicas;
+    if (const char *replica_list = std::getenv("SEV_REPLICAS")) {
+        std::vector<std::string> servers;
+        std::istringstream list(replica_list);
+        for (std::string server; std::getline(list, server, ',');) {
+            if (!server.empty())
+                servers.push_back(server);
+        }
+        ReplicaOptions options;
+        if (const char *lag = std::getenv("SEV_REPLICA_MAX_LAG"))
+            options.max_lag = std::chrono::seconds(std::max(0, std::atoi(lag)));
+        if (const char *consistency = std::getenv("SEV_READ_YOUR_WRITES")) {
+            if (std::string(consistency) == "gtid")
+                options.compare_gtids = true;
+            else
+                options.pin_window = std::chrono::milliseconds(std::max(0, std::atoi(consistency)));
+        }
+        replicas = std::make_shared<ReplicaSet>(servers, connect_server, options);
+        replicas->start();
+        BasicTable::set_replicas(replicas);
+    }
+
+    // SEV_MAX_COLUMN_WIDTH=<n> cuts table cells wider than n terminal columns; SEV_PAGER=<command> pages tall tables.
+    RenderOptions render_options;
+    if (const char *width = std::getenv("SEV_MAX_COLUMN_WIDTH"))
+        if (std::atoi(width) > 0)
+            render_options.max_column_width = static_cast<size_t>(std::atoi(width));
+    if (const char *pager = std::getenv("SEV_PAGER"))
+        render_options.pager = pager;
+    set_render_options(render_options);
+
+    // SEV_CAPTURE=<file> records every service call with its arguments for tools/workload_replay.
+    const char *capture_file = std::getenv("SEV_CAPTURE");
+    if (capture_file)
+        WorkloadCapture::start(capture_file);
 
     Logger(ll_info, "Initiation Done!").log();
 
@@ -753,7 +1540,7 @@ int main() {
         int query_num;
         std::cout << "\n<<Select Table for Service>>\n\n";
         std::cout << "1. Club\t\t2. Student\n"
-                  << "3. Professor\t4. Result\n5. Location\t6. Equipment\n";
+                  << "3. Professor\t4. Result\n5. Location\t6. Equipment\n7. Analytics\t8. Diagnostics\n0. Exit\n";
 
         std::cin >> query_num;
 
@@ -763,19 +1550,47 @@ int main() {
             continue;
         }
 
+        if (query_num == 0)
+            break;
+
         switch (query_num) {
         case 1:
-            club_menu(club_table, gathering_table);
+            club_menu(club_table, gathering_table, result_table);
             break;
         case 2:
             student_menu(student_table);
             break;
         case 3:
             professor_menu(professor_table);
+            break;
+        case 4:
+            result_menu(result_table, result_batch_job, activity_rollup.get());
+            break;
+        case 7:
+            if (snapshot) {
+                analytics_menu(*snapshot, sketches.get(), con);
+            } else {
+                std::cout << "Analytics snapshot is disabled (set SEV_ANALYTICS=1)." << std::endl;
+            }
+            break;
+        case 8:
+            diagnostics_menu(slow_query_log.get(), query_digests.get(), replicas.get(), shards.get());
+            break;
         default:
             break;
         }
     }
 
+    if (capture_file)
+        WorkloadCapture::stop();
+    if (slow_query_log)
+        BasicTable::set_slow_query_log(nullptr);
+    if (replicas)
+        BasicTable::set_replicas(nullptr);
+    if (shards)
+        BasicTable::set_shard_map(nullptr);
+
+    if (trace_file)
+        Tracer::write(trace_file);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "TableRenderer.h"
+#include "../utils.h"
+
+namespace {
+
+RenderOptions render_options;
+
+/**
+ * @brief Columns are never narrower than this, as before.
+ */
+constexpr size_t min_column_width = 10;
+
+/**
+ * @brief Formatted output is written out whenever the buffer grows past this.
+ */
+constexpr size_t flush_threshold = 256 * 1024;
+
+/**
+ * @brief Length of the UTF-8 sequence a byte starts: 1 for ASCII, 2-4 for lead bytes, 0 for
+ * continuation bytes and bytes that never occur in valid UTF-8 (C0, C1, F5-FF).
+ */
+constexpr std::array<uint8_t, 256> sequence_length = [] {
+    std::array<uint8_t, 256> table{};
+    for (int b = 0x00; b <= 0x7F; ++b)
+        table[b] = 1;
+    for (int b = 0xC2; b <= 0xDF; ++b)
+        table[b] = 2;
+    for (int b = 0xE0; b <= 0xEF; ++b)
+        table[b] = 3;
+    for (int b = 0xF0; b <= 0xF4; ++b)
+        table[b] = 4;
+    return table;
+}();
+
+/**
+ * @brief Smallest code point each sequence length may encode; anything below is an overlong form.
+ */
+constexpr uint32_t min_code_point[5] = {0, 0, 0x80, 0x800, 0x10000};
+
+struct WidthRange {
+    uint32_t first;
+    uint32_t last;
+    uint8_t width;
+};
+
+/**
+ * @brief Code points whose width is not 1, sorted and disjoint: combining marks and format
+ * characters (0) and East Asian Wide/Fullwidth characters including emoji presentation (2).
+ */
+constexpr WidthRange width_ranges[] = {
+    {0x0300, 0x036F, 0},   {0x0483, 0x0489, 0},   {0x0591, 0x05BD, 0},   {0x0610, 0x061A, 0},
+    {0x064B, 0x065F, 0},   {0x0670, 0x0670, 0},   {0x06D6, 0x06DC, 0},   {0x1100, 0x115F, 2},
+    {0x1160, 0x11FF, 0},   {0x1AB0, 0x1AFF, 0},   {0x1DC0, 0x1DFF, 0},   {0x200B, 0x200F, 0},
+    {0x202A, 0x202E, 0},   {0x2060, 0x2064, 0},   {0x20D0, 0x20FF, 0},   {0x231A, 0x231B, 2},
+    {0x2329, 0x232A, 2},   {0x23E9, 0x23EC, 2},   {0x23F0, 0x23F0, 2},   {0x23F3, 0x23F3, 2},
+    {0x25FD, 0x25FE, 2},   {0x2614, 0x2615, 2},   {0x2648, 0x2653, 2},   {0x267F, 0x267F, 2},
+    {0x2693, 0x2693, 2},   {0x26A1, 0x26A1, 2},   {0x26AA, 0x26AB, 2},   {0x26BD, 0x26BE, 2},
+    {0x26C4, 0x26C5, 2},   {0x26CE, 0x26CE, 2},   {0x26D4, 0x26D4, 2},   {0x26EA, 0x26EA, 2},
+    {0x26F2, 0x26F3, 2},   {0x26F5, 0x26F5, 2},   {0x26FA, 0x26FA, 2},   {0x26FD, 0x26FD, 2},
+    {0x2705, 0x2705, 2},   {0x270A, 0x270B, 2},   {0x2728, 0x2728, 2},   {0x274C, 0x274C, 2},
+    {0x274E, 0x274E, 2},   {0x2753, 0x2755, 2},   {0x2757, 0x2757, 2},   {0x2795, 0x2797, 2},
+    {0x27B0, 0x27B0, 2},   {0x27BF, 0x27BF, 2},   {0x2B1B, 0x2B1C, 2},   {0x2B50, 0x2B50, 2},
+    {0x2B55, 0x2B55, 2},   {0x2E80, 0x3029, 2},   {0x302A, 0x302D, 0},   {0x302E, 0x303E, 2},
+    {0x3041, 0x3098, 2},   {0x3099, 0x309A, 0},   {0x309B, 0x33FF, 2},   {0x3400, 0x4DBF, 2},
+    {0x4E00, 0xA4CF, 2},   {0xA960, 0xA97F, 2},   {0xAC00, 0xD7A3, 2},   {0xD7B0, 0xD7FF, 0},
+    {0xF900, 0xFAFF, 2},   {0xFE00, 0xFE0F, 0},   {0xFE10, 0xFE19, 2},   {0xFE20, 0xFE2F, 0},
+    {0xFE30, 0xFE6F, 2},   {0xFEFF, 0xFEFF, 0},   {0xFF00, 0xFF60, 2},   {0xFFE0, 0xFFE6, 2},
+    {0x16FE0, 0x16FE4, 2}, {0x17000, 0x18CFF, 2}, {0x1B000, 0x1B2FF, 2}, {0x1F004, 0x1F004, 2},
+    {0x1F0CF, 0x1F0CF, 2}, {0x1F18E, 0x1F18E, 2}, {0x1F191, 0x1F19A, 2}, {0x1F200, 0x1F2FF, 2},
+    {0x1F300, 0x1F320, 2}, {0x1F32D, 0x1F335, 2}, {0x1F337, 0x1F37C, 2}, {0x1F37E, 0x1F393, 2},
+    {0x1F3A0, 0x1F3CA, 2}, {0x1F3CF, 0x1F3D3, 2}, {0x1F3E0, 0x1F3F0, 2}, {0x1F3F4, 0x1F3F4, 2},
+    {0x1F3F8, 0x1F43E, 2}, {0x1F440, 0x1F440, 2}, {0x1F442, 0x1F4FC, 2}, {0x1F4FF, 0x1F53D, 2},
+    {0x1F54B, 0x1F54E, 2}, {0x1F550, 0x1F567, 2}, {0x1F57A, 0x1F57A, 2}, {0x1F595, 0x1F596, 2},
+    {0x1F5A4, 0x1F5A4, 2}, {0x1F5FB, 0x1F64F, 2}, {0x1F680, 0x1F6C5, 2}, {0x1F6CC, 0x1F6CC, 2},
+    {0x1F6D0, 0x1F6D2, 2}, {0x1F6D5, 0x1F6D7, 2}, {0x1F6DC, 0x1F6DF, 2}, {0x1F6EB, 0x1F6EC, 2},
+    {0x1F6F4, 0x1F6FC, 2}, {0x1F7E0, 0x1F7EB, 2}, {0x1F7F0, 0x1F7F0, 2}, {0x1F90C, 0x1F93A, 2},
+    {0x1F93C, 0x1F945, 2}, {0x1F947, 0x1F9FF, 2}, {0x1FA70, 0x1FAFF, 2}, {0x20000, 0x2FFFD, 2},
+    {0x30000, 0x3FFFD, 2}, {0xE0001, 0xE0001, 0}, {0xE0020, 0xE007F, 0}, {0xE0100, 0xE01EF, 0},
+};
+
+size_t code_point_width(uint32_t cp) {
+    if (cp < 0x0300)
+        return 1;
+    if (cp >= 0xAC00 && cp <= 0xD7A3)
+        return 2;
+    const WidthRange *end = std::end(width_ranges);
+    const WidthRange *range =
+        std::upper_bound(std::begin(width_ranges), end, cp, [](uint32_t c, const WidthRange &r) { return c < r.first; });
+    if (range == std::begin(width_ranges) || cp > (range - 1)->last)
+        return 1;
+    return (range - 1)->width;
+}
+
+/**
+ * @brief Decodes the sequence at p. An invalid or truncated sequence consumes one byte.
+ * @param cp Set to the code point, or U+FFFD for an invalid sequence.
+ * @return Number of bytes consumed.
+ */
+size_t decode(const unsigned char *p, size_t remaining, uint32_t &cp) {
+    size_t length = sequence_length[p[0]];
+    if (length < 2 || length > remaining) {
+        cp = 0xFFFD;
+        return 1;
+    }
+    uint32_t value = p[0] & (0x7F >> length);
+    for (size_t k = 1; k < length; ++k) {
+        if ((p[k] & 0xC0) != 0x80) {
+            cp = 0xFFFD;
+            return 1;
+        }
+        value = (value << 6) | (p[k] & 0x3F);
+    }
+    if (value < min_code_point[length] || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) {
+        cp = 0xFFFD;
+        return 1;
+    }
+    cp = value;
+    return length;
+}
+
+/**
+ * @brief Returns how many ASCII bytes text has from position i on.
+ */
+size_t ascii_run(const unsigned char *text, size_t size, size_t i) {
+    size_t j = i;
+    while (j + 8 <= size) {
+        uint64_t word;
+        std::memcpy(&word, text + j, 8);
+        if (word & 0x8080808080808080ULL)
+            break;
+        j += 8;
+    }
+    while (j < size && text[j] < 0x80)
+        ++j;
+    return j - i;
+}
+
+/**
+ * @brief Where the formatted table goes: a stream, or a pager's pipe.
+ */
+class TableSink {
+public:
+    TableSink(std::ostream &out, FILE *pipe) : out(out), pipe(pipe) {}
+
+    void write(const std::string &data) {
+        if (pipe)
+            std::fwrite(data.data(), 1, data.size(), pipe);
+        else
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+private:
+    std::ostream &out;
+    FILE *pipe;
+};
+
+size_t terminal_rows() {
+    winsize size{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0)
+        return size.ws_row;
+    if (const char *lines = std::getenv("LINES"))
+        if (std::atoi(lines) > 0)
+            return static_cast<size_t>(std::atoi(lines));
+    return 24;
+}
+
+/**
+ * @brief Appends one table row to buffer, cutting cells wider than their column.
+ */
+template <typename Cell>
+void append_row(std::string &buffer, const std::vector<size_t> &widths, Cell cell) {
+    for (size_t column = 0; column < widths.size(); ++column) {
+        std::string_view text = cell(column);
+        size_t width = widths[column];
+        buffer += "| ";
+        TextExtent extent = fit_display_width(text, width);
+        if (extent.bytes < text.size()) {
+            extent = fit_display_width(text, width - 1);
+            buffer.append(text.data(), extent.bytes);
+            buffer += '~';
+            extent.width += 1;
+        } else {
+            buffer.append(text.data(), text.size());
+        }
+        buffer.append(width - extent.width + 1, ' ');
+    }
+    buffer += "|\n";
+}
+
+} // namespace
+
+void set_render_options(const RenderOptions &options) {
+    render_options = options;
+}
+
+TextExtent fit_display_width(std::string_view text, size_t max_width) {
+    const auto *bytes = reinterpret_cast<const unsigned char *>(text.data());
+    const size_t size = text.size();
+    size_t width = 0;
+    size_t i = 0;
+    while (i < size) {
+        if (bytes[i] < 0x80) {
+            size_t run = ascii_run(bytes, size, i);
+            if (width + run > max_width)
+                return {max_width, i + (max_width - width)};
+            width += run;
+            i += run;
+            continue;
+        }
+        uint32_t cp;
+        size_t length = decode(bytes + i, size - i, cp);
+        size_t cp_width = code_point_width(cp);
+        if (width + cp_width > max_width)
+            return {width, i};
+        width += cp_width;
+        i += length;
+    }
+    return {width, size};
+}
+
+size_t display_width(std::string_view text) {
+    return fit_display_width(text, SIZE_MAX).width;
+}
+
+void render_table(const std::vector<std::string> &column_names, size_t rows, const CellSource &cell,
+                  std::ostream &out) {
+    TraceSpan span("render", "render_table");
+    const size_t column_count = column_names.size();
+    const size_t max_width = render_options.max_column_width;
+
+    std::vector<size_t> widths(column_count, min_column_width);
+    for (size_t column = 0; column < column_count; ++column) {
+        widths[column] = std::max(widths[column], display_width(column_names[column]));
+        for (size_t row = 0; row < rows; ++row) {
+            // Once a column has reached the limit, measuring the rest of it changes nothing.
+            if (max_width && widths[column] >= max_width)
+                break;
+            widths[column] = std::max(widths[column], display_width(cell(row, column)));
+        }
+        if (max_width)
+            widths[column] = std::min(widths[column], max_width);
+    }
+
+    FILE *pipe = nullptr;
+    void (*previous_sigpipe)(int) = SIG_DFL;
+    if (!render_options.pager.empty() && &out == &std::cout && isatty(STDOUT_FILENO) && rows + 4 > terminal_rows()) {
+        std::cout.flush();
+        pipe = popen(render_options.pager.c_str(), "w");
+        if (pipe)
+            previous_sigpipe = std::signal(SIGPIPE, SIG_IGN); // quitting the pager early must not kill us
+        else
+            Logger(ll_error, "Failed to start pager: " + render_options.pager).log();
+    }
+    TableSink sink(out, pipe);
+
+    static thread_local std::string buffer;
+    if (buffer.capacity() < flush_threshold * 2)
+        buffer.reserve(flush_threshold * 2);
+    buffer.clear();
+
+    std::string separator;
+    for (size_t width : widths)
+        separator.append("+").append(width + 2, '-');
+    separator += "+\n";
+
+    buffer += separator;
+    append_row(buffer, widths, [&](size_t column) { return std::string_view(column_names[column]); });
+    buffer += separator;
+    for (size_t row = 0; row < rows; ++row) {
+        append_row(buffer, widths, [&](size_t column) { return cell(row, column); });
+        if (buffer.size() >= flush_threshold) {
+            sink.write(buffer);
+            buffer.clear();
+        }
+    }
+    buffer += separator;
+    sink.write(buffer);
+    buffer.clear();
+
+    if (pipe) {
+        pclose(pipe);
+        std::signal(SIGPIPE, previous_sigpipe);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief How result tables are laid out and where they go.
+ */
+struct RenderOptions {
+    /**
+     * @brief Cells wider than this many terminal columns are cut and end in '~'; 0 means no limit.
+     */
+    size_t max_column_width = 0;
+
+    /**
+     * @brief Command a table taller than the terminal is piped through, e.g. "less -S"; empty for none.
+     * Only used when standard output is a terminal.
+     */
+    std::string pager;
+};
+
+/**
+ * @brief Replaces the options used by render_table. Call before rendering starts, e.g. at startup.
+ * @param options The new options.
+ */
+void set_render_options(const RenderOptions &options);
+
+/**
+ * @brief Width and byte length of a prefix of UTF-8 text as laid out on a terminal.
+ */
+struct TextExtent {
+    size_t width;
+    size_t bytes;
+};
+
+/**
+ * @brief Finds the longest prefix of text that fits in max_width terminal columns.
+ *
+ * East Asian wide and fullwidth characters (Hangul, CJK, fullwidth forms, most emoji) take two
+ * columns, combining marks and zero-width characters none, everything else one. Bytes that are
+ * not valid UTF-8 count as one column each.
+ *
+ * @param text UTF-8 text.
+ * @param max_width Available columns.
+ * @return The prefix's display width and length in bytes; bytes == text.size() if all of it fits.
+ */
+TextExtent fit_display_width(std::string_view text, size_t max_width);
+
+/**
+ * @brief Returns how many terminal columns text occupies.
+ * @param text UTF-8 text.
+ */
+size_t display_width(std::string_view text);
+
+/**
+ * @brief Returns the cell at (row, column), both zero-based. The view must stay valid until render_table returns.
+ */
+using CellSource = std::function<std::string_view(size_t row, size_t column)>;
+
+/**
+ * @brief Writes a bordered table, with columns padded to their display width.
+ *
+ * The table is formatted into one reused buffer and written in large chunks. Wide cells are cut
+ * to RenderOptions::max_column_width; when out is std::cout, the table is taller than the
+ * terminal and a pager is configured, it is written through the pager instead.
+ *
+ * @param column_names Header labels.
+ * @param rows Number of rows.
+ * @param cell Returns the cell text.
+ * @param out Destination stream.
+ */
+void render_table(const std::vector<std::string> &column_names, size_t rows, const CellSource &cell,
+                  std::ostream &out = std::cout);
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+
+#include "../utils.h"
+#include "ActivityRollup.h"
+#include "BasicTable.h"
+#include "Transaction.h"
+
+/**
+ * @brief Rollup rows of the clubs in [?, ?], grouped from the base tables.
+ */
+static const std::string grouped_rows =
+    "SELECT a.club_id, YEAR(a.start_date) AS year, COUNT(DISTINCT a.act_id) AS activity_count, "
+    "COUNT(DISTINCT g.gathering_id) AS gathering_count, COUNT(gs.student_id) AS attendee_count "
+    "FROM Activity AS a "
+    "LEFT JOIN Gathering AS g ON g.act_id = a.act_id "
+    "LEFT JOIN Gathering_Student AS gs ON gs.gathering_id = g.gathering_id "
+    "WHERE a.club_id BETWEEN ? AND ? AND a.pending_delete = 0 "
+    "GROUP BY a.club_id, YEAR(a.start_date)";
+
+ActivityRollup::ActivityRollup(std::shared_ptr<ConnectionPool> connection_pool, int partition_size)
+    : pool(connection_pool), partition_size(std::max(partition_size, 1)) {}
+
+std::optional<ActivityContribution> ActivityRollup::contribution(std::shared_ptr<sql::Connection> conn, int act_id) {
+    std::string query = "SELECT a.club_id, YEAR(a.start_date), COUNT(DISTINCT g.gathering_id), COUNT(gs.student_id) "
+                        "FROM Activity AS a "
+                        "LEFT JOIN Gathering AS g ON g.act_id = a.act_id "
+                        "LEFT JOIN Gathering_Student AS gs ON gs.gathering_id = g.gathering_id "
+                        "WHERE a.act_id = ? AND a.pending_delete = 0 AND a.club_id IS NOT NULL "
+                        "GROUP BY a.club_id, YEAR(a.start_date)";
+    std::unique_ptr<sql::ResultSet> res = BasicTable::execute_query(*conn, query, {act_id});
+    if (!res->next())
+        return std::nullopt;
+    return ActivityContribution{res->getInt(1), res->getInt(2), res->getInt(3), res->getInt(4)};
+}
+
+void ActivityRollup::apply(std::shared_ptr<sql::Connection> conn, int club_id, int year, int activities, int gatherings,
+                           int attendees) {
+    if (activities == 0 && gatherings == 0 && attendees == 0)
+        return;
+    std::string query = "INSERT INTO Club_Activity_Rollup (club_id, year, activity_count, gathering_count, attendee_count) "
+                        "VALUES (?, ?, ?, ?, ?) AS d "
+                        "ON DUPLICATE KEY UPDATE activity_count = Club_Activity_Rollup.activity_count + d.activity_count, "
+                        "gathering_count = Club_Activity_Rollup.gathering_count + d.gathering_count, "
+                        "attendee_count = Club_Activity_Rollup.attendee_count + d.attendee_count";
+    BasicTable::execute_update(*conn, query, {club_id, year, activities, gatherings, attendees});
+}
+
+void ActivityRollup::apply_difference(std::shared_ptr<sql::Connection> conn, const std::optional<ActivityContribution> &before,
+                                      const std::optional<ActivityContribution> &after) {
+    if (before && after && before->club_id == after->club_id && before->year == after->year) {
+        apply(conn, after->club_id, after->year, 0, after->gatherings - before->gatherings, after->attendees - before->attendees);
+        return;
+    }
+    if (before)
+        apply(conn, before->club_id, before->year, -1, -before->gatherings, -before->attendees);
+    if (after)
+        apply(conn, after->club_id, after->year, 1, after->gatherings, after->attendees);
+}
+
+void ActivityRollup::apply_for_gathering(std::shared_ptr<sql::Connection> conn, int gathering_id, int gatherings, int attendees) {
+    if (gatherings == 0 && attendees == 0)
+        return;
+    std::string query = "INSERT INTO Club_Activity_Rollup (club_id, year, activity_count, gathering_count, attendee_count) "
+                        "SELECT * FROM (SELECT a.club_id, YEAR(a.start_date) AS year, 0 AS activity_count, "
+                        "? AS gathering_count, ? AS attendee_count FROM Gathering AS g "
+                        "JOIN Activity AS a ON a.act_id = g.act_id "
+                        "WHERE g.gathering_id = ? AND a.pending_delete = 0 AND a.club_id IS NOT NULL) AS d "
+                        "ON DUPLICATE KEY UPDATE gathering_count = Club_Activity_Rollup.gathering_count + d.gathering_count, "
+                        "attendee_count = Club_Activity_Rollup.attendee_count + d.attendee_count";
+    BasicTable::execute_update(*conn, query, {gatherings, attendees, gathering_id});
+}
+
+void ActivityRollup::remove_student(std::shared_ptr<sql::Connection> conn, int student_id) {
+    std::string query = "UPDATE Club_Activity_Rollup AS r JOIN "
+                        "(SELECT a.club_id, YEAR(a.start_date) AS year, COUNT(*) AS attendances FROM Gathering_Student AS gs "
+                        "JOIN Gathering AS g ON g.gathering_id = gs.gathering_id "
+                        "JOIN Activity AS a ON a.act_id = g.act_id "
+                        "WHERE gs.student_id = ? AND a.pending_delete = 0 "
+                        "GROUP BY a.club_id, YEAR(a.start_date)) AS d ON d.club_id = r.club_id AND d.year = r.year "
+                        "SET r.attendee_count = r.attendee_count - d.attendances";
+    BasicTable::execute_update(*conn, query, {student_id});
+}
+
+void ActivityRollup::refresh_for_gathering(std::shared_ptr<sql::Connection> conn, int gathering_id) {
+    std::string key_query = "SELECT a.club_id, YEAR(a.start_date) FROM Gathering AS g JOIN Activity AS a ON a.act_id = g.act_id "
+                            "WHERE g.gathering_id = ? AND a.pending_delete = 0 AND a.club_id IS NOT NULL";
+    std::unique_ptr<sql::ResultSet> key = BasicTable::execute_query(*conn, key_query, {gathering_id});
+    if (!key->next())
+        return;
+    int club_id = key->getInt(1);
+    int year = key->getInt(2);
+
+    // A date range rather than YEAR(start_date) so that the (club_id, start_date) index applies.
+    std::string query = "INSERT INTO Club_Activity_Rollup (club_id, year, activity_count, gathering_count, attendee_count) "
+                        "SELECT * FROM (SELECT ? AS club_id, ? AS year, COUNT(DISTINCT a.act_id) AS activity_count, "
+                        "COUNT(DISTINCT g.gathering_id) AS gathering_count, COUNT(gs.student_id) AS attendee_count "
+                        "FROM Activity AS a "
+                        "LEFT JOIN Gathering AS g ON g.act_id = a.act_id "
+                        "LEFT JOIN Gathering_Student AS gs ON gs.gathering_id = g.gathering_id "
+                        "WHERE a.club_id = ? AND a.start_date >= ? AND a.start_date < ? AND a.pending_delete = 0) AS d "
+                        "ON DUPLICATE KEY UPDATE activity_count = d.activity_count, gathering_count = d.gathering_count, "
+                        "attendee_count = d.attendee_count";
+    BasicTable::execute_update(*conn, query, {club_id, year, club_id, std::to_string(year) + "-01-01", std::to_string(year + 1) + "-01-01"});
+}
+
+RollupRebuildSummary ActivityRollup::rebuild() {
+    auto started = std::chrono::steady_clock::now();
+    RollupRebuildSummary summary;
+
+    int min_id = 0, max_id = -1;
+    try {
+        ConnectionPool::Lease lease = pool->acquire();
+        std::unique_ptr<sql::Statement> stmt(lease->createStatement());
+        std::string query = "SELECT MIN(club_id), MAX(club_id) FROM Club";
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query));
+        Logger(ll_info, "executeQuery: " + query).log();
+        if (res->next() && !res->isNull(1)) {
+            min_id = res->getInt(1);
+            max_id = res->getInt(2);
+        }
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in ActivityRollup::rebuild: " + std::string(e.what())).log();
+        summary.failed_partitions = 1;
+        return summary;
+    }
+
+    std::vector<std::pair<int, int>> partitions;
+    for (int64_t first = min_id; first <= max_id; first += partition_size)
+        partitions.emplace_back(static_cast<int>(first), static_cast<int>(std::min<int64_t>(first + partition_size - 1, max_id)));
+
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> rows{0};
+    std::atomic<size_t> rebuilt{0};
+
+    auto work = [&] {
+        std::optional<ConnectionPool::Lease> lease;
+        try {
+            lease.emplace(pool->acquire());
+        } catch (const sql::SQLException &e) {
+            // The partitions this worker would have taken are left to the others, or counted as failed below.
+            Logger(ll_error, "SQL error in ActivityRollup::rebuild: " + std::string(e.what())).log();
+            return;
+        }
+        for (size_t i = next++; i < partitions.size(); i = next++) {
+            // A partition can deadlock with a concurrent delta on the same rows; InnoDB rolls one back, so retry.
+            int written = -1;
+            for (int attempt = 0; attempt < 3 && written < 0; ++attempt)
+                written = rebuild_partition(lease->get(), partitions[i].first, partitions[i].second);
+            if (written >= 0) {
+                rebuilt++;
+                rows += static_cast<size_t>(written);
+            }
+        }
+    };
+
+    size_t workers = std::min(pool->size(), partitions.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; ++i)
+        threads.emplace_back(work);
+    if (workers > 0)
+        work();
+    for (auto &thread : threads)
+        thread.join();
+
+    summary.partitions = partitions.size();
+    summary.rows = rows;
+    // Includes partitions no worker got to because no connection could be opened.
+    summary.failed_partitions = partitions.size() - rebuilt;
+    summary.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger(ll_info, "Activity rollup rebuilt: " + std::to_string(summary.rows) + " rows in " +
+                        std::to_string(summary.partitions) + " partitions, " + std::to_string(summary.failed_partitions) +
+                        " failed in " + std::to_string(summary.elapsed.count()) + " ms")
+        .log();
+    return summary;
+}
+
+int ActivityRollup::rebuild_partition(std::shared_ptr<sql::Connection> conn, int first, int last) {
+    try {
+        Transaction transaction(conn);
+
+        std::string delete_query = "DELETE FROM Club_Activity_Rollup WHERE club_id BETWEEN ? AND ?";
+        BasicTable::execute_update(*conn, delete_query, {first, last});
+
+        std::string insert_query = "INSERT INTO Club_Activity_Rollup "
+                                   "(club_id, year, activity_count, gathering_count, attendee_count) " +
+                                   grouped_rows;
+        int written = BasicTable::execute_update(*conn, insert_query, {first, last});
+
+        transaction.commit();
+        return written;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in ActivityRollup::rebuild_partition: " + std::string(e.what())).log();
+        return -1;
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <cppconn/connection.h>
+
+#include "ConnectionPool.h"
+
+/**
+ * @brief What one activity adds to its Club_Activity_Rollup row.
+ */
+struct ActivityContribution {
+    int club_id;
+    int year;
+    int gatherings;
+    int attendees;
+};
+
+/**
+ * @brief Totals of one rollup rebuild.
+ */
+struct RollupRebuildSummary {
+    size_t partitions = 0;
+    size_t rows = 0;
+    size_t failed_partitions = 0;
+    std::chrono::milliseconds elapsed{0};
+};
+
+/**
+ * @brief Maintains Club_Activity_Rollup(club_id, year, activity_count, gathering_count, attendee_count)
+ * (db_scripts/activity_rollup.sql).
+ *
+ * The static delta helpers run on the writer's connection, inside its transaction, and throw
+ * sql::SQLException so that a failed delta rolls the write back with it. An activity counts
+ * while pending_delete = 0, under the year of its start_date. rebuild() recomputes every row
+ * in parallel club_id partitions on pooled connections.
+ */
+class ActivityRollup {
+public:
+    /**
+     * @param connection_pool Rebuild partitions run on connections leased here.
+     * @param partition_size Number of club IDs per partition (and per transaction).
+     */
+    explicit ActivityRollup(std::shared_ptr<ConnectionPool> connection_pool, int partition_size = 500);
+
+    /**
+     * @brief Reads what an activity currently contributes.
+     * @return std::nullopt if the activity does not exist, has no club or is pending deletion.
+     */
+    static std::optional<ActivityContribution> contribution(std::shared_ptr<sql::Connection> conn, int act_id);
+
+    /**
+     * @brief Adds deltas to the (club_id, year) row, creating it if missing.
+     */
+    static void apply(std::shared_ptr<sql::Connection> conn, int club_id, int year, int activities, int gatherings,
+                      int attendees);
+
+    /**
+     * @brief Moves an activity's contribution from before to after (either may be std::nullopt).
+     */
+    static void apply_difference(std::shared_ptr<sql::Connection> conn, const std::optional<ActivityContribution> &before,
+                                 const std::optional<ActivityContribution> &after);
+
+    /**
+     * @brief Adds deltas to the row of a gathering's activity; does nothing if the activity does not count.
+     */
+    static void apply_for_gathering(std::shared_ptr<sql::Connection> conn, int gathering_id, int gatherings, int attendees);
+
+    /**
+     * @brief Subtracts a student's attendances; call before deleting the student, whose
+     * Gathering_Student rows go by ON DELETE CASCADE.
+     */
+    static void remove_student(std::shared_ptr<sql::Connection> conn, int student_id);
+
+    /**
+     * @brief Recomputes the row of a gathering's activity from the base tables, e.g. after writes
+     * whose exact effect is unknown (write-behind batches).
+     */
+    static void refresh_for_gathering(std::shared_ptr<sql::Connection> conn, int gathering_id);
+
+    /**
+     * @brief Recomputes every row, partition by partition, in parallel.
+     */
+    RollupRebuildSummary rebuild();
+
+private:
+    /**
+     * @brief Recomputes the rows of clubs [first, last] in one transaction.
+     * @return The number of rows written, or -1 if an error occurred.
+     */
+    int rebuild_partition(std::shared_ptr<sql::Connection> conn, int first, int last);
+
+    std::shared_ptr<ConnectionPool> pool;
+    int partition_size;
+};
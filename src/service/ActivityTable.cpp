@@ -1,18 +1,66 @@
+#include <algorithm>
 #include <memory>
 #include <map>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 #include <cppconn/resultset.h>
 #include <cppconn/prepared_statement.h>
 #include <cppconn/exception.h>
 
 #include "../utils.h"
+#include "../workload/ServiceCall.h"
 #include "BasicTable.h"
 #include "ActivityTable.h"
+#include "ShardMap.h"
+#include "Transaction.h"
 
-ActivityTable::ActivityTable(std::shared_ptr<sql::Connection> conn) : BasicTable("Activity", conn) {}
+ActivityTable::ActivityTable(std::shared_ptr<DbConnection> conn) : BasicTable("Activity", conn) {
+    visible_filter = "pending_delete = 0";
+}
+
+void ActivityTable::set_purger(std::shared_ptr<CascadePurger> cascade_purger) {
+    purger = cascade_purger;
+}
+
+void ActivityTable::set_title_index(std::shared_ptr<TrigramIndex> index) {
+    title_index = index;
+}
+
+void ActivityTable::set_period_index(std::shared_ptr<ActivityIntervalIndex> index) {
+    period_index = index;
+}
+
+void ActivityTable::set_activity_rollup(bool enabled) {
+    activity_rollup = enabled;
+}
+
+void ActivityTable::reindex_period(int act_id) {
+    try {
+        std::string query = "SELECT club_id, start_date, end_date FROM Activity "
+                            "WHERE act_id = ? AND pending_delete = 0 AND club_id IS NOT NULL";
+        std::unique_ptr<DbResult> res = execute_query(query, {act_id});
+
+        std::optional<int> start;
+        if (res->next())
+            start = date_to_days(res->get_string(1));
+        if (!start) {
+            period_index->erase(act_id);
+            return;
+        }
+        std::optional<int> end = res->is_null(2) ? ActivityIntervalIndex::open_end : date_to_days(res->get_string(2));
+        period_index->upsert(act_id, res->get_int(0), *start, end.value_or(ActivityIntervalIndex::open_end));
+    } catch (const sql::SQLException& e) {
+        // The periodic rebuild will pick the row up.
+        Logger(ll_error, "Error in reindex_period: " + std::string(e.what())).log();
+    }
+}
 
 bool ActivityTable::create_activity(int club_id, const std::string& act_title, 
                                     const std::string& start_date, const std::string& end_date) {
+    ServiceCall call("ActivityTable::create_activity", club_id, act_title, start_date, end_date);
+    ShardScope shard = ShardScope::club(club_id);
     try {
         std::string query = "INSERT INTO Activity (club_id, act_title, start_date, end_date) VALUES (?, ?, ";
 
@@ -23,17 +71,34 @@ bool ActivityTable::create_activity(int club_id, const std::string& act_title,
         }
         query += ")";
 
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, club_id);
-        pstmt->setString(2, act_title);
-        if (!start_date.empty()) {
-            pstmt->setString(3, start_date);
-            pstmt->setString(4, end_date);
-        } else {
-            pstmt->setString(3, end_date);
+        std::optional<Transaction> transaction;
+        if (activity_rollup)
+            transaction.emplace(connection());
+
+        std::vector<SqlParam> params{club_id, act_title};
+        if (!start_date.empty())
+            params.push_back(start_date);
+        params.push_back(end_date);
+        execute_update(query, params);
+
+        if (transaction) {
+            int act_id = last_insert_id();
+            if (act_id > 0)
+                ActivityRollup::apply_difference(connection(), std::nullopt, ActivityRollup::contribution(connection(), act_id));
+            transaction->commit();
+        }
+
+        if (title_index) {
+            int act_id = last_insert_id();
+            if (act_id > 0)
+                title_index->upsert(act_id, act_title);
+        }
+        if (period_index) {
+            // start_date may come from NOW(), so read back what the server stored.
+            int act_id = last_insert_id();
+            if (act_id > 0)
+                reindex_period(act_id);
         }
-        pstmt->executeUpdate();        
-        Logger(ll_info, "executeQuery: " + query).log();
     } catch (const sql::SQLException& e) {
         Logger(ll_error, "Error in create_activity: " + std::string(e.what())).log();
         return false;
@@ -41,13 +106,12 @@ bool ActivityTable::create_activity(int club_id, const std::string& act_title,
     return true;
 }
 
-std::unique_ptr<sql::ResultSet> ActivityTable::read_activity_by_club_id(int club_id) {
+std::unique_ptr<DbResult> ActivityTable::read_activity_by_club_id(int club_id) {
+    ServiceCall call("ActivityTable::read_activity_by_club_id", club_id);
+    ShardScope shard = ShardScope::club(club_id);
     try {
-        std::string query = "SELECT * FROM Activity WHERE club_id = ?";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, club_id);        
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
+        std::string query = "SELECT * FROM Activity WHERE club_id = ? AND pending_delete = 0";
+        std::unique_ptr<DbResult> res = execute_query(query, {club_id});
         return res;
     } catch (const sql::SQLException& e) {
         Logger(ll_error, "Error in read_activity_by_club_id: " + std::string(e.what())).log();
@@ -55,58 +119,146 @@ std::unique_ptr<sql::ResultSet> ActivityTable::read_activity_by_club_id(int club
     }
 }
 
-std::unique_ptr<sql::ResultSet> ActivityTable::read_activity_by_title(const std::string& act_title, int club_id) {
+std::shared_ptr<const QueryResult> ActivityTable::read_activity_by_title(const std::string& act_title, int club_id) {
+    ServiceCall call("ActivityTable::read_activity_by_title", act_title, club_id);
+    ShardScope shard = ShardScope::club(club_id);
     try {        
-        std::string query = "SELECT * FROM Activity WHERE act_title LIKE ?";
+        std::vector<int> ids;
+        bool use_index = title_index && title_index->ready() && TrigramIndex::covers(act_title);
+        if (use_index) {
+            ids = title_index->search(act_title);
+            use_index = ids.size() <= TrigramIndex::max_selective_matches;
+        }
+
+        std::string query = "SELECT * FROM Activity WHERE act_title LIKE ? AND pending_delete = 0";
+        if (use_index) {
+            // Matches come from the index; the server only fetches them by primary key.
+            query = "SELECT * FROM Activity WHERE act_id IN (";
+            for (size_t i = 0; i < ids.size(); ++i)
+                query += i == 0 ? "?" : ", ?";
+            query += ids.empty() ? "NULL) AND pending_delete = 0" : ") AND pending_delete = 0";
+        }
         if (club_id != -1)
             query += " AND club_id = ?";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setString(1, '%' + act_title + '%');
+        std::vector<SqlParam> params;
+        if (use_index) {
+            params.assign(ids.begin(), ids.end());
+        } else {
+            params.push_back('%' + act_title + '%');
+        }
         if (club_id != -1)
-            pstmt->setInt(2, club_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-        return res;
+            params.push_back(club_id);
+        return scatter_query(query, params, {{"act_id"}});
     } catch (const sql::SQLException& e) {
         Logger(ll_error, "Error in read_activity_by_title: " + std::string(e.what())).log();
         return nullptr;
     }
 }
 
-std::unique_ptr<sql::ResultSet> ActivityTable::read_activity_by_period(const std::string& from_date, const std::string& to_date, int club_id) {
+std::shared_ptr<const QueryResult> ActivityTable::read_activity_by_period(const std::string& from_date, const std::string& to_date, int club_id) {
+    ServiceCall call("ActivityTable::read_activity_by_period", from_date, to_date, club_id);
+    ShardScope shard = ShardScope::club(club_id);
+    if (period_index && period_index->ready()) {
+        std::optional<int> from = date_to_days(from_date);
+        std::optional<int> to = date_to_days(to_date);
+        if (from && to) {
+            int club = club_id == -1 ? ActivityIntervalIndex::all_clubs : club_id;
+            std::vector<int> ids = period_index->overlapping(DayWindow{*from, *to}, club);
+            if (ids.size() <= ActivityIntervalIndex::max_selective_matches) {
+                std::unique_ptr<DbResult> res = select_by_ids("act_id", ids);
+                return res ? QueryResult::from_db_result(*res) : nullptr;
+            }
+        }
+    }
+
     try {
-        std::string query = "SELECT * FROM Activity WHERE (start_date <= ? AND (end_date >= ? OR end_date IS NULL))";
+        std::string query = "SELECT * FROM Activity WHERE (start_date <= ? AND (end_date >= ? OR end_date IS NULL)) AND pending_delete = 0";
         if (club_id != -1)
             query += " AND club_id = ?";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setString(1, to_date);
-        pstmt->setString(2, from_date);
+        std::vector<SqlParam> params{to_date, from_date};
         if (club_id != -1)
-            pstmt->setInt(3, club_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-        return res;
+            params.push_back(club_id);
+        return scatter_query(query, params, {{"act_id"}});
     } catch (const sql::SQLException& e) {
         Logger(ll_error, "Error in read_activity_by_period: " + std::string(e.what())).log();
         return nullptr;
     }
 }
 
-std::unique_ptr<sql::ResultSet> ActivityTable::read_activity_by_id(int act_id) {
+std::vector<std::vector<int>> ActivityTable::read_activity_ids_by_periods(const std::vector<std::pair<std::string, std::string>>& periods, int club_id) {
+    ServiceCall call("ActivityTable::read_activity_ids_by_periods", periods, club_id);
+    ShardScope shard = ShardScope::club(club_id);
+    if (period_index && period_index->ready()) {
+        std::vector<DayWindow> windows;
+        windows.reserve(periods.size());
+        for (const auto& [from_date, to_date] : periods) {
+            std::optional<int> from = date_to_days(from_date);
+            std::optional<int> to = date_to_days(to_date);
+            if (!from || !to)
+                break;
+            windows.push_back(DayWindow{*from, *to});
+        }
+        if (windows.size() == periods.size()) {
+            int club = club_id == -1 ? ActivityIntervalIndex::all_clubs : club_id;
+            return period_index->overlapping_batch(windows, club);
+        }
+    }
+
     try {
-        std::string query = "SELECT * FROM Activity WHERE act_id = ?";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, act_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-        return res;
+        std::string query = "SELECT act_id FROM Activity WHERE (start_date <= ? AND (end_date >= ? OR end_date IS NULL)) AND pending_delete = 0";
+        if (club_id != -1)
+            query += " AND club_id = ?";
+        query += " ORDER BY act_id";
+        auto read_ids = [&](sql::Connection& conn) {
+            std::unique_ptr<sql::PreparedStatement> pstmt(conn.prepareStatement(query));
+            std::vector<std::vector<int>> results;
+            results.reserve(periods.size());
+            for (const auto& [from_date, to_date] : periods) {
+                pstmt->setString(1, to_date);
+                pstmt->setString(2, from_date);
+                if (club_id != -1)
+                    pstmt->setInt(3, club_id);
+                std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+                std::vector<int> ids;
+                while (res->next())
+                    ids.push_back(res->getInt(1));
+                results.push_back(std::move(ids));
+            }
+            return results;
+        };
+
+        std::vector<std::vector<int>> results;
+        std::shared_ptr<ShardMap> shards = shard_map();
+        if (shards && club_id == -1) {
+            std::vector<std::vector<std::vector<int>>> parts(shards->size());
+            shards->scatter([&](size_t shard, sql::Connection& conn) { parts[shard] = read_ids(conn); });
+            results.resize(periods.size());
+            for (auto& part : parts) {
+                for (size_t i = 0; i < part.size(); ++i)
+                    results[i].insert(results[i].end(), part[i].begin(), part[i].end());
+            }
+            for (auto& ids : results)
+                std::sort(ids.begin(), ids.end());
+        } else {
+            results = read_ids(*connection());
+        }
+        Logger(ll_info, "executeQuery: " + query + " x" + std::to_string(periods.size())).log();
+        return results;
     } catch (const sql::SQLException& e) {
-        Logger(ll_error, "Error in read_activity_by_id: " + std::string(e.what())).log();
-        return nullptr;
+        Logger(ll_error, "Error in read_activity_ids_by_periods: " + std::string(e.what())).log();
+        return {};
     }
 }
 
+std::shared_ptr<const QueryResult> ActivityTable::read_activity_by_id(int act_id) {
+    ServiceCall call("ActivityTable::read_activity_by_id", act_id);
+    ShardScope shard = ShardScope::row("Activity", "act_id", act_id);
+    return coalesced_query("SELECT * FROM Activity WHERE act_id = ? AND pending_delete = 0", {act_id});
+}
+
 bool ActivityTable::update_activity(int act_id, const std::map<std::string, std::string>& updates) {
+    ServiceCall call("ActivityTable::update_activity", act_id, updates);
+    ShardScope shard = ShardScope::row("Activity", "act_id", act_id);
     try {
         std::string query = "UPDATE Activity SET ";
         for (auto it = updates.begin(); it != updates.end(); ++it) {
@@ -117,14 +269,30 @@ bool ActivityTable::update_activity(int act_id, const std::map<std::string, std:
         }
         query += " WHERE act_id = ?";
 
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        int param_index = 1;
+        std::optional<Transaction> transaction;
+        std::optional<ActivityContribution> before;
+        if (activity_rollup) {
+            transaction.emplace(connection());
+            before = ActivityRollup::contribution(connection(), act_id);
+        }
+
+        std::vector<SqlParam> params;
         for (const auto& kv : updates) {
-            pstmt->setString(param_index++, kv.second);
+            params.push_back(kv.second);
+        }
+        params.push_back(act_id);
+        execute_update(query, params);
+
+        if (transaction) {
+            ActivityRollup::apply_difference(connection(), before, ActivityRollup::contribution(connection(), act_id));
+            transaction->commit();
         }
-        pstmt->setInt(param_index, act_id);
-        pstmt->executeUpdate();
-        Logger(ll_info, "executeQuery: " + query).log();
+
+        auto title = updates.find("act_title");
+        if (title_index && title != updates.end())
+            title_index->upsert(act_id, title->second);
+        if (period_index && (updates.count("club_id") || updates.count("start_date") || updates.count("end_date")))
+            reindex_period(act_id);
     } catch (const sql::SQLException& e) {
         Logger(ll_error, "Error in update_activity: " + std::string(e.what())).log();
         return false;
@@ -133,12 +301,50 @@ bool ActivityTable::update_activity(int act_id, const std::map<std::string, std:
 }
 
 bool ActivityTable::delete_activity(int act_id) {
+    ServiceCall call("ActivityTable::delete_activity", act_id);
+    ShardScope shard = ShardScope::row("Activity", "act_id", act_id);
     try {
+        std::optional<Transaction> transaction;
+        std::optional<ActivityContribution> before;
+        if (activity_rollup) {
+            transaction.emplace(connection());
+            before = ActivityRollup::contribution(connection(), act_id);
+        }
+
+        if (purger) {
+            std::string query = "UPDATE Activity SET pending_delete = 1 WHERE act_id = ? AND pending_delete = 0";
+            int marked = execute_update(query, {act_id});
+
+            if (transaction) {
+                if (marked == 1)
+                    ActivityRollup::apply_difference(connection(), before, std::nullopt);
+                transaction->commit();
+            }
+
+            if (marked == 1) {
+                purger->purge_activity(act_id);
+                if (title_index)
+                    title_index->erase(act_id);
+                if (period_index)
+                    period_index->erase(act_id);
+            }
+            return marked == 1;
+        }
+
         std::string query = "DELETE FROM Activity WHERE act_id = ?";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, act_id);
-        pstmt->executeUpdate();
-        Logger(ll_info, "executeQuery: " + query).log();
+        int deleted = execute_update(query, {act_id});
+
+        if (transaction) {
+            // Its gatherings and attendances go by ON DELETE CASCADE; before holds them.
+            if (deleted == 1)
+                ActivityRollup::apply_difference(connection(), before, std::nullopt);
+            transaction->commit();
+        }
+
+        if (title_index)
+            title_index->erase(act_id);
+        if (period_index)
+            period_index->erase(act_id);
     } catch (const sql::SQLException& e) {
         Logger(ll_error, "Error in delete_activity: " + std::string(e.what())).log();
         return false;
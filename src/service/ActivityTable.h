@@ -3,12 +3,18 @@
 #include <memory>
 #include <map>
 #include <string>
+#include <utility>
+#include <vector>
 #include <cppconn/resultset.h>
 #include <cppconn/prepared_statement.h>
 #include <cppconn/exception.h>
 
 #include "../utils.h"
+#include "../index/ActivityIntervalIndex.h"
+#include "../index/TrigramIndex.h"
+#include "ActivityRollup.h"
 #include "BasicTable.h"
+#include "CascadePurger.h"
 
 /**
  * @class ActivityTable
@@ -19,13 +25,62 @@
  */
 class ActivityTable : public BasicTable {
 protected:
-    
+    /**
+     * @brief Optional background purger. When set, delete_activity marks the activity and purges it asynchronously.
+     */
+    std::shared_ptr<CascadePurger> purger;
+
+    /**
+     * @brief Optional substring index over Activity.act_title. Null means title searches use LIKE.
+     */
+    std::shared_ptr<TrigramIndex> title_index;
+
+    /**
+     * @brief Optional interval index over activity periods. Null means period searches scan Activity.
+     */
+    std::shared_ptr<ActivityIntervalIndex> period_index;
+
+    /**
+     * @brief Whether writes apply their deltas to Club_Activity_Rollup in the same transaction.
+     */
+    bool activity_rollup = false;
+
+    /**
+     * @brief Re-reads an activity's club and period into period_index, or drops it if the row is gone.
+     * @param act_id The ID of the activity.
+     */
+    void reindex_period(int act_id);
+
 public:
     /**
      * @brief Constructs a new Activity Table object.
      * @param conn A shared pointer to an active SQL database connection.
      */
-    ActivityTable(std::shared_ptr<sql::Connection> conn);
+    ActivityTable(std::shared_ptr<DbConnection> conn);
+
+    /**
+     * @brief Switches delete_activity to the asynchronous chunked purge.
+     * @param cascade_purger The purger to hand deletions to, or nullptr to delete with ON DELETE CASCADE again.
+     */
+    void set_purger(std::shared_ptr<CascadePurger> cascade_purger);
+
+    /**
+     * @brief Serves title searches from a trigram index and keeps it current on writes.
+     * @param index An index over Activity.act_title, or nullptr to search with LIKE again.
+     */
+    void set_title_index(std::shared_ptr<TrigramIndex> index);
+
+    /**
+     * @brief Serves period searches from an interval index and keeps it current on writes.
+     * @param index A built interval index, or nullptr to query Activity directly again.
+     */
+    void set_period_index(std::shared_ptr<ActivityIntervalIndex> index);
+
+    /**
+     * @brief Keeps Club_Activity_Rollup current with this table's writes (db_scripts/activity_rollup.sql).
+     * @param enabled True if the rollup table is installed.
+     */
+    void set_activity_rollup(bool enabled);
 
     /**
      * @brief Creates a new activity record.
@@ -44,18 +99,18 @@ public:
      * @brief Reads activities by club ID.
      * 
      * @param club_id The ID of the club whose activities are to be retrieved.
-     * @return std::unique_ptr<sql::ResultSet> Result set containing the matching records.
+     * @return std::unique_ptr<DbResult> Result set containing the matching records.
      */
-    std::unique_ptr<sql::ResultSet> read_activity_by_club_id(int club_id);
+    std::unique_ptr<DbResult> read_activity_by_club_id(int club_id);
 
     /**
      * @brief Reads activities by activity title.
      * 
      * @param act_title The title of the activity to search for.
      * @param club_id The ID of the club whose activities are to be retrieved. If it is default(-1), do not use it.
-     * @return std::unique_ptr<sql::ResultSet> Result set containing the matching records.
+     * @return std::shared_ptr<const QueryResult> The matching records in act_id order, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_activity_by_title(const std::string& act_title, int club_id = -1);
+    std::shared_ptr<const QueryResult> read_activity_by_title(const std::string& act_title, int club_id = -1);
 
     /**
      * @brief Reads activities within a specified period.
@@ -63,17 +118,26 @@ public:
      * @param from_date Start date of the period.
      * @param to_date End date of the period.
      * @param club_id The ID of the club whose activities are to be retrieved. If it is default(-1), do not use it.
-     * @return std::unique_ptr<sql::ResultSet> Result set containing the activities within the period.
+     * @return std::shared_ptr<const QueryResult> The activities within the period in act_id order, or nullptr if an error occurred.
+     */
+    std::shared_ptr<const QueryResult> read_activity_by_period(const std::string& from_date, const std::string& to_date, int club_id = -1);
+
+    /**
+     * @brief Finds the activities of many periods at once, e.g. the days or weeks of a calendar view.
+     * 
+     * @param periods (from_date, to_date) pairs; both ends are inclusive.
+     * @param club_id The ID of the club whose activities are to be retrieved. If it is default(-1), do not use it.
+     * @return std::vector<std::vector<int>> For each period, the matching activity IDs in ascending order. Empty if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_activity_by_period(const std::string& from_date, const std::string& to_date, int club_id = -1);
+    std::vector<std::vector<int>> read_activity_ids_by_periods(const std::vector<std::pair<std::string, std::string>>& periods, int club_id = -1);
 
     /**
-     * @brief Reads a specific activity by its activity ID.
+     * @brief Reads a specific activity by its activity ID, sharing the query with concurrent identical reads.
      * 
      * @param act_id The ID of the activity.
-     * @return std::unique_ptr<sql::ResultSet> Result set containing the matching record.
+     * @return std::shared_ptr<const QueryResult> Materialized matching record, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_activity_by_id(int act_id);
+    std::shared_ptr<const QueryResult> read_activity_by_id(int act_id);
 
     /**
      * @brief Updates an activity's information.
@@ -87,6 +151,8 @@ public:
 
     /**
      * @brief Deletes an activity.
+     * With a purger set, the activity is marked pending_delete (hiding it from reads) and
+     * its dependent rows are removed in the background.
      * 
      * @param act_id The ID of the activity to delete.
      * @return true If the activity was successfully deleted.
@@ -1,24 +1,69 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <map>
 #include <string>
 #include <iostream>
 #include <mysql_driver.h>
 #include <mysql_connection.h>
+#include <cppconn/exception.h>
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
 
+#include "../storage/MySqlBackend.h"
+#include "../trace/Tracer.h"
 #include "../utils.h"
 #include "BasicTable.h"
+#include "QueryDigest.h"
+#include "ReplicaSet.h"
+#include "ShardMap.h"
+#include "SlowQueryLog.h"
 
-BasicTable::BasicTable(std::string name, std::shared_ptr<sql::Connection> conn): table_name(name), con(conn) {
-    try {
-        std::string query = "DESCRIBE " + table_name;
-        std::unique_ptr<sql::PreparedStatement> pstmt(conn->prepareStatement(query));
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());        
+/**
+ * @brief Process-wide group coalescing identical reads issued through any table.
+ */
+static SingleFlight<std::string, QueryResult> read_flights;
+
+/**
+ * @brief Bumped by every write (note_write); part of the coalescing key, so that a read never
+ * joins a flight that started before a write it must see.
+ */
+static std::atomic<uint64_t> write_epoch{0};
+
+/**
+ * @brief Process-wide receiver of statement timings, if SEV_SLOW_QUERY is set.
+ */
+static std::shared_ptr<SlowQueryLog> slow_query_log;
+
+/**
+ * @brief Process-wide per-shape statement statistics, if SEV_QUERY_DIGESTS is set.
+ */
+static std::shared_ptr<QueryDigestTable> query_digests;
+
+/**
+ * @brief Process-wide read replicas, if SEV_REPLICAS is set.
+ */
+static std::shared_ptr<ReplicaSet> replicas;
+
+/**
+ * @brief Process-wide shard map, if SEV_SHARDS is set.
+ */
+static std::shared_ptr<ShardMap> shards;
+
+/**
+ * @brief The shard of the calling thread's innermost ShardScope and its session connection, if any.
+ */
+static thread_local size_t scoped_shard = SIZE_MAX;
+static thread_local std::shared_ptr<sql::Connection> scoped_connection;
 
-        Logger(ll_info, "executeQuery: " + query).log();     
+BasicTable::BasicTable(std::string name, std::shared_ptr<DbConnection> conn)
+    : table_name(name), db(conn), con(conn->session()) {
+    try {
+        std::unique_ptr<DbResult> res = db->execute_query("DESCRIBE " + table_name);
+        int field = res->column_index("Field");
         while (res->next()) {
-            std::string field = res->getString("Field");
-            columns.push_back(field);
+            columns.push_back(res->get_string(field));
         }                
     } catch (sql::SQLException &e) {
         Logger(ll_error, "Error in BasicTable: " + std::string(e.what())).log();        
@@ -26,6 +71,7 @@ BasicTable::BasicTable(std::string name, std::shared_ptr<sql::Connection> conn):
 }
 
 bool BasicTable::basic_insert(std::map<std::string, std::string> attributes) {
+    TraceSpan span("table", "BasicTable::basic_insert");
     try {
         std::string columns, values;
         for (const auto &pair : attributes) {
@@ -37,10 +83,7 @@ bool BasicTable::basic_insert(std::map<std::string, std::string> attributes) {
             values += "'" + pair.second + "'";
         }
 
-        std::string query = "INSERT INTO " + table_name + "(" + columns + ") VALUES (" + values + ")";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->execute();
-        Logger(ll_info, "executeQuery: " + query).log();
+        execute_update("INSERT INTO " + table_name + "(" + columns + ") VALUES (" + values + ")");
         return true;
     } catch (sql::SQLException &e) {
         Logger(ll_error, "Error in basic_insert: " + std::string(e.what())).log();
@@ -49,12 +92,9 @@ bool BasicTable::basic_insert(std::map<std::string, std::string> attributes) {
 }
 
 bool BasicTable::basic_show() {
+    TraceSpan span("table", "BasicTable::basic_show");
     try {
-        std::string query = "DESCRIBE " + table_name;
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-
-        Logger(ll_info, "executeQuery: " + query).log();
+        std::unique_ptr<DbResult> res = execute_query("DESCRIBE " + table_name);
 
         std::cout << "Table structure for '" << table_name << "':" << std::endl;
         print_result_set(res);
@@ -66,6 +106,7 @@ bool BasicTable::basic_show() {
 }
 
 bool BasicTable::basic_delete(std::map<std::string, std::string> conditions) {
+    TraceSpan span("table", "BasicTable::basic_delete");
     try {
         std::string query = "DELETE FROM " + table_name + " WHERE ";
         bool first = true;
@@ -75,9 +116,7 @@ bool BasicTable::basic_delete(std::map<std::string, std::string> conditions) {
             first = false;
         }
 
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        if (pstmt->executeUpdate() == 1) {
-            Logger(ll_info, "executeQuery: " + query).log();
+        if (execute_update(query) == 1) {
             return true;
         } else {
             Logger(ll_info, "A single matching tuple was not found in basic_delete.").log();
@@ -90,6 +129,7 @@ bool BasicTable::basic_delete(std::map<std::string, std::string> conditions) {
 }
 
 bool BasicTable::basic_update(std::map<std::string, std::string> conditions, std::map<std::string, std::string> new_values) {
+    TraceSpan span("table", "BasicTable::basic_update");
     try {
         std::string query = "UPDATE " + table_name + " SET ";
         bool first = true;
@@ -107,9 +147,7 @@ bool BasicTable::basic_update(std::map<std::string, std::string> conditions, std
             first = false;
         }
 
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        if (pstmt->executeUpdate() == 1) {
-            Logger(ll_info, "executeQuery: " + query).log();
+        if (execute_update(query) == 1) {
             return true;
         } else {
             Logger(ll_info, "A single matching tuple was not found in basic_update.").log();
@@ -121,7 +159,8 @@ bool BasicTable::basic_update(std::map<std::string, std::string> conditions, std
     }
 }
 
-std::unique_ptr<sql::ResultSet> BasicTable::basic_string_select(std::map<std::string, std::string> conditions) {    
+std::unique_ptr<DbResult> BasicTable::basic_string_select(std::map<std::string, std::string> conditions) {    
+    TraceSpan span("table", "BasicTable::basic_string_select");
     try {
         std::string query = "SELECT * FROM " + table_name + " WHERE ";
         bool first = true;
@@ -130,19 +169,19 @@ std::unique_ptr<sql::ResultSet> BasicTable::basic_string_select(std::map<std::st
             query += pair.first + " like '%" + pair.second + "%'";
             first = false;
         }
+        if (!visible_filter.empty()) {
+            query += (first ? "" : " AND ") + visible_filter;
+        }
 
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-
-        return res;
+        return execute_query(query);
     } catch (sql::SQLException &e) {
         Logger(ll_error, "Error in basic_select: " + std::string(e.what())).log();
         return nullptr;
     }
 }
 
-std::unique_ptr<sql::ResultSet> BasicTable::basic_select(std::map<std::string, std::string> conditions) {    
+std::unique_ptr<DbResult> BasicTable::basic_select(std::map<std::string, std::string> conditions) {    
+    TraceSpan span("table", "BasicTable::basic_select");
     try {
         std::string query = "SELECT * FROM " + table_name + " WHERE ";
         bool first = true;
@@ -151,29 +190,314 @@ std::unique_ptr<sql::ResultSet> BasicTable::basic_select(std::map<std::string, s
             query += pair.first + " = '" + pair.second + "'";
             first = false;
         }
+        if (!visible_filter.empty()) {
+            query += (first ? "" : " AND ") + visible_filter;
+        }
 
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-
-        return res;
+        return execute_query(query);
     } catch (sql::SQLException &e) {
         Logger(ll_error, "Error in basic_select: " + std::string(e.what())).log();
         return nullptr;
     }
 }
 
-std::unique_ptr<sql::ResultSet> BasicTable::basic_select_all() {
+std::unique_ptr<DbResult> BasicTable::basic_select_all() {
+    TraceSpan span("table", "BasicTable::basic_select_all");
     try {
         std::string query = "SELECT * FROM " + table_name;        
+        if (!visible_filter.empty()) {
+            query += " WHERE " + visible_filter;
+        }
 
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-
-        return res;
+        return execute_query(query);
     } catch (sql::SQLException &e) {
         Logger(ll_error, "Error in basic_select: " + std::string(e.what())).log();
         return nullptr;
     }
+}
+
+std::unique_ptr<DbResult> BasicTable::select_by_ids(const std::string &id_column, const std::vector<int> &ids) {
+    TraceSpan span("table", "BasicTable::select_by_ids");
+    try {
+        std::string query = "SELECT * FROM " + table_name + " WHERE ";
+        if (ids.empty()) {
+            query += "1 = 0";
+        } else {
+            query += id_column + " IN (";
+            for (size_t i = 0; i < ids.size(); ++i) {
+                if (i != 0) query += ", ";
+                query += "?";
+            }
+            query += ")";
+        }
+        if (!visible_filter.empty()) {
+            query += " AND " + visible_filter;
+        }
+
+        return execute_query(query, std::vector<SqlParam>(ids.begin(), ids.end()));
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, "Error in select_by_ids: " + std::string(e.what())).log();
+        return nullptr;
+    }
+}
+
+int BasicTable::last_insert_id() {
+    try {
+        std::unique_ptr<DbResult> res = execute_query("SELECT LAST_INSERT_ID()");
+        if (res->next())
+            return res->get_int(0);
+        return -1;
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, "Error in last_insert_id: " + std::string(e.what())).log();
+        return -1;
+    }
+}
+
+void BasicTable::bind_params(sql::PreparedStatement &pstmt, const std::vector<SqlParam> &params) {
+    for (size_t i = 0; i < params.size(); ++i) {
+        unsigned int index = static_cast<unsigned int>(i + 1);
+        if (const int *value = std::get_if<int>(&params[i])) {
+            pstmt.setInt(index, *value);
+        } else if (const double *value = std::get_if<double>(&params[i])) {
+            pstmt.setDouble(index, *value);
+        } else {
+            pstmt.setString(index, std::get<std::string>(params[i]));
+        }
+    }
+}
+
+/**
+ * @brief Hands a finished statement to the slow-query log and the digest table, whichever are set.
+ * The digest table may sample rows examined on conn, so this runs before anything else uses it.
+ */
+static void report(sql::Connection &conn, const std::string &query, const std::vector<SqlParam> &params,
+                   std::chrono::steady_clock::time_point started, uint64_t rows, bool failed) {
+    if (!slow_query_log && !query_digests)
+        return;
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+    if (query_digests)
+        query_digests->record(&conn, query, elapsed, rows, failed);
+    if (slow_query_log && !failed)
+        slow_query_log->observe(query, params, elapsed, rows);
+}
+
+BasicTable::ShardScope::ShardScope(size_t target, std::shared_ptr<sql::Connection> conn)
+    : shard(target), previous_shard(scoped_shard) {
+    if (shard == no_shard)
+        return;
+    if (!conn)
+        conn = shard == previous_shard ? scoped_connection : shards->connection(shard);
+    previous_connection = std::move(scoped_connection);
+    scoped_shard = shard;
+    scoped_connection = std::move(conn);
+}
+
+BasicTable::ShardScope::~ShardScope() {
+    if (shard == no_shard)
+        return;
+    scoped_shard = previous_shard;
+    scoped_connection = std::move(previous_connection);
+}
+
+BasicTable::ShardScope BasicTable::ShardScope::club(int club_id) {
+    if (!shards || club_id == -1)
+        return ShardScope(no_shard);
+    size_t target = shards->shard_for_club(club_id);
+    shards->note_routed(target);
+    return ShardScope(target);
+}
+
+BasicTable::ShardScope BasicTable::ShardScope::row(const char *table, const char *key_column, int id) {
+    if (!shards)
+        return ShardScope(no_shard);
+    if (scoped_shard != no_shard)
+        return ShardScope(scoped_shard);
+    size_t target = shards->shard_for_row(table, key_column, id);
+    shards->note_routed(target);
+    return ShardScope(target);
+}
+
+BasicTable::ShardScope BasicTable::ShardScope::new_club() {
+    if (!shards)
+        return ShardScope(no_shard);
+    size_t target = shards->shard_for_new_club();
+    shards->note_routed(target);
+    return ShardScope(target);
+}
+
+BasicTable::ShardScope BasicTable::ShardScope::session(size_t shard, std::shared_ptr<sql::Connection> conn) {
+    if (!shards)
+        return ShardScope(no_shard);
+    return ShardScope(shard, std::move(conn));
+}
+
+bool BasicTable::ShardScope::place_club(int club_id) const {
+    return shard == no_shard || shards->place_club(club_id, shard);
+}
+
+std::shared_ptr<sql::Connection> BasicTable::connection() const {
+    return scoped_connection ? scoped_connection : con;
+}
+
+std::shared_ptr<ShardMap> BasicTable::shard_map() {
+    return shards;
+}
+
+std::shared_ptr<const QueryResult> BasicTable::scatter_query(const std::string &query, const std::vector<SqlParam> &params,
+                                                             const std::vector<QueryResult::SortKey> &order, size_t limit) {
+    if (shards && !scoped_connection)
+        return shards->scatter_query(query, params, order, limit);
+    std::unique_ptr<DbResult> res = execute_query(query, params);
+    return QueryResult::from_db_result(*res);
+}
+
+std::unique_ptr<DbResult> BasicTable::execute_query(const std::string &query, const std::vector<SqlParam> &params) {
+    if (scoped_connection)
+        return std::make_unique<MySqlResult>(execute_query(*scoped_connection, query, params));
+    // Inside a transaction every read must see its uncommitted writes.
+    if (replicas && con && con->getAutoCommit() && ReplicaSet::is_replica_safe(query)) {
+        if (std::unique_ptr<sql::ResultSet> res = replicas->try_query(*con, query, params))
+            return std::make_unique<MySqlResult>(std::move(res));
+    }
+    return db->execute_query(query, params);
+}
+
+int BasicTable::execute_update(const std::string &query, const std::vector<SqlParam> &params) {
+    if (scoped_connection)
+        return execute_update(*scoped_connection, query, params);
+    return db->execute_update(query, params);
+}
+
+std::unique_ptr<sql::ResultSet> BasicTable::execute_query(sql::Connection &conn, const std::string &query,
+                                                          const std::vector<SqlParam> &params) {
+    auto started = std::chrono::steady_clock::now();
+    std::unique_ptr<sql::ResultSet> res;
+    try {
+        std::unique_ptr<sql::PreparedStatement> pstmt;
+        {
+            TraceSpan span("sql", "prepare", query);
+            pstmt.reset(conn.prepareStatement(query));
+        }
+        bind_params(*pstmt, params);
+        TraceSpan span("sql", "execute", query);
+        res.reset(pstmt->executeQuery());
+    } catch (sql::SQLException &) {
+        report(conn, query, params, started, 0, true);
+        throw;
+    }
+    report(conn, query, params, started, res->rowsCount(), false);
+    Logger(ll_info, "executeQuery: " + query).log();
+    return res;
+}
+
+int BasicTable::execute_update(sql::Connection &conn, const std::string &query, const std::vector<SqlParam> &params) {
+    auto started = std::chrono::steady_clock::now();
+    int affected;
+    try {
+        std::unique_ptr<sql::PreparedStatement> pstmt;
+        {
+            TraceSpan span("sql", "prepare", query);
+            pstmt.reset(conn.prepareStatement(query));
+        }
+        bind_params(*pstmt, params);
+        TraceSpan span("sql", "execute", query);
+        affected = pstmt->executeUpdate();
+    } catch (sql::SQLException &) {
+        report(conn, query, params, started, 0, true);
+        throw;
+    }
+    report(conn, query, params, started, static_cast<uint64_t>(std::max(affected, 0)), false);
+    note_write();
+    Logger(ll_info, "executeQuery: " + query).log();
+    return affected;
+}
+
+void BasicTable::set_slow_query_log(std::shared_ptr<SlowQueryLog> log) {
+    slow_query_log = log;
+}
+
+void BasicTable::set_query_digests(std::shared_ptr<QueryDigestTable> digests) {
+    query_digests = digests;
+}
+
+void BasicTable::set_replicas(std::shared_ptr<ReplicaSet> replica_set) {
+    replicas = replica_set;
+}
+
+void BasicTable::set_shard_map(std::shared_ptr<ShardMap> shard_map) {
+    shards = shard_map;
+}
+
+void BasicTable::note_write() {
+    write_epoch.fetch_add(1, std::memory_order_release);
+    if (replicas)
+        replicas->note_write();
+}
+
+std::shared_ptr<const QueryResult> BasicTable::coalesced_query(const std::string &query, const std::vector<SqlParam> &params) {
+    TraceSpan span("table", "BasicTable::coalesced_query");
+    std::shared_ptr<sql::Connection> conn = connection();
+    if (conn && !conn->getAutoCommit()) {
+        // Inside a transaction the read must see its own uncommitted writes; it runs alone.
+        try {
+            std::unique_ptr<DbResult> res = execute_query(query, params);
+            return QueryResult::from_db_result(*res);
+        } catch (sql::SQLException &e) {
+            Logger(ll_error, "Error in coalesced_query: " + std::string(e.what())).log();
+            return nullptr;
+        }
+    }
+
+    // The key separates parameters with a unit separator and tags each with its type,
+    // so that e.g. int 1 and string "1" never share a flight. Reads on different shards never do either.
+    // The write epoch keeps a read after a write out of flights started before it: the leader of a
+    // flight chose primary or replica after the caller's last write, as the caller itself would have,
+    // so read-your-writes pinning carries over to everyone who joins.
+    std::string key = std::to_string(write_epoch.load(std::memory_order_acquire)) + '\x1e';
+    if (scoped_connection)
+        key += std::to_string(scoped_shard) + '\x1e';
+    key += query;
+    for (const auto &param : params) {
+        key += '\x1f';
+        key += static_cast<char>('0' + param.index());
+        if (const int *value = std::get_if<int>(&param)) {
+            key += std::to_string(*value);
+        } else if (const double *value = std::get_if<double>(&param)) {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.17g", *value);
+            key += buffer;
+        } else {
+            key += std::get<std::string>(param);
+        }
+    }
+
+    try {
+        return read_flights.run(key, [&]() -> std::shared_ptr<const QueryResult> {
+            std::unique_ptr<DbResult> res = execute_query(query, params);
+            return QueryResult::from_db_result(*res);
+        });
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, "Error in coalesced_query: " + std::string(e.what())).log();
+        return nullptr;
+    }
+}
+
+std::shared_ptr<const QueryResult> BasicTable::coalesced_select(std::map<std::string, std::string> conditions) {
+    std::string query = "SELECT * FROM " + table_name + " WHERE ";
+    std::vector<SqlParam> params;
+    bool first = true;
+    for (const auto &pair : conditions) {
+        if (!first) query += " AND ";
+        query += pair.first + " = ?";
+        params.push_back(pair.second);
+        first = false;
+    }
+    if (!visible_filter.empty()) {
+        query += (first ? "" : " AND ") + visible_filter;
+    }
+    return coalesced_query(query, params);
+}
+
+SingleFlightStats BasicTable::coalescing_stats() {
+    return read_flights.stats();
 }
\ No newline at end of file
@@ -1,11 +1,23 @@
 #pragma once
 
 #include <mysql_driver.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 #include <map>
 
+#include "../storage/DbBackend.h"
+#include "QueryResult.h"
+#include "SingleFlight.h"
+
+class QueryDigestTable;
+class ReplicaSet;
+class ShardMap;
+class SlowQueryLog;
+
 /**
  * @brief Represents a basic database table for CRUD operations.
  */
@@ -17,7 +29,14 @@ protected:
     std::string table_name;
 
     /**
-     * @brief Shared database connection.     
+     * @brief Runs this table's statements outside a ShardScope.
+     */
+    std::shared_ptr<DbConnection> db;
+
+    /**
+     * @brief The MySQL session under db, or nullptr if db is not on a MySQL server (e.g. a MemoryConnection).
+     * Transactions, shard scopes and replicas need it; without it only execute_query/execute_update
+     * and the reads built on them work.
      */
     std::shared_ptr<sql::Connection> con;
 
@@ -25,13 +44,19 @@ protected:
      * @brief List of columns of this table.     
      */
     std::vector<std::string> columns;
+
+    /**
+     * @brief Extra SQL condition appended to every basic_* and coalesced_select read,
+     * e.g. to hide rows marked for deletion. Empty means no filter.
+     */
+    std::string visible_filter;
     
     /**
      * @brief Constructs a new BasicTable object.
      * @param name The name of the table to manage.
-     * @param conn A shared pointer to an active database connection.
+     * @param conn The connection to run statements on.
      */
-    BasicTable(std::string name, std::shared_ptr<sql::Connection> conn);
+    BasicTable(std::string name, std::shared_ptr<DbConnection> conn);
 
     /**
      * @brief Inserts a tuple into the table using given attributes.
@@ -59,27 +84,230 @@ protected:
     /**
      * @brief Selects tuples from the table matching the given conditions.
      * @param conditions A map of column names to values that identify the tuple.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
      * @retval nullptr An error occurred.
      */
-    std::unique_ptr<sql::ResultSet> basic_select(std::map<std::string, std::string> conditions);
+    std::unique_ptr<DbResult> basic_select(std::map<std::string, std::string> conditions);
     
     /**
      * @brief Selects tuples from the table matching the given conditions.
      * @param conditions A map of column names to values that identify the tuple.
      * All fields need to be string, then this query will find values including value of conditions.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
+     * @retval nullptr An error occurred.
+     */
+    std::unique_ptr<DbResult> basic_string_select(std::map<std::string, std::string> conditions);   
+
+    /**
+     * @brief Selects all tuples from the table.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
+     * @retval nullptr An error occurred.
+     */
+    std::unique_ptr<DbResult> basic_select_all();
+
+    /**
+     * @brief Selects the tuples whose id_column is one of the given IDs, e.g. the matches of an in-memory index.
+     * @param id_column The integer key column.
+     * @param ids The IDs to fetch. An empty list yields an empty result.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
+     * @retval nullptr An error occurred.
+     */
+    std::unique_ptr<DbResult> select_by_ids(const std::string &id_column, const std::vector<int> &ids);
+
+    /**
+     * @brief Returns the AUTO_INCREMENT value generated by the last insert on this connection.
+     * @return The generated ID, or -1 if an error occurred.
+     */
+    int last_insert_id();
+
+public:
+    /**
+     * @brief While alive, routes the statements of every table on the calling thread to one shard
+     * (see set_shard_map). Club-scoped service calls open one first thing; scopes nest, and without
+     * a shard map they change nothing.
+     */
+    class ShardScope {
+    public:
+        /**
+         * @brief Routes to the shard holding a club.
+         * @param club_id The club, or -1 (all clubs) to leave routing alone.
+         */
+        static ShardScope club(int club_id);
+
+        /**
+         * @brief Routes to the shard holding a row of a club-owned table, e.g. an Activity by act_id.
+         * Inside another scope the enclosing shard is kept, since a club's rows never span shards.
+         */
+        static ShardScope row(const char *table, const char *key_column, int id);
+
+        /**
+         * @brief Routes to the shard a new club is created on.
+         */
+        static ShardScope new_club();
+
+        /**
+         * @brief Routes to a shard over the given session rather than the shard's shared one, e.g. a
+         * pooled connection of a worker thread. Scopes opened inside for the same shard keep it.
+         */
+        static ShardScope session(size_t shard, std::shared_ptr<sql::Connection> conn);
+
+        /**
+         * @brief Records in the shard directory that a club created in this scope lives on its shard.
+         * @return True on success or without a shard map, false if the directory could not be written.
+         */
+        bool place_club(int club_id) const;
+
+        ~ShardScope();
+
+        ShardScope(const ShardScope &) = delete;
+        ShardScope &operator=(const ShardScope &) = delete;
+
+    private:
+        /**
+         * @param target The shard to route to, or no_shard to leave routing alone.
+         * @param conn The session to use; nullptr for the enclosing scope's if it is on target, else the shard's.
+         */
+        explicit ShardScope(size_t target, std::shared_ptr<sql::Connection> conn = nullptr);
+
+        static constexpr size_t no_shard = SIZE_MAX;
+
+        size_t shard;
+        size_t previous_shard;
+        std::shared_ptr<sql::Connection> previous_connection;
+    };
+
+protected:
+    /**
+     * @brief Returns the MySQL session statements of this table run on: the shard of the calling
+     * thread's ShardScope if one is open, otherwise con (nullptr if db is not on a MySQL server).
+     */
+    std::shared_ptr<sql::Connection> connection() const;
+
+    /**
+     * @brief Returns the shard map set by set_shard_map, or nullptr if the database is not sharded.
+     */
+    static std::shared_ptr<ShardMap> shard_map();
+
+    /**
+     * @brief Runs a read that may span clubs. With a shard map and no open ShardScope it runs on
+     * every shard in parallel and the results are merged; otherwise it runs like execute_query.
+     * @param query The SQL statement with '?' placeholders.
+     * @param params Values for the placeholders.
+     * @param order Columns to sort merged rows by, so that they come in the order one database would return.
+     * @param limit Keeps at most this many merged rows, e.g. for a query with LIMIT.
+     * @return The materialized result; never nullptr.
+     * @throws sql::SQLException if the statement fails.
+     */
+    std::shared_ptr<const QueryResult> scatter_query(const std::string &query, const std::vector<SqlParam> &params = {},
+                                                     const std::vector<QueryResult::SortKey> &order = {},
+                                                     size_t limit = SIZE_MAX);
+
+    /**
+     * @brief Prepares, binds and runs a read on the open ShardScope's shard, or else on db. With
+     * replicas set, a plain SELECT outside a transaction may run on a replica instead.
+     * @throws sql::SQLException if the statement fails.
+     */
+    std::unique_ptr<DbResult> execute_query(const std::string &query, const std::vector<SqlParam> &params = {});
+
+    /**
+     * @brief Prepares, binds and runs a write on the open ShardScope's shard, or else on db.
+     * @throws sql::SQLException if the statement fails.
+     */
+    int execute_update(const std::string &query, const std::vector<SqlParam> &params = {});
+
+    /**
+     * @brief Binds parameters to the placeholders of a prepared statement, in order.
+     * @param pstmt The prepared statement.
+     * @param params Values for placeholders 1..n.
+     */
+    static void bind_params(sql::PreparedStatement &pstmt, const std::vector<SqlParam> &params);
+
+    /**
+     * @brief Runs a read query, sharing one execution among concurrent identical calls.
+     * Callers in any thread issuing the same query with the same parameters while it is
+     * in flight wait for it and receive the same materialized result.
+     * @param query The SQL statement with '?' placeholders.
+     * @param params Values for the placeholders.
+     * @return A shared pointer to the materialized result, or nullptr if an error occurred.
+     * @retval nullptr An error occurred.
+     */
+    std::shared_ptr<const QueryResult> coalesced_query(const std::string &query, const std::vector<SqlParam> &params);
+
+    /**
+     * @brief Coalesced counterpart of basic_select.
+     * @param conditions A map of column names to values that identify the tuple.
+     * @return A shared pointer to the materialized result, or nullptr if an error occurred.
      * @retval nullptr An error occurred.
      */
-    std::unique_ptr<sql::ResultSet> basic_string_select(std::map<std::string, std::string> conditions);   
+    std::shared_ptr<const QueryResult> coalesced_select(std::map<std::string, std::string> conditions);
 
     /// @brief Destructor for BasicTable.
     virtual ~BasicTable() {}
 
 public:
+    /**
+     * @brief Runs a read query. Every statement of the service layer goes through here or
+     * execute_update, which trace the prepare and execute steps and log the query.
+     * @param conn The connection to run on.
+     * @param query The SQL statement with '?' placeholders.
+     * @param params Values for the placeholders.
+     * @return The result set; never nullptr.
+     * @throws sql::SQLException if the statement fails.
+     */
+    static std::unique_ptr<sql::ResultSet> execute_query(sql::Connection &conn, const std::string &query,
+                                                         const std::vector<SqlParam> &params = {});
+
+    /**
+     * @brief Runs an INSERT, UPDATE or DELETE.
+     * @param conn The connection to run on.
+     * @param query The SQL statement with '?' placeholders.
+     * @param params Values for the placeholders.
+     * @return The number of affected rows.
+     * @throws sql::SQLException if the statement fails.
+     */
+    static int execute_update(sql::Connection &conn, const std::string &query, const std::vector<SqlParam> &params = {});
+
+    /**
+     * @brief Reports every statement run through execute_query/execute_update to a slow-query log.
+     * @param log The log, or nullptr to stop reporting. Set it before statements run concurrently.
+     */
+    static void set_slow_query_log(std::shared_ptr<SlowQueryLog> log);
+
+    /**
+     * @brief Aggregates every statement run through execute_query/execute_update by its shape.
+     * @param digests The table, or nullptr to stop aggregating. Set it before statements run concurrently.
+     */
+    static void set_query_digests(std::shared_ptr<QueryDigestTable> digests);
+
+    /**
+     * @brief Routes reads of every table to replicas where possible (see ReplicaSet).
+     * @param replicas The replicas, or nullptr to read from the primary only. Set it before statements run concurrently.
+     */
+    static void set_replicas(std::shared_ptr<ReplicaSet> replicas);
+
+    /**
+     * @brief Splits the club-owned tables over shards (see ShardMap): club-scoped calls of ClubTable,
+     * ActivityTable, GatheringTable, ClubStudentTable and ResultTable run on the club's shard, and their reads
+     * across clubs on every shard.
+     * @param shards The shard map, or nullptr to use each table's own connection. Set it before statements run concurrently.
+     */
+    static void set_shard_map(std::shared_ptr<ShardMap> shards);
+
+    /**
+     * @brief Records a write to the primary made outside execute_update, e.g. a transaction
+     * committed on another connection, so that following reads see it.
+     */
+    static void note_write();
+
     /**
      * @brief Displays the structure of the table.
      * @return True if the operation was successful, false otherwise.
      */
     bool basic_show();
+
+    /**
+     * @brief Returns how many coalesced reads ran and how many joined an in-flight one.
+     * The counters are shared by every table in the process.
+     */
+    static SingleFlightStats coalescing_stats();
 };
\ No newline at end of file
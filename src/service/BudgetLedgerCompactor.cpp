@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+
+#include "../utils.h"
+#include "BudgetLedgerCompactor.h"
+#include "Transaction.h"
+
+BudgetLedgerCompactor::BudgetLedgerCompactor(std::shared_ptr<sql::Connection> conn, int batch_size)
+    : con(conn), batch_size(batch_size) {}
+
+BudgetLedgerCompactor::~BudgetLedgerCompactor() {
+    stop();
+}
+
+int BudgetLedgerCompactor::compact_once() {
+    try {
+        // Read committed, so that the sums below see every entry committed up to the moment the clubs are
+        // locked rather than a snapshot taken before. The connection is this compactor's own.
+        std::unique_ptr<sql::Statement> isolation(con->createStatement());
+        isolation->execute("SET SESSION TRANSACTION ISOLATION LEVEL READ COMMITTED");
+
+        // Upper bound of this batch. Entries appended meanwhile get higher ids and wait for the next round.
+        std::string bound_query = "SELECT COUNT(*) AS entries, MAX(entry_id) AS last_entry FROM "
+                                  "(SELECT entry_id FROM Budget_Ledger ORDER BY entry_id LIMIT ?) AS batch";
+        std::unique_ptr<sql::PreparedStatement> bound_stmt(con->prepareStatement(bound_query));
+        bound_stmt->setInt(1, batch_size);
+        std::unique_ptr<sql::ResultSet> bound(bound_stmt->executeQuery());
+        Logger(ll_info, "executeQuery: " + bound_query).log();
+
+        if (!bound->next() || bound->getInt("entries") == 0)
+            return 0;
+        int64_t last_entry = bound->getInt64("last_entry");
+
+        std::string clubs_query = "SELECT DISTINCT club_id FROM Budget_Ledger WHERE entry_id <= ? ORDER BY club_id";
+        std::unique_ptr<sql::PreparedStatement> clubs_stmt(con->prepareStatement(clubs_query));
+        clubs_stmt->setInt64(1, last_entry);
+        std::unique_ptr<sql::ResultSet> clubs(clubs_stmt->executeQuery());
+        Logger(ll_info, "executeQuery: " + clubs_query).log();
+        std::vector<int> club_ids;
+        while (clubs->next())
+            club_ids.push_back(clubs->getInt(1));
+
+        // A few clubs per transaction, so that debits of the other clubs of a large batch do not wait for it.
+        int entries = 0;
+        for (size_t first = 0; first < club_ids.size(); first += clubs_per_transaction) {
+            size_t last = std::min(club_ids.size(), first + clubs_per_transaction);
+            int folded = compact_clubs(std::vector<int>(club_ids.begin() + first, club_ids.begin() + last), last_entry);
+            entries += folded;
+            std::lock_guard<std::mutex> lock(mutex);
+            total_compacted += folded;
+        }
+        return entries;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in compact_once: " + std::string(e.what())).log();
+        return -1;
+    }
+}
+
+int BudgetLedgerCompactor::compact_clubs(const std::vector<int> &club_ids, int64_t last_entry) {
+    Transaction transaction(con);
+
+    // Take the Club rows first and in club_id order. A credit holds a shared lock on its Club row
+    // through the foreign key until it commits, so once these are held no entry of these clubs
+    // can commit between the sum and the delete.
+    std::string club_list;
+    for (size_t i = 0; i < club_ids.size(); ++i)
+        club_list += (i == 0 ? "" : ", ") + std::to_string(club_ids[i]);
+
+    std::string lock_query = "SELECT club_id FROM Club WHERE club_id IN (" + club_list + ") ORDER BY club_id FOR UPDATE";
+    std::unique_ptr<sql::Statement> lock_stmt(con->createStatement());
+    std::unique_ptr<sql::ResultSet> locked(lock_stmt->executeQuery(lock_query));
+    Logger(ll_info, "executeQuery: " + lock_query).log();
+
+    std::string apply_query = "UPDATE Club AS c JOIN "
+                              "(SELECT club_id, SUM(delta) AS total FROM Budget_Ledger WHERE entry_id <= ? AND club_id IN (" +
+                              club_list + ") GROUP BY club_id) AS l "
+                              "ON c.club_id = l.club_id SET c.budget = c.budget + l.total";
+    std::unique_ptr<sql::PreparedStatement> apply_stmt(con->prepareStatement(apply_query));
+    apply_stmt->setInt64(1, last_entry);
+    apply_stmt->executeUpdate();
+    Logger(ll_info, "executeQuery: " + apply_query).log();
+
+    std::string delete_query = "DELETE FROM Budget_Ledger WHERE entry_id <= ? AND club_id IN (" + club_list + ")";
+    std::unique_ptr<sql::PreparedStatement> delete_stmt(con->prepareStatement(delete_query));
+    delete_stmt->setInt64(1, last_entry);
+    int entries = delete_stmt->executeUpdate();
+    Logger(ll_info, "executeQuery: " + delete_query).log();
+
+    transaction.commit();
+    return entries;
+}
+
+void BudgetLedgerCompactor::start(std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (worker.joinable())
+        return;
+    stopping = false;
+    worker = std::thread(&BudgetLedgerCompactor::run, this, interval);
+}
+
+void BudgetLedgerCompactor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable())
+        worker.join();
+}
+
+uint64_t BudgetLedgerCompactor::compacted_entries() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return total_compacted;
+}
+
+void BudgetLedgerCompactor::run(std::chrono::milliseconds interval) {
+    while (true) {
+        // Keep going while full batches come back so that a burst drains quickly.
+        int compacted;
+        do {
+            compacted = compact_once();
+        } while (compacted == batch_size);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (wake.wait_for(lock, interval, [this] { return stopping; }))
+            break;
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cppconn/connection.h>
+
+/**
+ * @brief Folds Budget_Ledger deltas into Club.budget in batches.
+ *
+ * Each compaction takes the oldest entries up to a batch size and, for at most
+ * clubs_per_transaction of their clubs at a time, locks the Club rows, applies the per-club
+ * sums to Club with one UPDATE ... JOIN and deletes the entries in one transaction. Credits
+ * recorded through the ledger therefore touch each Club row once per batch instead of once
+ * per credit, and a debit waits only for the chunk holding its club.
+ */
+class BudgetLedgerCompactor {
+public:
+    /**
+     * @brief Constructs a compactor. No background thread runs until start() is called.
+     * @param conn A connection used only by this compactor.
+     * @param batch_size Maximum number of ledger entries folded per transaction.
+     */
+    BudgetLedgerCompactor(std::shared_ptr<sql::Connection> conn, int batch_size = 5000);
+
+    /**
+     * @brief Most Club rows one compaction transaction locks.
+     */
+    static constexpr size_t clubs_per_transaction = 64;
+
+    /**
+     * @brief Stops the background thread if it is running.
+     */
+    ~BudgetLedgerCompactor();
+
+    BudgetLedgerCompactor(const BudgetLedgerCompactor &) = delete;
+    BudgetLedgerCompactor &operator=(const BudgetLedgerCompactor &) = delete;
+
+    /**
+     * @brief Compacts one batch of the oldest ledger entries.
+     * @return The number of entries folded into Club.budget, or -1 if an error occurred.
+     */
+    int compact_once();
+
+    /**
+     * @brief Compacts every few moments on a background thread until stop() is called.
+     * @param interval Time to wait between rounds once the ledger is drained.
+     */
+    void start(std::chrono::milliseconds interval);
+
+    /**
+     * @brief Stops the background thread after its current round.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the total number of entries compacted so far.
+     */
+    uint64_t compacted_entries() const;
+
+private:
+    void run(std::chrono::milliseconds interval);
+
+    /**
+     * @brief Folds the entries up to last_entry of a few clubs in one transaction.
+     * @return The number of entries folded.
+     * @throws sql::SQLException if a statement fails; the transaction is rolled back.
+     */
+    int compact_clubs(const std::vector<int> &club_ids, int64_t last_entry);
+
+    std::shared_ptr<sql::Connection> con;
+    int batch_size;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    uint64_t total_compacted = 0;
+    std::thread worker;
+};
@@ -0,0 +1,194 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+
+#include "../utils.h"
+#include "CascadePurger.h"
+
+/**
+ * @brief One chunked DELETE step: rows of table matching condition (one '?' for the parent ID).
+ */
+struct PurgeStage {
+    const char *table;
+    const char *condition;
+    const char *order_by;
+};
+
+/**
+ * @brief Children of a club, leaves first. Each condition has one '?' for the club ID.
+ */
+static const PurgeStage club_stages[] = {
+    {"Result_Activity", "result_id IN (SELECT result_id FROM Result WHERE club_id = ?)", "result_id, act_id"},
+    {"Result_Activity", "act_id IN (SELECT act_id FROM Activity WHERE club_id = ?)", "result_id, act_id"},
+    {"Result", "club_id = ?", "result_id"},
+    {"Gathering_Student", "gathering_id IN (SELECT g.gathering_id FROM Gathering AS g JOIN Activity AS a ON a.act_id = g.act_id WHERE a.club_id = ?)", "gathering_id, student_id"},
+    {"Gathering", "act_id IN (SELECT act_id FROM Activity WHERE club_id = ?)", "gathering_id"},
+    {"Activity", "club_id = ?", "act_id"},
+    {"Club_Student", "club_id = ?", "club_id, student_id"},
+    {"Club_Equipment", "club_id = ?", "club_id, equip_id"},
+    {"Location", "club_id = ?", "loc_id"},
+    {"Budget_Ledger", "club_id = ?", "entry_id"},
+    {"Club", "club_id = ?", "club_id"},
+};
+
+/**
+ * @brief Children of an activity, leaves first. Each condition has one '?' for the activity ID.
+ */
+static const PurgeStage activity_stages[] = {
+    {"Result_Activity", "act_id = ?", "result_id, act_id"},
+    {"Gathering_Student", "gathering_id IN (SELECT gathering_id FROM Gathering WHERE act_id = ?)", "gathering_id, student_id"},
+    {"Gathering", "act_id = ?", "gathering_id"},
+    {"Activity", "act_id = ?", "act_id"},
+};
+
+CascadePurger::CascadePurger(std::shared_ptr<sql::Connection> conn, PurgeOptions options)
+    : con(conn), options(options) {
+    worker = std::thread(&CascadePurger::run, this);
+}
+
+CascadePurger::~CascadePurger() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void CascadePurger::purge_club(int club_id) {
+    enqueue("Club", club_id);
+}
+
+void CascadePurger::purge_activity(int act_id) {
+    enqueue("Activity", act_id);
+}
+
+bool CascadePurger::resume_pending() {
+    try {
+        std::vector<std::pair<std::string, int>> pending;
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        {
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT club_id FROM Club WHERE pending_delete = 1"));
+            while (res->next())
+                pending.emplace_back("Club", res->getInt(1));
+        }
+        {
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT act_id FROM Activity WHERE pending_delete = 1"));
+            while (res->next())
+                pending.emplace_back("Activity", res->getInt(1));
+        }
+
+        // Clubs first: purging a club also removes its pending activities.
+        for (const auto &[target, id] : pending)
+            enqueue(target, id);
+        return true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in resume_pending: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+std::vector<PurgeProgress> CascadePurger::progress() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs;
+}
+
+void CascadePurger::enqueue(const std::string &target, int id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        PurgeProgress job;
+        job.target = target;
+        job.id = id;
+        job.stages_total = target == "Club" ? std::size(club_stages) : std::size(activity_stages);
+        jobs.push_back(job);
+        queue.push_back(jobs.size() - 1);
+    }
+    wake.notify_one();
+}
+
+void CascadePurger::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping)
+            break;
+
+        size_t job = queue.front();
+        queue.pop_front();
+        lock.unlock();
+
+        bool ok = purge(job);
+
+        lock.lock();
+        jobs[job].stage.clear();
+        if (ok) {
+            jobs[job].finished = true;
+        } else if (!stopping) {
+            jobs[job].failed = true;
+        }
+        Logger(ok ? ll_info : ll_error, "Purge of " + jobs[job].target + " " + std::to_string(jobs[job].id) +
+                                            (ok ? " finished: " : " stopped: ") +
+                                            std::to_string(jobs[job].rows_deleted) + " rows deleted")
+            .log();
+    }
+}
+
+bool CascadePurger::purge(size_t job) {
+    std::string target;
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        target = jobs[job].target;
+        id = jobs[job].id;
+    }
+
+    const PurgeStage *stages = target == "Club" ? club_stages : activity_stages;
+    size_t stage_count = target == "Club" ? std::size(club_stages) : std::size(activity_stages);
+
+    try {
+        for (size_t i = 0; i < stage_count; ++i) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                jobs[job].stage = stages[i].table;
+            }
+
+            std::string query = std::string("DELETE FROM ") + stages[i].table + " WHERE " + stages[i].condition +
+                                " ORDER BY " + stages[i].order_by + " LIMIT ?";
+            std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
+
+            while (true) {
+                pstmt->setInt(1, id);
+                pstmt->setInt(2, options.chunk_size);
+                int deleted = pstmt->executeUpdate();
+
+                bool stop;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    jobs[job].rows_deleted += deleted;
+                    stop = stopping;
+                }
+                if (stop)
+                    return false;
+                if (deleted < options.chunk_size)
+                    break;
+
+                // Let foreground statements get at the locks between chunks.
+                std::this_thread::sleep_for(options.pause);
+            }
+            Logger(ll_info, "executeQuery: " + query).log();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs[job].stages_done++;
+        }
+        return true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in CascadePurger: " + std::string(e.what())).log();
+        return false;
+    }
+}
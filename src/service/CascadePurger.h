@@ -0,0 +1,113 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cppconn/connection.h>
+
+/**
+ * @brief Tuning knobs for CascadePurger.
+ */
+struct PurgeOptions {
+    /**
+     * @brief Maximum rows deleted by one statement (and so held locked by one transaction).
+     */
+    int chunk_size = 1000;
+
+    /**
+     * @brief Pause between two chunks, leaving room for foreground traffic.
+     */
+    std::chrono::milliseconds pause{10};
+};
+
+/**
+ * @brief Progress of one purge job.
+ */
+struct PurgeProgress {
+    /**
+     * @brief "Club" or "Activity".
+     */
+    std::string target;
+    int id = 0;
+
+    /**
+     * @brief Table currently being emptied, or empty when not started/finished.
+     */
+    std::string stage;
+    int stages_done = 0;
+    int stages_total = 0;
+    uint64_t rows_deleted = 0;
+    bool finished = false;
+    bool failed = false;
+};
+
+/**
+ * @brief Deletes clubs and activities with their dependent rows in the background.
+ *
+ * Instead of one ON DELETE CASCADE transaction spanning every child table, children are
+ * deleted bottom-up (Result_Activity, Result, Gathering_Student, Gathering, Activity,
+ * Club_Student, ...) in primary-key ordered chunks, each its own short autocommitted
+ * statement, with a pause in between. The parent must already be marked
+ * pending_delete = 1 so that reads skip it while the purge runs.
+ */
+class CascadePurger {
+public:
+    /**
+     * @brief Starts the purge thread.
+     * @param conn A connection used only by this purger.
+     * @param options Chunk size and throttling.
+     */
+    CascadePurger(std::shared_ptr<sql::Connection> conn, PurgeOptions options = {});
+
+    /**
+     * @brief Stops after the current chunk. Unfinished jobs stay marked pending and can be resumed.
+     */
+    ~CascadePurger();
+
+    CascadePurger(const CascadePurger &) = delete;
+    CascadePurger &operator=(const CascadePurger &) = delete;
+
+    /**
+     * @brief Queues the purge of a club marked pending_delete.
+     * @param club_id The ID of the club.
+     */
+    void purge_club(int club_id);
+
+    /**
+     * @brief Queues the purge of an activity marked pending_delete.
+     * @param act_id The ID of the activity.
+     */
+    void purge_activity(int act_id);
+
+    /**
+     * @brief Queues every club and activity still marked pending_delete, e.g. after a restart.
+     * @return True if the pending rows could be listed, false otherwise.
+     */
+    bool resume_pending();
+
+    /**
+     * @brief Returns the progress of every job queued so far.
+     */
+    std::vector<PurgeProgress> progress() const;
+
+private:
+    void enqueue(const std::string &target, int id);
+    void run();
+    bool purge(size_t job);
+
+    std::shared_ptr<sql::Connection> con;
+    PurgeOptions options;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<size_t> queue;
+    std::vector<PurgeProgress> jobs;
+    bool stopping = false;
+    std::thread worker;
+};
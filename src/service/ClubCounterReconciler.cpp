@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+
+#include "../utils.h"
+#include "ClubCounterReconciler.h"
+#include "Transaction.h"
+
+ClubCounterReconciler::ClubCounterReconciler(std::shared_ptr<ConnectionPool> connection_pool, int chunk_size)
+    : pool(connection_pool), chunk_size(std::max(chunk_size, 1)) {}
+
+ReconcileSummary ClubCounterReconciler::reconcile() {
+    auto started = std::chrono::steady_clock::now();
+    ReconcileSummary summary;
+
+    int min_id = 0, max_id = -1;
+    try {
+        ConnectionPool::Lease lease = pool->acquire();
+        std::unique_ptr<sql::Statement> stmt(lease->createStatement());
+        std::string query = "SELECT MIN(club_id), MAX(club_id) FROM Club";
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query));
+        Logger(ll_info, "executeQuery: " + query).log();
+        if (res->next() && !res->isNull(1)) {
+            min_id = res->getInt(1);
+            max_id = res->getInt(2);
+        }
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in ClubCounterReconciler::reconcile: " + std::string(e.what())).log();
+        summary.failed_chunks = 1;
+        return summary;
+    }
+
+    std::vector<std::pair<int, int>> chunks;
+    for (int64_t first = min_id; first <= max_id; first += chunk_size)
+        chunks.emplace_back(static_cast<int>(first), static_cast<int>(std::min<int64_t>(first + chunk_size - 1, max_id)));
+
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> clubs{0};
+    std::atomic<size_t> repaired{0};
+    std::atomic<size_t> reconciled{0};
+
+    auto work = [&] {
+        std::optional<ConnectionPool::Lease> lease;
+        try {
+            lease.emplace(pool->acquire());
+        } catch (const sql::SQLException &e) {
+            // The chunks this worker would have taken are left to the others, or counted as failed below.
+            Logger(ll_error, "SQL error in ClubCounterReconciler::reconcile: " + std::string(e.what())).log();
+            return;
+        }
+        for (size_t i = next++; i < chunks.size(); i = next++) {
+            auto [checked, fixed] = reconcile_chunk(lease->get(), chunks[i].first, chunks[i].second);
+            if (checked < 0)
+                continue;
+            reconciled++;
+            clubs += static_cast<size_t>(checked);
+            repaired += static_cast<size_t>(fixed);
+        }
+    };
+
+    size_t workers = std::min(pool->size(), chunks.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < workers; ++i)
+        threads.emplace_back(work);
+    if (workers > 0)
+        work();
+    for (auto &thread : threads)
+        thread.join();
+
+    summary.chunks = chunks.size();
+    summary.clubs = clubs;
+    summary.repaired = repaired;
+    // Includes chunks no worker got to because no connection could be opened.
+    summary.failed_chunks = chunks.size() - reconciled;
+    summary.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger(summary.repaired > 0 ? ll_warning : ll_info,
+           "Club counters reconciled: " + std::to_string(summary.clubs) + " clubs in " + std::to_string(summary.chunks) +
+               " chunks, " + std::to_string(summary.repaired) + " repaired, " + std::to_string(summary.failed_chunks) +
+               " chunks failed in " + std::to_string(summary.elapsed.count()) + " ms")
+        .log();
+    return summary;
+}
+
+std::pair<int, int> ClubCounterReconciler::reconcile_chunk(std::shared_ptr<sql::Connection> conn, int first, int last) {
+    try {
+        Transaction transaction(conn);
+
+        // Locking the Club rows first makes concurrent trigger updates of these clubs wait for this transaction.
+        std::map<int, std::pair<int, int>> stored;
+        std::string lock_query = "SELECT club_id, member_count, activity_count FROM Club WHERE club_id BETWEEN ? AND ? FOR UPDATE";
+        std::unique_ptr<sql::PreparedStatement> lock_stmt(conn->prepareStatement(lock_query));
+        lock_stmt->setInt(1, first);
+        lock_stmt->setInt(2, last);
+        {
+            std::unique_ptr<sql::ResultSet> res(lock_stmt->executeQuery());
+            while (res->next())
+                stored[res->getInt(1)] = {res->getInt(2), res->getInt(3)};
+        }
+        if (stored.empty()) {
+            transaction.commit();
+            return {0, 0};
+        }
+
+        std::map<int, std::pair<int, int>> counted;
+        for (const auto &[club_id, counts] : stored)
+            counted[club_id] = {0, 0};
+
+        std::string member_query = "SELECT club_id, COUNT(*) FROM Club_Student WHERE club_id BETWEEN ? AND ? GROUP BY club_id";
+        std::unique_ptr<sql::PreparedStatement> member_stmt(conn->prepareStatement(member_query));
+        member_stmt->setInt(1, first);
+        member_stmt->setInt(2, last);
+        {
+            std::unique_ptr<sql::ResultSet> res(member_stmt->executeQuery());
+            while (res->next()) {
+                auto it = counted.find(res->getInt(1));
+                if (it != counted.end())
+                    it->second.first = res->getInt(2);
+            }
+        }
+
+        std::string activity_query = "SELECT club_id, COUNT(*) FROM Activity "
+                                     "WHERE club_id BETWEEN ? AND ? AND pending_delete = 0 GROUP BY club_id";
+        std::unique_ptr<sql::PreparedStatement> activity_stmt(conn->prepareStatement(activity_query));
+        activity_stmt->setInt(1, first);
+        activity_stmt->setInt(2, last);
+        {
+            std::unique_ptr<sql::ResultSet> res(activity_stmt->executeQuery());
+            while (res->next()) {
+                auto it = counted.find(res->getInt(1));
+                if (it != counted.end())
+                    it->second.second = res->getInt(2);
+            }
+        }
+
+        int fixed = 0;
+        std::string repair_query = "UPDATE Club SET member_count = ?, activity_count = ? WHERE club_id = ?";
+        std::unique_ptr<sql::PreparedStatement> repair_stmt(conn->prepareStatement(repair_query));
+        for (const auto &[club_id, counts] : counted) {
+            if (counts == stored[club_id])
+                continue;
+            Logger(ll_warning, "Club ID " + std::to_string(club_id) + " counters drifted: members " +
+                                   std::to_string(stored[club_id].first) + " -> " + std::to_string(counts.first) +
+                                   ", activities " + std::to_string(stored[club_id].second) + " -> " +
+                                   std::to_string(counts.second))
+                .log();
+            repair_stmt->setInt(1, counts.first);
+            repair_stmt->setInt(2, counts.second);
+            repair_stmt->setInt(3, club_id);
+            repair_stmt->executeUpdate();
+            fixed++;
+        }
+
+        transaction.commit();
+        return {static_cast<int>(stored.size()), fixed};
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in ClubCounterReconciler::reconcile_chunk: " + std::string(e.what())).log();
+        return {-1, 0};
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "ConnectionPool.h"
+
+/**
+ * @brief Totals of one reconciliation run.
+ */
+struct ReconcileSummary {
+    size_t chunks = 0;
+    size_t clubs = 0;
+
+    /**
+     * @brief Clubs whose counters differed from the counted rows and were repaired.
+     */
+    size_t repaired = 0;
+    size_t failed_chunks = 0;
+    std::chrono::milliseconds elapsed{0};
+};
+
+/**
+ * @brief Verifies Club.member_count and Club.activity_count against Club_Student and Activity and repairs drift.
+ *
+ * The club_id range is split into chunks handed out to one worker per pooled connection. Each chunk
+ * runs in a transaction that first locks its Club rows, so the counter triggers of those clubs wait
+ * for it; counts read after that are exact, and only drifted rows are updated.
+ */
+class ClubCounterReconciler {
+public:
+    /**
+     * @param connection_pool Workers lease their connections here; one worker per pooled connection.
+     * @param chunk_size Number of club IDs per chunk (and per transaction).
+     */
+    explicit ClubCounterReconciler(std::shared_ptr<ConnectionPool> connection_pool, int chunk_size = 500);
+
+    /**
+     * @brief Verifies and repairs every club.
+     */
+    ReconcileSummary reconcile();
+
+private:
+    /**
+     * @brief Verifies and repairs the clubs with IDs in [first, last].
+     * @return The number of clubs checked and repaired, or -1 checked if an error occurred.
+     */
+    std::pair<int, int> reconcile_chunk(std::shared_ptr<sql::Connection> conn, int first, int last);
+
+    std::shared_ptr<ConnectionPool> pool;
+    int chunk_size;
+};
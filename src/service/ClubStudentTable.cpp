@@ -2,16 +2,20 @@
 #include <string>
 #include <memory>
 #include <cppconn/connection.h>
+#include <cppconn/exception.h>
 #include <cppconn/resultset.h>
 #include <cppconn/prepared_statement.h>
 
 #include "../utils.h"
+#include "../workload/ServiceCall.h"
 #include "ClubStudentTable.h"
 
-ClubStudentTable::ClubStudentTable(std::shared_ptr<sql::Connection> conn)
+ClubStudentTable::ClubStudentTable(std::shared_ptr<DbConnection> conn)
     : BasicTable("Club_Student", conn) {}
 
 bool ClubStudentTable::create_club_student(int student_id, int club_id) {
+    ServiceCall call("ClubStudentTable::create_club_student", student_id, club_id);
+    ShardScope shard = ShardScope::club(club_id);
     try {
         std::map<std::string, std::string> attributes;
         attributes["student_id"] = std::to_string(student_id);
@@ -29,15 +33,21 @@ bool ClubStudentTable::create_club_student(int student_id, int club_id) {
     }
 }
 
-std::unique_ptr<sql::ResultSet> ClubStudentTable::read_by_student_id(int student_id) {
-    auto result = basic_select({{"student_id", std::to_string(student_id)}});
-    if (!result) {
+std::shared_ptr<const QueryResult> ClubStudentTable::read_by_student_id(int student_id) {
+    ServiceCall call("ClubStudentTable::read_by_student_id", student_id);
+    try {
+        // A student's clubs may be on different shards.
+        return scatter_query("SELECT * FROM Club_Student WHERE student_id = ?", {student_id}, {{"club_id"}});
+    } catch (const sql::SQLException &e) {
         Logger(ll_info, "No relationships found for student ID: " + std::to_string(student_id)).log();
+        Logger(ll_error, "Error in read_by_student_id: " + std::string(e.what())).log();
+        return nullptr;
     }
-    return result;
 }
 
-std::unique_ptr<sql::ResultSet> ClubStudentTable::read_by_club_id(int club_id) {
+std::unique_ptr<DbResult> ClubStudentTable::read_by_club_id(int club_id) {
+    ServiceCall call("ClubStudentTable::read_by_club_id", club_id);
+    ShardScope shard = ShardScope::club(club_id);
     auto result = basic_select({{"club_id", std::to_string(club_id)}});
     if (!result) {
         Logger(ll_info, "No relationships found for club ID: " + std::to_string(club_id)).log();
@@ -46,6 +56,8 @@ std::unique_ptr<sql::ResultSet> ClubStudentTable::read_by_club_id(int club_id) {
 }
 
 bool ClubStudentTable::delete_club_student(int student_id, int club_id) {
+    ServiceCall call("ClubStudentTable::delete_club_student", student_id, club_id);
+    ShardScope shard = ShardScope::club(club_id);
     try {
         std::map<std::string, std::string> conditions = {
             {"student_id", std::to_string(student_id)},
@@ -19,7 +19,7 @@ public:
      * @brief Constructs a new ClubStudentTable object with a database connection.
      * @param conn A shared pointer to an active database connection.
      */
-    ClubStudentTable(std::shared_ptr<sql::Connection> conn);
+    ClubStudentTable(std::shared_ptr<DbConnection> conn);
 
     /**
      * @brief Creates a new club-student relationship record.
@@ -33,16 +33,16 @@ public:
     /**
      * @brief Reads relationships based on student ID.
      * @param student_id The ID of the student.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return The student's relationships in club_id order, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_by_student_id(int student_id);
+    std::shared_ptr<const QueryResult> read_by_student_id(int student_id);
 
     /**
      * @brief Reads relationships based on club ID.
      * @param club_id The ID of the club.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_by_club_id(int club_id);
+    std::unique_ptr<DbResult> read_by_club_id(int club_id);
 
     /**
      * @brief Deletes a club-student relationship.
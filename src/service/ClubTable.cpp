@@ -1,48 +1,144 @@
 #include <cppconn/connection.h>
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
+#include <algorithm>
 #include <map>
 #include <memory>
+#include <span>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "../utils.h"
+#include "../workload/ServiceCall.h"
 #include "ClubTable.h"
+#include "Transaction.h"
 
-ClubTable::ClubTable(std::shared_ptr<sql::Connection> conn)
-    : BasicTable("Club", conn), club_student_table(conn), activity_table(conn) {}
+/**
+ * @brief Upper bound of rows per multi-row INSERT when loading a roster.
+ */
+static constexpr size_t roster_rows_per_statement = 1000;
+
+ClubTable::ClubTable(std::shared_ptr<DbConnection> conn)
+    : BasicTable("Club", conn), club_student_table(conn), activity_table(conn) {
+    visible_filter = "pending_delete = 0";
+}
+
+ClubTable::~ClubTable() {
+    if (write_queue)
+        write_queue->set_listener(MembershipKind::club_student, nullptr);
+}
+
+void ClubTable::set_write_queue(std::shared_ptr<WriteBehindQueue> queue) {
+    if (write_queue)
+        write_queue->set_listener(MembershipKind::club_student, nullptr);
+    write_queue = queue;
+    if (write_queue)
+        write_queue->set_listener(MembershipKind::club_student,
+                                  [this](int club_id, int student_id, bool insert, std::shared_ptr<sql::Connection>) {
+                                      record_membership_change(club_id, student_id, insert);
+                                  });
+}
+
+void ClubTable::set_budget_ledger(bool enabled) {
+    budget_ledger = enabled;
+}
+
+void ClubTable::set_purger(std::shared_ptr<CascadePurger> cascade_purger) {
+    purger = cascade_purger;
+    activity_table.set_purger(cascade_purger);
+}
+
+void ClubTable::set_search_indexes(std::shared_ptr<TrigramIndex> club_names, std::shared_ptr<TrigramIndex> student_names,
+                                   std::shared_ptr<TrigramIndex> activity_titles) {
+    name_index = club_names;
+    member_name_index = student_names;
+    activity_table.set_title_index(activity_titles);
+}
+
+void ClubTable::set_period_index(std::shared_ptr<ActivityIntervalIndex> index) {
+    period_index = index;
+    activity_table.set_period_index(index);
+}
+
+void ClubTable::set_membership_graph(std::shared_ptr<MembershipGraph> graph) {
+    membership_graph = graph;
+}
+
+void ClubTable::set_membership_sketches(std::shared_ptr<MembershipSketches> membership_sketches) {
+    sketches = membership_sketches;
+}
+
+void ClubTable::set_club_counters(bool enabled) {
+    club_counters = enabled;
+}
+
+void ClubTable::set_activity_rollup(bool enabled) {
+    activity_rollup = enabled;
+    activity_table.set_activity_rollup(enabled);
+}
 
 bool ClubTable::create_club(const std::string &club_name, double budget, int prof_id) {
+    ServiceCall call("ClubTable::create_club", club_name, budget, prof_id);
     std::map<std::string, std::string> attributes;
     attributes["club_name"] = club_name;
     attributes["budget"] = std::to_string(budget);
     attributes["prof_id"] = std::to_string(prof_id);
 
+    ShardScope shard = ShardScope::new_club();
     if (!basic_insert(attributes)) {
         Logger(ll_info, "Failed to create club: " + club_name).log();
         return false;
     }
+    if (name_index || shard_map()) {
+        int club_id = last_insert_id();
+        if (club_id > 0 && !shard.place_club(club_id)) {
+            // Without a directory row the club would be looked for on its default shard; drop it rather than leave it unreachable.
+            try {
+                execute_update("DELETE FROM Club WHERE club_id = ?", {club_id});
+            } catch (const sql::SQLException &e) {
+                Logger(ll_error, "SQL error in create_club: " + std::string(e.what())).log();
+            }
+            Logger(ll_info, "Failed to create club: " + club_name).log();
+            return false;
+        }
+        if (club_id > 0 && name_index)
+            name_index->upsert(club_id, club_name);
+    }
     return true;
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_club_by_id(int club_id) {
-    return basic_select({{"club_id", std::to_string(club_id)}});
+std::shared_ptr<const QueryResult> ClubTable::read_club_by_id(int club_id) {
+    ServiceCall call("ClubTable::read_club_by_id", club_id);
+    ShardScope shard = ShardScope::club(club_id);
+    return coalesced_select({{"club_id", std::to_string(club_id)}});
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_club_by_name(const std::string &club_name) {
-    return basic_string_select({{"club_name", club_name}});
+std::shared_ptr<const QueryResult> ClubTable::read_club_by_name(const std::string &club_name) {
+    ServiceCall call("ClubTable::read_club_by_name", club_name);
+    if (name_index && name_index->ready() && TrigramIndex::covers(club_name)) {
+        std::vector<int> ids = name_index->search(club_name);
+        if (ids.size() <= TrigramIndex::max_selective_matches) {
+            std::unique_ptr<DbResult> res = select_by_ids("club_id", ids);
+            return res ? QueryResult::from_db_result(*res) : nullptr;
+        }
+    }
+    try {
+        return scatter_query("SELECT * FROM Club WHERE club_name LIKE ? AND pending_delete = 0", {"%" + club_name + "%"},
+                             {{"club_id"}});
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in read_club_by_name: " + std::string(e.what())).log();
+        return nullptr;
+    }
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_club_by_location_id(int loc_id) {
+std::shared_ptr<const QueryResult> ClubTable::read_club_by_location_id(int loc_id) {
+    ServiceCall call("ClubTable::read_club_by_location_id", loc_id);
     try {
-        std::string query = "SELECT * FROM Club WHERE club_id IN (SELECT club_id FROM Location WHERE loc_id = ?)";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, loc_id);
-
-        std::unique_ptr<sql::ResultSet> result(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
+        std::string query = "SELECT * FROM Club WHERE club_id IN (SELECT club_id FROM Location WHERE loc_id = ?) AND pending_delete = 0";
+        std::shared_ptr<const QueryResult> result = scatter_query(query, {loc_id}, {{"club_id"}});
 
-        if (!result || result->rowsCount() == 0) {
+        if (result->rows_count() == 0) {
             Logger(ll_info, "No club found with location ID: " + std::to_string(loc_id)).log();
         }
 
@@ -53,16 +149,13 @@ std::unique_ptr<sql::ResultSet> ClubTable::read_club_by_location_id(int loc_id)
     }
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_club_by_location_name(const std::string &loc_name) {
+std::shared_ptr<const QueryResult> ClubTable::read_club_by_location_name(const std::string &loc_name) {
+    ServiceCall call("ClubTable::read_club_by_location_name", loc_name);
     try {
-        std::string query = "SELECT * FROM Club WHERE club_id IN (SELECT club_id FROM Location WHERE loc_name like '%?%')";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setString(1, loc_name);
+        std::string query = "SELECT * FROM Club WHERE club_id IN (SELECT club_id FROM Location WHERE loc_name LIKE ?) AND pending_delete = 0";
+        std::shared_ptr<const QueryResult> result = scatter_query(query, {"%" + loc_name + "%"}, {{"club_id"}});
 
-        std::unique_ptr<sql::ResultSet> result(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-
-        if (!result || result->rowsCount() == 0) {
+        if (result->rows_count() == 0) {
             Logger(ll_info, "No club found with location name: " + loc_name).log();
         }
 
@@ -73,11 +166,19 @@ std::unique_ptr<sql::ResultSet> ClubTable::read_club_by_location_name(const std:
     }
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_club_by_prof_id(int prof_id) {
-    return basic_select({{"prof_id", std::to_string(prof_id)}});
+std::shared_ptr<const QueryResult> ClubTable::read_club_by_prof_id(int prof_id) {
+    ServiceCall call("ClubTable::read_club_by_prof_id", prof_id);
+    try {
+        return scatter_query("SELECT * FROM Club WHERE prof_id = ? AND pending_delete = 0", {prof_id}, {{"club_id"}});
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in read_club_by_prof_id: " + std::string(e.what())).log();
+        return nullptr;
+    }
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_info(int club_id, std::set<std::string> join_table) {
+std::unique_ptr<DbResult> ClubTable::read_info(int club_id, std::set<std::string> join_table) {
+    ServiceCall call("ClubTable::read_info", club_id, join_table);
+    ShardScope shard = ShardScope::club(club_id);
     try {
         std::ostringstream query;
 
@@ -90,16 +191,12 @@ std::unique_ptr<sql::ResultSet> ClubTable::read_info(int club_id, std::set<std::
         }
 
         // Build the underlying SQL query
-        query << "FROM " << table_name << " AS c WHERE c.club_id = ?";
+        query << "FROM " << table_name << " AS c WHERE c.club_id = ? AND c.pending_delete = 0";
 
         std::string query_str = query.str();
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query_str));
-        pstmt->setInt(1, club_id);
-
-        std::unique_ptr<sql::ResultSet> result(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query_str).log();
+        std::unique_ptr<DbResult> result = execute_query(query_str, {club_id});
 
-        if (!result || result->rowsCount() == 0) {
+        if (!result || result->rows_count() == 0) {
             Logger(ll_info, "No information found for club ID: " + std::to_string(club_id)).log();
         }
 
@@ -113,44 +210,51 @@ std::unique_ptr<sql::ResultSet> ClubTable::read_info(int club_id, std::set<std::
     }
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_members_by_club_id(int club_id) {
-    try {
-        std::string query = "SELECT * FROM Student WHERE student_id IN (SELECT student_id FROM Club_Student WHERE club_id = ?)";
-
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, club_id);
+std::shared_ptr<const QueryResult> ClubTable::read_members_by_club_id(int club_id) {
+    ServiceCall call("ClubTable::read_members_by_club_id", club_id);
+    ShardScope shard = ShardScope::club(club_id);
+    std::string query = "SELECT * FROM Student WHERE student_id IN (SELECT student_id FROM Club_Student WHERE club_id = ?)";
+    std::shared_ptr<const QueryResult> result = coalesced_query(query, {club_id});
 
-        std::unique_ptr<sql::ResultSet> result(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-
-        if (!result || result->rowsCount() == 0) {
-            Logger(ll_info, "No students found for club ID: " + std::to_string(club_id)).log();
-        }
-
-        return result;
-    } catch (const sql::SQLException &e) {
-        Logger(ll_error, "SQL error in read_students_by_club_id: " + std::string(e.what())).log();
-        return nullptr;
-    } catch (const std::exception &e) {
-        Logger(ll_error, "Error in read_students_by_club_id: " + std::string(e.what())).log();
-        return nullptr;
+    if (result && result->rows_count() == 0) {
+        Logger(ll_info, "No students found for club ID: " + std::to_string(club_id)).log();
     }
+    return result;
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_members_by_name_in_club(int club_id, const std::string &student_name) {
+std::unique_ptr<DbResult> ClubTable::read_members_by_name_in_club(int club_id, const std::string &student_name) {
+    ServiceCall call("ClubTable::read_members_by_name_in_club", club_id, student_name);
+    ShardScope shard = ShardScope::club(club_id);
     try {
+        std::vector<int> ids;
+        bool use_index = member_name_index && member_name_index->ready() && TrigramIndex::covers(student_name);
+        if (use_index) {
+            ids = member_name_index->search(student_name);
+            use_index = ids.size() <= TrigramIndex::max_selective_matches;
+        }
+
         std::string query = "SELECT s.* FROM Student AS s "
                             "JOIN Club_Student AS cs ON s.student_id = cs.student_id "
                             "WHERE cs.club_id = ? AND s.name LIKE ?";
+        if (use_index) {
+            query = "SELECT s.* FROM Student AS s "
+                    "JOIN Club_Student AS cs ON s.student_id = cs.student_id "
+                    "WHERE cs.club_id = ? AND s.student_id IN (";
+            for (size_t i = 0; i < ids.size(); ++i)
+                query += i == 0 ? "?" : ", ?";
+            query += ids.empty() ? "NULL)" : ")";
+        }
 
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, club_id);
-        pstmt->setString(2, '%' + student_name + '%');
+        std::vector<SqlParam> params{club_id};
+        if (use_index) {
+            params.insert(params.end(), ids.begin(), ids.end());
+        } else {
+            params.push_back('%' + student_name + '%');
+        }
 
-        std::unique_ptr<sql::ResultSet> result(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
+        std::unique_ptr<DbResult> result = execute_query(query, params);
 
-        if (!result || result->rowsCount() == 0) {
+        if (!result || result->rows_count() == 0) {
             Logger(ll_info, "No students found with the name pattern '" + student_name + "' in club ID: " + std::to_string(club_id)).log();
         }
 
@@ -165,16 +269,41 @@ std::unique_ptr<sql::ResultSet> ClubTable::read_members_by_name_in_club(int club
 }
 
 bool ClubTable::update_club_name(int club_id, const std::string &new_name) {
+    ServiceCall call("ClubTable::update_club_name", club_id, new_name);
+    ShardScope shard = ShardScope::club(club_id);
     std::map<std::string, std::string> conditions = {{"club_id", std::to_string(club_id)}};
     std::map<std::string, std::string> new_values = {{"club_name", new_name}};
     if (!basic_update(conditions, new_values)) {
         Logger(ll_info, "Failed to update club name for ID: " + std::to_string(club_id)).log();
         return false;
     }
+    if (name_index)
+        name_index->upsert(club_id, new_name);
     return true;
 }
 
 bool ClubTable::update_club_budget(int club_id, double new_budget) {
+    ServiceCall call("ClubTable::update_club_budget", club_id, new_budget);
+    ShardScope shard = ShardScope::club(club_id);
+    if (budget_ledger) {
+        // The new budget replaces whatever is pending in the ledger, so both change under the club's lock.
+        try {
+            Transaction transaction(connection());
+            std::unique_ptr<DbResult> club = execute_query("SELECT club_id FROM Club WHERE club_id = ? FOR UPDATE", {club_id});
+            if (!club->next()) {
+                Logger(ll_info, "Failed to update club budget for ID: " + std::to_string(club_id)).log();
+                return false;
+            }
+            execute_update("UPDATE Club SET budget = ? WHERE club_id = ?", {new_budget, club_id});
+            execute_update("DELETE FROM Budget_Ledger WHERE club_id = ?", {club_id});
+            transaction.commit();
+            return true;
+        } catch (const sql::SQLException &e) {
+            Logger(ll_error, "SQL error in update_club_budget: " + std::string(e.what())).log();
+            return false;
+        }
+    }
+
     std::map<std::string, std::string> conditions = {{"club_id", std::to_string(club_id)}};
     std::map<std::string, std::string> new_values = {{"budget", std::to_string(new_budget)}};
     if (!basic_update(conditions, new_values)) {
@@ -184,7 +313,54 @@ bool ClubTable::update_club_budget(int club_id, double new_budget) {
     return true;
 }
 
+bool ClubTable::adjust_budget(int club_id, double delta) {
+    ServiceCall call("ClubTable::adjust_budget", club_id, delta);
+    ShardScope shard = ShardScope::club(club_id);
+    try {
+        if (budget_ledger && delta >= 0) {
+            // Credits only append. The foreign key takes a shared lock on the Club row, so concurrent
+            // credits of one club do not wait on each other and a missing club fails the insert.
+            execute_update("INSERT INTO Budget_Ledger (club_id, delta) VALUES (?, ?)", {club_id, delta});
+            return true;
+        }
+
+        // Debits take the guarded update, also with the ledger: its pending entries are all credits, so the
+        // compacted budget alone never lets a spend overdraw.
+        int affected = execute_update("UPDATE Club SET budget = budget + ? WHERE club_id = ? AND budget + ? >= 0", {delta, club_id, delta});
+
+        if (affected != 1) {
+            Logger(ll_info, "Budget of club ID " + std::to_string(club_id) + " was not adjusted (missing club or insufficient budget)").log();
+            return false;
+        }
+        return true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in adjust_budget: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+std::unique_ptr<DbResult> ClubTable::read_effective_budget(int club_id) {
+    ServiceCall call("ClubTable::read_effective_budget", club_id);
+    ShardScope shard = ShardScope::club(club_id);
+    try {
+        std::string query = "SELECT club_id, budget FROM Club WHERE club_id = ?";
+        if (budget_ledger) {
+            query = "SELECT c.club_id, c.budget + "
+                    "COALESCE((SELECT SUM(l.delta) FROM Budget_Ledger AS l WHERE l.club_id = c.club_id), 0) AS budget "
+                    "FROM Club AS c WHERE c.club_id = ?";
+        }
+
+        std::unique_ptr<DbResult> result = execute_query(query, {club_id});
+        return result;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in read_effective_budget: " + std::string(e.what())).log();
+        return nullptr;
+    }
+}
+
 bool ClubTable::update_club_prof_id(int club_id, int new_prof_id) {
+    ServiceCall call("ClubTable::update_club_prof_id", club_id, new_prof_id);
+    ShardScope shard = ShardScope::club(club_id);
     std::map<std::string, std::string> conditions = {{"club_id", std::to_string(club_id)}};
     std::map<std::string, std::string> new_values = {{"prof_id", std::to_string(new_prof_id)}};
     if (!basic_update(conditions, new_values)) {
@@ -195,39 +371,272 @@ bool ClubTable::update_club_prof_id(int club_id, int new_prof_id) {
 }
 
 bool ClubTable::add_member(int club_id, int student_id) {
-    return club_student_table.create_club_student(student_id, club_id);
+    ServiceCall call("ClubTable::add_member", club_id, student_id);
+    ShardScope shard = ShardScope::club(club_id);
+    // Queued writes reach the graph and sketches through the queue's listener, once written.
+    if (write_queue)
+        return write_queue->add(MembershipKind::club_student, club_id, student_id);
+
+    bool added = club_student_table.create_club_student(student_id, club_id);
+    if (added)
+        record_membership_change(club_id, student_id, true);
+    return added;
 }
 
 bool ClubTable::delete_member(int club_id, int student_id) {
-    return club_student_table.delete_club_student(student_id, club_id);
+    ServiceCall call("ClubTable::delete_member", club_id, student_id);
+    ShardScope shard = ShardScope::club(club_id);
+    if (write_queue)
+        return write_queue->remove(MembershipKind::club_student, club_id, student_id);
+
+    bool deleted = club_student_table.delete_club_student(student_id, club_id);
+    if (deleted)
+        record_membership_change(club_id, student_id, false);
+    return deleted;
+}
+
+void ClubTable::record_membership_change(int club_id, int student_id, bool insert) {
+    if (insert) {
+        if (membership_graph)
+            membership_graph->add_member(club_id, student_id);
+        if (sketches)
+            sketches->record_membership(club_id, student_id);
+    } else if (membership_graph) {
+        membership_graph->remove_member(club_id, student_id);
+    }
+}
+
+int ClubTable::add_members_by_department(int club_id, const std::string &department) {
+    ServiceCall call("ClubTable::add_members_by_department", club_id, department);
+    ShardScope shard = ShardScope::club(club_id);
+    try {
+        // Keep queued single-row writes ordered before the set-based one.
+        if (write_queue)
+            write_queue->flush();
+
+        std::string query = "INSERT IGNORE INTO Club_Student (club_id, student_id) "
+                            "SELECT ?, s.student_id FROM Student AS s WHERE s.department = ?";
+        int added = execute_update(query, {club_id, department});
+        Logger(ll_info, "Added " + std::to_string(added) + " members of " + department + " to club ID: " + std::to_string(club_id)).log();
+        if (added > 0 && membership_graph)
+            membership_graph->reload_club(connection(), club_id);
+        if (added > 0 && sketches)
+            sketches->record_club_roster(connection(), club_id, static_cast<uint64_t>(added));
+        return added;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in add_members_by_department: " + std::string(e.what())).log();
+        return -1;
+    }
+}
+
+int ClubTable::delete_members_by_department(int club_id, const std::string &department) {
+    ServiceCall call("ClubTable::delete_members_by_department", club_id, department);
+    ShardScope shard = ShardScope::club(club_id);
+    try {
+        if (write_queue)
+            write_queue->flush();
+
+        std::string query = "DELETE cs FROM Club_Student AS cs "
+                            "JOIN Student AS s ON s.student_id = cs.student_id "
+                            "WHERE cs.club_id = ? AND s.department = ?";
+        int removed = execute_update(query, {club_id, department});
+        Logger(ll_info, "Removed " + std::to_string(removed) + " members of " + department + " from club ID: " + std::to_string(club_id)).log();
+        if (removed > 0 && membership_graph)
+            membership_graph->reload_club(connection(), club_id);
+        return removed;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in delete_members_by_department: " + std::string(e.what())).log();
+        return -1;
+    }
+}
+
+bool ClubTable::sync_members(int club_id, std::span<const int> student_ids) {
+    ServiceCall call("ClubTable::sync_members", club_id, student_ids);
+    ShardScope shard = ShardScope::club(club_id);
+    // The roster is staged in a session temporary table, which only a MySQL session has.
+    std::shared_ptr<sql::Connection> conn = connection();
+    if (!conn) {
+        Logger(ll_error, "sync_members is not supported without a MySQL connection").log();
+        return false;
+    }
+    try {
+        if (write_queue)
+            write_queue->flush();
+
+        Transaction transaction(conn);
+
+        // Creating a temporary table does not commit the open transaction.
+        std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+        stmt->execute("CREATE TEMPORARY TABLE IF NOT EXISTS Sync_Roster (student_id INT PRIMARY KEY) ENGINE = MEMORY");
+        stmt->execute("DELETE FROM Sync_Roster");
+
+        for (size_t begin = 0; begin < student_ids.size(); begin += roster_rows_per_statement) {
+            size_t end = std::min(student_ids.size(), begin + roster_rows_per_statement);
+            std::string query = "INSERT IGNORE INTO Sync_Roster (student_id) VALUES ";
+            for (size_t i = begin; i < end; ++i) {
+                if (i != begin) query += ", ";
+                query += "(?)";
+            }
+            execute_update(query, std::vector<SqlParam>(student_ids.begin() + begin, student_ids.begin() + end));
+        }
+
+        std::string delete_query = "DELETE cs FROM Club_Student AS cs "
+                                   "LEFT JOIN Sync_Roster AS r ON r.student_id = cs.student_id "
+                                   "WHERE cs.club_id = ? AND r.student_id IS NULL";
+        int removed = execute_update(delete_query, {club_id});
+
+        std::string insert_query = "INSERT IGNORE INTO Club_Student (club_id, student_id) "
+                                   "SELECT ?, r.student_id FROM Sync_Roster AS r "
+                                   "JOIN Student AS s ON s.student_id = r.student_id";
+        int added = execute_update(insert_query, {club_id});
+
+        stmt->execute("DELETE FROM Sync_Roster");
+        transaction.commit();
+
+        Logger(ll_info, "Synchronized members of club ID " + std::to_string(club_id) + ": " +
+                            std::to_string(added) + " added, " + std::to_string(removed) + " removed")
+            .log();
+        if (membership_graph)
+            membership_graph->reload_club(conn, club_id);
+        if (added > 0 && sketches)
+            sketches->record_club_roster(conn, club_id, static_cast<uint64_t>(added));
+        return true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in sync_members: " + std::string(e.what())).log();
+        return false;
+    }
 }
 
 bool ClubTable::delete_club(int club_id) {
+    ServiceCall call("ClubTable::delete_club", club_id);
+    ShardScope shard = ShardScope::club(club_id);
+    if (purger) {
+        try {
+            std::string query = "UPDATE Club SET pending_delete = 1 WHERE club_id = ? AND pending_delete = 0";
+            int marked = execute_update(query, {club_id});
+
+            if (marked != 1) {
+                Logger(ll_info, "Failed to delete club with ID: " + std::to_string(club_id)).log();
+                return false;
+            }
+            purger->purge_club(club_id);
+            if (name_index)
+                name_index->erase(club_id);
+            if (period_index)
+                period_index->erase_club(club_id);
+            if (membership_graph)
+                membership_graph->drop_club(club_id);
+            return true;
+        } catch (const sql::SQLException &e) {
+            Logger(ll_error, "SQL error in delete_club: " + std::string(e.what())).log();
+            return false;
+        }
+    }
+
     std::map<std::string, std::string> conditions = {{"club_id", std::to_string(club_id)}};
     if (!basic_delete(conditions)) {
         Logger(ll_info, "Failed to delete club with ID: " + std::to_string(club_id)).log();
         return false;
     }
+    if (name_index)
+        name_index->erase(club_id);
+    if (period_index)
+        period_index->erase_club(club_id);
+    if (membership_graph)
+        membership_graph->drop_club(club_id);
     return true;
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_all_club() {
-    return basic_select_all();
+std::shared_ptr<const QueryResult> ClubTable::read_all_club() {
+    ServiceCall call("ClubTable::read_all_club");
+    try {
+        return scatter_query("SELECT * FROM Club WHERE pending_delete = 0", {}, {{"club_id"}});
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in read_all_club: " + std::string(e.what())).log();
+        return nullptr;
+    }
+}
+
+std::unique_ptr<DbResult> ClubTable::read_club_counts(int club_id) {
+    ServiceCall call("ClubTable::read_club_counts", club_id);
+    ShardScope shard = ShardScope::club(club_id);
+    try {
+        std::string query = club_counters
+            ? "SELECT club_id, member_count, activity_count FROM Club WHERE club_id = ? AND pending_delete = 0"
+            : "SELECT c.club_id, "
+              "(SELECT COUNT(*) FROM Club_Student AS cs WHERE cs.club_id = c.club_id) AS member_count, "
+              "(SELECT COUNT(*) FROM Activity AS a WHERE a.club_id = c.club_id AND a.pending_delete = 0) AS activity_count "
+              "FROM Club AS c WHERE c.club_id = ? AND c.pending_delete = 0";
+        std::unique_ptr<DbResult> res = execute_query(query, {club_id});
+        return res;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in read_club_counts: " + std::string(e.what())).log();
+        return nullptr;
+    }
+}
+
+std::shared_ptr<const QueryResult> ClubTable::read_largest_clubs(int k) {
+    ServiceCall call("ClubTable::read_largest_clubs", k);
+    if (k < 1) {
+        Logger(ll_info, "Failed to read largest clubs: the number of clubs must be at least 1, got " + std::to_string(k)).log();
+        return nullptr;
+    }
+    try {
+        std::string query = club_counters
+            ? "SELECT club_id, club_name, member_count, activity_count FROM Club "
+              "WHERE pending_delete = 0 ORDER BY member_count DESC, club_id DESC LIMIT ?"
+            : "SELECT c.club_id, c.club_name, COUNT(cs.student_id) AS member_count, "
+              "(SELECT COUNT(*) FROM Activity AS a WHERE a.club_id = c.club_id AND a.pending_delete = 0) AS activity_count "
+              "FROM Club AS c LEFT JOIN Club_Student AS cs ON cs.club_id = c.club_id WHERE c.pending_delete = 0 "
+              "GROUP BY c.club_id, c.club_name ORDER BY member_count DESC, c.club_id DESC LIMIT ?";
+        // Every shard returns its own top k; the largest k of those are the largest overall.
+        return scatter_query(query, {k}, {{"member_count", true}, {"club_id", true}}, static_cast<size_t>(k));
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in read_largest_clubs: " + std::string(e.what())).log();
+        return nullptr;
+    }
+}
+
+std::unique_ptr<DbResult> ClubTable::read_yearly_activity(int club_id) {
+    ServiceCall call("ClubTable::read_yearly_activity", club_id);
+    ShardScope shard = ShardScope::club(club_id);
+    try {
+        std::string query = activity_rollup
+            ? "SELECT year, activity_count, gathering_count, attendee_count FROM Club_Activity_Rollup "
+              "WHERE club_id = ? AND activity_count > 0 ORDER BY year DESC"
+            : "SELECT YEAR(a.start_date) AS year, COUNT(DISTINCT a.act_id) AS activity_count, "
+              "COUNT(DISTINCT g.gathering_id) AS gathering_count, COUNT(gs.student_id) AS attendee_count "
+              "FROM Activity AS a "
+              "LEFT JOIN Gathering AS g ON g.act_id = a.act_id "
+              "LEFT JOIN Gathering_Student AS gs ON gs.gathering_id = g.gathering_id "
+              "WHERE a.club_id = ? AND a.pending_delete = 0 GROUP BY YEAR(a.start_date) ORDER BY year DESC";
+        std::unique_ptr<DbResult> res = execute_query(query, {club_id});
+        return res;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in read_yearly_activity: " + std::string(e.what())).log();
+        return nullptr;
+    }
 }
 
 // Activities
 
 bool ClubTable::create_activity_for_club(int club_id, const std::string &act_title, const std::string &start_date, const std::string &end_date) {
+    ServiceCall call("ClubTable::create_activity_for_club", club_id, act_title, start_date, end_date);
+    ShardScope shard = ShardScope::club(club_id);
     if (end_date.empty())
         return activity_table.create_activity(club_id, act_title, start_date);
     return activity_table.create_activity(club_id, act_title, start_date, end_date);
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_activities_by_club(int club_id) {
+std::unique_ptr<DbResult> ClubTable::read_activities_by_club(int club_id) {
+    ServiceCall call("ClubTable::read_activities_by_club", club_id);
+    ShardScope shard = ShardScope::club(club_id);
     return activity_table.read_activity_by_club_id(club_id);
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_activity_by_id(int club_id, int act_id) {
+std::shared_ptr<const QueryResult> ClubTable::read_activity_by_id(int club_id, int act_id) {
+    ServiceCall call("ClubTable::read_activity_by_id", club_id, act_id);
+    ShardScope shard = ShardScope::club(club_id);
     if (!validate_activity_belongs_to_club(club_id, act_id)) {
         Logger(ll_info, "Activity does not belong to the given club").log();
         return nullptr;
@@ -236,6 +645,8 @@ std::unique_ptr<sql::ResultSet> ClubTable::read_activity_by_id(int club_id, int
 }
 
 bool ClubTable::update_activity_for_club(int club_id, int act_id, const std::map<std::string, std::string> &updates) {
+    ServiceCall call("ClubTable::update_activity_for_club", club_id, act_id, updates);
+    ShardScope shard = ShardScope::club(club_id);
     if (!validate_activity_belongs_to_club(club_id, act_id)) {
         Logger(ll_info, "Activity does not belong to the given club").log();
         return false;
@@ -244,6 +655,8 @@ bool ClubTable::update_activity_for_club(int club_id, int act_id, const std::map
 }
 
 bool ClubTable::delete_activity_for_club(int club_id, int act_id) {
+    ServiceCall call("ClubTable::delete_activity_for_club", club_id, act_id);
+    ShardScope shard = ShardScope::club(club_id);
     if (!validate_activity_belongs_to_club(club_id, act_id)) {
         Logger(ll_info, "Activity does not belong to the given club").log();
         return false;
@@ -252,17 +665,24 @@ bool ClubTable::delete_activity_for_club(int club_id, int act_id) {
 }
 
 bool ClubTable::validate_activity_belongs_to_club(int club_id, int act_id) {
+    ServiceCall call("ClubTable::validate_activity_belongs_to_club", club_id, act_id);
+    ShardScope shard = ShardScope::club(club_id);
     auto result = activity_table.read_activity_by_id(act_id);
-    if (result && result->next()) {
-        return result->getInt("club_id") == club_id;
+    if (result && result->rows_count() > 0) {
+        int column = result->column_index("club_id");
+        return column >= 0 && !result->is_null(0, column) && result->get_int(0, column) == club_id;
     }
     return false;
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_activity_by_title(int club_id, const std::string &act_title) {
+std::shared_ptr<const QueryResult> ClubTable::read_activity_by_title(int club_id, const std::string &act_title) {
+    ServiceCall call("ClubTable::read_activity_by_title", club_id, act_title);
+    ShardScope shard = ShardScope::club(club_id);
     return activity_table.read_activity_by_title(act_title, club_id);
 }
 
-std::unique_ptr<sql::ResultSet> ClubTable::read_activity_by_period(int club_id, const std::string &from_date, const std::string &to_date) {
+std::shared_ptr<const QueryResult> ClubTable::read_activity_by_period(int club_id, const std::string &from_date, const std::string &to_date) {
+    ServiceCall call("ClubTable::read_activity_by_period", club_id, from_date, to_date);
+    ShardScope shard = ShardScope::club(club_id);
     return activity_table.read_activity_by_period(from_date, to_date, club_id);
 }
\ No newline at end of file
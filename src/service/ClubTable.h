@@ -6,12 +6,18 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <span>
 #include <string>
 
+#include "../analytics/MembershipSketches.h"
+#include "../index/MembershipGraph.h"
+#include "../index/TrigramIndex.h"
 #include "../utils.h"
 #include "ActivityTable.h"
 #include "BasicTable.h"
+#include "CascadePurger.h"
 #include "ClubStudentTable.h"
+#include "WriteBehindQueue.h"
 
 /**
  * @brief Represents the club table with specific CRUD operations.
@@ -21,12 +27,134 @@ class ClubTable : public BasicTable {
     ClubStudentTable club_student_table;
     ActivityTable activity_table;
 
+    /**
+     * @brief Optional write-behind queue for add_member/delete_member. Null means write immediately.
+     */
+    std::shared_ptr<WriteBehindQueue> write_queue;
+
+    /**
+     * @brief Whether adjust_budget appends credits to Budget_Ledger instead of updating Club.budget.
+     */
+    bool budget_ledger = false;
+
+    /**
+     * @brief Optional background purger. When set, delete_club marks the club and purges it asynchronously.
+     */
+    std::shared_ptr<CascadePurger> purger;
+
+    /**
+     * @brief Optional substring index over Club.club_name.
+     */
+    std::shared_ptr<TrigramIndex> name_index;
+
+    /**
+     * @brief Optional substring index over Student.name, used for member searches.
+     */
+    std::shared_ptr<TrigramIndex> member_name_index;
+
+    /**
+     * @brief Optional interval index over activity periods, shared with activity_table.
+     */
+    std::shared_ptr<ActivityIntervalIndex> period_index;
+
+    /**
+     * @brief Optional in-memory membership graph kept current by the membership writes.
+     */
+    std::shared_ptr<MembershipGraph> membership_graph;
+
+    /**
+     * @brief Optional approximate membership sketches fed by the membership writes.
+     */
+    std::shared_ptr<MembershipSketches> sketches;
+
+    /**
+     * @brief Whether Club.member_count and Club.activity_count are maintained (db_scripts/club_counters.sql).
+     */
+    bool club_counters = false;
+
+    /**
+     * @brief Whether Club_Activity_Rollup is maintained (db_scripts/activity_rollup.sql).
+     */
+    bool activity_rollup = false;
+
+    /**
+     * @brief Applies a written membership change to the membership graph and sketches.
+     */
+    void record_membership_change(int club_id, int student_id, bool insert);
+
   public:  
     /**
      * @brief Constructs a new ClubTable object with a database connection.
      * @param conn A shared pointer to an active database connection.
      */
-    ClubTable(std::shared_ptr<sql::Connection> conn);
+    ClubTable(std::shared_ptr<DbConnection> conn);
+
+    /**
+     * @brief Stops listening to the write-behind queue.
+     */
+    ~ClubTable();
+
+    ClubTable(const ClubTable &) = delete;
+    ClubTable &operator=(const ClubTable &) = delete;
+
+    /**
+     * @brief Routes add_member/delete_member through a write-behind queue.
+     * The membership graph and sketches then follow the rows the queue actually writes.
+     * @param queue The queue to use, or nullptr to write immediately again.
+     */
+    void set_write_queue(std::shared_ptr<WriteBehindQueue> queue);
+
+    /**
+     * @brief Makes adjust_budget append credits to Budget_Ledger (see db_scripts/budget_ledger.sql).
+     * The credits are folded into Club.budget by a BudgetLedgerCompactor; debits still update Club.budget.
+     * @param enabled True to use the ledger, false to update Club.budget directly.
+     */
+    void set_budget_ledger(bool enabled);
+
+    /**
+     * @brief Switches delete_club and delete_activity_for_club to the asynchronous chunked purge.
+     * @param cascade_purger The purger to hand deletions to, or nullptr to delete with ON DELETE CASCADE again.
+     */
+    void set_purger(std::shared_ptr<CascadePurger> cascade_purger);
+
+    /**
+     * @brief Serves substring searches from trigram indexes. Any of them may be nullptr to keep using LIKE.
+     * @param club_names Index over Club.club_name, kept current by this table's writes.
+     * @param student_names Index over Student.name, used by read_members_by_name_in_club.
+     * @param activity_titles Index over Activity.act_title, kept current by the activity writes.
+     */
+    void set_search_indexes(std::shared_ptr<TrigramIndex> club_names, std::shared_ptr<TrigramIndex> student_names,
+                            std::shared_ptr<TrigramIndex> activity_titles);
+
+    /**
+     * @brief Serves activity period searches from an interval index and drops a deleted club's activities from it.
+     * @param index A built interval index, or nullptr to query Activity directly again.
+     */
+    void set_period_index(std::shared_ptr<ActivityIntervalIndex> index);
+
+    /**
+     * @brief Keeps a membership graph current with this table's membership writes.
+     * @param graph A built graph, or nullptr to stop updating it.
+     */
+    void set_membership_graph(std::shared_ptr<MembershipGraph> graph);
+
+    /**
+     * @brief Feeds the membership writes into approximate sketches. Removals are not reflected until the next rebuild.
+     * @param membership_sketches The sketches to update, or nullptr to stop updating them.
+     */
+    void set_membership_sketches(std::shared_ptr<MembershipSketches> membership_sketches);
+
+    /**
+     * @brief Serves member and activity counts from the Club counter columns instead of COUNT(*).
+     * @param enabled True if the counter columns and triggers are installed.
+     */
+    void set_club_counters(bool enabled);
+
+    /**
+     * @brief Keeps Club_Activity_Rollup current with the activity writes and serves yearly figures from it.
+     * @param enabled True if the rollup table is installed.
+     */
+    void set_activity_rollup(bool enabled);
 
     /**
      * @brief Creates a new club record.
@@ -38,62 +166,63 @@ class ClubTable : public BasicTable {
     bool create_club(const std::string &club_name, double budget, int prof_id);
 
     /**
-     * @brief Reads a club record based on club ID.
+     * @brief Reads a club record based on club ID, sharing the query with concurrent identical reads.
      * @param club_id The ID of the club.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return A shared pointer to the materialized result, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_club_by_id(int club_id);
+    std::shared_ptr<const QueryResult> read_club_by_id(int club_id);
 
     /**
      * @brief Reads a club record based on club name.
      * @param club_name The name of the club.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return The matching clubs in club_id order, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_club_by_name(const std::string &club_name);
+    std::shared_ptr<const QueryResult> read_club_by_name(const std::string &club_name);
 
     /**
      * @brief Reads clubs using a specific location ID.
      * @param loc_id The ID of the location.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return The matching clubs in club_id order, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_club_by_location_id(int loc_id);
+    std::shared_ptr<const QueryResult> read_club_by_location_id(int loc_id);
 
     /**
      * @brief Reads clubs using a specific location name.
      * @param loc_name The name of the location.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return The matching clubs in club_id order, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_club_by_location_name(const std::string &loc_name);
+    std::shared_ptr<const QueryResult> read_club_by_location_name(const std::string &loc_name);
 
     /**
      * @brief Reads clubs advised by a specific professor.
      * @param prof_id The ID of the professor.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return The matching clubs in club_id order, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_club_by_prof_id(int prof_id);
+    std::shared_ptr<const QueryResult> read_club_by_prof_id(int prof_id);
 
     /**
      * @brief Reads info of a club with joining given tables.
      * @param club_id The ID of the club to see.
      * @param join_table The names of tables to join for presentation.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_info(int club_id, std::set<std::string> join_table);
+    std::unique_ptr<DbResult> read_info(int club_id, std::set<std::string> join_table);
 
     /**
      * @brief Reads list of students belong to such club. In short, reading member of the club.
+     * Concurrent identical reads share one query.
      * @param club_id The ID of the club that students belong to.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return A shared pointer to the materialized result, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_members_by_club_id(int club_id);
+    std::shared_ptr<const QueryResult> read_members_by_club_id(int club_id);
 
     /**
      * @brief Reads students in the specified club which have names matching the given pattern.
      * @param club_id The ID of the club to search for students.
      * @param name_pattern The name pattern to match; can include '%' as a wildcard for LIKE queries.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_members_by_name_in_club(int club_id, const std::string &student_name);
+    std::unique_ptr<DbResult> read_members_by_name_in_club(int club_id, const std::string &student_name);
 
     /**
      * @brief Updates the name of a club.
@@ -104,13 +233,31 @@ class ClubTable : public BasicTable {
     bool update_club_name(int club_id, const std::string &new_name);
 
     /**
-     * @brief Updates the budget of a club.
+     * @brief Updates the budget of a club. With the ledger enabled, pending ledger deltas of the club are discarded.
      * @param club_id The ID of the club to update.
      * @param new_budget The new budget for the club.
      * @return True if the club's budget was updated successfully, false otherwise.
      */
     bool update_club_budget(int club_id, double new_budget);
 
+    /**
+     * @brief Adds a (possibly negative) amount to the budget of a club atomically.
+     * The change is rejected if it would make the budget negative. With the ledger enabled, a
+     * credit is appended to Budget_Ledger without locking the Club row, and a debit is checked
+     * against Club.budget only, so credits still pending in the ledger cannot be spent yet.
+     * @param club_id The ID of the club to update.
+     * @param delta The amount to add; negative to spend.
+     * @return True if the budget was adjusted, false if the club does not exist, funds are insufficient or an error occurred.
+     */
+    bool adjust_budget(int club_id, double delta);
+
+    /**
+     * @brief Reads the budget of a club including deltas not yet compacted from Budget_Ledger.
+     * @param club_id The ID of the club.
+     * @return A unique pointer to a DbResult with columns club_id and budget, or nullptr if an error occurred.
+     */
+    std::unique_ptr<DbResult> read_effective_budget(int club_id);
+
     /**
      * @brief Updates the professor advising a club.
      * @param club_id The ID of the club to update.
@@ -135,8 +282,38 @@ class ClubTable : public BasicTable {
      */
     bool delete_member(int club_id, int student_id);
 
+    /**
+     * @brief Adds every student of a department to a club with one INSERT ... SELECT.
+     * Students who are already members are skipped.
+     * @param club_id The ID of the club.
+     * @param department The department whose students are added.
+     * @return The number of members added, or -1 if an error occurred.
+     */
+    int add_members_by_department(int club_id, const std::string &department);
+
+    /**
+     * @brief Removes every student of a department from a club with one DELETE ... JOIN.
+     * @param club_id The ID of the club.
+     * @param department The department whose students are removed.
+     * @return The number of members removed, or -1 if an error occurred.
+     */
+    int delete_members_by_department(int club_id, const std::string &department);
+
+    /**
+     * @brief Makes the members of a club exactly the given students.
+     * The roster is loaded into a temporary table, and the difference is applied with one
+     * DELETE ... LEFT JOIN and one INSERT ... SELECT in a single transaction. IDs of
+     * students that do not exist are ignored.
+     * @param club_id The ID of the club.
+     * @param student_ids The desired member IDs.
+     * @return True if the roster was synchronized, false otherwise, also on a database other than MySQL.
+     */
+    bool sync_members(int club_id, std::span<const int> student_ids);
+
     /**
      * @brief Deletes a club record.
+     * With a purger set, the club is marked pending_delete (hiding it from reads) and
+     * it is removed together with its dependent rows in the background.
      * @param club_id The ID of the club to delete.
      * @return True if the club was deleted successfully, false otherwise.
      */
@@ -144,9 +321,33 @@ class ClubTable : public BasicTable {
 
     /**
      * @brief Reads all clubs in the table.
-     * @return A unique pointer to a ResultSet containing all clubs, or nullptr if an error occurred.
+     * @return All clubs in club_id order, or nullptr if an error occurred.
+     */
+    std::shared_ptr<const QueryResult> read_all_club();
+
+    /**
+     * @brief Reads the member and activity counts of a club.
+     * With counters this reads one Club row; otherwise it counts Club_Student and Activity.
+     * @param club_id The ID of the club.
+     * @return A unique pointer to a DbResult (club_id, member_count, activity_count), or nullptr if an error occurred.
+     */
+    std::unique_ptr<DbResult> read_club_counts(int club_id);
+
+    /**
+     * @brief Reads the k clubs with the most members, largest first.
+     * With counters this walks the (member_count, club_id) index backwards and stops after k rows.
+     * @param k The number of clubs, at least 1.
+     * @return The clubs (club_id, club_name, member_count, activity_count), or nullptr if k is less than 1 or an error occurred.
+     */
+    std::shared_ptr<const QueryResult> read_largest_clubs(int k);
+
+    /**
+     * @brief Reads a club's activities, gatherings and attendances per year, newest first.
+     * With the rollup this reads the club's rollup rows; otherwise it aggregates the base tables.
+     * @param club_id The ID of the club.
+     * @return A unique pointer to a DbResult (year, activity_count, gathering_count, attendee_count), or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_all_club();
+    std::unique_ptr<DbResult> read_yearly_activity(int club_id);
 
     /**
      * @brief Validates that a given activity belongs to a specific club.
@@ -172,17 +373,17 @@ class ClubTable : public BasicTable {
     /**
      * @brief Retrieves activities associated with a particular club.
      * @param club_id The ID of the club whose activities are to be retrieved.
-     * @return std::unique_ptr<sql::ResultSet> Result set containing the activities.
+     * @return std::unique_ptr<DbResult> Result set containing the activities.
      */
-    std::unique_ptr<sql::ResultSet> read_activities_by_club(int club_id);
+    std::unique_ptr<DbResult> read_activities_by_club(int club_id);
 
     /**
      * @brief Reads a specific activity by its ID, verifying club membership.
      * @param club_id The ID of the club to which the activity must belong.
      * @param act_id The ID of the activity to be read.
-     * @return std::unique_ptr<sql::ResultSet> Result set if valid, nullptr if not.
+     * @return std::shared_ptr<const QueryResult> Result if valid, nullptr if not.
      */
-    std::unique_ptr<sql::ResultSet> read_activity_by_id(int club_id, int act_id);
+    std::shared_ptr<const QueryResult> read_activity_by_id(int club_id, int act_id);
 
     /**
      * @brief Updates the details of an activity for a club, checking club membership.
@@ -206,9 +407,9 @@ class ClubTable : public BasicTable {
      *
      * @param club_id The ID of the club.
      * @param act_title The title of the activity to search for.
-     * @return std::unique_ptr<sql::ResultSet> The result set containing matching activities.
+     * @return std::shared_ptr<const QueryResult> The matching activities.
      */
-    std::unique_ptr<sql::ResultSet> read_activity_by_title(int club_id, const std::string& act_title);
+    std::shared_ptr<const QueryResult> read_activity_by_title(int club_id, const std::string& act_title);
 
     /**
      * @brief Reads activities within a specified period for a specific club.
@@ -216,7 +417,7 @@ class ClubTable : public BasicTable {
      * @param club_id The ID of the club.
      * @param from_date The start date of the period.
      * @param to_date The end date of the period.
-     * @return std::unique_ptr<sql::ResultSet> The result set containing activities within the specified period.
+     * @return std::shared_ptr<const QueryResult> The activities within the specified period.
      */
-    std::unique_ptr<sql::ResultSet> read_activity_by_period(int club_id, const std::string& from_date, const std::string& to_date);
+    std::shared_ptr<const QueryResult> read_activity_by_period(int club_id, const std::string& from_date, const std::string& to_date);
 };
\ No newline at end of file
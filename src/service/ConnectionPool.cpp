@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+
+#include "../utils.h"
+#include "ConnectionPool.h"
+
+ConnectionPool::ConnectionPool(Factory factory, size_t size)
+    : factory(std::move(factory)), capacity(std::max<size_t>(size, 1)) {}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    std::shared_ptr<sql::Connection> conn;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        returned.wait(lock, [this] { return !idle.empty() || opened < capacity; });
+        if (!idle.empty()) {
+            conn = std::move(idle.back());
+            idle.pop_back();
+        } else {
+            opened++;
+        }
+    }
+
+    try {
+        if (conn && (conn->isClosed() || !conn->isValid())) {
+            Logger(ll_warning, "Replacing a broken pooled connection").log();
+            conn.reset();
+        }
+    } catch (const sql::SQLException &e) {
+        Logger(ll_warning, "Replacing a broken pooled connection: " + std::string(e.what())).log();
+        conn.reset();
+    }
+
+    // Opened outside the lock so that other threads keep leasing meanwhile.
+    if (!conn) {
+        try {
+            conn = factory();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            opened--;
+            returned.notify_one();
+            throw;
+        }
+    }
+    return Lease(*this, std::move(conn));
+}
+
+void ConnectionPool::release(std::shared_ptr<sql::Connection> conn) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(std::move(conn));
+    }
+    returned.notify_one();
+}
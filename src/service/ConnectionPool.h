@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cppconn/connection.h>
+
+/**
+ * @brief A fixed-size pool of database connections shared by worker threads.
+ *
+ * Connections are opened lazily by the factory, up to the pool size. A thread takes one with
+ * acquire() and gives it back when the returned Lease goes out of scope; when every connection
+ * is leased, acquire() waits for one to be returned.
+ */
+class ConnectionPool {
+public:
+    using Factory = std::function<std::shared_ptr<sql::Connection>()>;
+
+    /**
+     * @brief Exclusive use of one pooled connection until destruction.
+     */
+    class Lease {
+    public:
+        Lease(ConnectionPool &pool, std::shared_ptr<sql::Connection> conn) : pool(&pool), con(std::move(conn)) {}
+        Lease(Lease &&other) noexcept : pool(other.pool), con(std::move(other.con)) { other.pool = nullptr; }
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        Lease &operator=(Lease &&) = delete;
+
+        /**
+         * @brief Returns the connection to the pool.
+         */
+        ~Lease() {
+            if (pool && con)
+                pool->release(std::move(con));
+        }
+
+        /**
+         * @brief The leased connection, e.g. to construct a table service on.
+         */
+        const std::shared_ptr<sql::Connection> &get() const { return con; }
+
+        sql::Connection *operator->() const { return con.get(); }
+
+    private:
+        ConnectionPool *pool;
+        std::shared_ptr<sql::Connection> con;
+    };
+
+    /**
+     * @brief Constructs an empty pool; no connection is opened until the first acquire().
+     * @param factory Opens a new connection, e.g. connect_server; reports failure by throwing sql::SQLException.
+     * @param size Maximum number of connections (at least 1).
+     */
+    ConnectionPool(Factory factory, size_t size);
+
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+    /**
+     * @brief Leases a connection, opening one if the pool is not full, otherwise waiting for a release.
+     * A connection that no longer answers is replaced by a new one.
+     * @throws sql::SQLException if a new connection cannot be opened.
+     */
+    Lease acquire();
+
+    /**
+     * @brief Returns the maximum number of connections.
+     */
+    size_t size() const { return capacity; }
+
+private:
+    void release(std::shared_ptr<sql::Connection> conn);
+
+    Factory factory;
+    size_t capacity;
+
+    std::mutex mutex;
+    std::condition_variable returned;
+    std::vector<std::shared_ptr<sql::Connection>> idle;
+    size_t opened = 0;
+};
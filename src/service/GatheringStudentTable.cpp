@@ -1,16 +1,14 @@
+#include "../workload/ServiceCall.h"
 #include "GatheringStudentTable.h"
 
-GatheringStudentTable::GatheringStudentTable(std::shared_ptr<sql::Connection> conn)
+GatheringStudentTable::GatheringStudentTable(std::shared_ptr<DbConnection> conn)
     : BasicTable("Gathering_Student", conn) {}
 
 bool GatheringStudentTable::create_gathering_student(int student_id, int gathering_id) {
+    ServiceCall call("GatheringStudentTable::create_gathering_student", student_id, gathering_id);
     try {
         std::string query = "INSERT INTO Gathering_Student (student_id, gathering_id) VALUES (?, ?)";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, student_id);
-        pstmt->setInt(2, gathering_id);
-        pstmt->executeUpdate();
-        Logger(ll_info, "executeQuery: " + query).log();
+        execute_update(query, {student_id, gathering_id});
     } catch (const sql::SQLException &e) {
         Logger(ll_error, "Error in create_gathering_student: " + std::string(e.what())).log();
         return false;
@@ -18,12 +16,11 @@ bool GatheringStudentTable::create_gathering_student(int student_id, int gatheri
     return true;
 }
 
-std::unique_ptr<sql::ResultSet> GatheringStudentTable::read_all_gathering_students() {
+std::unique_ptr<DbResult> GatheringStudentTable::read_all_gathering_students() {
+    ServiceCall call("GatheringStudentTable::read_all_gathering_students");
     try {
         std::string query = "SELECT * FROM Gathering_Student";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
+        std::unique_ptr<DbResult> res = execute_query(query);
         return res;
     } catch (const sql::SQLException &e) {
         Logger(ll_error, "Error in read_all_gathering_students: " + std::string(e.what())).log();
@@ -32,13 +29,10 @@ std::unique_ptr<sql::ResultSet> GatheringStudentTable::read_all_gathering_studen
 }
 
 bool GatheringStudentTable::delete_gathering_student(int student_id, int gathering_id) {
+    ServiceCall call("GatheringStudentTable::delete_gathering_student", student_id, gathering_id);
     try {
         std::string query = "DELETE FROM Gathering_Student WHERE student_id = ? AND gathering_id = ?";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, student_id);
-        pstmt->setInt(2, gathering_id);
-        pstmt->executeUpdate();
-        Logger(ll_info, "executeQuery: " + query).log();
+        execute_update(query, {student_id, gathering_id});
     } catch (const sql::SQLException &e) {
         Logger(ll_error, "Error in delete_gathering_student: " + std::string(e.what())).log();
         return false;
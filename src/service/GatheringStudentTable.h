@@ -21,7 +21,7 @@ public:
      * @brief Constructs a new Gathering Student Table object.
      * @param conn A shared pointer to an active SQL database connection.
      */
-    GatheringStudentTable(std::shared_ptr<sql::Connection> conn);
+    GatheringStudentTable(std::shared_ptr<DbConnection> conn);
 
     /**
      * @brief Creates a new record associating a student with a gathering.
@@ -33,9 +33,9 @@ public:
 
     /**
      * @brief Reads all records from the Gathering_Student table.
-     * @return std::unique_ptr<sql::ResultSet> Result set containing all records.
+     * @return std::unique_ptr<DbResult> Result set containing all records.
      */
-    std::unique_ptr<sql::ResultSet> read_all_gathering_students();
+    std::unique_ptr<DbResult> read_all_gathering_students();
 
     /**
      * @brief Deletes a record associating a student with a gathering.
@@ -1,15 +1,156 @@
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <cppconn/statement.h>
+
+#include "../workload/ServiceCall.h"
 #include "GatheringTable.h"
+#include "ShardMap.h"
+#include "Transaction.h"
+
+/**
+ * @brief One attended gathering with its activity period as day numbers (TO_DAYS).
+ */
+struct AttendedPeriod {
+    int student_id;
+    int gathering_id;
+    int start;
+    int end;
+};
+
+/**
+ * @brief Reports every overlapping pair among one student's periods, which must be sorted by start.
+ * Runs in O(n + k): a period leaves the active list once a later one starts after its end.
+ */
+static void sweep_conflicts(const AttendedPeriod *begin, const AttendedPeriod *end, std::vector<ScheduleConflict> &out) {
+    std::vector<const AttendedPeriod *> active;
+    for (const AttendedPeriod *period = begin; period != end; ++period) {
+        std::erase_if(active, [period](const AttendedPeriod *other) { return other->end < period->start; });
+        for (const AttendedPeriod *other : active)
+            out.push_back(ScheduleConflict{period->student_id, other->gathering_id, period->gathering_id});
+        active.push_back(period);
+    }
+}
+
+/**
+ * @brief Reads attended periods; a NULL end_date never ends.
+ */
+static std::vector<AttendedPeriod> read_periods(sql::ResultSet &res) {
+    std::vector<AttendedPeriod> periods;
+    periods.reserve(res.rowsCount());
+    while (res.next()) {
+        int end = res.isNull(4) ? std::numeric_limits<int>::max() : res.getInt(4);
+        periods.push_back(AttendedPeriod{res.getInt(1), res.getInt(2), res.getInt(3), end});
+    }
+    return periods;
+}
+
+/**
+ * @brief Reads attended periods from a materialized result, e.g. one merged across shards.
+ */
+static std::vector<AttendedPeriod> read_periods(const QueryResult &res) {
+    std::vector<AttendedPeriod> periods;
+    periods.reserve(res.rows_count());
+    for (size_t row = 0; row < res.rows_count(); ++row) {
+        int end = res.is_null(row, 3) ? std::numeric_limits<int>::max() : res.get_int(row, 3);
+        periods.push_back(AttendedPeriod{res.get_int(row, 0), res.get_int(row, 1), res.get_int(row, 2), end});
+    }
+    return periods;
+}
+
+GatheringTable::GatheringTable(std::shared_ptr<DbConnection> conn) : BasicTable("Gathering", conn), gathering_student_table(conn) {}
+
+GatheringTable::~GatheringTable() {
+    if (write_queue)
+        write_queue->set_listener(MembershipKind::gathering_student, nullptr);
+}
 
-GatheringTable::GatheringTable(std::shared_ptr<sql::Connection> conn) : BasicTable("Gathering", conn), gathering_student_table(conn) {}
+void GatheringTable::set_write_queue(std::shared_ptr<WriteBehindQueue> queue) {
+    if (write_queue)
+        write_queue->set_listener(MembershipKind::gathering_student, nullptr);
+    write_queue = queue;
+    if (write_queue)
+        write_queue->set_listener(MembershipKind::gathering_student,
+                                  [this](int gathering_id, int student_id, bool insert, std::shared_ptr<sql::Connection> conn) {
+                                      record_attendance_change(gathering_id, student_id, insert, conn);
+                                  });
+}
+
+void GatheringTable::set_name_index(std::shared_ptr<TrigramIndex> index) {
+    name_index = index;
+}
+
+void GatheringTable::set_conflict_check(bool enabled) {
+    conflict_check = enabled;
+}
+
+void GatheringTable::set_membership_graph(std::shared_ptr<MembershipGraph> graph) {
+    membership_graph = graph;
+}
+
+void GatheringTable::set_membership_sketches(std::shared_ptr<MembershipSketches> membership_sketches) {
+    sketches = membership_sketches;
+}
+
+void GatheringTable::set_activity_rollup(bool enabled) {
+    activity_rollup = enabled;
+}
+
+bool GatheringTable::write_attendance_with_rollup(int student_id, int gathering_id, bool insert) {
+    try {
+        Transaction transaction(connection());
+
+        // IGNORE so that a duplicate reports 0 rows instead of failing the transaction.
+        std::string query = insert ? "INSERT IGNORE INTO Gathering_Student (student_id, gathering_id) VALUES (?, ?)"
+                                   : "DELETE FROM Gathering_Student WHERE student_id = ? AND gathering_id = ?";
+        int changed = execute_update(query, {student_id, gathering_id});
+
+        ActivityRollup::apply_for_gathering(connection(), gathering_id, 0, insert ? changed : -changed);
+        transaction.commit();
+        return insert ? changed == 1 : true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "Error in write_attendance_with_rollup: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+void GatheringTable::refresh_rollup(int gathering_id) {
+    try {
+        ActivityRollup::refresh_for_gathering(connection(), gathering_id);
+    } catch (const sql::SQLException &e) {
+        // The next rebuild repairs the row.
+        Logger(ll_error, "Error in refresh_rollup: " + std::string(e.what())).log();
+    }
+}
 
 bool GatheringTable::create_gathering(int act_id, const std::string &gathering_name) {
+    ServiceCall call("GatheringTable::create_gathering", act_id, gathering_name);
+    ShardScope shard = ShardScope::row("Activity", "act_id", act_id);
     try {
+        std::optional<Transaction> transaction;
+        if (activity_rollup)
+            transaction.emplace(connection());
+
         std::string query = "INSERT INTO Gathering (act_id, gathering_name) VALUES (?, ?)";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, act_id);
-        pstmt->setString(2, gathering_name);
-        pstmt->executeUpdate();
-        Logger(ll_info, "executeQuery: " + query).log();
+        execute_update(query, {act_id, gathering_name});
+
+        if (transaction) {
+            int gathering_id = last_insert_id();
+            if (gathering_id > 0)
+                ActivityRollup::apply_for_gathering(connection(), gathering_id, 1, 0);
+            transaction->commit();
+        }
+
+        if (name_index || membership_graph) {
+            int gathering_id = last_insert_id();
+            if (gathering_id > 0 && name_index)
+                name_index->upsert(gathering_id, gathering_name);
+            // Registers the owning club, which members_without_gathering needs.
+            if (gathering_id > 0 && membership_graph)
+                membership_graph->reload_gathering(connection(), gathering_id);
+        }
     } catch (const sql::SQLException &e) {
         Logger(ll_error, "Error in create_gathering: " + std::string(e.what())).log();
         return false;
@@ -17,13 +158,12 @@ bool GatheringTable::create_gathering(int act_id, const std::string &gathering_n
     return true;
 }
 
-std::unique_ptr<sql::ResultSet> GatheringTable::read_gathering_by_act_id(int act_id) {
+std::unique_ptr<DbResult> GatheringTable::read_gathering_by_act_id(int act_id) {
+    ServiceCall call("GatheringTable::read_gathering_by_act_id", act_id);
+    ShardScope shard = ShardScope::row("Activity", "act_id", act_id);
     try {
         std::string query = "SELECT * FROM Gathering WHERE act_id = ?";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, act_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
+        std::unique_ptr<DbResult> res = execute_query(query, {act_id});
         return res;
     } catch (const sql::SQLException &e) {
         Logger(ll_error, "Error in read_gathering_by_act_id: " + std::string(e.what())).log();
@@ -31,14 +171,19 @@ std::unique_ptr<sql::ResultSet> GatheringTable::read_gathering_by_act_id(int act
     }
 }
 
-std::unique_ptr<sql::ResultSet> GatheringTable::read_gathering_by_name(const std::string &gathering_name) {
+std::shared_ptr<const QueryResult> GatheringTable::read_gathering_by_name(const std::string &gathering_name) {
+    ServiceCall call("GatheringTable::read_gathering_by_name", gathering_name);
+    if (name_index && name_index->ready() && TrigramIndex::covers(gathering_name)) {
+        std::vector<int> ids = name_index->search(gathering_name);
+        if (ids.size() <= TrigramIndex::max_selective_matches) {
+            std::unique_ptr<DbResult> res = select_by_ids("gathering_id", ids);
+            return res ? QueryResult::from_db_result(*res) : nullptr;
+        }
+    }
+
     try {
         std::string query = "SELECT * FROM Gathering WHERE gathering_name LIKE ?";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setString(1, '%' + gathering_name + '%');
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-        return res;
+        return scatter_query(query, {'%' + gathering_name + '%'}, {{"gathering_id"}});
     } catch (const sql::SQLException &e) {
         Logger(ll_error, "Error in read_gathering_by_name: " + std::string(e.what())).log();
         return nullptr;
@@ -46,13 +191,14 @@ std::unique_ptr<sql::ResultSet> GatheringTable::read_gathering_by_name(const std
 }
 
 bool GatheringTable::update_gathering_name(int gathering_id, const std::string &new_name) {
+    ServiceCall call("GatheringTable::update_gathering_name", gathering_id, new_name);
+    ShardScope shard = ShardScope::row("Gathering", "gathering_id", gathering_id);
     try {
         std::string query = "UPDATE Gathering SET gathering_name = ? WHERE gathering_id = ?";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setString(1, new_name);
-        pstmt->setInt(2, gathering_id);
-        pstmt->executeUpdate();
-        Logger(ll_info, "executeQuery: " + query).log();
+        execute_update(query, {new_name, gathering_id});
+
+        if (name_index)
+            name_index->upsert(gathering_id, new_name);
     } catch (const sql::SQLException &e) {
         Logger(ll_error, "Error in update_gathering_name: " + std::string(e.what())).log();
         return false;
@@ -61,12 +207,29 @@ bool GatheringTable::update_gathering_name(int gathering_id, const std::string &
 }
 
 bool GatheringTable::delete_gathering(int gathering_id) {
+    ServiceCall call("GatheringTable::delete_gathering", gathering_id);
+    ShardScope shard = ShardScope::row("Gathering", "gathering_id", gathering_id);
     try {
+        std::optional<Transaction> transaction;
+        if (activity_rollup) {
+            transaction.emplace(connection());
+            // Its attendances go by ON DELETE CASCADE, so subtract them while the gathering still resolves to its activity.
+            std::string count_query = "SELECT COUNT(*) FROM Gathering_Student WHERE gathering_id = ?";
+            std::unique_ptr<DbResult> count = execute_query(count_query, {gathering_id});
+            int attendees = count->next() ? count->get_int(0) : 0;
+            ActivityRollup::apply_for_gathering(connection(), gathering_id, -1, -attendees);
+        }
+
         std::string query = "DELETE FROM Gathering WHERE gathering_id = ?";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, gathering_id);
-        pstmt->executeUpdate();
-        Logger(ll_info, "executeQuery: " + query).log();
+        execute_update(query, {gathering_id});
+
+        if (transaction)
+            transaction->commit();
+
+        if (name_index)
+            name_index->erase(gathering_id);
+        if (membership_graph)
+            membership_graph->reload_gathering(connection(), gathering_id);
     } catch (const sql::SQLException &e) {
         Logger(ll_error, "Error in delete_gathering: " + std::string(e.what())).log();
         return false;
@@ -75,23 +238,266 @@ bool GatheringTable::delete_gathering(int gathering_id) {
 }
 
 bool GatheringTable::add_student_to_gathering(int student_id, int gathering_id) {
-    return gathering_student_table.create_gathering_student(student_id, gathering_id);
+    ServiceCall call("GatheringTable::add_student_to_gathering", student_id, gathering_id);
+    ShardScope shard = ShardScope::row("Gathering", "gathering_id", gathering_id);
+    if (conflict_check) {
+        int overlap = overlaps_schedule(student_id, gathering_id);
+        if (overlap != 0) {
+            if (overlap == 1)
+                Logger(ll_warning, "Schedule conflict: student " + std::to_string(student_id) +
+                                       " already attends a gathering overlapping gathering " + std::to_string(gathering_id))
+                    .log();
+            return false;
+        }
+    }
+
+    bool added;
+    if (write_queue) {
+        added = write_queue->add(MembershipKind::gathering_student, gathering_id, student_id);
+        if (added && activity_rollup) {
+            // The rollup is recomputed from Gathering_Student; in async mode the row may still be queued.
+            write_queue->flush();
+            refresh_rollup(gathering_id);
+        }
+    } else if (activity_rollup) {
+        added = write_attendance_with_rollup(student_id, gathering_id, true);
+    } else {
+        added = gathering_student_table.create_gathering_student(student_id, gathering_id);
+    }
+    // Queued writes reach the graph and sketches through the queue's listener, once written.
+    if (added && !write_queue)
+        record_attendance_change(gathering_id, student_id, true, connection());
+    return added;
 }
 
-std::unique_ptr<sql::ResultSet> GatheringTable::read_all_students_from_gathering(int gathering_id) {
+int GatheringTable::add_all_club_members(int gathering_id) {
+    ServiceCall call("GatheringTable::add_all_club_members", gathering_id);
+    ShardScope shard = ShardScope::row("Gathering", "gathering_id", gathering_id);
     try {
-        std::string query = "SELECT * FROM Student AS s WHERE s.student_id IN (SELECT gs.student_id FROM Gathering_Student AS gs WHERE gs.gathering_id = ?)";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, gathering_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-        return res;
+        if (write_queue)
+            write_queue->flush();
+
+        std::string query = "INSERT IGNORE INTO Gathering_Student (gathering_id, student_id) "
+                            "SELECT g.gathering_id, cs.student_id FROM Gathering AS g "
+                            "JOIN Activity AS a ON a.act_id = g.act_id "
+                            "JOIN Club_Student AS cs ON cs.club_id = a.club_id "
+                            "WHERE g.gathering_id = ?";
+        std::optional<Transaction> transaction;
+        if (activity_rollup)
+            transaction.emplace(connection());
+
+        int added = execute_update(query, {gathering_id});
+
+        if (transaction) {
+            ActivityRollup::apply_for_gathering(connection(), gathering_id, 0, added);
+            transaction->commit();
+        }
+        if (added > 0 && membership_graph)
+            membership_graph->reload_gathering(connection(), gathering_id);
+        if (added > 0 && sketches)
+            sketches->record_gathering_roster(connection(), gathering_id);
+        return added;
     } catch (const sql::SQLException &e) {
-        Logger(ll_error, "Error in delete_gathering: " + std::string(e.what())).log();
-        return nullptr;
+        Logger(ll_error, "Error in add_all_club_members: " + std::string(e.what())).log();
+        return -1;
     }
 }
 
+int GatheringTable::delete_non_members(int gathering_id) {
+    ServiceCall call("GatheringTable::delete_non_members", gathering_id);
+    ShardScope shard = ShardScope::row("Gathering", "gathering_id", gathering_id);
+    try {
+        if (write_queue)
+            write_queue->flush();
+
+        std::string query = "DELETE gs FROM Gathering_Student AS gs "
+                            "JOIN Gathering AS g ON g.gathering_id = gs.gathering_id "
+                            "JOIN Activity AS a ON a.act_id = g.act_id "
+                            "LEFT JOIN Club_Student AS cs ON cs.club_id = a.club_id AND cs.student_id = gs.student_id "
+                            "WHERE gs.gathering_id = ? AND cs.student_id IS NULL";
+        std::optional<Transaction> transaction;
+        if (activity_rollup)
+            transaction.emplace(connection());
+
+        int removed = execute_update(query, {gathering_id});
+
+        if (transaction) {
+            ActivityRollup::apply_for_gathering(connection(), gathering_id, 0, -removed);
+            transaction->commit();
+        }
+        if (removed > 0 && membership_graph)
+            membership_graph->reload_gathering(connection(), gathering_id);
+        return removed;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "Error in delete_non_members: " + std::string(e.what())).log();
+        return -1;
+    }
+}
+
+std::shared_ptr<const QueryResult> GatheringTable::read_all_students_from_gathering(int gathering_id) {
+    ServiceCall call("GatheringTable::read_all_students_from_gathering", gathering_id);
+    ShardScope shard = ShardScope::row("Gathering", "gathering_id", gathering_id);
+    return coalesced_query("SELECT * FROM Student AS s WHERE s.student_id IN (SELECT gs.student_id FROM Gathering_Student AS gs WHERE gs.gathering_id = ?)", {gathering_id});
+}
+
 bool GatheringTable::delete_student_from_gathering(int student_id, int gathering_id) {
-    return gathering_student_table.delete_gathering_student(student_id, gathering_id);
-}
\ No newline at end of file
+    ServiceCall call("GatheringTable::delete_student_from_gathering", student_id, gathering_id);
+    ShardScope shard = ShardScope::row("Gathering", "gathering_id", gathering_id);
+    bool deleted;
+    if (write_queue) {
+        deleted = write_queue->remove(MembershipKind::gathering_student, gathering_id, student_id);
+        if (deleted && activity_rollup) {
+            write_queue->flush();
+            refresh_rollup(gathering_id);
+        }
+    } else if (activity_rollup) {
+        deleted = write_attendance_with_rollup(student_id, gathering_id, false);
+    } else {
+        deleted = gathering_student_table.delete_gathering_student(student_id, gathering_id);
+    }
+    if (deleted && !write_queue)
+        record_attendance_change(gathering_id, student_id, false, connection());
+    return deleted;
+}
+
+void GatheringTable::record_attendance_change(int gathering_id, int student_id, bool insert, std::shared_ptr<sql::Connection> conn) {
+    if (insert) {
+        if (membership_graph)
+            membership_graph->add_attendee(gathering_id, student_id);
+        if (sketches)
+            sketches->record_attendee(conn, gathering_id, student_id);
+    } else if (membership_graph) {
+        membership_graph->remove_attendee(gathering_id, student_id);
+    }
+}
+
+int GatheringTable::overlaps_schedule(int student_id, int gathering_id) {
+    try {
+        // Queued additions have to be visible to the check.
+        if (write_queue)
+            write_queue->flush();
+
+        std::string period_query = "SELECT a.start_date, COALESCE(a.end_date, '9999-12-31') FROM Gathering AS g "
+                                   "JOIN Activity AS a ON a.act_id = g.act_id WHERE g.gathering_id = ?";
+        std::unique_ptr<DbResult> period = execute_query(period_query, {gathering_id});
+        if (!period->next())
+            return 0;
+
+        std::string query = "SELECT 1 FROM Gathering_Student AS gs "
+                            "JOIN Gathering AS og ON og.gathering_id = gs.gathering_id "
+                            "JOIN Activity AS oa ON oa.act_id = og.act_id "
+                            "WHERE gs.student_id = ? AND og.gathering_id <> ? AND oa.pending_delete = 0 "
+                            "AND oa.start_date <= ? AND COALESCE(oa.end_date, '9999-12-31') >= ? "
+                            "LIMIT 1";
+        std::vector<SqlParam> params = {student_id, gathering_id, period->get_string(1), period->get_string(0)};
+        // The student may attend gatherings of clubs on several shards, not only the one this call is scoped to.
+        if (std::shared_ptr<ShardMap> shards = shard_map())
+            return shards->scatter_query(query, params, {}, 1)->rows_count() > 0 ? 1 : 0;
+        return execute_query(query, params)->next() ? 1 : 0;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "Error in overlaps_schedule: " + std::string(e.what())).log();
+        return -1;
+    }
+}
+
+std::optional<std::vector<ScheduleConflict>> GatheringTable::find_conflicts(int student_id) {
+    ServiceCall call("GatheringTable::find_conflicts", student_id);
+    try {
+        if (write_queue)
+            write_queue->flush();
+
+        std::string query = "SELECT gs.student_id, gs.gathering_id, TO_DAYS(a.start_date), TO_DAYS(a.end_date) "
+                            "FROM Gathering_Student AS gs "
+                            "JOIN Gathering AS g ON g.gathering_id = gs.gathering_id "
+                            "JOIN Activity AS a ON a.act_id = g.act_id "
+                            "WHERE gs.student_id = ? AND a.pending_delete = 0";
+        // The student may attend gatherings of clubs on several shards.
+        std::vector<AttendedPeriod> periods = read_periods(*scatter_query(query, {student_id}));
+        std::sort(periods.begin(), periods.end(), [](const AttendedPeriod &a, const AttendedPeriod &b) {
+            return a.start < b.start;
+        });
+
+        std::vector<ScheduleConflict> conflicts;
+        sweep_conflicts(periods.data(), periods.data() + periods.size(), conflicts);
+        return conflicts;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "Error in find_conflicts: " + std::string(e.what())).log();
+        return std::nullopt;
+    }
+}
+
+std::optional<std::vector<ScheduleConflict>> GatheringTable::find_all_conflicts(unsigned threads) {
+    ServiceCall call("GatheringTable::find_all_conflicts", threads);
+    std::vector<AttendedPeriod> periods;
+    try {
+        if (write_queue)
+            write_queue->flush();
+
+        std::string query = "SELECT gs.student_id, gs.gathering_id, TO_DAYS(a.start_date), TO_DAYS(a.end_date) "
+                            "FROM Gathering_Student AS gs "
+                            "JOIN Gathering AS g ON g.gathering_id = gs.gathering_id "
+                            "JOIN Activity AS a ON a.act_id = g.act_id "
+                            "WHERE a.pending_delete = 0";
+        auto read_all = [&query](sql::Connection &conn) {
+            std::unique_ptr<sql::Statement> stmt(conn.createStatement());
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query));
+            return read_periods(*res);
+        };
+        if (std::shared_ptr<ShardMap> shards = shard_map()) {
+            std::vector<std::vector<AttendedPeriod>> parts(shards->size());
+            shards->scatter([&](size_t shard, sql::Connection &conn) { parts[shard] = read_all(conn); });
+            for (const auto &part : parts)
+                periods.insert(periods.end(), part.begin(), part.end());
+        } else {
+            periods = read_all(*connection());
+        }
+        Logger(ll_info, "executeQuery: " + query).log();
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "Error in find_all_conflicts: " + std::string(e.what())).log();
+        return std::nullopt;
+    }
+
+    // Sorting here rather than with ORDER BY keeps the server from materializing a filesort.
+    std::sort(periods.begin(), periods.end(), [](const AttendedPeriod &a, const AttendedPeriod &b) {
+        return a.student_id != b.student_id ? a.student_id < b.student_id : a.start < b.start;
+    });
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::clamp<size_t>(periods.size() / 65536, 1, threads));
+
+    // Each thread sweeps a contiguous range, with boundaries moved forward to the next student.
+    std::vector<size_t> bounds(threads + 1, periods.size());
+    bounds[0] = 0;
+    for (unsigned t = 1; t < threads; ++t) {
+        size_t i = std::max(bounds[t - 1], periods.size() * t / threads);
+        while (i > 0 && i < periods.size() && periods[i].student_id == periods[i - 1].student_id)
+            ++i;
+        bounds[t] = i;
+    }
+
+    std::vector<std::vector<ScheduleConflict>> found(threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            size_t begin = bounds[t];
+            while (begin < bounds[t + 1]) {
+                size_t end = begin;
+                while (end < bounds[t + 1] && periods[end].student_id == periods[begin].student_id)
+                    ++end;
+                sweep_conflicts(periods.data() + begin, periods.data() + end, found[t]);
+                begin = end;
+            }
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+
+    std::vector<ScheduleConflict> conflicts;
+    for (auto &part : found)
+        conflicts.insert(conflicts.end(), part.begin(), part.end());
+    Logger(ll_info, "find_all_conflicts: " + std::to_string(periods.size()) + " memberships, " +
+                        std::to_string(conflicts.size()) + " conflicts")
+        .log();
+    return conflicts;
+}
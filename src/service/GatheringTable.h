@@ -3,14 +3,30 @@
 #include <memory>
 #include <string>
 #include <map>
+#include <optional>
+#include <vector>
 #include <cppconn/resultset.h>
 #include <cppconn/prepared_statement.h>
 #include <cppconn/exception.h>
 
 
+#include "../analytics/MembershipSketches.h"
+#include "../index/MembershipGraph.h"
+#include "../index/TrigramIndex.h"
 #include "../utils.h"
+#include "ActivityRollup.h"
 #include "BasicTable.h"
 #include "GatheringStudentTable.h"
+#include "WriteBehindQueue.h"
+
+/**
+ * @brief Two gatherings of one student whose activity periods overlap.
+ */
+struct ScheduleConflict {
+    int student_id;
+    int first_gathering_id;
+    int second_gathering_id;
+};
 
 /**
  * @class GatheringTable
@@ -22,12 +38,114 @@
 class GatheringTable : public BasicTable {
 protected:
     GatheringStudentTable gathering_student_table;
+
+    /**
+     * @brief Optional write-behind queue for attendance changes. Null means write immediately.
+     */
+    std::shared_ptr<WriteBehindQueue> write_queue;
+
+    /**
+     * @brief Optional substring index over Gathering.gathering_name. Null means name searches use LIKE.
+     */
+    std::shared_ptr<TrigramIndex> name_index;
+
+    /**
+     * @brief Whether add_student_to_gathering rejects gatherings that overlap the student's schedule.
+     */
+    bool conflict_check = false;
+
+    /**
+     * @brief Optional in-memory membership graph kept current by the attendance writes.
+     */
+    std::shared_ptr<MembershipGraph> membership_graph;
+
+    /**
+     * @brief Optional approximate participation sketches fed by the attendance writes.
+     */
+    std::shared_ptr<MembershipSketches> sketches;
+
+    /**
+     * @brief Whether writes apply their deltas to Club_Activity_Rollup in the same transaction.
+     */
+    bool activity_rollup = false;
+
+    /**
+     * @brief Inserts or deletes one attendance and applies its rollup delta in one transaction.
+     * @return For an insert, whether a row was added; for a delete, true unless an error occurred.
+     */
+    bool write_attendance_with_rollup(int student_id, int gathering_id, bool insert);
+
+    /**
+     * @brief Recomputes the rollup row of a gathering after a write-behind attendance change has been flushed.
+     */
+    void refresh_rollup(int gathering_id);
+
+    /**
+     * @brief Applies a written attendance change to the membership graph and sketches.
+     * @param conn The connection the sketches read the attendee's department and year with.
+     */
+    void record_attendance_change(int gathering_id, int student_id, bool insert, std::shared_ptr<sql::Connection> conn);
+
+    /**
+     * @brief Returns whether the gathering's activity overlaps an activity of another gathering the student attends.
+     * @param student_id The ID of the student.
+     * @param gathering_id The ID of the gathering to join.
+     * @return 1 on overlap, 0 if none, -1 if an error occurred.
+     */
+    int overlaps_schedule(int student_id, int gathering_id);
 public:
     /**
      * @brief Constructs a new Gathering Table object.
      * @param conn A shared pointer to an active SQL database connection.
      */
-    GatheringTable(std::shared_ptr<sql::Connection> conn);
+    GatheringTable(std::shared_ptr<DbConnection> conn);
+
+    /**
+     * @brief Stops listening to the write-behind queue.
+     */
+    ~GatheringTable();
+
+    GatheringTable(const GatheringTable &) = delete;
+    GatheringTable &operator=(const GatheringTable &) = delete;
+
+    /**
+     * @brief Routes add_student_to_gathering/delete_student_from_gathering through a write-behind queue.
+     * The membership graph and sketches then follow the rows the queue actually writes.
+     * @param queue The queue to use, or nullptr to write immediately again.
+     */
+    void set_write_queue(std::shared_ptr<WriteBehindQueue> queue);
+
+    /**
+     * @brief Serves name searches from a trigram index and keeps it current on writes.
+     * @param index An index over Gathering.gathering_name, or nullptr to search with LIKE again.
+     */
+    void set_name_index(std::shared_ptr<TrigramIndex> index);
+
+    /**
+     * @brief Makes add_student_to_gathering refuse gatherings whose activity period overlaps the student's other gatherings.
+     * @param enabled True to check before adding.
+     */
+    void set_conflict_check(bool enabled);
+
+    /**
+     * @brief Keeps a membership graph current with this table's attendance writes.
+     * @param graph A built graph, or nullptr to stop updating it.
+     */
+    void set_membership_graph(std::shared_ptr<MembershipGraph> graph);
+
+    /**
+     * @brief Feeds the attendance writes into approximate sketches.
+     * @param membership_sketches The sketches to update, or nullptr to stop updating them.
+     */
+    void set_membership_sketches(std::shared_ptr<MembershipSketches> membership_sketches);
+
+    /**
+     * @brief Keeps Club_Activity_Rollup current with this table's writes (db_scripts/activity_rollup.sql).
+     * Write-behind attendance changes recompute the affected row instead; with fire-and-forget
+     * durability that row can lag until the next rebuild.
+     * @param enabled True if the rollup table is installed.
+     */
+    void set_activity_rollup(bool enabled);
 
     /**
      * @brief Creates a new gathering record.
@@ -40,16 +158,16 @@ public:
     /**
      * @brief Retrieves gatherings by activity ID.
      * @param act_id The ID of the activity whose gatherings are to be retrieved.
-     * @return std::unique_ptr<sql::ResultSet> Pointer to the result set with the matching gatherings.
+     * @return std::unique_ptr<DbResult> Pointer to the result set with the matching gatherings.
      */
-    std::unique_ptr<sql::ResultSet> read_gathering_by_act_id(int act_id);
+    std::unique_ptr<DbResult> read_gathering_by_act_id(int act_id);
     
     /**
      * @brief Retrieves gatherings by gathering name.
      * @param gathering_name The name of the gathering to search for.
-     * @return std::unique_ptr<sql::ResultSet> Pointer to the result set with the matching gatherings.
+     * @return std::shared_ptr<const QueryResult> The matching gatherings in gathering_id order, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_gathering_by_name(const std::string &gathering_name);
+    std::shared_ptr<const QueryResult> read_gathering_by_name(const std::string &gathering_name);
     
     /**
      * @brief Updates the name of a specific gathering.     
@@ -68,18 +186,37 @@ public:
 
     /**
      * @brief Add a student to a gathering.     
+     * With the conflict check enabled, a gathering overlapping the student's schedule is refused.
      * @param student_id The ID of the student.
      * @param gathering_id The ID of the gathering.
      * @return True If the operation was successful, false otherwise.     
      */
     bool add_student_to_gathering(int student_id, int gathering_id);
 
+    /**
+     * @brief Adds every member of the club owning the gathering's activity to the gathering,
+     * with one INSERT ... SELECT. Students already in the gathering are skipped.
+     * @param gathering_id The ID of the gathering.
+     * @return The number of students added, or -1 if an error occurred.
+     */
+    int add_all_club_members(int gathering_id);
+
+    /**
+     * @brief Removes students who are no longer members of the owning club from a gathering,
+     * with one DELETE ... JOIN.
+     * @param gathering_id The ID of the gathering.
+     * @return The number of students removed, or -1 if an error occurred.
+     */
+    int delete_non_members(int gathering_id);
+
     /**
      * @brief Reads all students associated with any gathering.     
      * @param gathering_id The ID of the gathering.
-     * @return Result set containing all gathering-student associations.
+     * Concurrent identical reads share one query.
+     * @param gathering_id The ID of the gathering.
+     * @return Materialized gathering-student associations, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_all_students_from_gathering(int gathering_id);
+    std::shared_ptr<const QueryResult> read_all_students_from_gathering(int gathering_id);
 
     /**
      * @brief Disassociates a student from a gathering by deleting a record.     
@@ -88,4 +225,19 @@ public:
      * @return True If the operation was successful, false otherwise.
      */
     bool delete_student_from_gathering(int student_id, int gathering_id);
+
+    /**
+     * @brief Finds pairs of a student's gatherings whose activity periods overlap.
+     * @param student_id The ID of the student.
+     * @return The conflicts ordered by start of the earlier activity, or std::nullopt if an error occurred.
+     */
+    std::optional<std::vector<ScheduleConflict>> find_conflicts(int student_id);
+
+    /**
+     * @brief Finds the schedule conflicts of every student.
+     * All memberships are read in one query and swept in parallel, one student range per thread.
+     * @param threads Number of sweeping threads; 0 means one per core.
+     * @return The conflicts ordered by student, or std::nullopt if an error occurred.
+     */
+    std::optional<std::vector<ScheduleConflict>> find_all_conflicts(unsigned threads = 0);
 };
\ No newline at end of file
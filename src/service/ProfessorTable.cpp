@@ -6,12 +6,14 @@
 #include <string>
 
 #include "../utils.h"
+#include "../workload/ServiceCall.h"
 #include "ProfessorTable.h"
 
-ProfessorTable::ProfessorTable(std::shared_ptr<sql::Connection> conn)
+ProfessorTable::ProfessorTable(std::shared_ptr<DbConnection> conn)
     : BasicTable("Professor", conn) {}
 
 bool ProfessorTable::create_professor(const std::string &name) {
+    ServiceCall call("ProfessorTable::create_professor", name);
     try {
         std::map<std::string, std::string> attributes;
         attributes["name"] = name;
@@ -28,7 +30,8 @@ bool ProfessorTable::create_professor(const std::string &name) {
     }
 }
 
-std::unique_ptr<sql::ResultSet> ProfessorTable::read_professor_by_id(int prof_id) {
+std::unique_ptr<DbResult> ProfessorTable::read_professor_by_id(int prof_id) {
+    ServiceCall call("ProfessorTable::read_professor_by_id", prof_id);
     auto result = basic_select({{"prof_id", std::to_string(prof_id)}});
     if (!result) {
         Logger(ll_info, "Failed to find professor with ID: " + std::to_string(prof_id)).log();
@@ -36,16 +39,13 @@ std::unique_ptr<sql::ResultSet> ProfessorTable::read_professor_by_id(int prof_id
     return result;
 }
 
-std::unique_ptr<sql::ResultSet> ProfessorTable::read_professor_by_club_id(int club_id) {
+std::unique_ptr<DbResult> ProfessorTable::read_professor_by_club_id(int club_id) {
+    ServiceCall call("ProfessorTable::read_professor_by_club_id", club_id);
     try {
         std::string query = "SELECT * FROM professor WHERE prof_id IN (SELECT prof_id FROM club WHERE club_id = ?)";
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
-        pstmt->setInt(1, club_id);
+        std::unique_ptr<DbResult> result = execute_query(query, {club_id});
 
-        std::unique_ptr<sql::ResultSet> result(pstmt->executeQuery());
-        Logger(ll_info, "executeQuery: " + query).log();
-
-        if (!result || result->rowsCount() == 0) {
+        if (!result || result->rows_count() == 0) {
             Logger(ll_info, "No professors found for club with ID: " + std::to_string(club_id)).log();
         }
 
@@ -57,6 +57,7 @@ std::unique_ptr<sql::ResultSet> ProfessorTable::read_professor_by_club_id(int cl
 }
 
 bool ProfessorTable::update_professor_name(int prof_id, const std::string &new_name) {
+    ServiceCall call("ProfessorTable::update_professor_name", prof_id, new_name);
     try {
         std::map<std::string, std::string> conditions = {{"prof_id", std::to_string(prof_id)}};
         std::map<std::string, std::string> new_values = {{"name", new_name}};
@@ -74,6 +75,7 @@ bool ProfessorTable::update_professor_name(int prof_id, const std::string &new_n
 }
 
 bool ProfessorTable::delete_professor(int prof_id) {
+    ServiceCall call("ProfessorTable::delete_professor", prof_id);
     try {
         std::map<std::string, std::string> conditions = {{"prof_id", std::to_string(prof_id)}};
 
@@ -89,6 +91,7 @@ bool ProfessorTable::delete_professor(int prof_id) {
     }
 }
 
-std::unique_ptr<sql::ResultSet> ProfessorTable::read_all_professor() {
+std::unique_ptr<DbResult> ProfessorTable::read_all_professor() {
+    ServiceCall call("ProfessorTable::read_all_professor");
     return basic_select_all();
 }
\ No newline at end of file
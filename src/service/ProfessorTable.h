@@ -19,7 +19,7 @@ public:
      * @brief Constructs a new ProfessorTable object with a database connection.
      * @param conn A shared pointer to an active database connection.
      */
-    ProfessorTable(std::shared_ptr<sql::Connection> conn);
+    ProfessorTable(std::shared_ptr<DbConnection> conn);
 
     /**
      * @brief Creates a new professor record.
@@ -31,16 +31,16 @@ public:
     /**
      * @brief Reads a professor record based on professor ID.
      * @param prof_id The ID of the professor.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_professor_by_id(int prof_id);
+    std::unique_ptr<DbResult> read_professor_by_id(int prof_id);
 
     /**
      * @brief Reads professors advising specific clubs.
      * @param club_id The ID of the club.
-     * @return A unique pointer to a ResultSet containing the query results, or nullptr if an error occurred.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_professor_by_club_id(int club_id);
+    std::unique_ptr<DbResult> read_professor_by_club_id(int club_id);
 
     /**
      * @brief Updates the name of a professor.
@@ -59,7 +59,7 @@ public:
 
     /**
      * @brief Reads all professors in the table.
-     * @return A unique pointer to a ResultSet containing all clubs, or nullptr if an error occurred.
+     * @return A unique pointer to a DbResult containing all clubs, or nullptr if an error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_all_professor();
+    std::unique_ptr<DbResult> read_all_professor();
 };
\ No newline at end of file
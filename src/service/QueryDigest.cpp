@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <cppconn/exception.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+
+#include "../utils.h"
+#include "QueryDigest.h"
+
+static bool is_word_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+/**
+ * @brief Whether a '-' before a number is a sign rather than a subtraction.
+ */
+static bool sign_position(const std::vector<std::string> &tokens) {
+    if (tokens.size() < 2 || tokens.back() != "-")
+        return false;
+    const std::string &before = tokens[tokens.size() - 2];
+    return !(is_word_char(before.back()) || before == "?" || before == ")" || before.back() == '`');
+}
+
+/**
+ * @brief Replaces "( ? , ? , ... )" at the end of tokens with "(?+)", and a list of such tuples
+ * after VALUES with a single one.
+ */
+static void collapse_list(std::vector<std::string> &tokens) {
+    size_t n = tokens.size();
+    if (n < 3 || tokens[n - 1] != ")")
+        return;
+    size_t open = n - 2;
+    while (open > 0 && (tokens[open] == "?" || tokens[open] == ",")) {
+        if (tokens[open] == tokens[open - 1])
+            return;
+        --open;
+    }
+    if (tokens[open] != "(" || tokens[open + 1] != "?" || tokens[n - 2] != "?")
+        return;
+    tokens.resize(open);
+    tokens.push_back("(?+)");
+
+    // values (?+), (?+) -> values (?+)
+    while (tokens.size() >= 3 && tokens[tokens.size() - 2] == "," && tokens[tokens.size() - 3] == "(?+)")
+        tokens.resize(tokens.size() - 2);
+}
+
+std::string normalize_query(const std::string &sql) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < sql.size()) {
+        char c = sql[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == '/' && i + 1 < sql.size() && sql[i + 1] == '*') {
+            size_t end = sql.find("*/", i + 2);
+            i = end == std::string::npos ? sql.size() : end + 2;
+        } else if (c == '#' || (c == '-' && i + 1 < sql.size() && sql[i + 1] == '-')) {
+            size_t end = sql.find('\n', i);
+            i = end == std::string::npos ? sql.size() : end + 1;
+        } else if (c == '\'' || c == '"') {
+            size_t j = i + 1;
+            while (j < sql.size()) {
+                if (sql[j] == '\\') {
+                    j += 2;
+                } else if (sql[j] == c && j + 1 < sql.size() && sql[j + 1] == c) {
+                    j += 2;
+                } else if (sql[j] == c) {
+                    break;
+                } else {
+                    ++j;
+                }
+            }
+            i = std::min(sql.size(), j + 1);
+            tokens.push_back("?");
+        } else if (c == '`') {
+            size_t end = sql.find('`', i + 1);
+            end = end == std::string::npos ? sql.size() : end + 1;
+            tokens.push_back(sql.substr(i, end - i));
+            i = end;
+        } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+                   (c == '.' && i + 1 < sql.size() && std::isdigit(static_cast<unsigned char>(sql[i + 1])))) {
+            size_t j = i;
+            if (c == '0' && i + 1 < sql.size() && (sql[i + 1] == 'x' || sql[i + 1] == 'X')) {
+                j += 2;
+                while (j < sql.size() && std::isxdigit(static_cast<unsigned char>(sql[j])))
+                    ++j;
+            } else {
+                while (j < sql.size() && (std::isdigit(static_cast<unsigned char>(sql[j])) || sql[j] == '.'))
+                    ++j;
+                if (j < sql.size() && (sql[j] == 'e' || sql[j] == 'E')) {
+                    size_t k = j + 1;
+                    if (k < sql.size() && (sql[k] == '+' || sql[k] == '-'))
+                        ++k;
+                    if (k < sql.size() && std::isdigit(static_cast<unsigned char>(sql[k]))) {
+                        j = k;
+                        while (j < sql.size() && std::isdigit(static_cast<unsigned char>(sql[j])))
+                            ++j;
+                    }
+                }
+            }
+            if (j < sql.size() && is_word_char(sql[j])) {
+                // An identifier that starts with digits, e.g. 1st_year.
+                while (j < sql.size() && is_word_char(sql[j]))
+                    ++j;
+                std::string word = sql.substr(i, j - i);
+                std::transform(word.begin(), word.end(), word.begin(), [](unsigned char ch) { return std::tolower(ch); });
+                tokens.push_back(word);
+            } else {
+                if (sign_position(tokens))
+                    tokens.pop_back();
+                tokens.push_back("?");
+            }
+            i = j;
+        } else if (is_word_char(c)) {
+            size_t j = i;
+            while (j < sql.size() && is_word_char(sql[j]))
+                ++j;
+            std::string word = sql.substr(i, j - i);
+            std::transform(word.begin(), word.end(), word.begin(), [](unsigned char ch) { return std::tolower(ch); });
+            tokens.push_back(word);
+            i = j;
+        } else {
+            static const char *const operators[] = {"<=>", "<=", ">=", "<>", "!=", ":=", "||", "&&", "<<", ">>"};
+            std::string op(1, c);
+            for (const char *candidate : operators) {
+                size_t length = std::char_traits<char>::length(candidate);
+                if (sql.compare(i, length, candidate) == 0) {
+                    op = candidate;
+                    break;
+                }
+            }
+            i += op.size();
+            tokens.push_back(op == "!=" ? "<>" : op);
+            if (op == ")")
+                collapse_list(tokens);
+        }
+    }
+
+    std::string out;
+    for (size_t t = 0; t < tokens.size(); ++t) {
+        const std::string &token = tokens[t];
+        bool glue = t == 0 || token == "," || token == ")" || token == "." || tokens[t - 1] == "(" || tokens[t - 1] == ".";
+        if (!glue)
+            out += ' ';
+        out += token;
+    }
+    return out;
+}
+
+uint64_t query_fingerprint(const std::string &normalized) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : normalized) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash ? hash : 1;
+}
+
+static void atomic_max(std::atomic<uint64_t> &target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        ;
+}
+
+QueryDigestTable::QueryDigestTable(size_t capacity, unsigned examine_every) : examine_every(examine_every) {
+    size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    slots = std::make_unique<Slot[]>(size);
+    mask = size - 1;
+}
+
+QueryDigestTable::~QueryDigestTable() {
+    for (size_t i = 0; i <= mask; ++i)
+        delete slots[i].text.load(std::memory_order_acquire);
+}
+
+QueryDigestTable::Slot *QueryDigestTable::find_or_claim(uint64_t digest, const std::string &text) {
+    for (size_t probe = 0; probe <= mask; ++probe) {
+        Slot &slot = slots[(digest + probe) & mask];
+        uint64_t current = slot.digest.load(std::memory_order_acquire);
+        if (current == 0 && slot.digest.compare_exchange_strong(current, digest, std::memory_order_acq_rel)) {
+            slot.text.store(new std::string(text), std::memory_order_release);
+            return &slot;
+        }
+        if (current == digest)
+            return &slot;
+    }
+    return nullptr;
+}
+
+std::optional<uint64_t> QueryDigestTable::rows_examined(sql::Connection &conn) {
+    try {
+        // The sampling statement itself is still in events_statements_current, so the latest
+        // history row of this thread is the statement being recorded.
+        std::unique_ptr<sql::Statement> stmt(conn.createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+            "SELECT ROWS_EXAMINED FROM performance_schema.events_statements_history "
+            "WHERE THREAD_ID = PS_CURRENT_THREAD_ID() ORDER BY EVENT_ID DESC LIMIT 1"));
+        if (res->next())
+            return static_cast<uint64_t>(res->getUInt64(1));
+        return std::nullopt;
+    } catch (sql::SQLException &e) {
+        bool expected = true;
+        if (examine_available.compare_exchange_strong(expected, false))
+            Logger(ll_warning, "QueryDigestTable: rows examined are not sampled: " + std::string(e.what())).log();
+        return std::nullopt;
+    }
+}
+
+void QueryDigestTable::record(sql::Connection *conn, const std::string &sql, std::chrono::microseconds elapsed, uint64_t rows,
+                              bool failed) {
+    std::string text = normalize_query(sql);
+    Slot *slot = find_or_claim(query_fingerprint(text), text);
+    if (!slot) {
+        overflowed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t us = static_cast<uint64_t>(std::max<int64_t>(0, elapsed.count()));
+    uint64_t previous = slot->count.fetch_add(1, std::memory_order_relaxed);
+    slot->total_us.fetch_add(us, std::memory_order_relaxed);
+    atomic_max(slot->max_us, us);
+    if (failed) {
+        slot->errors.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    slot->rows.fetch_add(rows, std::memory_order_relaxed);
+
+    if (conn && examine_every && previous % examine_every == 0 && examine_available.load(std::memory_order_relaxed)) {
+        if (auto examined = rows_examined(*conn)) {
+            slot->sampled.fetch_add(1, std::memory_order_relaxed);
+            slot->sampled_rows_examined.fetch_add(*examined, std::memory_order_relaxed);
+            slot->sampled_rows.fetch_add(rows, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::vector<QueryDigestStats> QueryDigestTable::snapshot() const {
+    std::vector<QueryDigestStats> all;
+    for (size_t i = 0; i <= mask; ++i) {
+        const Slot &slot = slots[i];
+        const std::string *text = slot.text.load(std::memory_order_acquire);
+        if (!text)
+            continue;
+        QueryDigestStats stats;
+        stats.digest = slot.digest.load(std::memory_order_relaxed);
+        stats.text = *text;
+        stats.count = slot.count.load(std::memory_order_relaxed);
+        stats.errors = slot.errors.load(std::memory_order_relaxed);
+        stats.total_us = slot.total_us.load(std::memory_order_relaxed);
+        stats.max_us = slot.max_us.load(std::memory_order_relaxed);
+        stats.rows = slot.rows.load(std::memory_order_relaxed);
+        stats.sampled = slot.sampled.load(std::memory_order_relaxed);
+        stats.sampled_rows_examined = slot.sampled_rows_examined.load(std::memory_order_relaxed);
+        stats.sampled_rows = slot.sampled_rows.load(std::memory_order_relaxed);
+        all.push_back(std::move(stats));
+    }
+    std::sort(all.begin(), all.end(), [](const QueryDigestStats &a, const QueryDigestStats &b) { return a.total_us > b.total_us; });
+    return all;
+}
+
+static std::string json_string(const std::string &text) {
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    return out + "\"";
+}
+
+bool QueryDigestTable::write_json(const std::string &path) const {
+    std::string out = "[";
+    bool first = true;
+    for (const auto &stats : snapshot()) {
+        char digest[17], numbers[64];
+        std::snprintf(digest, sizeof(digest), "%016llx", static_cast<unsigned long long>(stats.digest));
+        out += first ? "\n" : ",\n";
+        first = false;
+        out += "{\"digest\":\"" + std::string(digest) + "\",\"text\":" + json_string(stats.text);
+        out += ",\"count\":" + std::to_string(stats.count) + ",\"errors\":" + std::to_string(stats.errors);
+        out += ",\"total_us\":" + std::to_string(stats.total_us);
+        std::snprintf(numbers, sizeof(numbers), "%.1f", stats.avg_us());
+        out += ",\"avg_us\":" + std::string(numbers) + ",\"max_us\":" + std::to_string(stats.max_us);
+        out += ",\"rows\":" + std::to_string(stats.rows) + ",\"sampled\":" + std::to_string(stats.sampled);
+        out += ",\"sampled_rows_examined\":" + std::to_string(stats.sampled_rows_examined);
+        out += ",\"sampled_rows\":" + std::to_string(stats.sampled_rows);
+        std::snprintf(numbers, sizeof(numbers), "%.2f", stats.examined_per_row());
+        out += ",\"examined_per_row\":" + std::string(numbers) + "}";
+    }
+    out += "\n]\n";
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+        Logger(ll_error, "Failed to write query digests to " + path).log();
+        return false;
+    }
+    return true;
+}
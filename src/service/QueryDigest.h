@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <cppconn/connection.h>
+
+/**
+ * @brief Reduces a statement to its shape: string and number literals become '?', lists of
+ * placeholders in IN (...) and VALUES (...), (...) collapse to one, whitespace collapses to one
+ * space and everything outside quoted identifiers is lower-cased.
+ *
+ * "SELECT * FROM Club WHERE club_id = '12'" and "select * from Club where club_id=?" both become
+ * "select * from club where club_id = ?".
+ */
+std::string normalize_query(const std::string &sql);
+
+/**
+ * @brief The 64-bit FNV-1a hash of a normalized statement; never 0.
+ */
+uint64_t query_fingerprint(const std::string &normalized);
+
+/**
+ * @brief What QueryDigestTable knows about one statement shape.
+ */
+struct QueryDigestStats {
+    uint64_t digest = 0;
+    std::string text;
+    uint64_t count = 0;
+    uint64_t errors = 0;
+    uint64_t total_us = 0;
+    uint64_t max_us = 0;
+
+    /**
+     * @brief Rows returned by reads plus rows affected by writes.
+     */
+    uint64_t rows = 0;
+
+    /**
+     * @brief Executions whose rows examined were read from performance_schema.
+     */
+    uint64_t sampled = 0;
+    uint64_t sampled_rows_examined = 0;
+
+    /**
+     * @brief Rows returned or affected by the sampled executions, the denominator of examined_per_row().
+     */
+    uint64_t sampled_rows = 0;
+
+    double avg_us() const {
+        return count ? static_cast<double>(total_us) / static_cast<double>(count) : 0;
+    }
+
+    /**
+     * @brief Rows the server examined per row it returned, over the sampled executions.
+     */
+    double examined_per_row() const {
+        return static_cast<double>(sampled_rows_examined) / static_cast<double>(sampled_rows ? sampled_rows : 1);
+    }
+};
+
+/**
+ * @brief Aggregates statement timings per fingerprint.
+ *
+ * The table is a fixed-size open-addressing hash table of atomic counters: recording claims or
+ * finds a slot with one compare-and-swap and then only does atomic adds, so statements on any
+ * number of connections never wait for each other. Shapes beyond the capacity are counted as
+ * overflow.
+ *
+ * Rows examined are not part of the client protocol. For the first execution of a shape and then
+ * every examine_every-th one, the table reads them from performance_schema.events_statements_history
+ * on the same connection; if that is not available, sampling turns itself off.
+ */
+class QueryDigestTable {
+public:
+    /**
+     * @param capacity Number of distinct shapes kept; rounded up to a power of two.
+     * @param examine_every Sample rows examined once per this many executions of a shape; 0 never samples.
+     */
+    explicit QueryDigestTable(size_t capacity = 4096, unsigned examine_every = 16);
+    ~QueryDigestTable();
+
+    QueryDigestTable(const QueryDigestTable &) = delete;
+    QueryDigestTable &operator=(const QueryDigestTable &) = delete;
+
+    /**
+     * @brief Adds one execution of a statement.
+     * @param conn The connection the statement ran on, used for sampling rows examined; may be nullptr.
+     * @param sql The statement text.
+     * @param elapsed Time spent preparing and executing it.
+     * @param rows Rows returned by a read or affected by a write.
+     * @param failed Whether the statement raised an error.
+     */
+    void record(sql::Connection *conn, const std::string &sql, std::chrono::microseconds elapsed, uint64_t rows, bool failed);
+
+    /**
+     * @brief Returns every shape, largest total time first.
+     */
+    std::vector<QueryDigestStats> snapshot() const;
+
+    /**
+     * @brief Executions of shapes that found the table full.
+     */
+    uint64_t overflow() const {
+        return overflowed.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Writes snapshot() as a JSON array.
+     * @return True on success, false if the file could not be written.
+     */
+    bool write_json(const std::string &path) const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> digest{0};
+
+        /**
+         * @brief Published by the thread that claimed the slot, after digest; readers skip the slot until then.
+         */
+        std::atomic<const std::string *> text{nullptr};
+
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> total_us{0};
+        std::atomic<uint64_t> max_us{0};
+        std::atomic<uint64_t> rows{0};
+        std::atomic<uint64_t> sampled{0};
+        std::atomic<uint64_t> sampled_rows_examined{0};
+        std::atomic<uint64_t> sampled_rows{0};
+    };
+
+    Slot *find_or_claim(uint64_t digest, const std::string &text);
+    std::optional<uint64_t> rows_examined(sql::Connection &conn);
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    unsigned examine_every;
+    std::atomic<bool> examine_available{true};
+    std::atomic<uint64_t> overflowed{0};
+};
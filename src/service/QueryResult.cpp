@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cppconn/resultset.h>
+
+#include "../storage/DbBackend.h"
+#include "../trace/Tracer.h"
+#include "QueryResult.h"
+
+/**
+ * @brief Per column, the cells already holding each distinct value, while the column still looks low-cardinality.
+ *
+ * Each column has an open-addressing table of cell descriptors; keys are compared against the
+ * arena, so interning allocates nothing per value.
+ */
+struct QueryResult::Interner {
+    static constexpr size_t slot_count = 2 * max_interned_values;
+
+    struct Column {
+        std::vector<Cell> slots;
+        size_t size = 0;
+        bool active = true;
+    };
+
+    explicit Interner(size_t column_count) : columns(column_count) {}
+
+    std::vector<Column> columns;
+};
+
+void QueryResult::append_cell(Interner &interner, size_t column, const std::optional<std::string_view> &value) {
+    if (!value) {
+        cells.push_back({0, null_length});
+        return;
+    }
+
+    Interner::Column &seen = interner.columns[column];
+    Cell *slot = nullptr;
+    if (seen.active && value->size() <= max_interned_length) {
+        if (seen.slots.empty())
+            seen.slots.assign(Interner::slot_count, Cell{0, null_length});
+        size_t i = std::hash<std::string_view>{}(*value) & (Interner::slot_count - 1);
+        for (;; i = (i + 1) & (Interner::slot_count - 1)) {
+            Cell &candidate = seen.slots[i];
+            if (candidate.length == null_length) {
+                slot = &candidate;
+                break;
+            }
+            if (candidate.length == value->size() &&
+                std::string_view(arena.data() + candidate.offset, candidate.length) == *value) {
+                cells.push_back(candidate);
+                return;
+            }
+        }
+    }
+
+    if (arena.size() + value->size() >= null_length)
+        throw std::length_error("QueryResult arena exceeds 4 GiB");
+    Cell added{static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(value->size())};
+    arena.insert(arena.end(), value->begin(), value->end());
+    cells.push_back(added);
+
+    if (slot) {
+        if (seen.size < max_interned_values) {
+            *slot = added;
+            ++seen.size;
+        } else {
+            seen.active = false;
+            seen.slots = {};
+        }
+    }
+}
+
+void QueryResult::reserve_arena(size_t rows_read, size_t total_rows) {
+    if (rows_read == arena_sample_rows && total_rows > rows_read)
+        arena.reserve(arena.size() / rows_read * total_rows * 9 / 8);
+}
+
+std::shared_ptr<QueryResult> QueryResult::from_result_set(sql::ResultSet &res) {
+    TraceSpan span("fetch", "QueryResult::from_result_set");
+    auto result = std::make_shared<QueryResult>();
+
+    sql::ResultSetMetaData *metadata = res.getMetaData();
+    unsigned int column_count = metadata->getColumnCount();
+    result->columns.reserve(column_count);
+    for (unsigned int i = 1; i <= column_count; ++i) {
+        std::string label = metadata->getColumnLabel(i);
+        result->columns.push_back(label);
+    }
+
+    Interner interner(column_count);
+    size_t total_rows = res.rowsCount();
+    result->cells.reserve(total_rows * column_count);
+    for (size_t rows_read = 1; res.next(); ++rows_read) {
+        for (unsigned int i = 1; i <= column_count; ++i) {
+            if (res.isNull(i)) {
+                result->append_cell(interner, i - 1, std::nullopt);
+            } else {
+                std::string value = res.getString(i);
+                result->append_cell(interner, i - 1, value);
+            }
+        }
+        result->reserve_arena(rows_read, total_rows);
+    }
+    return result;
+}
+
+std::shared_ptr<QueryResult> QueryResult::from_db_result(DbResult &res) {
+    TraceSpan span("fetch", "QueryResult::from_db_result");
+    auto result = std::make_shared<QueryResult>();
+
+    size_t column_count = res.column_count();
+    result->columns.reserve(column_count);
+    for (size_t i = 0; i < column_count; ++i)
+        result->columns.push_back(res.column_name(i));
+
+    Interner interner(column_count);
+    size_t total_rows = res.rows_count();
+    result->cells.reserve(total_rows * column_count);
+    for (size_t rows_read = 1; res.next(); ++rows_read) {
+        for (size_t i = 0; i < column_count; ++i) {
+            if (res.is_null(i)) {
+                result->append_cell(interner, i, std::nullopt);
+            } else {
+                std::string value = res.get_string(i);
+                result->append_cell(interner, i, value);
+            }
+        }
+        result->reserve_arena(rows_read, total_rows);
+    }
+    return result;
+}
+
+int QueryResult::column_index(const std::string &name) const {
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (columns[i] == name)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+int QueryResult::get_int(size_t row, size_t column) const {
+    std::string_view text = get_string(row, column);
+    int value = 0;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+std::shared_ptr<QueryResult> QueryResult::merge(const std::vector<std::shared_ptr<const QueryResult>> &parts,
+                                                const std::vector<SortKey> &order, size_t limit) {
+    TraceSpan span("fetch", "QueryResult::merge");
+    auto result = std::make_shared<QueryResult>();
+
+    struct RowRef {
+        const QueryResult *part;
+        size_t row;
+    };
+    std::vector<RowRef> rows;
+    for (const auto &part : parts) {
+        if (!part || part->columns.empty())
+            continue;
+        if (result->columns.empty())
+            result->columns = part->columns;
+        else if (part->columns.size() != result->columns.size())
+            throw std::invalid_argument("QueryResult::merge: parts have different columns");
+        for (size_t row = 0; row < part->rows_count(); ++row)
+            rows.push_back({part.get(), row});
+    }
+
+    std::vector<std::pair<size_t, bool>> keys;
+    for (const SortKey &key : order) {
+        int column = result->column_index(key.column);
+        if (column >= 0)
+            keys.emplace_back(static_cast<size_t>(column), key.descending);
+    }
+    if (!keys.empty()) {
+        std::stable_sort(rows.begin(), rows.end(), [&keys](const RowRef &a, const RowRef &b) {
+            for (const auto &[column, descending] : keys) {
+                int x = a.part->get_int(a.row, column);
+                int y = b.part->get_int(b.row, column);
+                if (x != y)
+                    return descending ? x > y : x < y;
+            }
+            return false;
+        });
+    }
+    if (rows.size() > limit)
+        rows.resize(limit);
+
+    // Where each contributing part's arena starts in the combined one; there are only a few parts.
+    std::vector<std::pair<const QueryResult *, uint32_t>> bases;
+    size_t column_count = result->columns.size();
+    result->cells.reserve(rows.size() * column_count);
+    for (const RowRef &ref : rows) {
+        auto base = std::find_if(bases.begin(), bases.end(), [&ref](const auto &entry) { return entry.first == ref.part; });
+        if (base == bases.end()) {
+            if (result->arena.size() + ref.part->arena.size() >= null_length)
+                throw std::length_error("QueryResult arena exceeds 4 GiB");
+            bases.emplace_back(ref.part, static_cast<uint32_t>(result->arena.size()));
+            result->arena.insert(result->arena.end(), ref.part->arena.begin(), ref.part->arena.end());
+            base = bases.end() - 1;
+        }
+        for (size_t column = 0; column < column_count; ++column) {
+            Cell copied = ref.part->cell(ref.row, column);
+            if (copied.length != null_length)
+                copied.offset += base->second;
+            result->cells.push_back(copied);
+        }
+    }
+    return result;
+}
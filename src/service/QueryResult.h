@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cppconn/resultset.h>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class DbResult;
+
+/**
+ * @brief A fully materialized, read-only query result.
+ *
+ * Unlike sql::ResultSet it has no cursor, so one instance can be shared by
+ * several readers at once (e.g. callers coalesced onto the same query).
+ *
+ * All cell bytes live in one contiguous arena and each cell is an offset/length
+ * pair into it, so materializing a result costs a few geometrically growing
+ * allocations rather than one string per cell and one vector per row. Values
+ * repeated within a low-cardinality column (e.g. Student.department) are stored
+ * once and shared by every cell holding them. Moving a QueryResult moves its
+ * buffers; copying is disabled.
+ */
+class QueryResult {
+private:
+    /**
+     * @brief Where a cell's bytes are in the arena.
+     */
+    struct Cell {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    /**
+     * @brief Cell::length of a NULL cell.
+     */
+    static constexpr uint32_t null_length = UINT32_MAX;
+
+    /**
+     * @brief A column stops being interned once it has more distinct values than this.
+     */
+    static constexpr size_t max_interned_values = 256;
+
+    /**
+     * @brief Longer values are never interned.
+     */
+    static constexpr size_t max_interned_length = 64;
+
+    /**
+     * @brief After this many rows the arena is sized for the whole result from their average width.
+     */
+    static constexpr size_t arena_sample_rows = 64;
+
+    struct Interner;
+
+    /**
+     * @brief Column labels in select order.
+     */
+    std::vector<std::string> columns;
+
+    /**
+     * @brief Bytes of all cells, back to back.
+     */
+    std::vector<char> arena;
+
+    /**
+     * @brief Cell descriptors, row by row.
+     */
+    std::vector<Cell> cells;
+
+    /**
+     * @brief Appends a cell to the current row.
+     * @param interner Values seen so far in each column.
+     * @param column Zero-based column index.
+     * @param value The cell text, or std::nullopt for NULL.
+     * @throws std::length_error if the arena would exceed 4 GiB.
+     */
+    void append_cell(Interner &interner, size_t column, const std::optional<std::string_view> &value);
+
+    /**
+     * @brief Reserves the arena for total_rows once arena_sample_rows rows have been read.
+     */
+    void reserve_arena(size_t rows_read, size_t total_rows);
+
+    const Cell &cell(size_t row, size_t column) const { return cells[row * columns.size() + column]; }
+
+public:
+    QueryResult() = default;
+    QueryResult(QueryResult &&) noexcept = default;
+    QueryResult &operator=(QueryResult &&) noexcept = default;
+    QueryResult(const QueryResult &) = delete;
+    QueryResult &operator=(const QueryResult &) = delete;
+
+    /**
+     * @brief Reads every remaining row of a ResultSet.
+     * @param res The ResultSet to drain.
+     * @return A shared pointer to the materialized result.
+     */
+    static std::shared_ptr<QueryResult> from_result_set(sql::ResultSet &res);
+
+    /**
+     * @brief Reads every remaining row of a DbResult.
+     * @param res The result to drain.
+     * @return A shared pointer to the materialized result.
+     */
+    static std::shared_ptr<QueryResult> from_db_result(DbResult &res);
+
+    /**
+     * @brief A column merge() sorts rows by, compared as integers.
+     */
+    struct SortKey {
+        std::string column;
+        bool descending = false;
+    };
+
+    /**
+     * @brief Combines results of the same statement, e.g. one per shard, into one.
+     * Each part's arena is copied whole, so values interned within a part stay shared.
+     * @param parts The results to combine, all with the same columns; nullptr entries are skipped.
+     * @param order Columns to sort the combined rows by, most significant first; empty keeps the parts' order.
+     * A column missing from the result is ignored.
+     * @param limit Keeps at most this many rows after sorting, e.g. the k of a top-k query.
+     * @return A shared pointer to the combined result.
+     * @throws std::invalid_argument if the parts have different numbers of columns.
+     * @throws std::length_error if the arena would exceed 4 GiB.
+     */
+    static std::shared_ptr<QueryResult> merge(const std::vector<std::shared_ptr<const QueryResult>> &parts,
+                                              const std::vector<SortKey> &order = {}, size_t limit = SIZE_MAX);
+
+    /**
+     * @brief Returns the column labels.
+     */
+    const std::vector<std::string> &column_names() const { return columns; }
+
+    /**
+     * @brief Returns the number of columns.
+     */
+    size_t column_count() const { return columns.size(); }
+
+    /**
+     * @brief Returns the number of rows.
+     */
+    size_t rows_count() const { return columns.empty() ? 0 : cells.size() / columns.size(); }
+
+    /**
+     * @brief Returns the bytes held by the arena and the cell descriptors.
+     */
+    size_t memory_usage() const { return arena.capacity() + cells.capacity() * sizeof(Cell); }
+
+    /**
+     * @brief Finds a column by label.
+     * @param name The column label.
+     * @return The zero-based column index, or -1 if there is no such column.
+     */
+    int column_index(const std::string &name) const;
+
+    /**
+     * @brief Returns a cell as string. NULL cells are empty strings.
+     * The view stays valid as long as this result is alive (moving it does not invalidate views).
+     * @param row Zero-based row index.
+     * @param column Zero-based column index.
+     */
+    std::string_view get_string(size_t row, size_t column) const {
+        const Cell &c = cell(row, column);
+        if (c.length == null_length)
+            return {};
+        return std::string_view(arena.data() + c.offset, c.length);
+    }
+
+    /**
+     * @brief Returns a cell as int.
+     * @param row Zero-based row index.
+     * @param column Zero-based column index.
+     */
+    int get_int(size_t row, size_t column) const;
+
+    /**
+     * @brief Returns whether a cell is NULL.
+     * @param row Zero-based row index.
+     * @param column Zero-based column index.
+     */
+    bool is_null(size_t row, size_t column) const { return cell(row, column).length == null_length; }
+};
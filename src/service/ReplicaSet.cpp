@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+
+#include "../trace/Tracer.h"
+#include "../utils.h"
+#include "ReplicaSet.h"
+
+struct ReplicaSet::Replica {
+    std::string server;
+    std::unique_ptr<ConnectionPool> pool;
+
+    // Guarded by ReplicaSet::mutex.
+    bool healthy = false;
+    int lag_seconds = -1;
+    std::string gtid_executed;
+    std::string error;
+
+    /**
+     * @brief With compare_gtids: gtid_executed contains required_gtids.
+     */
+    bool caught_up = true;
+
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> failures{0};
+};
+
+namespace {
+
+using GtidSet = std::map<std::string, std::vector<std::pair<uint64_t, uint64_t>>>;
+
+/**
+ * @brief Parses a GTID set such as "3e11fa47-...:1-5:11-18,\n4a1b...:1-27" (tagged GTIDs as
+ * "uuid:tag:1-5") into intervals per source UUID and tag.
+ */
+GtidSet parse_gtid_set(const std::string &text) {
+    GtidSet set;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos)
+            end = text.size();
+        std::string token;
+        std::string key;
+        size_t field_start = pos;
+        for (size_t i = pos; i <= end; ++i) {
+            if (i < end && text[i] != ':')
+                continue;
+            token.clear();
+            for (size_t j = field_start; j < i; ++j) {
+                if (!std::isspace(static_cast<unsigned char>(text[j])))
+                    token += static_cast<char>(std::tolower(static_cast<unsigned char>(text[j])));
+            }
+            field_start = i + 1;
+            if (token.empty())
+                continue;
+            if (key.empty()) {
+                key = token;
+            } else if (std::isdigit(static_cast<unsigned char>(token[0]))) {
+                size_t dash = token.find('-');
+                uint64_t first = std::stoull(token.substr(0, dash));
+                uint64_t last = dash == std::string::npos ? first : std::stoull(token.substr(dash + 1));
+                set[key].emplace_back(first, last);
+            } else {
+                size_t tag_start = key.find(':');
+                key = (tag_start == std::string::npos ? key : key.substr(0, tag_start)) + ":" + token;
+            }
+        }
+        pos = end + 1;
+    }
+    return set;
+}
+
+/**
+ * @brief Reads one string value, e.g. @@GLOBAL.gtid_executed, without logging the statement.
+ */
+std::string query_value(sql::Connection &conn, const std::string &query) {
+    std::unique_ptr<sql::Statement> stmt(conn.createStatement());
+    std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(query));
+    return res->next() ? std::string(res->getString(1)) : std::string();
+}
+
+} // namespace
+
+ReplicaSet::ReplicaSet(const std::vector<std::string> &servers, Factory factory, ReplicaOptions options)
+    : options(options) {
+    for (const auto &server : servers) {
+        auto replica = std::make_unique<Replica>();
+        replica->server = server;
+        replica->pool = std::make_unique<ConnectionPool>([factory, server] { return factory(server); },
+                                                         options.connections_per_replica);
+        replicas.push_back(std::move(replica));
+    }
+}
+
+ReplicaSet::~ReplicaSet() {
+    {
+        std::lock_guard<std::mutex> lock(monitor_mutex);
+        monitor_stopping = true;
+    }
+    monitor_wake.notify_all();
+    if (monitor.joinable())
+        monitor.join();
+}
+
+void ReplicaSet::start() {
+    for (auto &replica : replicas)
+        poll(*replica);
+    std::lock_guard<std::mutex> lock(monitor_mutex);
+    if (!monitor.joinable())
+        monitor = std::thread(&ReplicaSet::run_monitor, this);
+}
+
+void ReplicaSet::run_monitor() {
+    Tracer::set_thread_name("replica-monitor");
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(monitor_mutex);
+            if (monitor_wake.wait_for(lock, options.poll_interval, [this] { return monitor_stopping; }))
+                break;
+        }
+        for (auto &replica : replicas)
+            poll(*replica);
+    }
+}
+
+void ReplicaSet::poll(Replica &replica) {
+    int lag = -1;
+    std::string gtids, error;
+    try {
+        ConnectionPool::Lease lease = replica.pool->acquire();
+        std::unique_ptr<sql::Statement> stmt(lease->createStatement());
+        std::unique_ptr<sql::ResultSet> res;
+        std::string lag_column = "Seconds_Behind_Source";
+        try {
+            res.reset(stmt->executeQuery("SHOW REPLICA STATUS"));
+        } catch (sql::SQLException &) {
+            // Servers before 8.0.22 only know the old names.
+            res.reset(stmt->executeQuery("SHOW SLAVE STATUS"));
+            lag_column = "Seconds_Behind_Master";
+        }
+        if (!res->next())
+            error = "not a replica";
+        else if (res->isNull(lag_column))
+            error = "replication is not running";
+        else
+            lag = res->getInt(lag_column);
+        if (error.empty() && options.compare_gtids)
+            gtids = query_value(*lease.get(), "SELECT @@GLOBAL.gtid_executed");
+    } catch (sql::SQLException &e) {
+        error = e.what();
+    }
+
+    bool was_healthy;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        was_healthy = replica.healthy;
+        replica.healthy = error.empty();
+        replica.lag_seconds = lag;
+        replica.error = error;
+        if (options.compare_gtids) {
+            replica.gtid_executed = gtids;
+            replica.caught_up = required_gtids.empty() || gtid_subset(required_gtids, gtids);
+        }
+    }
+    if (was_healthy && !error.empty())
+        Logger(ll_warning, "Replica " + replica.server + " is unavailable: " + error).log();
+    else if (!was_healthy && error.empty())
+        Logger(ll_info, "Replica " + replica.server + " is available, " + std::to_string(lag) + "s behind").log();
+}
+
+bool ReplicaSet::is_replica_safe(const std::string &query) {
+    std::string upper;
+    upper.reserve(query.size());
+    for (char c : query)
+        upper += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+
+    size_t start = upper.find_first_not_of(" \t\r\n(");
+    if (start == std::string::npos || upper.compare(start, 6, "SELECT") != 0)
+        return false;
+    if (start + 6 < upper.size() && (std::isalnum(static_cast<unsigned char>(upper[start + 6])) || upper[start + 6] == '_'))
+        return false;
+    for (const char *session_bound : {"FOR UPDATE", "FOR SHARE", "LOCK IN SHARE MODE", "LAST_INSERT_ID", "ROW_COUNT",
+                                      "FOUND_ROWS", "GET_LOCK", "@", " INTO "}) {
+        if (upper.find(session_bound) != std::string::npos)
+            return false;
+    }
+    return true;
+}
+
+bool ReplicaSet::gtid_subset(const std::string &subset, const std::string &set) {
+    GtidSet needed = parse_gtid_set(subset);
+    GtidSet have = parse_gtid_set(set);
+    for (const auto &[source, intervals] : needed) {
+        auto it = have.find(source);
+        for (const auto &[first, last] : intervals) {
+            if (it == have.end())
+                return false;
+            bool covered = std::any_of(it->second.begin(), it->second.end(),
+                                       [&](const auto &range) { return range.first <= first && last <= range.second; });
+            if (!covered)
+                return false;
+        }
+    }
+    return true;
+}
+
+ReplicaSet::Replica *ReplicaSet::choose(sql::Connection &primary) {
+    if (options.compare_gtids) {
+        if (gtids_stale.exchange(false)) {
+            std::string gtids;
+            try {
+                gtids = query_value(primary, "SELECT @@GLOBAL.gtid_executed");
+            } catch (sql::SQLException &e) {
+                gtids_stale = true;
+                Logger(ll_error, "Error in ReplicaSet: " + std::string(e.what())).log();
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            required_gtids = gtids;
+            for (auto &replica : replicas)
+                replica->caught_up = gtid_subset(required_gtids, replica->gtid_executed);
+        }
+    } else {
+        int64_t last_write = last_write_ns.load(std::memory_order_relaxed);
+        auto window = std::chrono::duration_cast<std::chrono::nanoseconds>(options.pin_window).count();
+        if (last_write != INT64_MIN && Tracer::now_ns() - last_write < window)
+            return nullptr;
+    }
+
+    std::vector<Replica *> best;
+    int best_lag = INT_MAX;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &replica : replicas) {
+        if (!replica->healthy || !replica->caught_up || replica->lag_seconds > options.max_lag.count())
+            continue;
+        if (replica->lag_seconds < best_lag) {
+            best.clear();
+            best_lag = replica->lag_seconds;
+        }
+        if (replica->lag_seconds == best_lag)
+            best.push_back(replica.get());
+    }
+    if (best.empty())
+        return nullptr;
+    return best[next_replica.fetch_add(1, std::memory_order_relaxed) % best.size()];
+}
+
+std::unique_ptr<sql::ResultSet> ReplicaSet::try_query(sql::Connection &primary, const std::string &query,
+                                                      const std::vector<SqlParam> &params) {
+    Replica *replica = choose(primary);
+    if (!replica) {
+        primary_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    try {
+        ConnectionPool::Lease lease = replica->pool->acquire();
+        std::unique_ptr<sql::ResultSet> res = BasicTable::execute_query(*lease.get(), query, params);
+        replica->reads.fetch_add(1, std::memory_order_relaxed);
+        return res;
+    } catch (sql::SQLException &e) {
+        replica->failures.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            replica->healthy = false;
+            replica->error = e.what();
+        }
+        Logger(ll_warning, "Replica " + replica->server + " failed, reading from the primary: " + std::string(e.what())).log();
+        primary_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+}
+
+void ReplicaSet::note_write() {
+    last_write_ns.store(Tracer::now_ns(), std::memory_order_relaxed);
+    if (options.compare_gtids)
+        gtids_stale.store(true, std::memory_order_relaxed);
+}
+
+std::vector<ReplicaSet::ReplicaStatus> ReplicaSet::status() const {
+    std::vector<ReplicaStatus> result;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &replica : replicas) {
+        result.push_back({replica->server, replica->healthy, replica->lag_seconds, replica->error,
+                          replica->reads.load(std::memory_order_relaxed), replica->failures.load(std::memory_order_relaxed)});
+    }
+    return result;
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/resultset.h>
+
+#include "BasicTable.h"
+#include "ConnectionPool.h"
+
+/**
+ * @brief How ReplicaSet routes reads and keeps them consistent with the session's writes.
+ */
+struct ReplicaOptions {
+    /**
+     * @brief Replicas further behind the primary than this (Seconds_Behind_Source) get no reads.
+     */
+    std::chrono::seconds max_lag{2};
+
+    /**
+     * @brief After a write, reads stay on the primary this long (read-your-writes by time).
+     */
+    std::chrono::milliseconds pin_window{2000};
+
+    /**
+     * @brief Instead of the time window, send a read to a replica only once its executed GTID
+     * set contains everything the primary had executed when the read was issued after a write.
+     */
+    bool compare_gtids = false;
+
+    /**
+     * @brief How often each replica's lag (and GTID set) is polled.
+     */
+    std::chrono::milliseconds poll_interval{500};
+
+    /**
+     * @brief Connections opened per replica, i.e. how many reads one replica serves at once.
+     */
+    size_t connections_per_replica = 2;
+};
+
+/**
+ * @brief Read replicas of the primary database, used by BasicTable to take reads off the primary.
+ *
+ * A background thread polls every replica's replication lag; a read goes to the least-lagged
+ * healthy replica within ReplicaOptions::max_lag (round robin among equals). The session, i.e.
+ * this process, reads its own writes: after any write, reads go to the primary for the pin
+ * window, or, with compare_gtids, until a replica has applied the primary's GTID set as of the
+ * first read after the write. Only plain SELECTs outside transactions are routed. Whenever no
+ * replica qualifies or a replica fails, the read runs on the primary; a failed replica gets no
+ * reads until its next successful poll.
+ */
+class ReplicaSet {
+public:
+    using Factory = std::function<std::shared_ptr<sql::Connection>(const std::string &server)>;
+
+    /**
+     * @brief Lag and traffic of one replica.
+     */
+    struct ReplicaStatus {
+        std::string server;
+        bool healthy;
+
+        /**
+         * @brief Seconds behind the primary at the last poll, or -1 if unknown.
+         */
+        int lag_seconds;
+
+        /**
+         * @brief Why the replica is unhealthy; empty if healthy.
+         */
+        std::string error;
+        uint64_t reads;
+        uint64_t failures;
+    };
+
+    /**
+     * @brief Constructs the set without connecting; call start() to begin polling.
+     * @param servers Replica addresses as "host:port".
+     * @param factory Opens a connection to a replica; throws sql::SQLException on failure.
+     * @param options Routing options.
+     */
+    ReplicaSet(const std::vector<std::string> &servers, Factory factory, ReplicaOptions options = {});
+
+    /**
+     * @brief Stops polling.
+     */
+    ~ReplicaSet();
+
+    ReplicaSet(const ReplicaSet &) = delete;
+    ReplicaSet &operator=(const ReplicaSet &) = delete;
+
+    /**
+     * @brief Polls every replica once, then keeps polling in the background.
+     */
+    void start();
+
+    /**
+     * @brief Returns whether a statement may run on a replica: a SELECT that takes no locks and
+     * does not depend on session state such as LAST_INSERT_ID().
+     */
+    static bool is_replica_safe(const std::string &query);
+
+    /**
+     * @brief Returns whether every transaction in GTID set subset is also in set, e.g. a
+     * replica's gtid_executed against the primary's.
+     */
+    static bool gtid_subset(const std::string &subset, const std::string &set);
+
+    /**
+     * @brief Runs a read on a replica if one qualifies.
+     * @param primary The caller's primary connection, used to read its GTID set after a write.
+     * @param query A statement for which is_replica_safe() holds.
+     * @param params Values for its placeholders.
+     * @return The result, or nullptr if the read should run on the primary instead.
+     */
+    std::unique_ptr<sql::ResultSet> try_query(sql::Connection &primary, const std::string &query,
+                                              const std::vector<SqlParam> &params);
+
+    /**
+     * @brief Records that the session wrote to the primary.
+     */
+    void note_write();
+
+    /**
+     * @brief Returns the state of every replica.
+     */
+    std::vector<ReplicaStatus> status() const;
+
+    /**
+     * @brief Returns how many routable reads ran on the primary because no replica qualified or one failed.
+     */
+    uint64_t primary_reads() const { return primary_fallbacks.load(std::memory_order_relaxed); }
+
+private:
+    struct Replica;
+
+    void poll(Replica &replica);
+    void run_monitor();
+    Replica *choose(sql::Connection &primary);
+
+    std::vector<std::unique_ptr<Replica>> replicas;
+    ReplicaOptions options;
+
+    /**
+     * @brief Guards the polled state of every replica and required_gtids.
+     */
+    mutable std::mutex mutex;
+
+    /**
+     * @brief Tracer::now_ns() of the last write, or INT64_MIN if none.
+     */
+    std::atomic<int64_t> last_write_ns{INT64_MIN};
+
+    /**
+     * @brief With compare_gtids: a write happened since required_gtids was read from the primary.
+     */
+    std::atomic<bool> gtids_stale{false};
+    std::string required_gtids;
+
+    std::atomic<uint64_t> next_replica{0};
+    std::atomic<uint64_t> primary_fallbacks{0};
+
+    std::mutex monitor_mutex;
+    std::condition_variable monitor_wake;
+    bool monitor_stopping = false;
+    std::thread monitor;
+};
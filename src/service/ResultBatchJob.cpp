@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cppconn/exception.h>
+#include <cppconn/resultset.h>
+
+#include "../storage/MySqlBackend.h"
+#include "../utils.h"
+#include "ResultBatchJob.h"
+#include "ResultTable.h"
+#include "ShardMap.h"
+
+ResultBatchJob::ResultBatchJob(std::shared_ptr<ConnectionPool> connection_pool) : pool(connection_pool) {}
+
+void ResultBatchJob::set_activity_rollup(bool enabled) {
+    activity_rollup = enabled;
+}
+
+void ResultBatchJob::set_shard_map(std::shared_ptr<ShardMap> shard_map) {
+    shards = shard_map;
+}
+
+ResultBatchSummary ResultBatchJob::run_all(int year) {
+    std::vector<int> club_ids;
+    try {
+        std::string query = "SELECT club_id FROM Club WHERE pending_delete = 0";
+        if (shards) {
+            std::vector<std::vector<int>> parts(shards->size());
+            shards->scatter([&](size_t shard, sql::Connection &conn) {
+                std::unique_ptr<sql::ResultSet> res = BasicTable::execute_query(conn, query);
+                while (res->next())
+                    parts[shard].push_back(res->getInt(1));
+            });
+            for (const auto &part : parts)
+                club_ids.insert(club_ids.end(), part.begin(), part.end());
+        } else {
+            ConnectionPool::Lease lease = pool->acquire();
+            std::unique_ptr<sql::ResultSet> res = BasicTable::execute_query(*lease.get(), query);
+            while (res->next())
+                club_ids.push_back(res->getInt(1));
+        }
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in ResultBatchJob::run_all: " + std::string(e.what())).log();
+        ResultBatchSummary summary;
+        summary.failed = 1;
+        return summary;
+    }
+    return run(year, club_ids);
+}
+
+ResultBatchSummary ResultBatchJob::run(int year, std::span<const int> club_ids) {
+    auto started = std::chrono::steady_clock::now();
+    std::vector<int> clubs(club_ids.begin(), club_ids.end());
+    std::sort(clubs.begin(), clubs.end());
+    clubs.erase(std::unique(clubs.begin(), clubs.end()), clubs.end());
+
+    // With a shard map each shard's clubs are submitted on pooled connections of that shard,
+    // since the shard's session connection is shared and a transaction needs one of its own.
+    std::vector<std::vector<int>> groups(shards ? shards->size() : 1);
+    for (int club_id : clubs)
+        groups[shards ? shards->shard_for_club(club_id) : 0].push_back(club_id);
+    std::vector<std::atomic<size_t>> next(groups.size());
+
+    std::atomic<size_t> submitted{0};
+    std::atomic<uint64_t> linked{0};
+
+    auto work = [&](size_t group) {
+        std::optional<ConnectionPool::Lease> lease;
+        try {
+            lease.emplace(shards ? shards->acquire(group) : pool->acquire());
+        } catch (const sql::SQLException &e) {
+            // The clubs this worker would have taken are left to the others, or counted as failed below.
+            Logger(ll_error, "SQL error in ResultBatchJob::run: " + std::string(e.what())).log();
+            return;
+        }
+        BasicTable::ShardScope scope = BasicTable::ShardScope::session(group, lease->get());
+        ResultTable result_table(std::make_shared<MySqlConnection>(lease->get()));
+        result_table.set_activity_rollup(activity_rollup);
+        const std::vector<int> &group_clubs = groups[group];
+        for (size_t i = next[group]++; i < group_clubs.size(); i = next[group]++) {
+            auto submission = result_table.submit_result(group_clubs[i], year);
+            if (submission) {
+                submitted++;
+                linked += static_cast<uint64_t>(submission->linked_activities);
+            }
+        }
+    };
+
+    size_t pool_size = shards ? shards->connections_per_shard() : pool->size();
+    std::vector<std::thread> threads;
+    for (size_t group = 0; group < groups.size(); ++group) {
+        for (size_t i = 0; i < std::min(pool_size, groups[group].size()); ++i)
+            threads.emplace_back(work, group);
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    ResultBatchSummary summary;
+    summary.clubs = clubs.size();
+    summary.submitted = submitted;
+    // Includes clubs no worker got to because no connection could be opened.
+    summary.failed = clubs.size() - submitted;
+    summary.linked_activities = linked;
+    summary.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger(ll_info, "Result batch for " + std::to_string(year) + ": " + std::to_string(summary.submitted) + "/" +
+                        std::to_string(summary.clubs) + " clubs, " + std::to_string(summary.linked_activities) +
+                        " activities linked, " + std::to_string(summary.failed) + " failed in " +
+                        std::to_string(summary.elapsed.count()) + " ms")
+        .log();
+    return summary;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "ConnectionPool.h"
+
+class ShardMap;
+
+/**
+ * @brief Totals of one ResultBatchJob run.
+ */
+struct ResultBatchSummary {
+    size_t clubs = 0;
+    size_t submitted = 0;
+    size_t failed = 0;
+    uint64_t linked_activities = 0;
+    std::chrono::milliseconds elapsed{0};
+};
+
+/**
+ * @brief Year-end job that submits the yearly Result of many clubs at once.
+ *
+ * Clubs are handed out one at a time to worker threads, each holding one pooled connection
+ * and submitting with ResultTable::submit_result (one transaction per club). With a shard
+ * map every shard gets workers of its own on the shard's pool.
+ * Because submissions are idempotent, a failed or interrupted run can simply be run again.
+ */
+class ResultBatchJob {
+public:
+    /**
+     * @param connection_pool Workers lease their connections here, one worker per pooled connection;
+     * unused with a shard map.
+     */
+    explicit ResultBatchJob(std::shared_ptr<ConnectionPool> connection_pool);
+
+    /**
+     * @brief Lets submissions consult Club_Activity_Rollup (see ResultTable::set_activity_rollup).
+     */
+    void set_activity_rollup(bool enabled);
+
+    /**
+     * @brief Submits each shard's clubs on pooled connections of that shard (see BasicTable::set_shard_map).
+     * @param shard_map The shard map, or nullptr to run on connection_pool.
+     */
+    void set_shard_map(std::shared_ptr<ShardMap> shard_map);
+
+    /**
+     * @brief Submits the year's result of every club.
+     */
+    ResultBatchSummary run_all(int year);
+
+    /**
+     * @brief Submits the year's result of the given clubs.
+     * @param year The year to submit.
+     * @param club_ids The clubs; duplicates are submitted once.
+     */
+    ResultBatchSummary run(int year, std::span<const int> club_ids);
+
+private:
+    std::shared_ptr<ConnectionPool> pool;
+    std::shared_ptr<ShardMap> shards;
+    bool activity_rollup = false;
+};
@@ -0,0 +1,135 @@
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "../utils.h"
+#include "../workload/ServiceCall.h"
+#include "ResultTable.h"
+#include "Transaction.h"
+
+ResultTable::ResultTable(std::shared_ptr<DbConnection> conn)
+    : BasicTable("Result", conn) {}
+
+void ResultTable::set_activity_rollup(bool enabled) {
+    activity_rollup = enabled;
+}
+
+std::optional<ResultSubmission> ResultTable::submit_result(int club_id, int year) {
+    ServiceCall call("ResultTable::submit_result", club_id, year);
+    ShardScope shard = ShardScope::club(club_id);
+    try {
+        Transaction transaction(connection());
+
+        // LAST_INSERT_ID(expr) makes the existing row's ID available when the insert hits the unique key.
+        std::string result_query = "INSERT INTO Result (club_id, year) VALUES (?, ?) "
+                                   "ON DUPLICATE KEY UPDATE result_id = LAST_INSERT_ID(result_id)";
+        execute_update(result_query, {club_id, year});
+
+        int result_id = last_insert_id();
+        if (result_id <= 0)
+            return std::nullopt;
+
+        if (activity_rollup) {
+            std::string rollup_query = "SELECT activity_count FROM Club_Activity_Rollup WHERE club_id = ? AND year = ?";
+            std::unique_ptr<DbResult> rollup = execute_query(rollup_query, {club_id, year});
+            if (!rollup->next() || rollup->get_int(0) <= 0) {
+                transaction.commit();
+                Logger(ll_info, "Submitted result " + std::to_string(result_id) + " of club ID " + std::to_string(club_id) +
+                                    " for " + std::to_string(year) + ": no activities")
+                    .log();
+                return ResultSubmission{result_id, 0};
+            }
+        }
+
+        // A date range rather than YEAR(start_date) so that the (club_id, start_date) index applies.
+        std::string link_query = "INSERT IGNORE INTO Result_Activity (result_id, act_id) "
+                                 "SELECT ?, a.act_id FROM Activity AS a "
+                                 "WHERE a.club_id = ? AND a.start_date >= ? AND a.start_date < ? AND a.pending_delete = 0";
+        int linked = execute_update(link_query, {result_id, club_id, std::to_string(year) + "-01-01", std::to_string(year + 1) + "-01-01"});
+
+        transaction.commit();
+        Logger(ll_info, "Submitted result " + std::to_string(result_id) + " of club ID " + std::to_string(club_id) +
+                            " for " + std::to_string(year) + ": " + std::to_string(linked) + " activities linked")
+            .log();
+        return ResultSubmission{result_id, linked};
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in submit_result: " + std::string(e.what())).log();
+        return std::nullopt;
+    }
+}
+
+std::unique_ptr<DbResult> ResultTable::read_results_by_club(int club_id) {
+    ServiceCall call("ResultTable::read_results_by_club", club_id);
+    ShardScope shard = ShardScope::club(club_id);
+    try {
+        std::string query = activity_rollup
+            ? "SELECT r.result_id, r.club_id, r.year, COALESCE(cr.activity_count, 0) AS activities, "
+              "COALESCE(cr.gathering_count, 0) AS gatherings, COALESCE(cr.attendee_count, 0) AS attendees FROM Result AS r "
+              "LEFT JOIN Club_Activity_Rollup AS cr ON cr.club_id = r.club_id AND cr.year = r.year "
+              "WHERE r.club_id = ? ORDER BY r.year DESC"
+            : "SELECT r.result_id, r.club_id, r.year, COUNT(DISTINCT ra.act_id) AS activities, "
+              "COUNT(DISTINCT g.gathering_id) AS gatherings, COUNT(gs.student_id) AS attendees FROM Result AS r "
+              "LEFT JOIN Result_Activity AS ra ON ra.result_id = r.result_id "
+              "LEFT JOIN Gathering AS g ON g.act_id = ra.act_id "
+              "LEFT JOIN Gathering_Student AS gs ON gs.gathering_id = g.gathering_id "
+              "WHERE r.club_id = ? GROUP BY r.result_id, r.club_id, r.year ORDER BY r.year DESC";
+        std::unique_ptr<DbResult> res = execute_query(query, {club_id});
+        return res;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in read_results_by_club: " + std::string(e.what())).log();
+        return nullptr;
+    }
+}
+
+std::unique_ptr<DbResult> ResultTable::read_result_activities(int result_id) {
+    ServiceCall call("ResultTable::read_result_activities", result_id);
+    ShardScope shard = ShardScope::row("Result", "result_id", result_id);
+    try {
+        std::string query = "SELECT a.* FROM Result_Activity AS ra JOIN Activity AS a ON a.act_id = ra.act_id "
+                            "WHERE ra.result_id = ? ORDER BY a.start_date";
+        std::unique_ptr<DbResult> res = execute_query(query, {result_id});
+        return res;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in read_result_activities: " + std::string(e.what())).log();
+        return nullptr;
+    }
+}
+
+std::shared_ptr<const QueryResult> ResultTable::read_year_summary(int year, int k) {
+    ServiceCall call("ResultTable::read_year_summary", year, k);
+    try {
+        std::string query = activity_rollup
+            ? "SELECT c.club_id, c.club_name, cr.activity_count, cr.gathering_count, cr.attendee_count, r.result_id "
+              "FROM Club_Activity_Rollup AS cr JOIN Club AS c ON c.club_id = cr.club_id "
+              "LEFT JOIN Result AS r ON r.club_id = cr.club_id AND r.year = cr.year "
+              "WHERE cr.year = ? AND cr.activity_count > 0 AND c.pending_delete = 0 "
+              "ORDER BY cr.activity_count DESC LIMIT ?"
+            : "SELECT c.club_id, c.club_name, COUNT(DISTINCT a.act_id) AS activity_count, "
+              "COUNT(DISTINCT g.gathering_id) AS gathering_count, COUNT(gs.student_id) AS attendee_count, "
+              "MAX(r.result_id) AS result_id FROM Activity AS a JOIN Club AS c ON c.club_id = a.club_id "
+              "LEFT JOIN Gathering AS g ON g.act_id = a.act_id "
+              "LEFT JOIN Gathering_Student AS gs ON gs.gathering_id = g.gathering_id "
+              "LEFT JOIN Result AS r ON r.club_id = a.club_id AND r.year = YEAR(a.start_date) "
+              "WHERE YEAR(a.start_date) = ? AND a.pending_delete = 0 AND c.pending_delete = 0 "
+              "GROUP BY c.club_id, c.club_name ORDER BY activity_count DESC LIMIT ?";
+        // A club's activities live on its shard, so every shard's top k holds the overall top k.
+        return scatter_query(query, {year, k}, {{"activity_count", true}}, k < 0 ? 0 : static_cast<size_t>(k));
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in read_year_summary: " + std::string(e.what())).log();
+        return nullptr;
+    }
+}
+
+bool ResultTable::delete_result(int result_id) {
+    ServiceCall call("ResultTable::delete_result", result_id);
+    ShardScope shard = ShardScope::row("Result", "result_id", result_id);
+    if (!basic_delete({{"result_id", std::to_string(result_id)}})) {
+        Logger(ll_info, "Failed to delete result with ID: " + std::to_string(result_id)).log();
+        return false;
+    }
+    return true;
+}
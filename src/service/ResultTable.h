@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cppconn/connection.h>
+#include <cppconn/resultset.h>
+#include <memory>
+#include <optional>
+
+#include "../utils.h"
+#include "BasicTable.h"
+
+/**
+ * @brief Outcome of submitting a club's yearly result.
+ */
+struct ResultSubmission {
+    int result_id;
+
+    /**
+     * @brief Activities linked by this submission; 0 when re-run on an unchanged year.
+     */
+    int linked_activities;
+};
+
+/**
+ * @brief Represents the Result table and its Result_Activity links.
+ */
+class ResultTable : public BasicTable {
+protected:
+    /**
+     * @brief Whether Club_Activity_Rollup is maintained (db_scripts/activity_rollup.sql).
+     */
+    bool activity_rollup = false;
+
+public:
+    /**
+     * @brief Constructs a new ResultTable object with a database connection.
+     * @param conn A shared pointer to an active database connection.
+     */
+    ResultTable(std::shared_ptr<DbConnection> conn);
+
+    /**
+     * @brief Reads yearly figures from Club_Activity_Rollup instead of aggregating Activity and Gathering_Student.
+     * @param enabled True if the rollup table is installed and maintained.
+     */
+    void set_activity_rollup(bool enabled);
+
+    /**
+     * @brief Creates the club's Result row for a year, if missing, and links every activity starting in that year.
+     * Idempotent: re-running reuses the row (UNIQUE (club_id, year), see db_scripts/result_unique.sql) and
+     * only links activities added since. Runs in one transaction. With the rollup, a year without
+     * activities skips the linking statement.
+     * @param club_id The ID of the club.
+     * @param year The year to submit.
+     * @return The result ID and the number of newly linked activities, or std::nullopt if an error occurred.
+     */
+    std::optional<ResultSubmission> submit_result(int club_id, int year);
+
+    /**
+     * @brief Reads the results of a club, newest year first, with their activity, gathering and attendee counts.
+     * @param club_id The ID of the club.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
+     */
+    std::unique_ptr<DbResult> read_results_by_club(int club_id);
+
+    /**
+     * @brief Reads the activities linked to a result.
+     * @param result_id The ID of the result.
+     * @return A unique pointer to a DbResult containing the query results, or nullptr if an error occurred.
+     */
+    std::unique_ptr<DbResult> read_result_activities(int result_id);
+
+    /**
+     * @brief Reads the clubs with the most activities in a year, for the year-end overview.
+     * With the rollup this walks the (year, activity_count) index and stops after k rows.
+     * @param year The year.
+     * @param k The number of clubs.
+     * @return A shared pointer to the materialized result (club_id, club_name, activity_count, gathering_count, attendee_count,
+     * result_id), or nullptr if an error occurred. result_id is NULL for clubs without a submitted result.
+     */
+    std::shared_ptr<const QueryResult> read_year_summary(int year, int k);
+
+    /**
+     * @brief Deletes a result; its Result_Activity links go with it (ON DELETE CASCADE).
+     * @param result_id The ID of the result.
+     * @return True if the result was deleted, false otherwise.
+     */
+    bool delete_result(int result_id);
+};
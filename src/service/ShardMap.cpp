@@ -0,0 +1,204 @@
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/resultset.h>
+
+#include "../trace/Tracer.h"
+#include "../utils.h"
+#include "ShardMap.h"
+
+struct ShardMap::Shard {
+    std::string server;
+
+    /**
+     * @brief The session connection club-scoped calls run on.
+     */
+    std::shared_ptr<sql::Connection> session;
+    std::unique_ptr<ConnectionPool> pool;
+
+    std::atomic<uint64_t> routed{0};
+    std::atomic<uint64_t> scatters{0};
+    std::atomic<uint64_t> failures{0};
+};
+
+ShardMap::ShardMap(const std::vector<std::string> &servers, Factory factory, std::shared_ptr<sql::Connection> directory,
+                   ShardOptions options)
+    : directory(std::move(directory)), options(options) {
+    for (const auto &server : servers) {
+        auto shard = std::make_unique<Shard>();
+        shard->server = server;
+        shard->session = factory(server);
+        shard->pool = std::make_unique<ConnectionPool>([factory, server] { return factory(server); },
+                                                       options.connections_per_shard);
+        shards.push_back(std::move(shard));
+    }
+}
+
+ShardMap::~ShardMap() = default;
+
+const std::string &ShardMap::server(size_t shard) const {
+    return shards[shard]->server;
+}
+
+size_t ShardMap::default_shard(int club_id, size_t shard_count) {
+    // Matches auto_increment_offset = shard + 1 with auto_increment_increment = shard_count.
+    long long position = (static_cast<long long>(club_id) - 1) % static_cast<long long>(shard_count);
+    return static_cast<size_t>(position < 0 ? position + static_cast<long long>(shard_count) : position);
+}
+
+size_t ShardMap::shard_for_club(int club_id) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto cached = placements.find(club_id);
+    if (cached != placements.end() && now - cached->second.read_at < options.placement_ttl)
+        return cached->second.shard;
+
+    size_t shard = default_shard(club_id, shards.size());
+    try {
+        std::unique_ptr<sql::ResultSet> res =
+            BasicTable::execute_query(*directory, "SELECT shard_id FROM Club_Shard WHERE club_id = ?", {club_id});
+        if (res->next()) {
+            int placed = res->getInt(1);
+            if (placed >= 0 && static_cast<size_t>(placed) < shards.size())
+                shard = static_cast<size_t>(placed);
+            else
+                Logger(ll_warning, "Club " + std::to_string(club_id) + " is placed on unknown shard " +
+                                       std::to_string(placed) + "; using shard " + std::to_string(shard))
+                    .log();
+        }
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, "Error in ShardMap: " + std::string(e.what())).log();
+        return shard;
+    }
+    placements[club_id] = Placement{shard, now};
+    return shard;
+}
+
+size_t ShardMap::shard_for_row(const std::string &table, const std::string &key_column, int id) {
+    std::string key = table + "." + key_column;
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &rows = row_placements[key];
+        auto cached = rows.find(id);
+        if (cached != rows.end() && now - cached->second.read_at < options.placement_ttl)
+            return cached->second.shard;
+    }
+
+    std::vector<char> found(shards.size(), 0);
+    try {
+        std::string query = "SELECT 1 FROM " + table + " WHERE " + key_column + " = ?";
+        scatter([&](size_t shard, sql::Connection &conn) {
+            found[shard] = BasicTable::execute_query(conn, query, {id})->next() ? 1 : 0;
+        });
+    } catch (sql::SQLException &e) {
+        // A shard that failed may hold the row; the others have answered.
+        Logger(ll_error, "Error in ShardMap: " + std::string(e.what())).log();
+    }
+
+    for (size_t shard = 0; shard < shards.size(); ++shard) {
+        if (found[shard]) {
+            std::lock_guard<std::mutex> lock(mutex);
+            row_placements[key][id] = Placement{shard, now};
+            return shard;
+        }
+    }
+    return default_shard(id, shards.size());
+}
+
+size_t ShardMap::shard_for_new_club() {
+    return static_cast<size_t>(next_new_club.fetch_add(1, std::memory_order_relaxed) % shards.size());
+}
+
+bool ShardMap::place_club(int club_id, size_t shard) {
+    std::lock_guard<std::mutex> lock(mutex);
+    try {
+        BasicTable::execute_update(*directory,
+                                   "INSERT INTO Club_Shard (club_id, shard_id) VALUES (?, ?) "
+                                   "ON DUPLICATE KEY UPDATE shard_id = VALUES(shard_id)",
+                                   {club_id, static_cast<int>(shard)});
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, "Error in ShardMap: " + std::string(e.what())).log();
+        placements.erase(club_id);
+        return false;
+    }
+    placements[club_id] = Placement{shard, std::chrono::steady_clock::now()};
+    // Rows of a moved club are looked up again.
+    row_placements.clear();
+    return true;
+}
+
+std::shared_ptr<sql::Connection> ShardMap::connection(size_t shard) const {
+    return shards[shard]->session;
+}
+
+ConnectionPool::Lease ShardMap::acquire(size_t shard) {
+    return shards[shard]->pool->acquire();
+}
+
+void ShardMap::scatter(const std::function<void(size_t shard, sql::Connection &conn)> &task) {
+    std::vector<std::exception_ptr> errors(shards.size());
+    auto run = [&](size_t shard) {
+        Shard &target = *shards[shard];
+        target.scatters.fetch_add(1, std::memory_order_relaxed);
+        try {
+            ConnectionPool::Lease lease = target.pool->acquire();
+            task(shard, *lease.get());
+        } catch (sql::SQLException &e) {
+            target.failures.fetch_add(1, std::memory_order_relaxed);
+            Logger(ll_warning, "Shard " + target.server + " failed: " + std::string(e.what())).log();
+            errors[shard] = std::current_exception();
+        } catch (...) {
+            target.failures.fetch_add(1, std::memory_order_relaxed);
+            errors[shard] = std::current_exception();
+        }
+    };
+
+    // The calling thread takes the first shard itself.
+    std::vector<std::thread> workers;
+    workers.reserve(shards.size());
+    for (size_t shard = 1; shard < shards.size(); ++shard)
+        workers.emplace_back(run, shard);
+    if (!shards.empty())
+        run(0);
+    for (auto &worker : workers)
+        worker.join();
+
+    for (const auto &error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+
+std::shared_ptr<const QueryResult> ShardMap::scatter_query(const std::string &query, const std::vector<SqlParam> &params,
+                                                           const std::vector<QueryResult::SortKey> &order, size_t limit) {
+    TraceSpan span("table", "ShardMap::scatter_query", query);
+    std::vector<std::shared_ptr<const QueryResult>> parts(shards.size());
+    scatter([&](size_t shard, sql::Connection &conn) {
+        std::unique_ptr<sql::ResultSet> res = BasicTable::execute_query(conn, query, params);
+        parts[shard] = QueryResult::from_result_set(*res);
+    });
+    return QueryResult::merge(parts, order, limit);
+}
+
+void ShardMap::note_routed(size_t shard) {
+    shards[shard]->routed.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<ShardMap::ShardStatus> ShardMap::status() const {
+    std::vector<ShardStatus> result;
+    for (const auto &shard : shards) {
+        result.push_back({shard->server, shard->routed.load(std::memory_order_relaxed),
+                          shard->scatters.load(std::memory_order_relaxed),
+                          shard->failures.load(std::memory_order_relaxed)});
+    }
+    return result;
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cppconn/connection.h>
+
+#include "BasicTable.h"
+#include "ConnectionPool.h"
+#include "QueryResult.h"
+
+/**
+ * @brief How ShardMap places clubs and runs cross-shard reads.
+ */
+struct ShardOptions {
+    /**
+     * @brief Connections opened per shard for cross-shard reads and batch jobs, i.e. how many run on one shard at once.
+     */
+    size_t connections_per_shard = 2;
+
+    /**
+     * @brief How long a club's placement read from the directory is used before it is read again,
+     * so that a club moved by tools/shard_rebalance is followed by running processes.
+     */
+    std::chrono::milliseconds placement_ttl{5000};
+};
+
+/**
+ * @brief Splits the club-owned tables over several databases (shards) by club_id.
+ *
+ * Every shard holds the full schema. A club and everything hanging off it (Location, Result,
+ * Activity, Gathering, Club_Student, Gathering_Student, ...) live on one shard; Student,
+ * Professor and Equipment are written to the directory database and replicated to every
+ * shard by MySQL replication, so the joins of the service layer stay local to one shard.
+ *
+ * The directory database keeps Club_Shard (db_scripts/shard_directory.sql), which records
+ * where a club lives. A club without a row is on default_shard(club_id), which is also where
+ * its ID came from if every shard sets auto_increment_increment to the number of shards and
+ * auto_increment_offset to its position plus one; those settings keep IDs unique across shards.
+ *
+ * BasicTable routes the statements of a club-scoped call to the club's shard (see
+ * BasicTable::ShardScope); cross-shard reads run on every shard in parallel and are merged.
+ */
+class ShardMap {
+public:
+    using Factory = std::function<std::shared_ptr<sql::Connection>(const std::string &server)>;
+
+    /**
+     * @brief Traffic of one shard.
+     */
+    struct ShardStatus {
+        std::string server;
+
+        /**
+         * @brief Club-scoped calls routed to the shard.
+         */
+        uint64_t routed;
+
+        /**
+         * @brief Cross-shard reads the shard took part in.
+         */
+        uint64_t scatters;
+        uint64_t failures;
+    };
+
+    /**
+     * @brief Connects to every shard.
+     * @param servers Shard addresses as "host:port"; a shard's number is its position here.
+     * @param factory Opens a connection to a shard.
+     * @param directory A connection to the database holding Club_Shard, used only by this object.
+     * @param options Placement and scatter options.
+     * @throws sql::SQLException if a shard cannot be reached.
+     */
+    ShardMap(const std::vector<std::string> &servers, Factory factory, std::shared_ptr<sql::Connection> directory,
+             ShardOptions options = {});
+    ~ShardMap();
+
+    ShardMap(const ShardMap &) = delete;
+    ShardMap &operator=(const ShardMap &) = delete;
+
+    /**
+     * @brief Returns the number of shards.
+     */
+    size_t size() const { return shards.size(); }
+
+    /**
+     * @brief Returns the address of a shard.
+     */
+    const std::string &server(size_t shard) const;
+
+    /**
+     * @brief Returns how many pooled connections each shard has (ShardOptions::connections_per_shard).
+     */
+    size_t connections_per_shard() const { return options.connections_per_shard; }
+
+    /**
+     * @brief Returns where a club without a directory row lives.
+     */
+    static size_t default_shard(int club_id, size_t shard_count);
+
+    /**
+     * @brief Returns the shard holding a club, from the directory (cached for placement_ttl).
+     * If the directory cannot be read, the error is logged and default_shard is used.
+     */
+    size_t shard_for_club(int club_id);
+
+    /**
+     * @brief Returns the shard holding a row of a club-owned table, e.g. a Gathering by gathering_id,
+     * by asking every shard in parallel (cached for placement_ttl). A row found nowhere maps to
+     * default_shard(id), where the statement then finds nothing.
+     * @param table The table.
+     * @param key_column Its integer primary key.
+     * @param id The key.
+     */
+    size_t shard_for_row(const std::string &table, const std::string &key_column, int id);
+
+    /**
+     * @brief Returns the shard to create the next club on; shards take turns.
+     */
+    size_t shard_for_new_club();
+
+    /**
+     * @brief Records in the directory that a club lives on a shard, e.g. after creating or moving it.
+     * @return True on success, false if the directory could not be written.
+     */
+    bool place_club(int club_id, size_t shard);
+
+    /**
+     * @brief Returns the session connection of a shard, on which club-scoped calls run.
+     * It is shared like the connection the tables are constructed with.
+     */
+    std::shared_ptr<sql::Connection> connection(size_t shard) const;
+
+    /**
+     * @brief Leases a pooled connection of a shard, e.g. for a worker thread running club-scoped
+     * calls of its own (see BasicTable::ShardScope::session).
+     * @throws sql::SQLException if a new connection cannot be opened.
+     */
+    ConnectionPool::Lease acquire(size_t shard);
+
+    /**
+     * @brief Runs a task on every shard in parallel, each on a pooled connection of its shard.
+     * Every task runs to completion even if another fails.
+     * @param task Called with the shard number and its connection; may throw sql::SQLException.
+     * @throws sql::SQLException the first failure, once every task has finished.
+     */
+    void scatter(const std::function<void(size_t shard, sql::Connection &conn)> &task);
+
+    /**
+     * @brief Runs a read on every shard in parallel and merges the results (see QueryResult::merge).
+     * @param query The SQL statement with '?' placeholders; a top-k query keeps its LIMIT per shard.
+     * @param params Values for the placeholders.
+     * @param order Columns to sort the merged rows by.
+     * @param limit Keeps at most this many merged rows.
+     * @return The merged result; never nullptr.
+     * @throws sql::SQLException if the read failed on any shard.
+     */
+    std::shared_ptr<const QueryResult> scatter_query(const std::string &query, const std::vector<SqlParam> &params,
+                                                     const std::vector<QueryResult::SortKey> &order = {},
+                                                     size_t limit = SIZE_MAX);
+
+    /**
+     * @brief Counts a club-scoped call routed to a shard.
+     */
+    void note_routed(size_t shard);
+
+    /**
+     * @brief Returns the traffic of every shard.
+     */
+    std::vector<ShardStatus> status() const;
+
+private:
+    struct Shard;
+
+    struct Placement {
+        size_t shard;
+        std::chrono::steady_clock::time_point read_at;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::shared_ptr<sql::Connection> directory;
+    ShardOptions options;
+
+    /**
+     * @brief Guards directory, placements and row_placements.
+     */
+    std::mutex mutex;
+    std::unordered_map<int, Placement> placements;
+
+    /**
+     * @brief Shards of rows found by shard_for_row, keyed by "table.key_column" and ID; like
+     * placements they are asked again after placement_ttl.
+     */
+    std::unordered_map<std::string, std::unordered_map<int, Placement>> row_placements;
+
+    std::atomic<uint64_t> next_new_club{0};
+};
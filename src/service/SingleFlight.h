@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @brief Counters describing how many calls a SingleFlight group saved.
+ */
+struct SingleFlightStats {
+    /**
+     * @brief Number of calls that actually ran the underlying function.
+     */
+    uint64_t executed = 0;
+
+    /**
+     * @brief Number of calls that joined an in-flight call instead of running their own.
+     */
+    uint64_t coalesced = 0;
+};
+
+/**
+ * @brief Deduplicates concurrent calls that share the same key.
+ *
+ * The first caller for a key (the leader) runs the function. Every caller that arrives
+ * while the leader is still running waits for it and receives the same shared value.
+ * Once the leader finishes the key is forgotten, so later calls run again.
+ *
+ * @tparam Key Hashable key identifying identical calls.
+ * @tparam Value Type of the shared result.
+ */
+template <typename Key, typename Value>
+class SingleFlight {
+public:
+    using Result = std::shared_ptr<const Value>;
+
+    /**
+     * @brief Runs fn for key, or waits for an identical in-flight call.
+     * @param key The key identifying the call.
+     * @param fn Callable returning Result. Exceptions are rethrown to every waiting caller.
+     * @return The result shared by all callers of this flight.
+     */
+    template <typename Fn>
+    Result run(const Key &key, Fn &&fn) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto it = in_flight.find(key);
+        if (it != in_flight.end()) {
+            std::shared_future<Result> future = it->second;
+            lock.unlock();
+            coalesced_count.fetch_add(1, std::memory_order_relaxed);
+            return future.get();
+        }
+
+        std::promise<Result> promise;
+        in_flight.emplace(key, promise.get_future().share());
+        lock.unlock();
+        executed_count.fetch_add(1, std::memory_order_relaxed);
+
+        Result result;
+        std::exception_ptr error;
+        try {
+            result = fn();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        in_flight.erase(key);
+        lock.unlock();
+
+        if (error) {
+            promise.set_exception(error);
+            std::rethrow_exception(error);
+        }
+        promise.set_value(result);
+        return result;
+    }
+
+    /**
+     * @brief Returns a snapshot of the executed/coalesced counters.
+     */
+    SingleFlightStats stats() const {
+        return {executed_count.load(std::memory_order_relaxed), coalesced_count.load(std::memory_order_relaxed)};
+    }
+
+private:
+    /**
+     * @brief Guards in_flight.
+     */
+    std::mutex mutex;
+
+    /**
+     * @brief Futures of calls that are currently running, by key.
+     */
+    std::unordered_map<Key, std::shared_future<Result>> in_flight;
+
+    std::atomic<uint64_t> executed_count{0};
+    std::atomic<uint64_t> coalesced_count{0};
+};
@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cppconn/exception.h>
+#include <cppconn/resultset.h>
+
+#include "../trace/Tracer.h"
+#include "../utils.h"
+#include "SlowQueryLog.h"
+
+/**
+ * @brief Replaces the characters that separate fields and records of the log.
+ */
+static std::string one_line(const std::string &text) {
+    std::string out = text;
+    for (char &c : out) {
+        if (c == '\t' || c == '\n' || c == '\r')
+            c = ' ';
+    }
+    return out;
+}
+
+static std::string format_param(const SqlParam &param) {
+    if (const int *value = std::get_if<int>(&param))
+        return std::to_string(*value);
+    if (const double *value = std::get_if<double>(&param)) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.17g", *value);
+        return buffer;
+    }
+    return one_line(std::get<std::string>(param));
+}
+
+/**
+ * @brief Whether the server can EXPLAIN the statement.
+ */
+static bool explainable(const std::string &sql) {
+    size_t start = sql.find_first_not_of(" \t\r\n(");
+    if (start == std::string::npos)
+        return false;
+    std::string verb;
+    for (size_t i = start; i < sql.size() && std::isalpha(static_cast<unsigned char>(sql[i])); ++i)
+        verb += static_cast<char>(std::toupper(static_cast<unsigned char>(sql[i])));
+    return verb == "SELECT" || verb == "WITH" || verb == "INSERT" || verb == "REPLACE" || verb == "UPDATE" ||
+           verb == "DELETE";
+}
+
+SlowQueryLog::SlowQueryLog(std::shared_ptr<sql::Connection> conn, std::string path, SlowQueryOptions options)
+    : con(conn), path(std::move(path)), options(options) {
+    worker = std::thread(&SlowQueryLog::run, this);
+}
+
+SlowQueryLog::~SlowQueryLog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+
+    SlowQueryStats s = stats();
+    Logger(ll_info, "SlowQueryLog: " + std::to_string(s.recorded) + " slow statements recorded, " +
+                        std::to_string(s.dropped) + " dropped")
+        .log();
+}
+
+void SlowQueryLog::observe(const std::string &sql, const std::vector<SqlParam> &params, std::chrono::microseconds elapsed,
+                           uint64_t rows) {
+    // The EXPLAINs of the worker go through BasicTable too; they are never recorded themselves.
+    if (elapsed < options.threshold || std::this_thread::get_id() == worker.get_id())
+        return;
+
+    const char *caller = TraceSpan::enclosing("service");
+    Record record{std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count(),
+                  static_cast<double>(elapsed.count()) / 1000.0,
+                  rows,
+                  caller ? caller : "-",
+                  sql,
+                  params};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.size() >= options.max_pending) {
+            counters.dropped++;
+            return;
+        }
+        pending.push_back(std::move(record));
+    }
+    wake.notify_one();
+}
+
+SlowQueryStats SlowQueryLog::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+void SlowQueryLog::run() {
+    Tracer::set_thread_name("slow-query-log");
+    while (true) {
+        Record record;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty())
+                return;
+            record = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        std::string plan = explain(record);
+
+        char ms[32];
+        std::snprintf(ms, sizeof(ms), "%.3f", record.ms);
+        std::string params;
+        for (const auto &param : record.params) {
+            if (!params.empty())
+                params += '\x1f';
+            params += format_param(param);
+        }
+        append(std::to_string(record.unix_time) + '\t' + ms + '\t' + std::to_string(record.rows) + '\t' + record.caller +
+               '\t' + one_line(record.sql) + '\t' + params + '\t' + plan + '\n');
+    }
+}
+
+std::string SlowQueryLog::explain(const Record &record) {
+    if (!explainable(record.sql))
+        return "-";
+    try {
+        std::unique_ptr<sql::ResultSet> res = BasicTable::execute_query(*con, "EXPLAIN " + record.sql, record.params);
+        std::string plan;
+        bool filesort = false, temporary = false;
+        while (res->next()) {
+            if (!plan.empty())
+                plan += ',';
+            plan += res->isNull("table") ? "-" : res->getString("table");
+            plan += ':';
+            plan += res->isNull("type") ? "-" : res->getString("type");
+            plan += ':';
+            plan += res->isNull("key") ? "-" : res->getString("key");
+            plan += ':';
+            plan += res->isNull("rows") ? "-" : res->getString("rows");
+
+            std::string extra = res->isNull("Extra") ? "" : res->getString("Extra");
+            filesort = filesort || extra.find("filesort") != std::string::npos;
+            temporary = temporary || extra.find("temporary") != std::string::npos;
+        }
+        if (filesort)
+            plan += ",filesort";
+        if (temporary)
+            plan += ",temporary";
+        return plan.empty() ? "-" : one_line(plan);
+    } catch (sql::SQLException &e) {
+        Logger(ll_warning, "SlowQueryLog: EXPLAIN failed: " + std::string(e.what())).log();
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.explain_failures++;
+        return "-";
+    }
+}
+
+void SlowQueryLog::append(const std::string &line) {
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(path, error);
+    bool rotated = false;
+    if (!error && size + line.size() > options.max_file_bytes) {
+        if (options.max_rotated_files > 0) {
+            std::filesystem::remove(path + "." + std::to_string(options.max_rotated_files), error);
+            for (int i = options.max_rotated_files - 1; i >= 1; --i)
+                std::filesystem::rename(path + "." + std::to_string(i), path + "." + std::to_string(i + 1), error);
+            std::filesystem::rename(path, path + ".1", error);
+        } else {
+            std::filesystem::remove(path, error);
+        }
+        rotated = true;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    bool written = file && file.write(line.data(), static_cast<std::streamsize>(line.size()));
+    if (!written)
+        Logger(ll_error, "SlowQueryLog: failed to write " + path).log();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (written)
+        counters.recorded++;
+    if (rotated)
+        counters.rotations++;
+}
+
+std::vector<SlowQueryOffender> SlowQueryLog::summarize(const std::string &path, size_t limit) {
+    std::map<std::string, SlowQueryOffender> by_sql;
+    std::map<std::string, int64_t> latest;
+
+    std::vector<std::string> files = {path};
+    for (int i = 1; std::filesystem::exists(path + "." + std::to_string(i)); ++i)
+        files.push_back(path + "." + std::to_string(i));
+
+    for (const auto &name : files) {
+        std::ifstream file(name);
+        std::string line;
+        while (std::getline(file, line)) {
+            std::vector<std::string> fields;
+            size_t start = 0;
+            while (fields.size() < 6) {
+                size_t tab = line.find('\t', start);
+                if (tab == std::string::npos)
+                    break;
+                fields.push_back(line.substr(start, tab - start));
+                start = tab + 1;
+            }
+            if (fields.size() != 6)
+                continue;
+            fields.push_back(line.substr(start));
+
+            int64_t unix_time = std::atoll(fields[0].c_str());
+            double ms = std::atof(fields[1].c_str());
+            SlowQueryOffender &offender = by_sql[fields[4]];
+            offender.sql = fields[4];
+            offender.count++;
+            offender.total_ms += ms;
+            offender.max_ms = std::max(offender.max_ms, ms);
+            offender.rows += std::strtoull(fields[2].c_str(), nullptr, 10);
+
+            auto [it, inserted] = latest.try_emplace(fields[4], unix_time);
+            if (inserted || unix_time >= it->second) {
+                it->second = unix_time;
+                offender.caller = fields[3];
+                offender.plan = fields[6];
+            }
+        }
+    }
+
+    std::vector<SlowQueryOffender> ranked;
+    ranked.reserve(by_sql.size());
+    for (auto &[sql, offender] : by_sql)
+        ranked.push_back(std::move(offender));
+    std::sort(ranked.begin(), ranked.end(),
+              [](const SlowQueryOffender &a, const SlowQueryOffender &b) { return a.total_ms > b.total_ms; });
+    if (ranked.size() > limit)
+        ranked.resize(limit);
+    return ranked;
+}
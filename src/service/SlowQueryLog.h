@@ -0,0 +1,158 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cppconn/connection.h>
+
+#include "BasicTable.h"
+
+/**
+ * @brief Tuning knobs for SlowQueryLog.
+ */
+struct SlowQueryOptions {
+    /**
+     * @brief Statements taking at least this long are recorded.
+     */
+    std::chrono::microseconds threshold{std::chrono::milliseconds(100)};
+
+    /**
+     * @brief The log file is rotated to "<path>.1" once it grows past this size.
+     */
+    size_t max_file_bytes = 4 << 20;
+
+    /**
+     * @brief Rotated files kept besides the current one ("<path>.1" is the newest).
+     */
+    int max_rotated_files = 3;
+
+    /**
+     * @brief Records waiting for their EXPLAIN; further slow statements are counted and dropped.
+     */
+    size_t max_pending = 256;
+};
+
+/**
+ * @brief Counters exposed by SlowQueryLog.
+ */
+struct SlowQueryStats {
+    uint64_t recorded = 0;
+    uint64_t dropped = 0;
+    uint64_t explain_failures = 0;
+    uint64_t rotations = 0;
+};
+
+/**
+ * @brief What the summary knows about one statement.
+ */
+struct SlowQueryOffender {
+    std::string sql;
+
+    /**
+     * @brief The service method of the latest occurrence.
+     */
+    std::string caller;
+
+    /**
+     * @brief The plan of the latest occurrence.
+     */
+    std::string plan;
+
+    uint64_t count = 0;
+    double total_ms = 0;
+    double max_ms = 0;
+    uint64_t rows = 0;
+};
+
+/**
+ * @brief Records statements that ran longer than a threshold.
+ *
+ * BasicTable::execute_query/execute_update report every statement. Those over the threshold
+ * are queued with their parameters, row count and the enclosing service method (the innermost
+ * "service" TraceSpan); a background thread EXPLAINs them on its own connection and appends one
+ * line per statement to a size-rotated file:
+ *
+ *     <unix time>\t<ms>\t<rows>\t<caller>\t<sql>\t<params>\t<plan>
+ *
+ * Parameters are separated by 0x1f, and the plan lists each table as "table:type:key:rows"
+ * followed by "filesort"/"temporary" if the server needs them.
+ */
+class SlowQueryLog {
+public:
+    /**
+     * @brief Starts the EXPLAIN thread.
+     * @param conn A connection used only by this log.
+     * @param path The log file; rotated files get ".1", ".2", ... appended.
+     * @param options Threshold and rotation.
+     */
+    SlowQueryLog(std::shared_ptr<sql::Connection> conn, std::string path, SlowQueryOptions options = {});
+
+    /**
+     * @brief Writes what is queued and stops the EXPLAIN thread.
+     */
+    ~SlowQueryLog();
+
+    SlowQueryLog(const SlowQueryLog &) = delete;
+    SlowQueryLog &operator=(const SlowQueryLog &) = delete;
+
+    /**
+     * @brief Called after every statement; queues it if it ran longer than the threshold.
+     * @param sql The statement text.
+     * @param params Its bound parameters.
+     * @param elapsed Time spent preparing and executing it.
+     * @param rows Rows returned by a read or affected by a write.
+     */
+    void observe(const std::string &sql, const std::vector<SqlParam> &params, std::chrono::microseconds elapsed, uint64_t rows);
+
+    /**
+     * @brief Returns a snapshot of the counters.
+     */
+    SlowQueryStats stats() const;
+
+    /**
+     * @brief The log file this instance appends to.
+     */
+    const std::string &file() const {
+        return path;
+    }
+
+    /**
+     * @brief Reads a log and its rotated files and ranks statements by total time.
+     * @param path The log file as passed to the constructor.
+     * @param limit At most this many offenders are returned.
+     * @return The offenders, slowest in total first; empty if nothing could be read.
+     */
+    static std::vector<SlowQueryOffender> summarize(const std::string &path, size_t limit = 10);
+
+private:
+    struct Record {
+        int64_t unix_time;
+        double ms;
+        uint64_t rows;
+        std::string caller;
+        std::string sql;
+        std::vector<SqlParam> params;
+    };
+
+    void run();
+    std::string explain(const Record &record);
+    void append(const std::string &line);
+
+    std::shared_ptr<sql::Connection> con;
+    std::string path;
+    SlowQueryOptions options;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Record> pending;
+    bool stopping = false;
+
+    SlowQueryStats counters;
+    std::thread worker;
+};
@@ -2,17 +2,34 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
+#include <cppconn/exception.h>
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
 
 #include "BasicTable.h"
 #include "../utils.h"
+#include "../workload/ServiceCall.h"
 #include "StudentTable.h"
+#include "Transaction.h"
 
-StudentTable::StudentTable(std::shared_ptr<sql::Connection> conn)
+StudentTable::StudentTable(std::shared_ptr<DbConnection> conn)
         : BasicTable("Student", conn) {}
 
+void StudentTable::set_name_index(std::shared_ptr<TrigramIndex> index) {
+    name_index = index;
+}
+
+void StudentTable::set_club_counters(bool enabled) {
+    club_counters = enabled;
+}
+
+void StudentTable::set_activity_rollup(bool enabled) {
+    activity_rollup = enabled;
+}
+
 bool StudentTable::create_student(const std::string &name, const std::string &department) {
+    ServiceCall call("StudentTable::create_student", name, department);
     std::map<std::string, std::string> attributes;
     attributes["name"] = name;
     attributes["department"] = department;
@@ -20,20 +37,34 @@ bool StudentTable::create_student(const std::string &name, const std::string &de
         Logger(ll_info, "Failed to insert student record: name=" + name + ", department=" + department).log();
         return false;
     }
+    if (name_index) {
+        int student_id = last_insert_id();
+        if (student_id > 0)
+            name_index->upsert(student_id, name);
+    }
     return true;
 }
 
-std::unique_ptr<sql::ResultSet> StudentTable::read_student_by_field(const std::string &field, const std::string &value) {
+std::unique_ptr<DbResult> StudentTable::read_student_by_field(const std::string &field, const std::string &value) {
+    ServiceCall call("StudentTable::read_student_by_field", field, value);
+    if (field == "name" && name_index && name_index->ready() && TrigramIndex::covers(value)) {
+        std::vector<int> ids = name_index->search(value);
+        if (ids.size() <= TrigramIndex::max_selective_matches)
+            return select_by_ids("student_id", ids);
+    }
+
     std::map<std::string, std::string> conditions;
     conditions[field] = value;
     return basic_string_select(conditions);
 }
 
-std::unique_ptr<sql::ResultSet> StudentTable::read_all_student() {
+std::unique_ptr<DbResult> StudentTable::read_all_student() {
+    ServiceCall call("StudentTable::read_all_student");
     return basic_select_all();
 }
 
 bool StudentTable::update_student_name(int student_id, const std::string &new_name) {
+    ServiceCall call("StudentTable::update_student_name", student_id, new_name);
     std::map<std::string, std::string> conditions;
     conditions["student_id"] = std::to_string(student_id);
 
@@ -44,15 +75,49 @@ bool StudentTable::update_student_name(int student_id, const std::string &new_na
         Logger(ll_info, "Failed to update student record: id=" + std::to_string(student_id)).log();
         return false;
     }
+    if (name_index)
+        name_index->upsert(student_id, new_name);
     return true;
 }
 
 bool StudentTable::delete_student_by_id(int student_id) {
+    ServiceCall call("StudentTable::delete_student_by_id", student_id);
+    if (club_counters || activity_rollup) {
+        try {
+            Transaction transaction(con);
+
+            if (club_counters) {
+                std::string counter_query = "UPDATE Club AS c JOIN Club_Student AS cs ON cs.club_id = c.club_id "
+                                            "SET c.member_count = c.member_count - 1 WHERE cs.student_id = ?";
+                execute_update(counter_query, {student_id});
+            }
+            if (activity_rollup)
+                ActivityRollup::remove_student(con, student_id);
+
+            std::string delete_query = "DELETE FROM Student WHERE student_id = ?";
+            int deleted = execute_update(delete_query, {student_id});
+
+            if (deleted != 1) {
+                Logger(ll_info, "Failed to delete student record: id=" + std::to_string(student_id)).log();
+                return false;
+            }
+            transaction.commit();
+        } catch (const sql::SQLException &e) {
+            Logger(ll_error, "SQL error in delete_student_by_id: " + std::string(e.what())).log();
+            return false;
+        }
+        if (name_index)
+            name_index->erase(student_id);
+        return true;
+    }
+
     std::map<std::string, std::string> conditions;
     conditions["student_id"] = std::to_string(student_id);
     if (!basic_delete(conditions)) {
         Logger(ll_info, "Failed to delete student record: id=" + std::to_string(student_id)).log();
         return false;
     }
+    if (name_index)
+        name_index->erase(student_id);
     return true;
 }
\ No newline at end of file
@@ -7,19 +7,57 @@
 #include <cppconn/prepared_statement.h>
 #include <cppconn/resultset.h>
 
+#include "ActivityRollup.h"
 #include "BasicTable.h"
+#include "../index/TrigramIndex.h"
 #include "../utils.h"
 
 /**
  * @brief Represents the student table with specific CRUD operations.
  */
 class StudentTable : public BasicTable {
+protected:
+    /**
+     * @brief Optional substring index over Student.name. Null means searches use LIKE.
+     */
+    std::shared_ptr<TrigramIndex> name_index;
+
+    /**
+     * @brief Whether Club.member_count is maintained (db_scripts/club_counters.sql).
+     */
+    bool club_counters = false;
+
+    /**
+     * @brief Whether Club_Activity_Rollup is maintained (db_scripts/activity_rollup.sql).
+     */
+    bool activity_rollup = false;
+
 public:
     /**
      * @brief Constructs a new StudentTable object.
      * @param conn A shared pointer to an active database connection.
      */
-    StudentTable(std::shared_ptr<sql::Connection> conn);
+    StudentTable(std::shared_ptr<DbConnection> conn);
+
+    /**
+     * @brief Serves name searches from a trigram index and keeps it current on writes.
+     * @param index An index over Student.name, or nullptr to search with LIKE again.
+     */
+    void set_name_index(std::shared_ptr<TrigramIndex> index);
+
+    /**
+     * @brief Makes delete_student_by_id decrement Club.member_count of the student's clubs.
+     * The Club_Student rows go by ON DELETE CASCADE, which does not fire the counter triggers.
+     * @param enabled True if the counter columns and triggers are installed.
+     */
+    void set_club_counters(bool enabled);
+
+    /**
+     * @brief Makes delete_student_by_id subtract the student's attendances from Club_Activity_Rollup.
+     * The Gathering_Student rows go by ON DELETE CASCADE, so no other write path sees them.
+     * @param enabled True if the rollup table is installed.
+     */
+    void set_activity_rollup(bool enabled);
 
     /**
      * @brief Creates a new student record.
@@ -33,17 +71,17 @@ public:
      * @brief Reads a student record based on a specific field and value.
      * @param field The field to search by (e.g., student_id, name, department).
      * @param value The value to search for.
-     * @return A unique pointer to a ResultSet containing the matching students' column names to their values, or nullptr if an error occurred.
+     * @return A unique pointer to a DbResult containing the matching students' column names to their values, or nullptr if an error occurred.
      * @retval nullptr An error occurred.
      */
-    std::unique_ptr<sql::ResultSet>  read_student_by_field(const std::string &field, const std::string &value);
+    std::unique_ptr<DbResult>  read_student_by_field(const std::string &field, const std::string &value);
 
     /**
      * @brief Reads all student record.
-     * @return A unique pointer to a ResultSet containing all students records, or nullptr if an error occurred.
+     * @return A unique pointer to a DbResult containing all students records, or nullptr if an error occurred.
      * @retval nullptr An error occurred.
      */
-    std::unique_ptr<sql::ResultSet> read_all_student();
+    std::unique_ptr<DbResult> read_all_student();
 
     /**
      * @brief Updates a student's name based on their ID.
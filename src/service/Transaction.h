@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+
+#include "BasicTable.h"
+
+/**
+ * @brief RAII scope for an explicit transaction on a connection.
+ *
+ * Turns autocommit off on construction. Unless commit() was called, the
+ * transaction is rolled back when the scope ends. Autocommit is restored either way.
+ */
+class Transaction {
+private:
+    std::shared_ptr<sql::Connection> con;
+    bool committed = false;
+
+public:
+    /**
+     * @brief Begins a transaction.
+     * @param conn The connection to run the transaction on.
+     */
+    explicit Transaction(std::shared_ptr<sql::Connection> conn) : con(conn) {
+        con->setAutoCommit(false);
+    }
+
+    Transaction(const Transaction &) = delete;
+    Transaction &operator=(const Transaction &) = delete;
+
+    /**
+     * @brief Commits the transaction.
+     */
+    void commit() {
+        con->commit();
+        committed = true;
+        BasicTable::note_write();
+    }
+
+    ~Transaction() {
+        try {
+            if (!committed)
+                con->rollback();
+            con->setAutoCommit(true);
+        } catch (sql::SQLException &) {
+            // The connection is unusable anyway; nothing sensible to do in a destructor.
+        }
+    }
+};
@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+
+#include "../utils.h"
+#include "Transaction.h"
+#include "WriteBehindQueue.h"
+
+/**
+ * @brief Upper bound of (a, b) tuples per generated statement.
+ */
+static constexpr size_t max_tuples_per_statement = 500;
+
+WriteBehindQueue::WriteBehindQueue(std::shared_ptr<sql::Connection> conn, WriteBehindOptions options)
+    : con(conn), options(options) {
+    pending_done = std::make_shared<std::promise<std::shared_ptr<const Outcome>>>();
+    pending_future = pending_done->get_future().share();
+    worker = std::thread(&WriteBehindQueue::run, this);
+}
+
+WriteBehindQueue::~WriteBehindQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+
+    WriteBehindStats s = stats();
+    Logger(ll_info, "WriteBehindQueue: " + std::to_string(s.flushes) + " flushes, " +
+                        std::to_string(s.rows_written) + " rows, " + std::to_string(s.cancelled) + " cancelled")
+        .log();
+}
+
+bool WriteBehindQueue::add(MembershipKind kind, int owner_id, int student_id) {
+    return enqueue(kind, owner_id, student_id, true);
+}
+
+bool WriteBehindQueue::remove(MembershipKind kind, int owner_id, int student_id) {
+    return enqueue(kind, owner_id, student_id, false);
+}
+
+bool WriteBehindQueue::enqueue(MembershipKind kind, int owner_id, int student_id, bool insert) {
+    Key key{kind, owner_id, student_id};
+    uint64_t ticket;
+    std::shared_future<std::shared_ptr<const Outcome>> future;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.enqueued++;
+
+        if (pending.empty())
+            oldest_pending = std::chrono::steady_clock::now();
+
+        ticket = next_ticket++;
+        auto [it, inserted] = pending.try_emplace(key, Mutation{insert, ticket});
+        if (!inserted) {
+            // INSERT IGNORE and DELETE are idempotent, so only the last intent per key matters. A duplicate
+            // keeps the first caller's ticket: only that caller is told the row was written.
+            if (it->second.insert == insert) {
+                counters.duplicates++;
+            } else {
+                it->second = Mutation{insert, ticket};
+                counters.cancelled++;
+            }
+        }
+
+        future = pending_future;
+    }
+
+    // The worker wakes on its own when the delay expires; only the size trigger needs a nudge.
+    wake.notify_one();
+
+    if (options.durability == WriteDurability::fire_and_forget)
+        return true;
+    std::shared_ptr<const Outcome> outcome = future.get();
+    auto written = outcome->written.find(key);
+    return outcome->committed && written != outcome->written.end() && written->second == ticket;
+}
+
+bool WriteBehindQueue::flush() {
+    std::shared_future<std::shared_ptr<const Outcome>> future;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.empty())
+            return true;
+        flush_requested = true;
+        future = pending_future;
+    }
+    wake.notify_one();
+    return future.get()->committed;
+}
+
+void WriteBehindQueue::set_listener(MembershipKind kind, Listener listener) {
+    std::lock_guard<std::mutex> lock(listener_mutex);
+    if (listener)
+        listeners[kind] = std::move(listener);
+    else
+        listeners.erase(kind);
+}
+
+WriteBehindStats WriteBehindQueue::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+WriteBehindQueue::Batch WriteBehindQueue::take_batch() {
+    Batch batch;
+    batch.mutations.swap(pending);
+    batch.done = pending_done;
+    pending_done = std::make_shared<std::promise<std::shared_ptr<const Outcome>>>();
+    pending_future = pending_done->get_future().share();
+    flush_requested = false;
+    return batch;
+}
+
+void WriteBehindQueue::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (pending.empty()) {
+            if (stopping)
+                break;
+            wake.wait(lock);
+            continue;
+        }
+
+        auto deadline = oldest_pending + options.max_delay;
+        bool due = stopping || flush_requested || pending.size() >= options.max_batch ||
+                   std::chrono::steady_clock::now() >= deadline;
+        if (!due) {
+            wake.wait_until(lock, deadline);
+            continue;
+        }
+
+        Batch batch = take_batch();
+        lock.unlock();
+
+        auto started = std::chrono::steady_clock::now();
+        auto outcome = std::make_shared<Outcome>();
+        outcome->committed = write_batch(batch.mutations, outcome->written);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+        if (outcome->committed)
+            notify_listeners(batch.mutations, outcome->written);
+
+        lock.lock();
+        uint64_t batch_size = batch.mutations.size();
+        uint64_t flush_us = static_cast<uint64_t>(elapsed.count());
+        counters.flushes++;
+        counters.last_batch_size = batch_size;
+        counters.max_batch_size = std::max(counters.max_batch_size, batch_size);
+        counters.total_flush_us += flush_us;
+        counters.max_flush_us = std::max(counters.max_flush_us, flush_us);
+        if (outcome->committed) {
+            counters.rows_written += outcome->written.size();
+        } else {
+            counters.failed_flushes++;
+        }
+        batch.done->set_value(outcome);
+    }
+}
+
+/**
+ * @brief Returns table and column names for a membership kind.
+ */
+static void membership_table(MembershipKind kind, std::string &table, std::string &owner_column) {
+    if (kind == MembershipKind::club_student) {
+        table = "Club_Student";
+        owner_column = "club_id";
+    } else {
+        table = "Gathering_Student";
+        owner_column = "gathering_id";
+    }
+}
+
+/**
+ * @brief Appends "(?, ?), (?, ?), ..." for tuples [begin, end).
+ */
+static void append_tuple_list(std::string &query, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        if (i != begin) query += ", ";
+        query += "(?, ?)";
+    }
+}
+
+static void bind_tuples(sql::PreparedStatement &pstmt, const std::vector<std::pair<int, int>> &tuples, size_t begin, size_t end) {
+    unsigned int index = 1;
+    for (size_t i = begin; i < end; ++i) {
+        pstmt.setInt(index++, tuples[i].first);
+        pstmt.setInt(index++, tuples[i].second);
+    }
+}
+
+/**
+ * @brief Returns which of tuples [begin, end) the transaction currently sees in the table.
+ */
+static std::set<std::pair<int, int>> select_present(sql::Connection &conn, const std::string &table, const std::string &owner_column,
+                                                    const std::vector<std::pair<int, int>> &tuples, size_t begin, size_t end) {
+    std::string query = "SELECT " + owner_column + ", student_id FROM " + table + " WHERE (" + owner_column + ", student_id) IN (";
+    append_tuple_list(query, begin, end);
+    query += ")";
+
+    std::unique_ptr<sql::PreparedStatement> pstmt(conn.prepareStatement(query));
+    bind_tuples(*pstmt, tuples, begin, end);
+    std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+    std::set<std::pair<int, int>> present;
+    while (res->next())
+        present.emplace(res->getInt(1), res->getInt(2));
+    return present;
+}
+
+bool WriteBehindQueue::write_batch(const std::map<Key, Mutation> &mutations, std::map<Key, uint64_t> &written) {
+    // Group by (table, operation) so that each group becomes a few multi-row statements.
+    std::map<std::pair<MembershipKind, bool>, std::vector<std::pair<int, int>>> groups;
+    for (const auto &[key, mutation] : mutations) {
+        groups[{std::get<0>(key), mutation.insert}].emplace_back(std::get<1>(key), std::get<2>(key));
+    }
+
+    try {
+        Transaction transaction(con);
+        std::map<Key, uint64_t> changed;
+        for (const auto &[group, tuples] : groups) {
+            std::string table, owner_column;
+            membership_table(group.first, table, owner_column);
+            bool insert = group.second;
+
+            for (size_t begin = 0; begin < tuples.size(); begin += max_tuples_per_statement) {
+                size_t end = std::min(tuples.size(), begin + max_tuples_per_statement);
+
+                // What the tuples look like before the statement. The rows it should change are the ones
+                // missing (insert) or present (delete) here; when the affected row count says otherwise, a
+                // second read in the same repeatable-read snapshot tells which ones it did change (rows other
+                // transactions committed meanwhile stay invisible to it).
+                std::set<std::pair<int, int>> before = select_present(*con, table, owner_column, tuples, begin, end);
+                size_t expected = insert ? (end - begin) - before.size() : before.size();
+
+                std::string query;
+                if (insert) {
+                    query = "INSERT IGNORE INTO " + table + " (" + owner_column + ", student_id) VALUES ";
+                    append_tuple_list(query, begin, end);
+                } else {
+                    query = "DELETE FROM " + table + " WHERE (" + owner_column + ", student_id) IN (";
+                    append_tuple_list(query, begin, end);
+                    query += ")";
+                }
+
+                std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(query));
+                bind_tuples(*pstmt, tuples, begin, end);
+                size_t affected = static_cast<size_t>(pstmt->executeUpdate());
+                Logger(ll_info, "executeQuery: " + table + (insert ? " batch insert of " : " batch delete of ") +
+                                    std::to_string(end - begin) + " rows, " + std::to_string(affected) + " changed")
+                    .log();
+
+                std::set<std::pair<int, int>> after;
+                if (affected != expected)
+                    after = select_present(*con, table, owner_column, tuples, begin, end);
+                for (size_t i = begin; i < end; ++i) {
+                    bool was_present = before.count(tuples[i]) > 0;
+                    bool is_present = affected == expected ? insert : after.count(tuples[i]) > 0;
+                    if (was_present != is_present) {
+                        Key key{group.first, tuples[i].first, tuples[i].second};
+                        changed[key] = mutations.at(key).ticket;
+                    }
+                }
+            }
+        }
+        transaction.commit();
+        written = std::move(changed);
+        return true;
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, "Error in WriteBehindQueue flush: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+void WriteBehindQueue::notify_listeners(const std::map<Key, Mutation> &mutations, const std::map<Key, uint64_t> &written) {
+    std::lock_guard<std::mutex> lock(listener_mutex);
+    for (const auto &[key, ticket] : written) {
+        auto listener = listeners.find(std::get<0>(key));
+        if (listener != listeners.end())
+            listener->second(std::get<1>(key), std::get<2>(key), mutations.at(key).insert, con);
+    }
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <cppconn/connection.h>
+
+/**
+ * @brief Which membership table a queued mutation targets.
+ */
+enum class MembershipKind {
+    /**
+     * @brief Club_Student(club_id, student_id).
+     */
+    club_student,
+
+    /**
+     * @brief Gathering_Student(gathering_id, student_id).
+     */
+    gathering_student
+};
+
+/**
+ * @brief What a caller of add/remove waits for.
+ */
+enum class WriteDurability {
+    /**
+     * @brief Block until the batch holding the mutation is committed, and report whether it changed a row.
+     */
+    await_flush,
+
+    /**
+     * @brief Return as soon as the mutation is queued.
+     */
+    fire_and_forget
+};
+
+/**
+ * @brief Tuning knobs for WriteBehindQueue.
+ */
+struct WriteBehindOptions {
+    /**
+     * @brief Flush as soon as this many distinct keys are pending.
+     */
+    size_t max_batch = 256;
+
+    /**
+     * @brief Flush when the oldest pending mutation has waited this long.
+     */
+    std::chrono::milliseconds max_delay{20};
+
+    WriteDurability durability = WriteDurability::await_flush;
+};
+
+/**
+ * @brief Counters exposed by WriteBehindQueue.
+ */
+struct WriteBehindStats {
+    uint64_t enqueued = 0;
+    /**
+     * @brief Mutations replaced by an opposite mutation on the same key before being written.
+     */
+    uint64_t cancelled = 0;
+    /**
+     * @brief Mutations dropped because the same mutation was already pending.
+     */
+    uint64_t duplicates = 0;
+    uint64_t flushes = 0;
+    uint64_t failed_flushes = 0;
+    /**
+     * @brief Rows actually inserted or deleted; duplicates, missing rows and foreign key failures are not counted.
+     */
+    uint64_t rows_written = 0;
+    uint64_t last_batch_size = 0;
+    uint64_t max_batch_size = 0;
+    uint64_t total_flush_us = 0;
+    uint64_t max_flush_us = 0;
+};
+
+/**
+ * @brief Collects membership/attendance mutations and writes them in batches.
+ *
+ * Pending mutations are keyed by (table, owner id, student id); only the latest
+ * intent per key is kept. A background thread flushes the pending set on a size or
+ * time trigger as multi-row INSERT IGNORE / DELETE ... WHERE (a, b) IN (...) statements
+ * inside one transaction on its own connection.
+ *
+ * The flush finds out which mutations changed a row (INSERT IGNORE silently skips
+ * duplicates and foreign key failures, DELETE of a missing row does nothing) and
+ * reports them per key: to the caller waiting on that mutation and to the listener
+ * registered for its table.
+ */
+class WriteBehindQueue {
+public:
+    /**
+     * @brief Called on the flush thread, after the commit, for every mutation that changed a row.
+     * The connection is the queue's own and may be used for follow-up reads.
+     */
+    using Listener = std::function<void(int owner_id, int student_id, bool insert, std::shared_ptr<sql::Connection> conn)>;
+
+    /**
+     * @brief Starts the flush thread.
+     * @param conn A connection used only by this queue.
+     * @param options Batch triggers and durability.
+     */
+    WriteBehindQueue(std::shared_ptr<sql::Connection> conn, WriteBehindOptions options = {});
+
+    /**
+     * @brief Flushes what is pending and stops the flush thread.
+     */
+    ~WriteBehindQueue();
+
+    WriteBehindQueue(const WriteBehindQueue &) = delete;
+    WriteBehindQueue &operator=(const WriteBehindQueue &) = delete;
+
+    /**
+     * @brief Queues an insertion of (owner_id, student_id).
+     * @param kind The target table.
+     * @param owner_id club_id or gathering_id.
+     * @param student_id The ID of the student.
+     * @return With await_flush, true if the row was inserted. With fire_and_forget, always true.
+     */
+    bool add(MembershipKind kind, int owner_id, int student_id);
+
+    /**
+     * @brief Queues a deletion of (owner_id, student_id).
+     * @param kind The target table.
+     * @param owner_id club_id or gathering_id.
+     * @param student_id The ID of the student.
+     * @return With await_flush, true if the row was deleted. With fire_and_forget, always true.
+     */
+    bool remove(MembershipKind kind, int owner_id, int student_id);
+
+    /**
+     * @brief Writes everything pending now and waits for it.
+     * @return True if the batch committed (or nothing was pending).
+     */
+    bool flush();
+
+    /**
+     * @brief Registers the listener told about written mutations of one table, replacing the previous one.
+     * Waits for a running call of the previous listener to return.
+     * @param kind The table.
+     * @param listener The listener, or nullptr to remove it.
+     */
+    void set_listener(MembershipKind kind, Listener listener);
+
+    /**
+     * @brief Returns a snapshot of the counters.
+     */
+    WriteBehindStats stats() const;
+
+private:
+    using Key = std::tuple<MembershipKind, int, int>;
+
+    /**
+     * @brief The latest intent for a key and the enqueue call that set it.
+     */
+    struct Mutation {
+        bool insert;
+        uint64_t ticket;
+    };
+
+    /**
+     * @brief What a flush did: whether it committed and, per key, the ticket of the mutation that changed a row.
+     */
+    struct Outcome {
+        bool committed = false;
+        std::map<Key, uint64_t> written;
+    };
+
+    /**
+     * @brief Mutations taken from the queue for one flush.
+     */
+    struct Batch {
+        std::map<Key, Mutation> mutations;
+        std::shared_ptr<std::promise<std::shared_ptr<const Outcome>>> done;
+    };
+
+    bool enqueue(MembershipKind kind, int owner_id, int student_id, bool insert);
+    void run();
+    Batch take_batch();
+    bool write_batch(const std::map<Key, Mutation> &mutations, std::map<Key, uint64_t> &written);
+    void notify_listeners(const std::map<Key, Mutation> &mutations, const std::map<Key, uint64_t> &written);
+
+    std::shared_ptr<sql::Connection> con;
+    WriteBehindOptions options;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+
+    /**
+     * @brief Latest intent per key.
+     */
+    std::map<Key, Mutation> pending;
+    std::chrono::steady_clock::time_point oldest_pending;
+    std::shared_ptr<std::promise<std::shared_ptr<const Outcome>>> pending_done;
+    std::shared_future<std::shared_ptr<const Outcome>> pending_future;
+    uint64_t next_ticket = 1;
+    bool flush_requested = false;
+    bool stopping = false;
+
+    WriteBehindStats counters;
+
+    /**
+     * @brief Held while a listener runs, so that set_listener never returns while the old one is running.
+     */
+    std::mutex listener_mutex;
+    std::map<MembershipKind, Listener> listeners;
+
+    std::thread worker;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+/**
+ * @brief A value bound to a '?' placeholder of a prepared statement.
+ */
+using SqlParam = std::variant<int, double, std::string>;
+
+namespace sql {
+class Connection;
+}
+
+/**
+ * @brief A forward-only result of a read run through a DbConnection.
+ * Columns are zero-based, as in QueryResult.
+ */
+class DbResult {
+public:
+    virtual ~DbResult() = default;
+
+    /**
+     * @brief Moves to the next row.
+     * @return True while positioned on a row, false after the last one.
+     */
+    virtual bool next() = 0;
+
+    virtual size_t rows_count() const = 0;
+    virtual size_t column_count() const = 0;
+
+    /**
+     * @brief The label of a column, e.g. "club_name" or the alias given in the select list.
+     */
+    virtual const std::string &column_name(size_t column) const = 0;
+
+    virtual bool is_null(size_t column) const = 0;
+
+    /**
+     * @brief A cell of the current row as text; NULL reads as an empty string.
+     */
+    virtual std::string get_string(size_t column) const = 0;
+
+    /**
+     * @brief A cell of the current row as int; NULL reads as 0.
+     */
+    virtual int get_int(size_t column) const = 0;
+
+    /**
+     * @brief A cell of the current row as double; NULL reads as 0.
+     */
+    virtual double get_double(size_t column) const = 0;
+
+    /**
+     * @brief Finds a column by label.
+     * @return The zero-based column index, or -1 if there is no such column.
+     */
+    int column_index(const std::string &name) const {
+        for (size_t i = 0; i < column_count(); ++i) {
+            if (column_name(i) == name)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+};
+
+/**
+ * @brief The statement interface the service layer needs from a database: prepare, bind and run
+ * a read or a write. Every BasicTable runs its own statements through one.
+ *
+ * MySqlConnection runs statements on a MySQL server through BasicTable::execute_query/execute_update;
+ * MemoryConnection runs them on an in-process MemoryDatabase, so the service classes' client-side
+ * work (building and binding statements, converting and rendering results) can be measured without
+ * a server.
+ */
+class DbConnection {
+public:
+    virtual ~DbConnection() = default;
+
+    /**
+     * @brief Runs a read.
+     * @param query The SQL statement with '?' placeholders.
+     * @param params Values for the placeholders.
+     * @return The result; never nullptr.
+     * @throws sql::SQLException if the statement fails.
+     */
+    virtual std::unique_ptr<DbResult> execute_query(const std::string &query, const std::vector<SqlParam> &params = {}) = 0;
+
+    /**
+     * @brief Runs an INSERT, UPDATE or DELETE.
+     * @param query The SQL statement with '?' placeholders.
+     * @param params Values for the placeholders.
+     * @return The number of affected rows.
+     * @throws sql::SQLException if the statement fails.
+     */
+    virtual int execute_update(const std::string &query, const std::vector<SqlParam> &params = {}) = 0;
+
+    /**
+     * @brief The MySQL session statements run on, for work that needs more than single statements:
+     * transactions, shard routing and replicas.
+     * @return The session, or nullptr if this connection is not on a MySQL server.
+     */
+    virtual std::shared_ptr<sql::Connection> session() const {
+        return nullptr;
+    }
+};
@@ -0,0 +1,1133 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include <cppconn/exception.h>
+
+#include "../service/BasicTable.h"
+#include "../trace/Tracer.h"
+#include "MemoryBackend.h"
+
+namespace {
+
+enum class ColumnType { integer, decimal, text };
+
+struct ColumnSpec {
+    const char *name;
+    const char *sql_type;
+    bool not_null;
+    const char *default_value;
+};
+
+/**
+ * @brief A table of club_init.sql. unique_keys[0] is the primary key; its first column is the
+ * AUTO_INCREMENT one when auto_increment is set.
+ */
+struct TableSpec {
+    const char *name;
+    std::vector<ColumnSpec> columns;
+    std::vector<std::vector<const char *>> unique_keys;
+    std::vector<const char *> ordered;
+    bool auto_increment;
+};
+
+/**
+ * @brief Mirrors db_scripts/club_init.sql; keep the two in sync.
+ */
+const std::vector<TableSpec> &club_schema() {
+    static const std::vector<TableSpec> schema = {
+        {"Professor", {{"prof_id", "int", true, nullptr}, {"name", "varchar(100)", true, nullptr}}, {{"prof_id"}}, {}, true},
+        {"Club",
+         {{"club_id", "int", true, nullptr},
+          {"club_name", "varchar(100)", true, nullptr},
+          {"budget", "decimal(10,2)", true, nullptr},
+          {"prof_id", "int", false, nullptr},
+          {"pending_delete", "tinyint(1)", true, "0"},
+          {"member_count", "int", true, "0"},
+          {"activity_count", "int", true, "0"}},
+         {{"club_id"}, {"club_name"}, {"prof_id"}},
+         {"member_count"},
+         true},
+        {"Location",
+         {{"loc_id", "int", true, nullptr}, {"club_id", "int", false, nullptr}, {"loc_name", "varchar(100)", true, nullptr}},
+         {{"loc_id"}, {"loc_name"}},
+         {"club_id"},
+         true},
+        {"Student",
+         {{"student_id", "int", true, nullptr}, {"name", "varchar(100)", true, nullptr}, {"department", "varchar(100)", true, nullptr}},
+         {{"student_id"}},
+         {},
+         true},
+        {"Equipment", {{"equip_id", "int", true, nullptr}, {"equip_name", "varchar(100)", true, nullptr}}, {{"equip_id"}}, {}, true},
+        {"Activity",
+         {{"act_id", "int", true, nullptr},
+          {"club_id", "int", false, nullptr},
+          {"act_title", "varchar(255)", true, nullptr},
+          {"start_date", "date", true, nullptr},
+          {"end_date", "date", false, nullptr},
+          {"pending_delete", "tinyint(1)", true, "0"}},
+         {{"act_id"}},
+         {"club_id"},
+         true},
+        {"Gathering",
+         {{"gathering_id", "int", true, nullptr}, {"act_id", "int", false, nullptr}, {"gathering_name", "varchar(255)", true, nullptr}},
+         {{"gathering_id"}, {"act_id"}},
+         {},
+         true},
+        {"Result",
+         {{"result_id", "int", true, nullptr}, {"club_id", "int", false, nullptr}, {"year", "year", true, nullptr}},
+         {{"result_id"}, {"club_id", "year"}},
+         {"club_id"},
+         true},
+        {"Club_Student",
+         {{"club_id", "int", true, nullptr}, {"student_id", "int", true, nullptr}},
+         {{"club_id", "student_id"}},
+         {"club_id", "student_id"},
+         false},
+        {"Gathering_Student",
+         {{"gathering_id", "int", true, nullptr}, {"student_id", "int", true, nullptr}},
+         {{"gathering_id", "student_id"}},
+         {"gathering_id", "student_id"},
+         false},
+        {"Result_Activity",
+         {{"result_id", "int", true, nullptr}, {"act_id", "int", true, nullptr}},
+         {{"result_id", "act_id"}},
+         {"result_id", "act_id"},
+         false},
+        {"Budget_Ledger",
+         {{"entry_id", "bigint", true, nullptr},
+          {"club_id", "int", true, nullptr},
+          {"delta", "decimal(10,2)", true, nullptr},
+          {"created_at", "timestamp", true, "CURRENT_TIMESTAMP"}},
+         {{"entry_id"}},
+         {"club_id"},
+         true},
+        {"Club_Activity_Rollup",
+         {{"club_id", "int", true, nullptr},
+          {"year", "year", true, nullptr},
+          {"activity_count", "int", true, "0"},
+          {"gathering_count", "int", true, "0"},
+          {"attendee_count", "int", true, "0"}},
+         {{"club_id", "year"}},
+         {"club_id", "year"},
+         false},
+        {"Club_Equipment",
+         {{"club_id", "int", true, nullptr}, {"equip_id", "int", true, nullptr}},
+         {{"club_id", "equip_id"}},
+         {"club_id", "equip_id"},
+         false},
+    };
+    return schema;
+}
+
+/**
+ * @brief Key of an ordered index: numbers order numerically, text byte-wise.
+ */
+using IndexKey = std::variant<double, std::string>;
+
+[[noreturn]] void fail(const std::string &message) {
+    throw sql::SQLException(message);
+}
+
+std::string current_timestamp() {
+    std::time_t now = std::time(nullptr);
+    char buffer[20];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+    return buffer;
+}
+
+std::string param_text(const SqlParam &param) {
+    if (const int *value = std::get_if<int>(&param))
+        return std::to_string(*value);
+    if (const double *value = std::get_if<double>(&param)) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.17g", *value);
+        return buffer;
+    }
+    return std::get<std::string>(param);
+}
+
+std::optional<std::string> bind(const MemoryOperand &operand, const std::vector<SqlParam> &params) {
+    switch (operand.kind) {
+    case MemoryOperand::null:
+        return std::nullopt;
+    case MemoryOperand::placeholder:
+        return param_text(params.at(operand.param));
+    default:
+        return operand.text;
+    }
+}
+
+/**
+ * @brief Parses a number the way MySQL converts text in a numeric context: leading number, else 0.
+ */
+double to_number(const std::string &text) {
+    return std::strtod(text.c_str(), nullptr);
+}
+
+bool like(const char *text, const char *pattern) {
+    for (; *pattern; ++pattern) {
+        if (*pattern == '%') {
+            while (*pattern == '%')
+                ++pattern;
+            if (!*pattern)
+                return true;
+            for (; *text; ++text) {
+                if (like(text, pattern))
+                    return true;
+            }
+            return false;
+        }
+        if (!*text)
+            return false;
+        char expected = *pattern;
+        if (expected == '\\' && pattern[1])
+            expected = *++pattern;
+        else if (expected == '_') {
+            ++text;
+            continue;
+        }
+        if (std::tolower(static_cast<unsigned char>(*text)) != std::tolower(static_cast<unsigned char>(expected)))
+            return false;
+        ++text;
+    }
+    return !*text;
+}
+
+} // namespace
+
+struct MemoryDatabase::Table {
+    struct Column {
+        std::string name;
+        std::string sql_type;
+        ColumnType type = ColumnType::text;
+
+        /**
+         * @brief Digits after the point of a DECIMAL column.
+         */
+        int scale = 0;
+
+        bool not_null = false;
+        std::optional<std::string> default_value;
+    };
+
+    std::string name;
+    std::vector<Column> columns;
+    std::vector<std::vector<size_t>> unique_keys;
+
+    /**
+     * @brief One hash index per unique key, from the key's cells to the row.
+     */
+    std::vector<std::unordered_map<std::string, size_t>> unique_indexes;
+
+    /**
+     * @brief Ordered indexes by column.
+     */
+    std::map<size_t, std::multimap<IndexKey, size_t>> ordered_indexes;
+
+    bool auto_increment = false;
+    int64_t next_id = 1;
+
+    /**
+     * @brief Rows by ID; deleted rows leave an empty slot.
+     */
+    std::vector<std::optional<MemoryRow>> rows;
+    size_t live = 0;
+
+    int column_index(const std::string &column) const {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (columns[i].name == column)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    size_t require_column(const std::string &column) const {
+        int index = column_index(column);
+        if (index < 0)
+            fail("Unknown column '" + column + "' in '" + name + "'");
+        return static_cast<size_t>(index);
+    }
+
+    /**
+     * @brief Converts a value to the stored form of a column.
+     * @throws sql::SQLException if a number column is given something that is not a number.
+     */
+    std::optional<std::string> normalize(size_t column, const std::optional<std::string> &value) const {
+        const Column &def = columns[column];
+        if (!value || def.type == ColumnType::text)
+            return value;
+        const char *begin = value->c_str();
+        char *end = nullptr;
+        double number = std::strtod(begin, &end);
+        while (end && std::isspace(static_cast<unsigned char>(*end)))
+            ++end;
+        if (end == begin || *end)
+            fail("Incorrect " + def.sql_type + " value: '" + *value + "' for column '" + def.name + "'");
+        if (def.type == ColumnType::integer)
+            return std::to_string(std::llround(number));
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%.*f", def.scale, number);
+        return std::string(buffer);
+    }
+
+    IndexKey key(size_t column, const std::string &value) const {
+        if (columns[column].type == ColumnType::text)
+            return value;
+        return to_number(value);
+    }
+
+    int compare(size_t column, const std::string &cell, const std::string &value) const {
+        if (columns[column].type == ColumnType::text)
+            return cell.compare(value) < 0 ? -1 : (cell == value ? 0 : 1);
+        double a = to_number(cell), b = to_number(value);
+        return a < b ? -1 : (a > b ? 1 : 0);
+    }
+
+    /**
+     * @return The unique-index key of a row, or std::nullopt if a key column is NULL (NULLs never collide).
+     */
+    std::optional<std::string> unique_key(size_t key, const MemoryRow &row) const {
+        std::string out;
+        for (size_t column : unique_keys[key]) {
+            if (!row[column])
+                return std::nullopt;
+            out += *row[column];
+            out += '\x1f';
+        }
+        return out;
+    }
+
+    void index(size_t id, const MemoryRow &row) {
+        for (size_t k = 0; k < unique_keys.size(); ++k) {
+            if (auto key = unique_key(k, row))
+                unique_indexes[k][*key] = id;
+        }
+        for (auto &[column, tree] : ordered_indexes) {
+            if (row[column])
+                tree.emplace(key(column, *row[column]), id);
+        }
+    }
+
+    void unindex(size_t id, const MemoryRow &row) {
+        for (size_t k = 0; k < unique_keys.size(); ++k) {
+            if (auto key = unique_key(k, row))
+                unique_indexes[k].erase(*key);
+        }
+        for (auto &[column, tree] : ordered_indexes) {
+            if (!row[column])
+                continue;
+            auto [first, last] = tree.equal_range(key(column, *row[column]));
+            for (auto it = first; it != last; ++it) {
+                if (it->second == id) {
+                    tree.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Throws if a row would duplicate a unique key held by another row.
+     */
+    void check_unique(const MemoryRow &row, std::optional<size_t> self) const {
+        for (size_t k = 0; k < unique_keys.size(); ++k) {
+            auto key = unique_key(k, row);
+            if (!key)
+                continue;
+            auto it = unique_indexes[k].find(*key);
+            if (it != unique_indexes[k].end() && it->second != self) {
+                std::string shown = key->substr(0, key->size() - 1);
+                std::replace(shown.begin(), shown.end(), '\x1f', '-');
+                fail("Duplicate entry '" + shown + "' for key '" + name + (k == 0 ? ".PRIMARY" : "." + columns[unique_keys[k][0]].name) +
+                     "'");
+            }
+        }
+    }
+};
+
+namespace {
+
+using Table = MemoryDatabase::Table;
+
+/**
+ * @brief A WHERE term with its column resolved and its values bound.
+ */
+struct Condition {
+    size_t slot = 0;
+    size_t column = 0;
+    MemoryPredicate::Op op = MemoryPredicate::eq;
+    std::vector<std::optional<std::string>> values;
+};
+
+bool holds(const Table &table, const Condition &condition, const std::optional<std::string> &cell) {
+    switch (condition.op) {
+    case MemoryPredicate::is_null:
+        return !cell;
+    case MemoryPredicate::is_not_null:
+        return cell.has_value();
+    case MemoryPredicate::never:
+        return false;
+    default:
+        break;
+    }
+    if (!cell)
+        return false;
+
+    auto compare = [&](size_t i) -> std::optional<int> {
+        if (!condition.values[i])
+            return std::nullopt;
+        return table.compare(condition.column, *cell, *condition.values[i]);
+    };
+    switch (condition.op) {
+    case MemoryPredicate::eq:
+        return compare(0) == 0;
+    case MemoryPredicate::ne: {
+        auto c = compare(0);
+        return c && *c != 0;
+    }
+    case MemoryPredicate::lt: {
+        auto c = compare(0);
+        return c && *c < 0;
+    }
+    case MemoryPredicate::le: {
+        auto c = compare(0);
+        return c && *c <= 0;
+    }
+    case MemoryPredicate::gt: {
+        auto c = compare(0);
+        return c && *c > 0;
+    }
+    case MemoryPredicate::ge: {
+        auto c = compare(0);
+        return c && *c >= 0;
+    }
+    case MemoryPredicate::like:
+        return condition.values[0] && like(cell->c_str(), condition.values[0]->c_str());
+    case MemoryPredicate::not_like:
+        return condition.values[0] && !like(cell->c_str(), condition.values[0]->c_str());
+    case MemoryPredicate::in:
+        for (size_t i = 0; i < condition.values.size(); ++i) {
+            if (compare(i) == 0)
+                return true;
+        }
+        return false;
+    case MemoryPredicate::between: {
+        auto low = compare(0), high = compare(1);
+        return low && high && *low >= 0 && *high <= 0;
+    }
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief How a table is read: 0 by unique key (condition set for an IN list on a one-column key),
+ * 1 by ordered index equality, 2 by ordered index range, 3 by scan.
+ */
+struct AccessPath {
+    int rank = 3;
+    size_t unique_key = 0;
+    const Condition *condition = nullptr;
+};
+
+AccessPath plan_access(const Table &table, const std::vector<const Condition *> &conditions) {
+    for (size_t k = 0; k < table.unique_keys.size(); ++k) {
+        bool covered = true;
+        for (size_t column : table.unique_keys[k]) {
+            bool found = false;
+            for (const Condition *condition : conditions)
+                found = found || (condition->column == column && condition->op == MemoryPredicate::eq && condition->values[0]);
+            covered = covered && found;
+        }
+        if (covered)
+            return {0, k, nullptr};
+    }
+    for (size_t k = 0; k < table.unique_keys.size(); ++k) {
+        for (const Condition *condition : conditions) {
+            if (table.unique_keys[k] == std::vector<size_t>{condition->column} && condition->op == MemoryPredicate::in)
+                return {0, k, condition};
+        }
+    }
+    AccessPath best;
+    for (const Condition *condition : conditions) {
+        if (!table.ordered_indexes.contains(condition->column))
+            continue;
+        int rank;
+        switch (condition->op) {
+        case MemoryPredicate::eq:
+        case MemoryPredicate::in:
+            rank = 1;
+            break;
+        case MemoryPredicate::lt:
+        case MemoryPredicate::le:
+        case MemoryPredicate::gt:
+        case MemoryPredicate::ge:
+        case MemoryPredicate::between:
+            rank = 2;
+            break;
+        default:
+            continue;
+        }
+        if (rank < best.rank)
+            best = {rank, 0, condition};
+    }
+    return best;
+}
+
+/**
+ * @brief IDs of the rows an access path reads; a superset of the matching rows.
+ */
+std::vector<size_t> access(const Table &table, const AccessPath &path, const std::vector<const Condition *> &conditions) {
+    std::vector<size_t> ids;
+    if (path.rank == 0 && path.condition) {
+        const auto &index = table.unique_indexes[path.unique_key];
+        for (const auto &value : path.condition->values) {
+            if (!value)
+                continue;
+            std::optional<std::string> key;
+            try {
+                key = table.normalize(path.condition->column, value);
+            } catch (sql::SQLException &) {
+                continue;
+            }
+            if (auto it = index.find(*key + '\x1f'); it != index.end())
+                ids.push_back(it->second);
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        return ids;
+    }
+    if (path.rank == 0) {
+        std::string key;
+        for (size_t column : table.unique_keys[path.unique_key]) {
+            for (const Condition *condition : conditions) {
+                if (condition->column == column && condition->op == MemoryPredicate::eq && condition->values[0]) {
+                    std::optional<std::string> value;
+                    try {
+                        value = table.normalize(column, condition->values[0]);
+                    } catch (sql::SQLException &) {
+                        return ids;
+                    }
+                    key += *value;
+                    key += '\x1f';
+                    break;
+                }
+            }
+        }
+        auto it = table.unique_indexes[path.unique_key].find(key);
+        if (it != table.unique_indexes[path.unique_key].end())
+            ids.push_back(it->second);
+        return ids;
+    }
+
+    if (path.condition) {
+        const Condition &condition = *path.condition;
+        const auto &tree = table.ordered_indexes.at(condition.column);
+        auto add = [&](auto first, auto last) {
+            for (auto it = first; it != last; ++it)
+                ids.push_back(it->second);
+        };
+        auto key = [&](size_t i) { return table.key(condition.column, *condition.values[i]); };
+        for (const auto &value : condition.values) {
+            if (!value)
+                return ids;
+        }
+        switch (condition.op) {
+        case MemoryPredicate::eq:
+        case MemoryPredicate::in:
+            for (size_t i = 0; i < condition.values.size(); ++i) {
+                auto [first, last] = tree.equal_range(key(i));
+                add(first, last);
+            }
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            break;
+        case MemoryPredicate::lt:
+            add(tree.begin(), tree.lower_bound(key(0)));
+            break;
+        case MemoryPredicate::le:
+            add(tree.begin(), tree.upper_bound(key(0)));
+            break;
+        case MemoryPredicate::gt:
+            add(tree.upper_bound(key(0)), tree.end());
+            break;
+        case MemoryPredicate::ge:
+            add(tree.lower_bound(key(0)), tree.end());
+            break;
+        case MemoryPredicate::between:
+            if (!(key(1) < key(0)))
+                add(tree.lower_bound(key(0)), tree.upper_bound(key(1)));
+            break;
+        default:
+            break;
+        }
+        return ids;
+    }
+
+    ids.reserve(table.live);
+    for (size_t id = 0; id < table.rows.size(); ++id) {
+        if (table.rows[id])
+            ids.push_back(id);
+    }
+    return ids;
+}
+
+using SubqueryRunner = std::function<std::vector<std::optional<std::string>>(const MemoryStatement &)>;
+
+/**
+ * @brief The tables of a statement and name resolution over them.
+ */
+struct Sources {
+    std::vector<const Table *> tables;
+    std::vector<std::string> aliases;
+
+    std::pair<size_t, size_t> resolve(const MemoryOperand &operand) const {
+        for (size_t slot = 0; slot < tables.size(); ++slot) {
+            if (!operand.qualifier.empty() && operand.qualifier != aliases[slot] && operand.qualifier != tables[slot]->name)
+                continue;
+            int column = tables[slot]->column_index(operand.text);
+            if (column >= 0)
+                return {slot, static_cast<size_t>(column)};
+        }
+        fail("Unknown column '" + (operand.qualifier.empty() ? "" : operand.qualifier + ".") + operand.text + "'");
+    }
+
+    /**
+     * @param subquery Runs the subquery of an IN term and returns its one column.
+     */
+    std::vector<Condition> bind_conditions(const std::vector<MemoryPredicate> &where, const std::vector<SqlParam> &params,
+                                           const SubqueryRunner &subquery) const {
+        std::vector<Condition> conditions;
+        conditions.reserve(where.size());
+        for (const auto &term : where) {
+            Condition condition;
+            condition.op = term.op;
+            if (term.op != MemoryPredicate::never)
+                std::tie(condition.slot, condition.column) = resolve(term.column);
+            if (term.subquery)
+                condition.values = subquery(*term.subquery);
+            for (const auto &value : term.values)
+                condition.values.push_back(bind(value, params));
+            conditions.push_back(std::move(condition));
+        }
+        return conditions;
+    }
+};
+
+using Match = std::array<size_t, 2>;
+
+std::vector<Match> find_matches(const Sources &sources, const std::vector<Condition> &conditions,
+                                const std::optional<std::pair<MemoryOperand, MemoryOperand>> &join_on) {
+    std::array<std::vector<const Condition *>, 2> by_slot;
+    for (const auto &condition : conditions) {
+        if (condition.op == MemoryPredicate::never)
+            return {};
+        by_slot[condition.slot].push_back(&condition);
+    }
+    // A key lookup for an IN list already matched its term, which is costly to test value by value.
+    auto matches_all = [&](size_t slot, size_t id, const AccessPath *path = nullptr) {
+        const Table &table = *sources.tables[slot];
+        for (const Condition *condition : by_slot[slot]) {
+            if (path && path->rank == 0 && condition == path->condition)
+                continue;
+            if (!holds(table, *condition, (*table.rows[id])[condition->column]))
+                return false;
+        }
+        return true;
+    };
+
+    std::vector<Match> matches;
+    if (sources.tables.size() == 1) {
+        const Table &table = *sources.tables[0];
+        AccessPath path = plan_access(table, by_slot[0]);
+        for (size_t id : access(table, path, by_slot[0])) {
+            if (matches_all(0, id, &path))
+                matches.push_back({id, 0});
+        }
+        return matches;
+    }
+
+    auto [left_slot, left_column] = sources.resolve(join_on->first);
+    auto [right_slot, right_column] = sources.resolve(join_on->second);
+    if (left_slot == right_slot)
+        fail("The ON clause of a join must compare columns of both tables");
+    std::array<size_t, 2> on_column;
+    on_column[left_slot] = left_column;
+    on_column[right_slot] = right_column;
+
+    // Drive the join from the table that its own conditions narrow down best.
+    std::array<AccessPath, 2> paths = {plan_access(*sources.tables[0], by_slot[0]), plan_access(*sources.tables[1], by_slot[1])};
+    size_t outer = paths[1].rank < paths[0].rank ? 1 : 0;
+    size_t inner = 1 - outer;
+    const Table &outer_table = *sources.tables[outer];
+    const Table &inner_table = *sources.tables[inner];
+    size_t inner_column = on_column[inner];
+
+    std::optional<size_t> inner_unique;
+    for (size_t k = 0; k < inner_table.unique_keys.size(); ++k) {
+        if (inner_table.unique_keys[k] == std::vector<size_t>{inner_column})
+            inner_unique = k;
+    }
+    const std::multimap<IndexKey, size_t> *inner_tree = nullptr;
+    if (auto it = inner_table.ordered_indexes.find(inner_column); it != inner_table.ordered_indexes.end())
+        inner_tree = &it->second;
+
+    // Without an index on the inner join column, hash the inner table's qualifying rows once.
+    std::unordered_multimap<std::string, size_t> inner_hash;
+    if (!inner_unique && !inner_tree) {
+        for (size_t id : access(inner_table, paths[inner], by_slot[inner])) {
+            const auto &cell = (*inner_table.rows[id])[inner_column];
+            if (cell && matches_all(inner, id))
+                inner_hash.emplace(*inner_table.normalize(inner_column, cell), id);
+        }
+    }
+
+    auto emit = [&](size_t outer_id, size_t inner_id) {
+        if (!inner_table.rows[inner_id] || !matches_all(inner, inner_id))
+            return;
+        Match match;
+        match[outer] = outer_id;
+        match[inner] = inner_id;
+        matches.push_back(match);
+    };
+
+    for (size_t outer_id : access(outer_table, paths[outer], by_slot[outer])) {
+        if (!matches_all(outer, outer_id, &paths[outer]))
+            continue;
+        const auto &value = (*outer_table.rows[outer_id])[on_column[outer]];
+        if (!value)
+            continue;
+        std::optional<std::string> probe;
+        try {
+            probe = inner_table.normalize(inner_column, value);
+        } catch (sql::SQLException &) {
+            continue;
+        }
+        if (inner_unique) {
+            auto &index = inner_table.unique_indexes[*inner_unique];
+            if (auto it = index.find(*probe + '\x1f'); it != index.end())
+                emit(outer_id, it->second);
+        } else if (inner_tree) {
+            auto [first, last] = inner_tree->equal_range(inner_table.key(inner_column, *probe));
+            for (auto it = first; it != last; ++it)
+                emit(outer_id, it->second);
+        } else {
+            auto [first, last] = inner_hash.equal_range(*probe);
+            for (auto it = first; it != last; ++it)
+                emit(outer_id, it->second);
+        }
+    }
+    return matches;
+}
+
+} // namespace
+
+MemoryResult::MemoryResult(std::vector<std::string> columns, std::vector<MemoryRow> rows)
+    : columns(std::move(columns)), rows(std::move(rows)) {}
+
+bool MemoryResult::next() {
+    if (cursor > rows.size())
+        return false;
+    return ++cursor <= rows.size();
+}
+
+size_t MemoryResult::rows_count() const {
+    return rows.size();
+}
+
+size_t MemoryResult::column_count() const {
+    return columns.size();
+}
+
+const std::string &MemoryResult::column_name(size_t column) const {
+    return columns[column];
+}
+
+bool MemoryResult::is_null(size_t column) const {
+    return !rows[cursor - 1][column];
+}
+
+std::string MemoryResult::get_string(size_t column) const {
+    const auto &cell = rows[cursor - 1][column];
+    return cell ? *cell : std::string();
+}
+
+int MemoryResult::get_int(size_t column) const {
+    const auto &cell = rows[cursor - 1][column];
+    return cell ? static_cast<int>(std::strtol(cell->c_str(), nullptr, 10)) : 0;
+}
+
+double MemoryResult::get_double(size_t column) const {
+    const auto &cell = rows[cursor - 1][column];
+    return cell ? to_number(*cell) : 0;
+}
+
+MemoryDatabase::MemoryDatabase() {
+    for (const auto &spec : club_schema()) {
+        auto table = std::make_unique<Table>();
+        table->name = spec.name;
+        for (const auto &column : spec.columns) {
+            Table::Column def;
+            def.name = column.name;
+            def.sql_type = column.sql_type;
+            if (def.sql_type.starts_with("decimal")) {
+                def.type = ColumnType::decimal;
+                size_t comma = def.sql_type.find(',');
+                def.scale = comma == std::string::npos ? 0 : std::atoi(def.sql_type.c_str() + comma + 1);
+            } else if (def.sql_type.find("int") != std::string::npos || def.sql_type == "year") {
+                def.type = ColumnType::integer;
+            }
+            def.not_null = column.not_null;
+            if (column.default_value)
+                def.default_value = column.default_value;
+            table->columns.push_back(std::move(def));
+        }
+        for (const auto &key : spec.unique_keys) {
+            std::vector<size_t> columns;
+            for (const char *column : key)
+                columns.push_back(table->require_column(column));
+            table->unique_keys.push_back(std::move(columns));
+        }
+        table->unique_indexes.resize(table->unique_keys.size());
+        for (const char *column : spec.ordered)
+            table->ordered_indexes[table->require_column(column)];
+        table->auto_increment = spec.auto_increment;
+        tables[spec.name] = std::move(table);
+    }
+}
+
+MemoryDatabase::~MemoryDatabase() = default;
+
+const MemoryDatabase::Table &MemoryDatabase::table(const std::string &name) const {
+    auto it = tables.find(name);
+    if (it == tables.end())
+        fail("Table '" + name + "' doesn't exist");
+    return *it->second;
+}
+
+MemoryDatabase::Table &MemoryDatabase::table(const std::string &name) {
+    auto it = tables.find(name);
+    if (it == tables.end())
+        fail("Table '" + name + "' doesn't exist");
+    return *it->second;
+}
+
+size_t MemoryDatabase::row_count(const std::string &name) const {
+    std::shared_lock lock(mutex);
+    auto it = tables.find(name);
+    return it == tables.end() ? 0 : it->second->live;
+}
+
+std::unique_ptr<MemoryResult> MemoryDatabase::query(const MemoryStatement &statement, const std::vector<SqlParam> &params,
+                                                    int64_t last_insert_id) const {
+    std::shared_lock lock(mutex);
+    return select(statement, params, last_insert_id);
+}
+
+std::vector<std::optional<std::string>> MemoryDatabase::subquery_values(const MemoryStatement &subquery,
+                                                                        const std::vector<SqlParam> &params) const {
+    std::unique_ptr<MemoryResult> res = select(subquery, params, 0);
+    std::vector<std::optional<std::string>> values;
+    values.reserve(res->rows_count());
+    while (res->next())
+        values.push_back(res->is_null(0) ? std::nullopt : std::optional<std::string>(res->get_string(0)));
+    return values;
+}
+
+std::unique_ptr<MemoryResult> MemoryDatabase::select(const MemoryStatement &statement, const std::vector<SqlParam> &params,
+                                                     int64_t last_insert_id) const {
+    if (statement.kind == MemoryStatement::describe) {
+        const Table &described = table(statement.tables[0].table);
+        std::vector<MemoryRow> rows;
+        for (size_t i = 0; i < described.columns.size(); ++i) {
+            const auto &column = described.columns[i];
+            std::string key;
+            if (std::find(described.unique_keys[0].begin(), described.unique_keys[0].end(), i) != described.unique_keys[0].end())
+                key = "PRI";
+            for (size_t k = 1; key.empty() && k < described.unique_keys.size(); ++k)
+                key = described.unique_keys[k][0] == i ? "UNI" : "";
+            if (key.empty() && described.ordered_indexes.contains(i))
+                key = "MUL";
+            bool auto_increment = described.auto_increment && i == described.unique_keys[0][0];
+            rows.push_back({column.name, column.sql_type, std::string(column.not_null ? "NO" : "YES"), key, column.default_value,
+                            std::string(auto_increment ? "auto_increment" : "")});
+        }
+        return std::make_unique<MemoryResult>(std::vector<std::string>{"Field", "Type", "Null", "Key", "Default", "Extra"},
+                                              std::move(rows));
+    }
+
+    if (statement.tables.empty()) {
+        std::vector<std::string> labels;
+        MemoryRow row;
+        for (const auto &item : statement.items) {
+            labels.push_back(item.label);
+            row.push_back(std::to_string(last_insert_id));
+        }
+        return std::make_unique<MemoryResult>(std::move(labels), std::vector<MemoryRow>{std::move(row)});
+    }
+
+    Sources sources;
+    for (const auto &ref : statement.tables) {
+        sources.tables.push_back(&table(ref.table));
+        sources.aliases.push_back(ref.alias);
+    }
+    std::vector<Condition> conditions = sources.bind_conditions(
+        statement.where, params, [&](const MemoryStatement &subquery) { return subquery_values(subquery, params); });
+    std::vector<Match> matches = find_matches(sources, conditions, statement.join_on);
+
+    bool counting = std::any_of(statement.items.begin(), statement.items.end(),
+                                [](const MemorySelectItem &item) { return item.kind == MemorySelectItem::count; });
+    if (counting) {
+        if (statement.items.size() != 1)
+            fail("MemoryDatabase only supports COUNT(*) on its own");
+        std::vector<MemoryRow> rows;
+        if (!statement.limit || (*statement.limit > 0 && statement.offset == 0))
+            rows.push_back({std::to_string(matches.size())});
+        return std::make_unique<MemoryResult>(std::vector<std::string>{statement.items[0].label}, std::move(rows));
+    }
+
+    if (!statement.order_by.empty()) {
+        std::vector<std::pair<size_t, size_t>> keys;
+        for (const auto &order : statement.order_by)
+            keys.push_back(sources.resolve(order.column));
+        std::stable_sort(matches.begin(), matches.end(), [&](const Match &a, const Match &b) {
+            for (size_t i = 0; i < keys.size(); ++i) {
+                auto [slot, column] = keys[i];
+                const Table &t = *sources.tables[slot];
+                const auto &x = (*t.rows[a[slot]])[column];
+                const auto &y = (*t.rows[b[slot]])[column];
+                int c = !x ? (y ? -1 : 0) : (!y ? 1 : t.compare(column, *x, *y));
+                if (c != 0)
+                    return statement.order_by[i].descending ? c > 0 : c < 0;
+            }
+            return false;
+        });
+    }
+
+    size_t first = std::min(statement.offset, matches.size());
+    size_t last = statement.limit ? std::min(matches.size(), first + *statement.limit) : matches.size();
+
+    std::vector<std::string> labels;
+    std::vector<std::pair<size_t, size_t>> outputs;
+    for (const auto &item : statement.items) {
+        if (item.kind == MemorySelectItem::all) {
+            for (size_t slot = 0; slot < sources.tables.size(); ++slot) {
+                if (!item.value.qualifier.empty() && item.value.qualifier != sources.aliases[slot] &&
+                    item.value.qualifier != sources.tables[slot]->name)
+                    continue;
+                for (size_t column = 0; column < sources.tables[slot]->columns.size(); ++column) {
+                    labels.push_back(sources.tables[slot]->columns[column].name);
+                    outputs.emplace_back(slot, column);
+                }
+            }
+        } else if (item.kind == MemorySelectItem::column) {
+            labels.push_back(item.label);
+            outputs.push_back(sources.resolve(item.value));
+        } else {
+            fail("MemoryDatabase cannot mix LAST_INSERT_ID() with table columns");
+        }
+    }
+
+    std::vector<MemoryRow> rows;
+    rows.reserve(last - first);
+    for (size_t i = first; i < last; ++i) {
+        MemoryRow row;
+        row.reserve(outputs.size());
+        for (auto [slot, column] : outputs)
+            row.push_back((*sources.tables[slot]->rows[matches[i][slot]])[column]);
+        rows.push_back(std::move(row));
+    }
+    return std::make_unique<MemoryResult>(std::move(labels), std::move(rows));
+}
+
+int MemoryDatabase::update(const MemoryStatement &statement, const std::vector<SqlParam> &params, int64_t &last_insert_id) {
+    std::unique_lock lock(mutex);
+    Table &target = table(statement.tables[0].table);
+
+    if (statement.kind == MemoryStatement::insert) {
+        std::vector<size_t> columns;
+        for (const auto &column : statement.insert_columns)
+            columns.push_back(target.require_column(column));
+
+        std::vector<size_t> added;
+        int64_t next_id = target.next_id;
+        int64_t generated = 0;
+        try {
+            for (const auto &values : statement.insert_rows) {
+                MemoryRow row(target.columns.size());
+                for (size_t i = 0; i < target.columns.size(); ++i) {
+                    const auto &def = target.columns[i].default_value;
+                    row[i] = def && *def == "CURRENT_TIMESTAMP" ? std::optional<std::string>(current_timestamp()) : def;
+                }
+                for (size_t i = 0; i < columns.size(); ++i)
+                    row[columns[i]] = target.normalize(columns[i], bind(values[i], params));
+
+                if (target.auto_increment) {
+                    size_t id_column = target.unique_keys[0][0];
+                    if (!row[id_column] || *row[id_column] == "0") {
+                        row[id_column] = std::to_string(target.next_id);
+                        if (!generated)
+                            generated = target.next_id;
+                        target.next_id++;
+                    } else {
+                        target.next_id = std::max<int64_t>(target.next_id, std::atoll(row[id_column]->c_str()) + 1);
+                    }
+                }
+                for (size_t i = 0; i < target.columns.size(); ++i) {
+                    if (target.columns[i].not_null && !row[i])
+                        fail("Column '" + target.columns[i].name + "' cannot be null");
+                }
+                if (statement.ignore) {
+                    try {
+                        target.check_unique(row, std::nullopt);
+                    } catch (sql::SQLException &) {
+                        continue;
+                    }
+                } else {
+                    target.check_unique(row, std::nullopt);
+                }
+
+                size_t id = target.rows.size();
+                target.rows.push_back(row);
+                target.index(id, row);
+                target.live++;
+                added.push_back(id);
+            }
+        } catch (sql::SQLException &) {
+            // A failed statement leaves the table as it was, as InnoDB does.
+            for (size_t id : added) {
+                target.unindex(id, *target.rows[id]);
+                target.rows[id].reset();
+                target.live--;
+            }
+            target.next_id = next_id;
+            throw;
+        }
+        if (generated)
+            last_insert_id = generated;
+        return static_cast<int>(added.size());
+    }
+
+    Sources sources{{&target}, {statement.tables[0].alias}};
+    std::vector<Condition> conditions = sources.bind_conditions(
+        statement.where, params, [&](const MemoryStatement &subquery) { return subquery_values(subquery, params); });
+    std::vector<Match> matches = find_matches(sources, conditions, std::nullopt);
+
+    if (statement.kind == MemoryStatement::remove) {
+        for (const auto &match : matches) {
+            target.unindex(match[0], *target.rows[match[0]]);
+            target.rows[match[0]].reset();
+            target.live--;
+        }
+        return static_cast<int>(matches.size());
+    }
+
+    std::vector<std::pair<size_t, std::optional<std::string>>> assignments;
+    for (const auto &assignment : statement.assignments) {
+        size_t column = target.require_column(assignment.column);
+        assignments.emplace_back(column, bind(assignment.value, params));
+    }
+
+    std::vector<std::pair<size_t, MemoryRow>> previous;
+    try {
+        for (const auto &match : matches) {
+            size_t id = match[0];
+            MemoryRow row = *target.rows[id];
+            for (size_t i = 0; i < assignments.size(); ++i) {
+                auto [column, value] = assignments[i];
+                char arithmetic = statement.assignments[i].arithmetic;
+                if (arithmetic && row[column] && value) {
+                    double delta = to_number(*value);
+                    char buffer[64];
+                    std::snprintf(buffer, sizeof(buffer), "%.17g",
+                                  to_number(*row[column]) + (arithmetic == '+' ? delta : -delta));
+                    value = buffer;
+                } else if (arithmetic) {
+                    value = std::nullopt;
+                }
+                row[column] = target.normalize(column, value);
+                if (target.columns[column].not_null && !row[column])
+                    fail("Column '" + target.columns[column].name + "' cannot be null");
+            }
+            target.check_unique(row, id);
+            previous.emplace_back(id, *target.rows[id]);
+            target.unindex(id, *target.rows[id]);
+            target.rows[id] = std::move(row);
+            target.index(id, *target.rows[id]);
+        }
+    } catch (sql::SQLException &) {
+        for (auto it = previous.rbegin(); it != previous.rend(); ++it) {
+            target.unindex(it->first, *target.rows[it->first]);
+            target.rows[it->first] = std::move(it->second);
+            target.index(it->first, *target.rows[it->first]);
+        }
+        throw;
+    }
+    return static_cast<int>(matches.size());
+}
+
+MemoryConnection::MemoryConnection(std::shared_ptr<MemoryDatabase> db, MemoryLatency latency) : db(db), latency(latency) {}
+
+const MemoryStatement &MemoryConnection::prepare(const std::string &query, const std::vector<SqlParam> &params) {
+    auto it = statements.find(query);
+    if (it == statements.end()) {
+        if (statements.size() >= max_cached_statements)
+            statements.clear();
+        it = statements.emplace(query, std::make_unique<const MemoryStatement>(parse_memory_statement(query))).first;
+    }
+    if (params.size() != it->second->param_count)
+        fail("\"" + query + "\" takes " + std::to_string(it->second->param_count) + " parameters, " +
+             std::to_string(params.size()) + " given");
+    return *it->second;
+}
+
+void MemoryConnection::delay() const {
+    if (latency.per_statement.count() <= 0)
+        return;
+    if (!latency.spin) {
+        std::this_thread::sleep_for(latency.per_statement);
+        return;
+    }
+    auto until = std::chrono::steady_clock::now() + latency.per_statement;
+    while (std::chrono::steady_clock::now() < until) {
+    }
+}
+
+std::unique_ptr<DbResult> MemoryConnection::execute_query(const std::string &query, const std::vector<SqlParam> &params) {
+    TraceSpan span("sql", "execute", query);
+    const MemoryStatement &statement = prepare(query, params);
+    if (statement.kind != MemoryStatement::select && statement.kind != MemoryStatement::describe)
+        fail("execute_query needs a SELECT or DESCRIBE: " + query);
+    std::unique_ptr<DbResult> res = db->query(statement, params, last_insert_id);
+    delay();
+    return res;
+}
+
+int MemoryConnection::execute_update(const std::string &query, const std::vector<SqlParam> &params) {
+    TraceSpan span("sql", "execute", query);
+    const MemoryStatement &statement = prepare(query, params);
+    if (statement.kind == MemoryStatement::select || statement.kind == MemoryStatement::describe)
+        fail("execute_update needs an INSERT, UPDATE or DELETE: " + query);
+    int affected = db->update(statement, params, last_insert_id);
+    // As BasicTable::execute_update does, so that coalesced reads after the write start a new flight.
+    BasicTable::note_write();
+    delay();
+    return affected;
+}
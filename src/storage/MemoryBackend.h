@@ -0,0 +1,150 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "DbBackend.h"
+#include "MemoryStatement.h"
+
+/**
+ * @brief A row of a MemoryDatabase table or result: one text cell per column, std::nullopt for NULL.
+ * Numbers are stored in the text form MySQL returns them in, e.g. "12" and "1500.00".
+ */
+using MemoryRow = std::vector<std::optional<std::string>>;
+
+/**
+ * @brief A DbResult holding rows produced by MemoryDatabase.
+ */
+class MemoryResult : public DbResult {
+public:
+    MemoryResult(std::vector<std::string> columns, std::vector<MemoryRow> rows);
+
+    bool next() override;
+    size_t rows_count() const override;
+    size_t column_count() const override;
+    const std::string &column_name(size_t column) const override;
+    bool is_null(size_t column) const override;
+    std::string get_string(size_t column) const override;
+    int get_int(size_t column) const override;
+    double get_double(size_t column) const override;
+
+private:
+    std::vector<std::string> columns;
+    std::vector<MemoryRow> rows;
+
+    /**
+     * @brief One past the current row; 0 before the first next().
+     */
+    size_t cursor = 0;
+};
+
+/**
+ * @brief The tables of db_scripts/club_init.sql, kept in process memory.
+ *
+ * Every primary and unique key has a hash index, which also enforces it; foreign-key columns and
+ * the leading columns of secondary indexes have an ordered (B-tree) index used for equality, IN
+ * and range conditions. A join probes the index of its inner table; an IN subquery runs once per
+ * statement and its values are then looked up like an IN list. Foreign keys, cascades and
+ * triggers are not modelled, and text compares byte-wise rather than by collation.
+ *
+ * Reads hold a shared lock and writes an exclusive one, so any number of connections may share
+ * a database.
+ */
+class MemoryDatabase {
+public:
+    MemoryDatabase();
+    ~MemoryDatabase();
+
+    MemoryDatabase(const MemoryDatabase &) = delete;
+    MemoryDatabase &operator=(const MemoryDatabase &) = delete;
+
+    /**
+     * @brief Number of rows in a table, or 0 if there is no such table.
+     */
+    size_t row_count(const std::string &table) const;
+
+    /**
+     * @brief Runs a SELECT or DESCRIBE.
+     * @param statement The parsed statement.
+     * @param params Values for its placeholders.
+     * @param last_insert_id The calling connection's LAST_INSERT_ID().
+     * @throws sql::SQLException if the statement refers to unknown tables or columns.
+     */
+    std::unique_ptr<MemoryResult> query(const MemoryStatement &statement, const std::vector<SqlParam> &params,
+                                        int64_t last_insert_id) const;
+
+    /**
+     * @brief Runs an INSERT, UPDATE or DELETE.
+     * @param statement The parsed statement.
+     * @param params Values for its placeholders.
+     * @param last_insert_id Set to the first generated AUTO_INCREMENT value of an insert that generated one.
+     * @return The number of affected rows.
+     * @throws sql::SQLException if the statement fails, e.g. on a duplicate key.
+     */
+    int update(const MemoryStatement &statement, const std::vector<SqlParam> &params, int64_t &last_insert_id);
+
+    struct Table;
+
+private:
+    /**
+     * @brief query, for a caller already holding the lock.
+     */
+    std::unique_ptr<MemoryResult> select(const MemoryStatement &statement, const std::vector<SqlParam> &params,
+                                         int64_t last_insert_id) const;
+
+    /**
+     * @brief Runs the subquery of an IN term and returns its one column.
+     */
+    std::vector<std::optional<std::string>> subquery_values(const MemoryStatement &subquery,
+                                                            const std::vector<SqlParam> &params) const;
+
+    const Table &table(const std::string &name) const;
+    Table &table(const std::string &name);
+
+    std::map<std::string, std::unique_ptr<Table>> tables;
+    mutable std::shared_mutex mutex;
+};
+
+/**
+ * @brief Delay added to every statement of a MemoryConnection, standing in for a network round trip.
+ */
+struct MemoryLatency {
+    std::chrono::nanoseconds per_statement{0};
+
+    /**
+     * @brief Busy-wait instead of sleeping: exact for microsecond delays, but occupies a core.
+     */
+    bool spin = false;
+};
+
+/**
+ * @brief A DbConnection on a MemoryDatabase.
+ *
+ * Like a server-side prepared statement, each distinct statement text is parsed once per
+ * connection and kept; the cache is dropped when it reaches max_cached_statements.
+ */
+class MemoryConnection : public DbConnection {
+public:
+    explicit MemoryConnection(std::shared_ptr<MemoryDatabase> db, MemoryLatency latency = {});
+
+    std::unique_ptr<DbResult> execute_query(const std::string &query, const std::vector<SqlParam> &params = {}) override;
+    int execute_update(const std::string &query, const std::vector<SqlParam> &params = {}) override;
+
+    static constexpr size_t max_cached_statements = 1024;
+
+private:
+    const MemoryStatement &prepare(const std::string &query, const std::vector<SqlParam> &params);
+    void delay() const;
+
+    std::shared_ptr<MemoryDatabase> db;
+    MemoryLatency latency;
+    int64_t last_insert_id = 0;
+    std::unordered_map<std::string, std::unique_ptr<const MemoryStatement>> statements;
+};
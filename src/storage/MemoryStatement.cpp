@@ -0,0 +1,453 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+#include <cppconn/exception.h>
+
+#include "MemoryStatement.h"
+
+namespace {
+
+struct Token {
+    enum Kind { word, number, text, symbol, end };
+    Kind kind = end;
+    std::string value;
+};
+
+std::string upper(const std::string &word) {
+    std::string out = word;
+    for (char &c : out)
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return out;
+}
+
+/**
+ * @brief Words that end a table reference, so they are never taken for an alias.
+ */
+const std::set<std::string> &reserved_words() {
+    static const std::set<std::string> words = {"AS",    "AND",  "ASC",   "BETWEEN", "BY",    "CROSS", "DESC",  "FOR",
+                                                "FROM",  "GROUP", "HAVING", "IN",     "INNER", "IS",    "JOIN",  "LEFT",
+                                                "LIKE",  "LIMIT", "NOT",   "NULL",    "OFFSET", "ON",   "OR",    "ORDER",
+                                                "RIGHT", "SET",   "UNION", "VALUES",  "WHERE"};
+    return words;
+}
+
+[[noreturn]] void unsupported(const std::string &sql, const std::string &why) {
+    throw sql::SQLException("MemoryDatabase cannot run \"" + sql + "\": " + why);
+}
+
+std::vector<Token> tokenize(const std::string &sql) {
+    std::vector<Token> tokens;
+    size_t i = 0;
+    while (i < sql.size()) {
+        unsigned char c = static_cast<unsigned char>(sql[i]);
+        if (std::isspace(c)) {
+            ++i;
+        } else if (std::isalpha(c) || c == '_') {
+            size_t start = i;
+            while (i < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '_'))
+                ++i;
+            tokens.push_back({Token::word, sql.substr(start, i - start)});
+        } else if (c == '`') {
+            size_t close = sql.find('`', i + 1);
+            if (close == std::string::npos)
+                unsupported(sql, "unterminated identifier");
+            tokens.push_back({Token::word, sql.substr(i + 1, close - i - 1)});
+            i = close + 1;
+        } else if (std::isdigit(c)) {
+            size_t start = i;
+            while (i < sql.size() && (std::isdigit(static_cast<unsigned char>(sql[i])) || sql[i] == '.'))
+                ++i;
+            tokens.push_back({Token::number, sql.substr(start, i - start)});
+        } else if (c == '\'' || c == '"') {
+            std::string value;
+            char quote = static_cast<char>(c);
+            ++i;
+            while (true) {
+                if (i >= sql.size())
+                    unsupported(sql, "unterminated string");
+                if (sql[i] == '\\' && i + 1 < sql.size()) {
+                    value += sql[i + 1];
+                    i += 2;
+                } else if (sql[i] == quote && i + 1 < sql.size() && sql[i + 1] == quote) {
+                    value += quote;
+                    i += 2;
+                } else if (sql[i] == quote) {
+                    ++i;
+                    break;
+                } else {
+                    value += sql[i++];
+                }
+            }
+            tokens.push_back({Token::text, value});
+        } else {
+            std::string two = sql.substr(i, 2);
+            if (two == "<=" || two == ">=" || two == "<>" || two == "!=") {
+                tokens.push_back({Token::symbol, two});
+                i += 2;
+            } else if (std::string("(),*=<>?.+-;").find(static_cast<char>(c)) != std::string::npos) {
+                tokens.push_back({Token::symbol, std::string(1, static_cast<char>(c))});
+                ++i;
+            } else {
+                unsupported(sql, std::string("unexpected character '") + static_cast<char>(c) + "'");
+            }
+        }
+    }
+    tokens.push_back({Token::end, ""});
+    return tokens;
+}
+
+class Parser {
+public:
+    explicit Parser(const std::string &sql) : sql(sql), tokens(tokenize(sql)) {}
+
+    MemoryStatement parse() {
+        MemoryStatement statement;
+        if (accept_word("SELECT")) {
+            statement.kind = MemoryStatement::select;
+            parse_select(statement);
+        } else if (accept_word("INSERT")) {
+            statement.kind = MemoryStatement::insert;
+            parse_insert(statement);
+        } else if (accept_word("UPDATE")) {
+            statement.kind = MemoryStatement::update;
+            parse_update(statement);
+        } else if (accept_word("DELETE")) {
+            statement.kind = MemoryStatement::remove;
+            expect_word("FROM");
+            statement.tables.push_back(table_ref());
+            parse_where(statement);
+        } else if (accept_word("DESCRIBE") || accept_word("DESC")) {
+            statement.kind = MemoryStatement::describe;
+            statement.tables.push_back({identifier(), ""});
+            statement.tables.back().alias = statement.tables.back().table;
+        } else {
+            unsupported(sql, "only SELECT, INSERT, UPDATE, DELETE and DESCRIBE are supported");
+        }
+        accept_symbol(";");
+        if (peek().kind != Token::end)
+            unsupported(sql, "unexpected \"" + peek().value + "\"");
+        statement.param_count = params;
+        return statement;
+    }
+
+private:
+    const Token &peek(size_t ahead = 0) const {
+        return tokens[std::min(pos + ahead, tokens.size() - 1)];
+    }
+
+    bool is_word(const char *word, size_t ahead = 0) const {
+        return peek(ahead).kind == Token::word && upper(peek(ahead).value) == word;
+    }
+
+    bool accept_word(const char *word) {
+        if (!is_word(word))
+            return false;
+        ++pos;
+        return true;
+    }
+
+    void expect_word(const char *word) {
+        if (!accept_word(word))
+            unsupported(sql, std::string("expected ") + word);
+    }
+
+    bool is_symbol(const char *symbol, size_t ahead = 0) const {
+        return peek(ahead).kind == Token::symbol && peek(ahead).value == symbol;
+    }
+
+    bool accept_symbol(const char *symbol) {
+        if (!is_symbol(symbol))
+            return false;
+        ++pos;
+        return true;
+    }
+
+    void expect_symbol(const char *symbol) {
+        if (!accept_symbol(symbol))
+            unsupported(sql, std::string("expected '") + symbol + "'");
+    }
+
+    std::string identifier() {
+        if (peek().kind != Token::word)
+            unsupported(sql, "expected a name");
+        return tokens[pos++].value;
+    }
+
+    MemoryTableRef table_ref() {
+        MemoryTableRef ref{identifier(), ""};
+        accept_word("AS");
+        if (peek().kind == Token::word && !reserved_words().contains(upper(peek().value)))
+            ref.alias = identifier();
+        else
+            ref.alias = ref.table;
+        return ref;
+    }
+
+    MemoryOperand column_ref() {
+        MemoryOperand operand{MemoryOperand::column, identifier(), "", 0};
+        if (accept_symbol(".")) {
+            operand.qualifier = operand.text;
+            operand.text = identifier();
+        }
+        return operand;
+    }
+
+    MemoryOperand operand() {
+        if (accept_symbol("?"))
+            return {MemoryOperand::placeholder, "", "", params++};
+        if (accept_word("NULL"))
+            return {MemoryOperand::null, "", "", 0};
+        bool negative = accept_symbol("-");
+        if (peek().kind == Token::number)
+            return {MemoryOperand::literal, (negative ? "-" : "") + tokens[pos++].value, "", 0};
+        if (negative)
+            unsupported(sql, "expected a number after '-'");
+        if (peek().kind == Token::text)
+            return {MemoryOperand::literal, tokens[pos++].value, "", 0};
+        return column_ref();
+    }
+
+    void parse_select(MemoryStatement &statement) {
+        do {
+            MemorySelectItem item;
+            if (accept_symbol("*")) {
+                item.kind = MemorySelectItem::all;
+            } else if (peek().kind == Token::word && is_symbol(".", 1) && is_symbol("*", 2)) {
+                item.kind = MemorySelectItem::all;
+                item.value.qualifier = identifier();
+                pos += 2;
+            } else if (is_word("COUNT") && is_symbol("(", 1)) {
+                pos += 2;
+                expect_symbol("*");
+                expect_symbol(")");
+                item.kind = MemorySelectItem::count;
+                item.label = "COUNT(*)";
+            } else if (is_word("LAST_INSERT_ID") && is_symbol("(", 1)) {
+                pos += 2;
+                expect_symbol(")");
+                item.kind = MemorySelectItem::last_insert_id;
+                item.label = "LAST_INSERT_ID()";
+            } else {
+                item.kind = MemorySelectItem::column;
+                item.value = column_ref();
+                item.label = item.value.text;
+            }
+            if (accept_word("AS") || (peek().kind == Token::word && !reserved_words().contains(upper(peek().value))))
+                item.label = identifier();
+            statement.items.push_back(std::move(item));
+        } while (accept_symbol(","));
+
+        if (!accept_word("FROM")) {
+            for (const auto &item : statement.items) {
+                if (item.kind != MemorySelectItem::last_insert_id)
+                    unsupported(sql, "SELECT without FROM only supports LAST_INSERT_ID()");
+            }
+            return;
+        }
+        statement.tables.push_back(table_ref());
+        if (accept_word("INNER") || is_word("JOIN")) {
+            expect_word("JOIN");
+            statement.tables.push_back(table_ref());
+            expect_word("ON");
+            MemoryOperand left = column_ref();
+            expect_symbol("=");
+            MemoryOperand right = column_ref();
+            statement.join_on = std::make_pair(left, right);
+        }
+        if (is_word("JOIN") || is_word("LEFT") || is_symbol(","))
+            unsupported(sql, "only one inner join is supported");
+
+        parse_where(statement);
+
+        if (accept_word("ORDER")) {
+            expect_word("BY");
+            do {
+                MemoryOrder order{column_ref(), false};
+                if (accept_word("DESC"))
+                    order.descending = true;
+                else
+                    accept_word("ASC");
+                statement.order_by.push_back(std::move(order));
+            } while (accept_symbol(","));
+        }
+
+        if (accept_word("LIMIT")) {
+            size_t first = count();
+            if (accept_symbol(",")) {
+                statement.offset = first;
+                statement.limit = count();
+            } else {
+                statement.limit = first;
+                if (accept_word("OFFSET"))
+                    statement.offset = count();
+            }
+        }
+    }
+
+    size_t count() {
+        if (peek().kind != Token::number)
+            unsupported(sql, "LIMIT and OFFSET take literal numbers");
+        return static_cast<size_t>(std::strtoull(tokens[pos++].value.c_str(), nullptr, 10));
+    }
+
+    void parse_insert(MemoryStatement &statement) {
+        statement.ignore = accept_word("IGNORE");
+        accept_word("INTO");
+        statement.tables.push_back({identifier(), ""});
+        statement.tables.back().alias = statement.tables.back().table;
+        expect_symbol("(");
+        do {
+            statement.insert_columns.push_back(identifier());
+        } while (accept_symbol(","));
+        expect_symbol(")");
+        if (!accept_word("VALUES"))
+            expect_word("VALUE");
+        do {
+            expect_symbol("(");
+            std::vector<MemoryOperand> row;
+            do {
+                row.push_back(operand());
+                if (row.back().kind == MemoryOperand::column)
+                    unsupported(sql, "INSERT values must be literals or placeholders");
+            } while (accept_symbol(","));
+            expect_symbol(")");
+            if (row.size() != statement.insert_columns.size())
+                unsupported(sql, "column count doesn't match value count");
+            statement.insert_rows.push_back(std::move(row));
+        } while (accept_symbol(","));
+    }
+
+    void parse_update(MemoryStatement &statement) {
+        statement.tables.push_back(table_ref());
+        expect_word("SET");
+        do {
+            MemoryAssignment assignment;
+            MemoryOperand target = column_ref();
+            assignment.column = target.text;
+            expect_symbol("=");
+            assignment.value = operand();
+            if (assignment.value.kind == MemoryOperand::column) {
+                if (assignment.value.text != assignment.column)
+                    unsupported(sql, "SET can only add to or subtract from the column itself");
+                if (accept_symbol("+"))
+                    assignment.arithmetic = '+';
+                else if (accept_symbol("-"))
+                    assignment.arithmetic = '-';
+                else
+                    unsupported(sql, "SET can only add to or subtract from the column itself");
+                assignment.value = operand();
+            }
+            statement.assignments.push_back(std::move(assignment));
+        } while (accept_symbol(","));
+        parse_where(statement);
+    }
+
+    void parse_where(MemoryStatement &statement) {
+        if (!accept_word("WHERE"))
+            return;
+        do {
+            if (auto term = predicate())
+                statement.where.push_back(std::move(*term));
+        } while (accept_word("AND"));
+        if (is_word("OR"))
+            unsupported(sql, "OR is not supported");
+    }
+
+    /**
+     * @return The term, or std::nullopt for a constant true one, which is dropped.
+     */
+    std::optional<MemoryPredicate> predicate() {
+        MemoryPredicate term;
+        MemoryOperand left = operand();
+        if (left.kind != MemoryOperand::column) {
+            // A constant term such as "1 = 0", which BasicTable uses for an empty ID list.
+            expect_symbol("=");
+            MemoryOperand right = operand();
+            if (right.kind == MemoryOperand::column || left.kind == MemoryOperand::placeholder ||
+                right.kind == MemoryOperand::placeholder)
+                unsupported(sql, "a condition must start with a column");
+            if (left.text == right.text)
+                return std::nullopt;
+            term.op = MemoryPredicate::never;
+            return term;
+        }
+        term.column = left;
+
+        if (accept_word("IS")) {
+            term.op = accept_word("NOT") ? MemoryPredicate::is_not_null : MemoryPredicate::is_null;
+            expect_word("NULL");
+            return term;
+        }
+        if (accept_word("NOT")) {
+            expect_word("LIKE");
+            term.op = MemoryPredicate::not_like;
+            term.values.push_back(value());
+            return term;
+        }
+        if (accept_word("LIKE")) {
+            term.op = MemoryPredicate::like;
+            term.values.push_back(value());
+            return term;
+        }
+        if (accept_word("IN")) {
+            term.op = MemoryPredicate::in;
+            expect_symbol("(");
+            if (accept_word("SELECT")) {
+                auto subquery = std::make_shared<MemoryStatement>();
+                parse_select(*subquery);
+                if (subquery->tables.empty() || subquery->items.size() != 1 ||
+                    subquery->items[0].kind != MemorySelectItem::column)
+                    unsupported(sql, "a subquery must select one column");
+                term.subquery = std::move(subquery);
+            } else {
+                do {
+                    term.values.push_back(value());
+                } while (accept_symbol(","));
+            }
+            expect_symbol(")");
+            return term;
+        }
+        if (accept_word("BETWEEN")) {
+            term.op = MemoryPredicate::between;
+            term.values.push_back(value());
+            expect_word("AND");
+            term.values.push_back(value());
+            return term;
+        }
+
+        static const std::pair<const char *, MemoryPredicate::Op> comparisons[] = {
+            {"=", MemoryPredicate::eq}, {"!=", MemoryPredicate::ne}, {"<>", MemoryPredicate::ne}, {"<=", MemoryPredicate::le},
+            {">=", MemoryPredicate::ge}, {"<", MemoryPredicate::lt}, {">", MemoryPredicate::gt}};
+        for (const auto &[symbol, op] : comparisons) {
+            if (accept_symbol(symbol)) {
+                term.op = op;
+                term.values.push_back(value());
+                return term;
+            }
+        }
+        unsupported(sql, "unsupported condition on " + left.text);
+    }
+
+    MemoryOperand value() {
+        MemoryOperand operand = this->operand();
+        if (operand.kind == MemoryOperand::column)
+            unsupported(sql, "conditions must compare a column with a literal or placeholder");
+        return operand;
+    }
+
+    const std::string &sql;
+    std::vector<Token> tokens;
+    size_t pos = 0;
+    size_t params = 0;
+};
+
+} // namespace
+
+MemoryStatement parse_memory_statement(const std::string &sql) {
+    return Parser(sql).parse();
+}
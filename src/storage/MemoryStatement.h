@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A column, literal, NULL or '?' placeholder in a statement run by MemoryDatabase.
+ */
+struct MemoryOperand {
+    enum Kind { column, literal, null, placeholder };
+    Kind kind = literal;
+
+    /**
+     * @brief The column name or the literal's text.
+     */
+    std::string text;
+
+    /**
+     * @brief Table name or alias qualifying a column, e.g. "cs" in cs.club_id; may be empty.
+     */
+    std::string qualifier;
+
+    /**
+     * @brief Zero-based placeholder position.
+     */
+    size_t param = 0;
+};
+
+struct MemoryStatement;
+
+/**
+ * @brief One "column op value" term of a WHERE clause; terms are joined by AND.
+ */
+struct MemoryPredicate {
+    enum Op { eq, ne, lt, le, gt, ge, like, not_like, in, between, is_null, is_not_null, never };
+    Op op = eq;
+
+    /**
+     * @brief The column tested; unused for never, which a constant false term such as "1 = 0" becomes.
+     */
+    MemoryOperand column;
+
+    /**
+     * @brief The values compared with: one, two for between, the list for in, none for the NULL tests.
+     */
+    std::vector<MemoryOperand> values;
+
+    /**
+     * @brief For in with a subquery instead of a list, e.g. IN (SELECT student_id FROM Club_Student
+     * WHERE club_id = ?): a one-column SELECT whose rows are the values.
+     */
+    std::shared_ptr<const MemoryStatement> subquery;
+};
+
+/**
+ * @brief One entry of a select list.
+ */
+struct MemorySelectItem {
+    enum Kind { all, column, count, last_insert_id };
+    Kind kind = all;
+
+    /**
+     * @brief The column for column; for all, the qualifier of "alias.*" or empty for "*".
+     */
+    MemoryOperand value;
+
+    /**
+     * @brief The label of the result column.
+     */
+    std::string label;
+};
+
+struct MemoryTableRef {
+    std::string table;
+
+    /**
+     * @brief The alias, or the table name when there is none.
+     */
+    std::string alias;
+};
+
+/**
+ * @brief "column = value", or "column = column + value" / "column - value" when arithmetic is set.
+ */
+struct MemoryAssignment {
+    std::string column;
+    MemoryOperand value;
+    char arithmetic = 0;
+};
+
+struct MemoryOrder {
+    MemoryOperand column;
+    bool descending = false;
+};
+
+/**
+ * @brief A parsed statement, kept by MemoryConnection like a server keeps a prepared statement.
+ *
+ * The supported shapes are the ones BasicTable builds and the simple reads and writes of the
+ * service layer: single-table SELECT, INSERT, UPDATE and DELETE, an inner JOIN of two tables on one
+ * equality, WHERE terms joined by AND, IN with a one-column subquery, COUNT(*), ORDER BY, LIMIT/OFFSET,
+ * LAST_INSERT_ID() and DESCRIBE.
+ */
+struct MemoryStatement {
+    enum Kind { select, insert, update, remove, describe };
+    Kind kind = select;
+
+    /**
+     * @brief One table, or two for a join; the target of INSERT, UPDATE, DELETE and DESCRIBE.
+     */
+    std::vector<MemoryTableRef> tables;
+
+    std::vector<MemorySelectItem> items;
+
+    /**
+     * @brief The two columns of the join's ON clause.
+     */
+    std::optional<std::pair<MemoryOperand, MemoryOperand>> join_on;
+
+    std::vector<MemoryPredicate> where;
+    std::vector<MemoryOrder> order_by;
+    std::optional<size_t> limit;
+    size_t offset = 0;
+
+    std::vector<std::string> insert_columns;
+    std::vector<std::vector<MemoryOperand>> insert_rows;
+
+    /**
+     * @brief INSERT IGNORE: rows that would duplicate a key are skipped.
+     */
+    bool ignore = false;
+
+    std::vector<MemoryAssignment> assignments;
+
+    /**
+     * @brief Number of '?' placeholders.
+     */
+    size_t param_count = 0;
+};
+
+/**
+ * @brief Parses a statement for MemoryDatabase.
+ * @param sql The statement text, with '?' placeholders.
+ * @return The parsed statement.
+ * @throws sql::SQLException if the statement is not one of the supported shapes.
+ */
+MemoryStatement parse_memory_statement(const std::string &sql);
@@ -0,0 +1,61 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include <cppconn/resultset.h>
+
+#include "../service/BasicTable.h"
+#include "MySqlBackend.h"
+
+MySqlResult::MySqlResult(std::unique_ptr<sql::ResultSet> res) : res(std::move(res)) {
+    sql::ResultSetMetaData *metadata = this->res->getMetaData();
+    unsigned int count = metadata->getColumnCount();
+    columns.reserve(count);
+    for (unsigned int i = 1; i <= count; ++i)
+        columns.push_back(metadata->getColumnLabel(i));
+}
+
+bool MySqlResult::next() {
+    return res->next();
+}
+
+size_t MySqlResult::rows_count() const {
+    return res->rowsCount();
+}
+
+size_t MySqlResult::column_count() const {
+    return columns.size();
+}
+
+const std::string &MySqlResult::column_name(size_t column) const {
+    return columns[column];
+}
+
+bool MySqlResult::is_null(size_t column) const {
+    return res->isNull(static_cast<unsigned int>(column + 1));
+}
+
+std::string MySqlResult::get_string(size_t column) const {
+    return res->getString(static_cast<unsigned int>(column + 1));
+}
+
+int MySqlResult::get_int(size_t column) const {
+    return res->getInt(static_cast<unsigned int>(column + 1));
+}
+
+double MySqlResult::get_double(size_t column) const {
+    return static_cast<double>(res->getDouble(static_cast<unsigned int>(column + 1)));
+}
+
+MySqlConnection::MySqlConnection(std::shared_ptr<sql::Connection> conn) : con(conn) {}
+
+std::unique_ptr<DbResult> MySqlConnection::execute_query(const std::string &query, const std::vector<SqlParam> &params) {
+    return std::make_unique<MySqlResult>(BasicTable::execute_query(*con, query, params));
+}
+
+int MySqlConnection::execute_update(const std::string &query, const std::vector<SqlParam> &params) {
+    return BasicTable::execute_update(*con, query, params);
+}
+
+std::shared_ptr<sql::Connection> MySqlConnection::session() const {
+    return con;
+}
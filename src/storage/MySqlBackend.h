@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cppconn/connection.h>
+#include <cppconn/resultset.h>
+
+#include "DbBackend.h"
+
+/**
+ * @brief A DbResult over a sql::ResultSet.
+ */
+class MySqlResult : public DbResult {
+public:
+    explicit MySqlResult(std::unique_ptr<sql::ResultSet> res);
+
+    bool next() override;
+    size_t rows_count() const override;
+    size_t column_count() const override;
+    const std::string &column_name(size_t column) const override;
+    bool is_null(size_t column) const override;
+    std::string get_string(size_t column) const override;
+    int get_int(size_t column) const override;
+    double get_double(size_t column) const override;
+
+private:
+    std::unique_ptr<sql::ResultSet> res;
+    std::vector<std::string> columns;
+};
+
+/**
+ * @brief A DbConnection on a MySQL server. Statements go through BasicTable, so they are traced,
+ * logged and reported to the slow-query log and digest table like every other statement.
+ */
+class MySqlConnection : public DbConnection {
+public:
+    explicit MySqlConnection(std::shared_ptr<sql::Connection> conn);
+
+    std::unique_ptr<DbResult> execute_query(const std::string &query, const std::vector<SqlParam> &params = {}) override;
+    int execute_update(const std::string &query, const std::vector<SqlParam> &params = {}) override;
+    std::shared_ptr<sql::Connection> session() const override;
+
+private:
+    std::shared_ptr<sql::Connection> con;
+};
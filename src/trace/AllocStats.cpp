@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+
+#include "AllocStats.h"
+#include "Tracer.h"
+
+namespace {
+
+thread_local AllocCounters counters;
+
+/**
+ * @brief Set while AllocStats itself allocates, so its bookkeeping is not charged to spans.
+ */
+thread_local bool suspended = false;
+
+struct SpanTable {
+    std::mutex mutex;
+    std::map<std::pair<std::string, std::string>, AllocStats::SpanStats> spans;
+};
+
+SpanTable &span_table() {
+    static SpanTable *instance = new SpanTable; // never destroyed: spans may close during static destruction
+    return *instance;
+}
+
+} // namespace
+
+#ifdef SEV_ALLOC_STATS
+
+namespace {
+
+void *counted_alloc(std::size_t size, std::size_t alignment) {
+    if (size == 0)
+        size = 1;
+    void *p = alignment > alignof(std::max_align_t)
+                  ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+                  : std::malloc(size);
+    if (p && !suspended) {
+        ++counters.allocations;
+        counters.bytes += size;
+    }
+    return p;
+}
+
+void counted_free(void *p) {
+    if (!p)
+        return;
+    if (!suspended)
+        ++counters.frees;
+    std::free(p);
+}
+
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (void *p = counted_alloc(size, 0))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    if (void *p = counted_alloc(size, 0))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    if (void *p = counted_alloc(size, static_cast<std::size_t>(alignment)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    if (void *p = counted_alloc(size, static_cast<std::size_t>(alignment)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size, 0);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_alloc(size, 0);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept { counted_free(p); }
+void operator delete[](void *p) noexcept { counted_free(p); }
+void operator delete(void *p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void *p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { counted_free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { counted_free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { counted_free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { counted_free(p); }
+
+#endif
+
+AllocCounters AllocStats::thread_counters() {
+    return counters;
+}
+
+long AllocStats::peak_rss_kib() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+AllocStats::Mark AllocStats::mark() {
+    return {counters, Tracer::now_ns(), peak_rss_kib()};
+}
+
+void AllocStats::record_span(const char *category, const char *name, const Mark &start) {
+    AllocCounters end = counters;
+    int64_t elapsed_ns = Tracer::now_ns() - start.start_ns;
+    long rss_growth = peak_rss_kib() - start.peak_rss_kib;
+
+    suspended = true;
+    {
+        SpanTable &table = span_table();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        SpanStats &stats = table.spans[{category, name}];
+        if (stats.calls == 0) {
+            stats.category = category;
+            stats.name = name;
+        }
+        ++stats.calls;
+        stats.counters.allocations += end.allocations - start.counters.allocations;
+        stats.counters.bytes += end.bytes - start.counters.bytes;
+        stats.counters.frees += end.frees - start.counters.frees;
+        stats.total_ns += elapsed_ns;
+        stats.max_rss_growth_kib = std::max(stats.max_rss_growth_kib, rss_growth);
+    }
+    suspended = false;
+}
+
+std::vector<AllocStats::SpanStats> AllocStats::spans(const char *category) {
+    std::vector<SpanStats> result;
+    {
+        SpanTable &table = span_table();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        for (const auto &[key, stats] : table.spans) {
+            if (!category || key.first == category)
+                result.push_back(stats);
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const SpanStats &a, const SpanStats &b) { return a.counters.bytes > b.counters.bytes; });
+    return result;
+}
+
+void AllocStats::reset() {
+    SpanTable &table = span_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    table.spans.clear();
+}
+
+void AllocStats::print(const char *category) {
+    std::printf("%-8s %-48s %8s %11s %12s %11s %9s\n", "category", "span", "calls", "allocs/call", "bytes/call",
+                "us/call", "+rss(KiB)");
+    for (const auto &stats : spans(category)) {
+        double calls = static_cast<double>(stats.calls);
+        std::printf("%-8s %-48s %8llu %11.1f %12.0f %11.1f %9ld\n", stats.category.c_str(), stats.name.c_str(),
+                    static_cast<unsigned long long>(stats.calls), static_cast<double>(stats.counters.allocations) / calls,
+                    static_cast<double>(stats.counters.bytes) / calls, static_cast<double>(stats.total_ns) / calls / 1e3,
+                    stats.max_rss_growth_kib);
+    }
+    std::printf("peak RSS: %ld KiB\n", peak_rss_kib());
+}
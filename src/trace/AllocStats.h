@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Heap activity counted by the replaced operator new/delete.
+ */
+struct AllocCounters {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t frees = 0;
+};
+
+/**
+ * @brief Allocation accounting for the instrumentation build (make ALLOC_STATS=1, which defines
+ * SEV_ALLOC_STATS).
+ *
+ * In that build the global operator new/delete count allocations, requested bytes and frees
+ * per thread, and every TraceSpan adds what happened between its start and end, together
+ * with its duration and how much it raised the process's peak RSS, to a table keyed by span
+ * category and name. Figures are inclusive: a service method's numbers contain those of the
+ * statements and rendering it ran. In a regular build nothing is counted and the table stays
+ * empty.
+ */
+class AllocStats {
+public:
+#ifdef SEV_ALLOC_STATS
+    static constexpr bool compiled = true;
+#else
+    static constexpr bool compiled = false;
+#endif
+
+    /**
+     * @brief Totals of one span name.
+     */
+    struct SpanStats {
+        std::string category;
+        std::string name;
+        uint64_t calls = 0;
+        AllocCounters counters;
+        int64_t total_ns = 0;
+
+        /**
+         * @brief The most one call raised the process's peak RSS, in KiB.
+         */
+        long max_rss_growth_kib = 0;
+    };
+
+    /**
+     * @brief State at the start of a span.
+     */
+    struct Mark {
+        AllocCounters counters;
+        int64_t start_ns;
+        long peak_rss_kib;
+    };
+
+    /**
+     * @brief The calling thread's counters since it started; all zero unless compiled.
+     */
+    static AllocCounters thread_counters();
+
+    /**
+     * @brief The process's peak resident set size so far, in KiB.
+     */
+    static long peak_rss_kib();
+
+    /**
+     * @brief Called by TraceSpan when it opens.
+     */
+    static Mark mark();
+
+    /**
+     * @brief Called by TraceSpan when it closes; adds the difference to start to the span's totals.
+     * Allocations made while recording are not counted.
+     */
+    static void record_span(const char *category, const char *name, const Mark &start);
+
+    /**
+     * @brief Returns the span totals, the most bytes allocated first.
+     * @param category Only spans of this category, e.g. "service"; nullptr for all.
+     */
+    static std::vector<SpanStats> spans(const char *category = nullptr);
+
+    /**
+     * @brief Forgets all span totals.
+     */
+    static void reset();
+
+    /**
+     * @brief Prints span totals as a table with calls, allocations and bytes per call and latency.
+     * @param category Only spans of this category; nullptr for all.
+     */
+    static void print(const char *category = nullptr);
+};
@@ -0,0 +1,172 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../utils.h"
+#include "Tracer.h"
+
+namespace {
+
+struct TraceEvent {
+    const char *category;
+    const char *name;
+    std::string detail;
+    int64_t start_ns;
+    int64_t end_ns;
+};
+
+/**
+ * @brief Spans of one thread. Only the owning thread appends, so the mutex is uncontended
+ * except while write() copies the events out.
+ */
+struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    uint64_t dropped = 0;
+    uint32_t tid = 0;
+    std::string thread_name;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    uint32_t next_tid = 1;
+};
+
+Registry &registry() {
+    static Registry instance;
+    return instance;
+}
+
+// Shared with the registry so that the spans of a finished thread survive until write().
+ThreadBuffer &local_buffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto created = std::make_shared<ThreadBuffer>();
+        Registry &all = registry();
+        std::lock_guard<std::mutex> lock(all.mutex);
+        created->tid = all.next_tid++;
+        all.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+void append_json_string(std::string &out, const std::string &text) {
+    out += '"';
+    for (unsigned char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    out += '"';
+}
+
+void append_micros(std::string &out, int64_t ns) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", static_cast<double>(ns) / 1000.0);
+    out += buffer;
+}
+
+} // namespace
+
+void Tracer::enable() {
+    now_ns();
+    active.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::disable() {
+    active.store(false, std::memory_order_relaxed);
+}
+
+int64_t Tracer::now_ns() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Tracer::record(const char *category, const char *name, std::string detail, int64_t start_ns, int64_t end_ns) {
+    ThreadBuffer &buffer = local_buffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= max_events_per_thread) {
+        ++buffer.dropped;
+        return;
+    }
+    buffer.events.push_back(TraceEvent{category, name, std::move(detail), start_ns, end_ns});
+}
+
+void Tracer::set_thread_name(const std::string &name) {
+    ThreadBuffer &buffer = local_buffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.thread_name = name;
+}
+
+bool Tracer::write(const std::string &path) {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        Registry &all = registry();
+        std::lock_guard<std::mutex> lock(all.mutex);
+        buffers = all.buffers;
+    }
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    size_t events = 0;
+    uint64_t dropped = 0;
+    for (const auto &buffer : buffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        std::string tid = std::to_string(buffer->tid);
+        if (!buffer->thread_name.empty()) {
+            out += first ? "\n" : ",\n";
+            first = false;
+            out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":";
+            append_json_string(out, buffer->thread_name);
+            out += "}}";
+        }
+        for (const auto &event : buffer->events) {
+            out += first ? "\n" : ",\n";
+            first = false;
+            out += "{\"name\":";
+            append_json_string(out, event.name);
+            out += ",\"cat\":";
+            append_json_string(out, event.category);
+            out += ",\"ph\":\"X\",\"pid\":1,\"tid\":" + tid + ",\"ts\":";
+            append_micros(out, event.start_ns);
+            out += ",\"dur\":";
+            append_micros(out, event.end_ns - event.start_ns);
+            if (!event.detail.empty()) {
+                out += ",\"args\":{\"detail\":";
+                append_json_string(out, event.detail);
+                out += '}';
+            }
+            out += '}';
+        }
+        events += buffer->events.size();
+        dropped += buffer->dropped;
+    }
+    out += "\n]}\n";
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+        Logger(ll_error, "Failed to write trace to " + path).log();
+        return false;
+    }
+    Logger(ll_info, "Wrote " + std::to_string(events) + " trace events to " + path +
+                        (dropped ? " (" + std::to_string(dropped) + " dropped over the per-thread limit)" : ""))
+        .log();
+    return true;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "AllocStats.h"
+
+/**
+ * @brief Process-wide switch and sink for TraceSpan events.
+ *
+ * Every thread appends finished spans to its own buffer, so recording takes no shared lock.
+ * write() merges the buffers into Chrome Trace Event JSON, which Perfetto (ui.perfetto.dev)
+ * and chrome://tracing open directly. Spans nest by time, so a menu action shows the service
+ * methods it called, their BasicTable primitives and the prepare/execute of each statement.
+ */
+class Tracer {
+public:
+    /**
+     * @brief Spans started from now on are recorded.
+     */
+    static void enable();
+
+    /**
+     * @brief Stops recording; buffered spans are kept until write().
+     */
+    static void disable();
+
+    /**
+     * @brief Whether spans are recorded; a relaxed load, so a disabled span costs one branch.
+     */
+    static bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Nanoseconds on the steady clock since the tracer was first used.
+     */
+    static int64_t now_ns();
+
+    /**
+     * @brief Appends a finished span to the calling thread's buffer.
+     * A thread keeps at most max_events_per_thread spans; later ones are counted and dropped.
+     */
+    static void record(const char *category, const char *name, std::string detail, int64_t start_ns, int64_t end_ns);
+
+    /**
+     * @brief Names the calling thread in the trace, e.g. "refresh" for a background index thread.
+     */
+    static void set_thread_name(const std::string &name);
+
+    /**
+     * @brief Writes every buffered span as Chrome Trace Event JSON.
+     * @param path The output file.
+     * @return True on success, false if the file could not be written.
+     */
+    static bool write(const std::string &path);
+
+    static constexpr size_t max_events_per_thread = 1 << 20;
+
+private:
+    static inline std::atomic<bool> active{false};
+};
+
+/**
+ * @brief Times the enclosing scope as one trace event.
+ *
+ * Names and categories must be string literals (or otherwise outlive the trace); only the
+ * optional detail, e.g. the SQL of a statement, is copied, and only while tracing is enabled.
+ */
+class TraceSpan {
+public:
+    /**
+     * @param category "menu", "service", "table", "sql", "fetch", "render" or "log".
+     * @param name What the span covers, e.g. "ClubTable::read_activity_by_id".
+     */
+    TraceSpan(const char *category, const char *name) : category(category), name(name), parent(innermost) {
+        innermost = this;
+#ifdef SEV_ALLOC_STATS
+        alloc_start = AllocStats::mark();
+#endif
+        if (Tracer::enabled())
+            start_ns = Tracer::now_ns();
+    }
+
+    /**
+     * @param detail Shown as the span's "detail" argument.
+     */
+    TraceSpan(const char *category, const char *name, const std::string &detail)
+        : category(category), name(name), parent(innermost) {
+        innermost = this;
+#ifdef SEV_ALLOC_STATS
+        alloc_start = AllocStats::mark();
+#endif
+        if (Tracer::enabled()) {
+            this->detail = detail;
+            start_ns = Tracer::now_ns();
+        }
+    }
+
+    ~TraceSpan() {
+        innermost = parent;
+        if (start_ns >= 0)
+            Tracer::record(category, name, std::move(detail), start_ns, Tracer::now_ns());
+#ifdef SEV_ALLOC_STATS
+        AllocStats::record_span(category, name, alloc_start);
+#endif
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    /**
+     * @brief The name of the innermost open span of a category on the calling thread, e.g. the
+     * service method a statement runs for. Spans are tracked whether or not tracing is enabled.
+     * @return The name, or nullptr if no span of that category is open.
+     */
+    static const char *enclosing(const char *category) {
+        for (const TraceSpan *span = innermost; span; span = span->parent) {
+            if (std::strcmp(span->category, category) == 0)
+                return span->name;
+        }
+        return nullptr;
+    }
+
+private:
+    const char *category;
+    const char *name;
+    std::string detail;
+    int64_t start_ns = -1;
+    TraceSpan *parent;
+#ifdef SEV_ALLOC_STATS
+    AllocStats::Mark alloc_start;
+#endif
+
+    static inline thread_local TraceSpan *innermost = nullptr;
+};
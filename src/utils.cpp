@@ -1,12 +1,15 @@
 #include <iostream>
 #include <vector>
 #include <memory>
-#include <iomanip>
 #include <limits>
-
-#include <cppconn/resultset.h>
+#include <optional>
+#include <string>
+#include <string_view>
 
 #include "utils.h"
+#include "render/TableRenderer.h"
+#include "service/QueryResult.h"
+#include "storage/DbBackend.h"
 
 constexpr auto max_size = std::numeric_limits<std::streamsize>::max();
 
@@ -19,59 +22,52 @@ void clear_cin_buffer() {
     std::cin.ignore(max_size, '\n');
 }
 
-void print_separator(const std::vector<int>& column_widths) {
-    for (const auto& width : column_widths) {
-        std::cout << "+" << std::string(width + 2, '-');
-    }
-    std::cout << "+\n";
+static void render_query_result(const QueryResult& res) {
+    render_table(res.column_names(), res.rows_count(),
+                 [&](size_t row, size_t column) { return res.get_string(row, column); });
 }
 
-void print_row(const std::vector<std::string>& values, const std::vector<int>& column_widths) {
-    for (size_t i = 0; i < values.size(); ++i) {
-        std::cout << "| " << std::setw(column_widths[i]) << std::left << values[i] << " ";
+void print_result_set(std::unique_ptr<DbResult>& res) {
+    TraceSpan span("render", "print_result_set");
+    if (res == nullptr) {
+        Logger(ll_error, "DbResult is null");
+        return;
     }
-    std::cout << "|\n";
+
+    render_query_result(*QueryResult::from_db_result(*res));
 }
 
-void print_result_set(std::unique_ptr<sql::ResultSet>& res) {
+void print_result_set(const std::shared_ptr<const QueryResult>& res) {
+    TraceSpan span("render", "print_result_set");
     if (res == nullptr) {
-        Logger(ll_error, "ResultSet is null");
+        Logger(ll_error, "QueryResult is null").log();
         return;
     }
 
-    // Retrieve metadata
-    sql::ResultSetMetaData* metadata = res->getMetaData();
-    int column_count = metadata->getColumnCount();    
+    render_query_result(*res);
+}
 
-    std::vector<std::string> column_names(column_count);
-    std::vector<int> column_widths(column_count, 10);
-    
-    // Initialize column names and determine maximum widths
-    for (int i = 1; i <= column_count; ++i) {
-        std::string column_name = metadata->getColumnName(i);
-        column_names[i - 1] = column_name;
-        column_widths[i - 1] = std::max(column_widths[i - 1], static_cast<int>(column_name.length()));
+std::optional<int> date_to_days(const std::string& date) {
+    if (date.size() < 10 || date[4] != '-' || date[7] != '-')
+        return std::nullopt;
+    for (size_t i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+        if (date[i] < '0' || date[i] > '9')
+            return std::nullopt;
     }
 
-    std::vector<std::vector<std::string>> rows;
-
-    // Store each row
-    while (res->next()) {
-        std::vector<std::string> row_values(column_count);
-        for (int i = 1; i <= column_count; ++i) {
-            std::string value = res->getString(i);
-            row_values[i - 1] = value;
-            column_widths[i - 1] = std::max(column_widths[i - 1], static_cast<int>(value.length()));
-        }
-        rows.push_back(row_values);
-    }
+    int y = std::stoi(date.substr(0, 4));
+    unsigned m = static_cast<unsigned>(std::stoi(date.substr(5, 2)));
+    unsigned d = static_cast<unsigned>(std::stoi(date.substr(8, 2)));
+    static const unsigned month_days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+    if (m < 1 || m > 12 || d < 1 || d > month_days[m - 1] + (m == 2 && leap ? 1 : 0))
+        return std::nullopt;
 
-    // Print table
-    print_separator(column_widths);
-    print_row(column_names, column_widths);
-    print_separator(column_widths);
-    for (const auto& row : rows) {
-        print_row(row, column_widths);
-    }
-    print_separator(column_widths);
-}
\ No newline at end of file
+    // Days from civil date (proleptic Gregorian calendar).
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = static_cast<unsigned>(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int>(doe) - 719468;
+}
@@ -2,9 +2,16 @@
 
 #include <ctime>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "trace/Tracer.h"
+
+class DbResult;
+class QueryResult;
+
 enum loglevel {
     /**
      * @brief Trace
@@ -75,6 +82,7 @@ public:
     Logger(enum loglevel ll, std::string msg) : severity(ll), message(msg) {}
 
     void log() {
+        TraceSpan span("log", "Logger::log");
         std::time_t now = std::time(nullptr);
         std::tm *localTime = std::localtime(&now);
 
@@ -96,20 +104,20 @@ void clear_cin_error();
 void clear_cin_buffer();
 
 /**
- * @brief Helper function to print a separator line for the table.
- * @param column_widths Vector of column widths for formatting.
+ * @brief Prints the rest of a DbResult as a table to the console.
+ * @param res A unique pointer to the DbResult containing the query results.
  */
-void print_separator(const std::vector<int>& column_widths);
+void print_result_set(std::unique_ptr<DbResult>& res);
 
 /**
- * @brief Helper function to print a row with column values in the table.
- * @param values Vector of string values for the row.
- * @param column_widths Vector of column widths for formatting.
+ * @brief Prints a materialized QueryResult as a table to the console.
+ * @param res A shared pointer to the result to print.
  */
-void print_row(const std::vector<std::string>& values, const std::vector<int>& column_widths);
+void print_result_set(const std::shared_ptr<const QueryResult>& res);
 
 /**
- * @brief Prints the ResultSet as a table to the console.
- * @param res A unique pointer to the ResultSet containing the query results.
+ * @brief Converts a "YYYY-MM-DD" date to a day number (days since 1970-01-01). A trailing time part is ignored.
+ * @param date The date string, as MySQL returns DATE and DATETIME values.
+ * @return The day number, or std::nullopt if date is not a valid calendar date.
  */
-void print_result_set(std::unique_ptr<sql::ResultSet>& res);
\ No newline at end of file
+std::optional<int> date_to_days(const std::string& date);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../trace/Tracer.h"
+#include "WorkloadLog.h"
+
+inline WorkloadValue to_workload_value(int value) {
+    return static_cast<int64_t>(value);
+}
+
+inline WorkloadValue to_workload_value(unsigned value) {
+    return static_cast<int64_t>(value);
+}
+
+inline WorkloadValue to_workload_value(double value) {
+    return value;
+}
+
+inline WorkloadValue to_workload_value(const std::string &value) {
+    return value;
+}
+
+inline WorkloadValue to_workload_value(std::span<const int> values) {
+    return std::vector<int64_t>(values.begin(), values.end());
+}
+
+inline WorkloadValue to_workload_value(const std::vector<std::pair<std::string, std::string>> &values) {
+    return values;
+}
+
+inline WorkloadValue to_workload_value(const std::map<std::string, std::string> &values) {
+    return std::vector<std::pair<std::string, std::string>>(values.begin(), values.end());
+}
+
+inline WorkloadValue to_workload_value(const std::set<std::string> &values) {
+    return std::vector<std::string>(values.begin(), values.end());
+}
+
+/**
+ * @brief Opens the "service" trace span of a public service method and, while a workload
+ * capture is running, records the call with its arguments.
+ *
+ * Only outermost calls are captured: a service method called by another one is replayed
+ * by replaying its caller.
+ */
+class ServiceCall {
+public:
+    /**
+     * @param method A string literal naming the method, e.g. "ClubTable::add_member".
+     * @param args The method's parameters in declaration order.
+     */
+    template <typename... Args>
+    explicit ServiceCall(const char *method, const Args &...args) : span("service", method) {
+        if (outermost && WorkloadCapture::active())
+            WorkloadCapture::record(method, {to_workload_value(args)...});
+    }
+
+    ServiceCall(const ServiceCall &) = delete;
+    ServiceCall &operator=(const ServiceCall &) = delete;
+
+private:
+    // Declared before span, so it is evaluated before this call's own span opens.
+    bool outermost = TraceSpan::enclosing("service") == nullptr;
+    TraceSpan span;
+};
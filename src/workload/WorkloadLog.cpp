@@ -0,0 +1,299 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../utils.h"
+#include "WorkloadLog.h"
+
+namespace {
+
+constexpr char magic[] = {'S', 'E', 'V', 'W'};
+constexpr uint8_t version = 1;
+constexpr size_t flush_bytes = 64 << 10;
+
+enum RecordType : uint8_t { method_record = 0, call_record = 1 };
+
+struct CaptureState {
+    std::mutex mutex;
+    std::ofstream file;
+    std::string buffer;
+    std::map<const char *, uint64_t> method_ids;
+    std::chrono::steady_clock::time_point started;
+};
+
+CaptureState &state() {
+    static CaptureState instance;
+    return instance;
+}
+
+uint32_t session_id() {
+    static std::atomic<uint32_t> next{1};
+    thread_local uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void put_varint(std::string &out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+void put_signed(std::string &out, int64_t value) {
+    put_varint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void put_string(std::string &out, const std::string &text) {
+    put_varint(out, text.size());
+    out += text;
+}
+
+void put_value(std::string &out, const WorkloadValue &value) {
+    out += static_cast<char>(value.index());
+    if (const int64_t *number = std::get_if<int64_t>(&value)) {
+        put_signed(out, *number);
+    } else if (const double *real = std::get_if<double>(&value)) {
+        char bytes[sizeof(double)];
+        std::memcpy(bytes, real, sizeof(double));
+        out.append(bytes, sizeof(double));
+    } else if (const std::string *text = std::get_if<std::string>(&value)) {
+        put_string(out, *text);
+    } else if (const auto *numbers = std::get_if<std::vector<int64_t>>(&value)) {
+        put_varint(out, numbers->size());
+        for (int64_t number : *numbers)
+            put_signed(out, number);
+    } else if (const auto *pairs = std::get_if<std::vector<std::pair<std::string, std::string>>>(&value)) {
+        put_varint(out, pairs->size());
+        for (const auto &[first, second] : *pairs) {
+            put_string(out, first);
+            put_string(out, second);
+        }
+    } else {
+        const auto &texts = std::get<std::vector<std::string>>(value);
+        put_varint(out, texts.size());
+        for (const auto &text : texts)
+            put_string(out, text);
+    }
+}
+
+/**
+ * @brief Reads the encoding above; every getter fails once the input is exhausted or malformed.
+ */
+class Reader {
+public:
+    explicit Reader(const std::string &data) : data(data) {}
+
+    bool done() const {
+        return pos >= data.size();
+    }
+
+    std::optional<uint64_t> varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(data[pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<int64_t> signed_varint() {
+        auto raw = varint();
+        if (!raw)
+            return std::nullopt;
+        return static_cast<int64_t>((*raw >> 1) ^ (~(*raw & 1) + 1));
+    }
+
+    std::optional<std::string> string() {
+        auto size = varint();
+        if (!size || *size > data.size() - pos)
+            return std::nullopt;
+        std::string text = data.substr(pos, *size);
+        pos += *size;
+        return text;
+    }
+
+    std::optional<WorkloadValue> value() {
+        if (done())
+            return std::nullopt;
+        uint8_t tag = static_cast<uint8_t>(data[pos++]);
+        switch (tag) {
+        case 0: {
+            auto number = signed_varint();
+            return number ? std::optional<WorkloadValue>(*number) : std::nullopt;
+        }
+        case 1: {
+            if (data.size() - pos < sizeof(double))
+                return std::nullopt;
+            double real;
+            std::memcpy(&real, data.data() + pos, sizeof(double));
+            pos += sizeof(double);
+            return WorkloadValue(real);
+        }
+        case 2: {
+            auto text = string();
+            return text ? std::optional<WorkloadValue>(std::move(*text)) : std::nullopt;
+        }
+        case 3: {
+            auto count = varint();
+            std::vector<int64_t> numbers;
+            for (uint64_t i = 0; count && i < *count; ++i) {
+                auto number = signed_varint();
+                if (!number)
+                    return std::nullopt;
+                numbers.push_back(*number);
+            }
+            return count ? std::optional<WorkloadValue>(std::move(numbers)) : std::nullopt;
+        }
+        case 4: {
+            auto count = varint();
+            std::vector<std::pair<std::string, std::string>> pairs;
+            for (uint64_t i = 0; count && i < *count; ++i) {
+                auto first = string();
+                auto second = string();
+                if (!first || !second)
+                    return std::nullopt;
+                pairs.emplace_back(std::move(*first), std::move(*second));
+            }
+            return count ? std::optional<WorkloadValue>(std::move(pairs)) : std::nullopt;
+        }
+        case 5: {
+            auto count = varint();
+            std::vector<std::string> texts;
+            for (uint64_t i = 0; count && i < *count; ++i) {
+                auto text = string();
+                if (!text)
+                    return std::nullopt;
+                texts.push_back(std::move(*text));
+            }
+            return count ? std::optional<WorkloadValue>(std::move(texts)) : std::nullopt;
+        }
+        default:
+            return std::nullopt;
+        }
+    }
+
+private:
+    const std::string &data;
+    size_t pos = 0;
+};
+
+} // namespace
+
+bool WorkloadCapture::start(const std::string &path) {
+    CaptureState &capture = state();
+    std::lock_guard<std::mutex> lock(capture.mutex);
+    capture.file.open(path, std::ios::binary | std::ios::trunc);
+    if (!capture.file) {
+        Logger(ll_error, "Failed to create workload capture " + path).log();
+        return false;
+    }
+    capture.buffer.assign(magic, sizeof(magic));
+    capture.buffer += static_cast<char>(version);
+    capture.method_ids.clear();
+    capture.started = std::chrono::steady_clock::now();
+    capturing.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void WorkloadCapture::stop() {
+    CaptureState &capture = state();
+    std::lock_guard<std::mutex> lock(capture.mutex);
+    if (!capturing.exchange(false))
+        return;
+    capture.file.write(capture.buffer.data(), static_cast<std::streamsize>(capture.buffer.size()));
+    capture.buffer.clear();
+    capture.file.close();
+}
+
+void WorkloadCapture::record(const char *method, const std::vector<WorkloadValue> &args) {
+    uint32_t session = session_id();
+    auto now = std::chrono::steady_clock::now();
+
+    CaptureState &capture = state();
+    std::lock_guard<std::mutex> lock(capture.mutex);
+    if (!capturing.load(std::memory_order_relaxed))
+        return;
+
+    auto [it, inserted] = capture.method_ids.try_emplace(method, capture.method_ids.size());
+    if (inserted) {
+        capture.buffer += static_cast<char>(method_record);
+        put_varint(capture.buffer, it->second);
+        put_string(capture.buffer, method);
+    }
+
+    capture.buffer += static_cast<char>(call_record);
+    put_varint(capture.buffer, it->second);
+    put_varint(capture.buffer, session);
+    put_varint(capture.buffer,
+               static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - capture.started).count()));
+    put_varint(capture.buffer, args.size());
+    for (const auto &arg : args)
+        put_value(capture.buffer, arg);
+
+    if (capture.buffer.size() >= flush_bytes) {
+        capture.file.write(capture.buffer.data(), static_cast<std::streamsize>(capture.buffer.size()));
+        capture.buffer.clear();
+    }
+}
+
+std::optional<std::vector<WorkloadCall>> read_workload(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        Logger(ll_error, "Failed to open workload capture " + path).log();
+        return std::nullopt;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(magic) + 1 || data.compare(0, sizeof(magic), magic, sizeof(magic)) != 0 ||
+        static_cast<uint8_t>(data[sizeof(magic)]) != version) {
+        Logger(ll_error, path + " is not a workload capture").log();
+        return std::nullopt;
+    }
+
+    std::string body = data.substr(sizeof(magic) + 1);
+    Reader reader(body);
+    std::map<uint64_t, std::string> methods;
+    std::vector<WorkloadCall> calls;
+    while (!reader.done()) {
+        auto type = reader.varint();
+        auto id = reader.varint();
+        if (type && id && *type == method_record) {
+            auto name = reader.string();
+            if (!name)
+                break;
+            methods[*id] = std::move(*name);
+            continue;
+        }
+
+        auto session = reader.varint();
+        auto at_us = reader.varint();
+        auto count = reader.varint();
+        auto method = id ? methods.find(*id) : methods.end();
+        if (!type || *type != call_record || !session || !at_us || !count || method == methods.end())
+            break;
+
+        WorkloadCall call{static_cast<uint32_t>(*session), static_cast<int64_t>(*at_us), method->second, {}};
+        bool complete = true;
+        for (uint64_t i = 0; i < *count && complete; ++i) {
+            auto value = reader.value();
+            if (value)
+                call.args.push_back(std::move(*value));
+            complete = value.has_value();
+        }
+        if (!complete)
+            break;
+        calls.push_back(std::move(call));
+    }
+
+    if (!reader.done())
+        Logger(ll_warning, path + " ends with an incomplete record; read " + std::to_string(calls.size()) + " calls").log();
+    return calls;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/**
+ * @brief An argument of a captured service call.
+ * Integers of any width, doubles, strings, ID lists, string pairs (update maps, date periods)
+ * and string sets (join tables) cover every public service method.
+ */
+using WorkloadValue = std::variant<int64_t, double, std::string, std::vector<int64_t>,
+                                   std::vector<std::pair<std::string, std::string>>, std::vector<std::string>>;
+
+/**
+ * @brief One service call read back from a capture.
+ */
+struct WorkloadCall {
+    /**
+     * @brief The capturing thread; calls of one session ran one after another.
+     */
+    uint32_t session = 0;
+
+    /**
+     * @brief Microseconds since the capture started.
+     */
+    int64_t at_us = 0;
+
+    std::string method;
+    std::vector<WorkloadValue> args;
+};
+
+/**
+ * @brief Records every outermost service call (method, arguments, time, session) into a binary log.
+ *
+ * The file starts with "SEVW" and a version byte, followed by records of varints:
+ * a method record (0, id, name) the first time a method is seen, and a call record
+ * (1, method id, session, time, argument count, tagged arguments) per call. Calls are encoded
+ * into a buffer under one mutex and written out in 64 KiB chunks, so a capture costs a
+ * few hundred nanoseconds per call and no I/O on the calling thread most of the time.
+ */
+class WorkloadCapture {
+public:
+    /**
+     * @brief Starts capturing into a new file.
+     * @return True on success, false if the file could not be created.
+     */
+    static bool start(const std::string &path);
+
+    /**
+     * @brief Writes what is buffered and closes the file.
+     */
+    static void stop();
+
+    /**
+     * @brief Whether calls are captured; a relaxed load, so a service call costs one branch otherwise.
+     */
+    static bool active() {
+        return capturing.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Appends one call.
+     * @param method A string literal naming the method, e.g. "ClubTable::add_member".
+     * @param args The call's arguments in declaration order.
+     */
+    static void record(const char *method, const std::vector<WorkloadValue> &args);
+
+private:
+    static inline std::atomic<bool> capturing{false};
+};
+
+/**
+ * @brief Reads a capture back, in the order the calls were recorded.
+ * @return The calls, or std::nullopt if the file is missing or not a capture.
+ */
+std::optional<std::vector<WorkloadCall>> read_workload(const std::string &path);
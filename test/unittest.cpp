@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/index/ActivityIntervalIndex.h"
+#include "../src/index/RoaringBitmap.h"
+#include "../src/index/TrigramIndex.h"
+#include "../src/render/TableRenderer.h"
+#include "../src/service/QueryDigest.h"
+#include "../src/storage/MemoryBackend.h"
+
+static int failures = 0;
+
+#define CHECK(condition)                                                                          \
+    do {                                                                                          \
+        if (!(condition)) {                                                                       \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            ++failures;                                                                           \
+        }                                                                                         \
+    } while (0)
+
+static std::vector<uint32_t> range(uint32_t from, uint32_t to, uint32_t step = 1) {
+    std::vector<uint32_t> values;
+    for (uint32_t value = from; value < to; value += step)
+        values.push_back(value);
+    return values;
+}
+
+static std::vector<int> sorted(std::vector<int> ids) {
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+static void test_roaring_array_bitmap_transitions() {
+    const uint32_t limit = static_cast<uint32_t>(RoaringBitmap::array_limit);
+
+    // Exactly array_limit values fit an array container; one more turns it into a bitmap.
+    RoaringBitmap bitmap;
+    for (uint32_t value : range(0, 2 * limit, 2))
+        CHECK(bitmap.add(value));
+    CHECK(bitmap.cardinality() == limit);
+    CHECK(!bitmap.add(0));
+    CHECK(bitmap.add(1));
+    CHECK(bitmap.cardinality() == limit + 1);
+    CHECK(bitmap.contains(1) && bitmap.contains(2 * limit - 2) && !bitmap.contains(3));
+
+    // Shrinking back to array_limit keeps every remaining value.
+    CHECK(bitmap.remove(1));
+    CHECK(!bitmap.remove(1));
+    CHECK(bitmap.cardinality() == limit);
+    CHECK(bitmap.to_vector() == range(0, 2 * limit, 2));
+
+    // Set operations between an array container and a bitmap container of the same key.
+    RoaringBitmap evens = RoaringBitmap::from_values(range(0, 4 * limit, 2));
+    RoaringBitmap small = RoaringBitmap::from_values({0, 1, 2, 3, 4});
+    CHECK(evens.cardinality() == 2 * limit);
+    CHECK(RoaringBitmap::intersect(evens, small).to_vector() == std::vector<uint32_t>({0, 2, 4}));
+    CHECK(RoaringBitmap::intersect(small, evens).to_vector() == std::vector<uint32_t>({0, 2, 4}));
+    CHECK(RoaringBitmap::intersect_cardinality(evens, small) == 3);
+    CHECK(RoaringBitmap::unite(evens, small).cardinality() == 2 * limit + 2);
+    CHECK(RoaringBitmap::difference(small, evens).to_vector() == std::vector<uint32_t>({1, 3}));
+
+    // A union of two arrays that no longer fits an array, and a difference that fits one again.
+    RoaringBitmap low = RoaringBitmap::from_values(range(0, limit));
+    RoaringBitmap high = RoaringBitmap::from_values(range(limit, limit + 10));
+    RoaringBitmap both = RoaringBitmap::unite(low, high);
+    CHECK(both.cardinality() == limit + 10);
+    CHECK(both.contains(0) && both.contains(limit + 9) && !both.contains(limit + 10));
+    CHECK(RoaringBitmap::difference(both, low).to_vector() == range(limit, limit + 10));
+    low.unite_with(high);
+    CHECK(low.to_vector() == both.to_vector());
+
+    // Values in different 16-bit keys live in separate containers.
+    RoaringBitmap spread = RoaringBitmap::from_values({5, 65536 + 5, 3 * 65536});
+    CHECK(spread.cardinality() == 3);
+    CHECK(spread.contains(65536 + 5) && !spread.contains(65536 + 6));
+    CHECK(spread.remove(5) && spread.remove(65536 + 5) && spread.remove(3 * 65536));
+    CHECK(spread.empty());
+}
+
+static void test_interval_overlap_with_open_ends() {
+    ActivityIntervalIndex index;
+    index.upsert(1, 10, 100, 200);
+    index.upsert(2, 10, 150, ActivityIntervalIndex::open_end);
+    index.upsert(3, 20, 50, 99);
+    index.upsert(4, 20, 300, ActivityIntervalIndex::open_end);
+    index.upsert(5, 10, 201, 201);
+
+    // Windows are closed on both ends.
+    CHECK(sorted(index.overlapping({200, 200})) == std::vector<int>({1, 2}));
+    CHECK(sorted(index.overlapping({99, 100})) == std::vector<int>({1, 3}));
+    CHECK(sorted(index.overlapping({201, 201})) == std::vector<int>({2, 5}));
+    CHECK(index.overlapping({0, 49}).empty());
+
+    // Open-ended activities match any window after their start.
+    CHECK(sorted(index.overlapping({1000000, 1000001})) == std::vector<int>({2, 4}));
+    CHECK(sorted(index.overlapping({250, ActivityIntervalIndex::open_end})) == std::vector<int>({2, 4}));
+    CHECK(sorted(index.overlapping({0, ActivityIntervalIndex::open_end})) == std::vector<int>({1, 2, 3, 4, 5}));
+
+    // Club filter, and upsert/erase keeping the tree's subtree maxima right.
+    CHECK(sorted(index.overlapping({0, ActivityIntervalIndex::open_end}, 20)) == std::vector<int>({3, 4}));
+    index.upsert(2, 10, 150, 160);
+    CHECK(sorted(index.overlapping({1000000, 1000001})) == std::vector<int>({4}));
+    index.erase(4);
+    CHECK(index.overlapping({1000000, 1000001}).empty());
+    index.erase_club(10);
+    CHECK(sorted(index.overlapping({0, ActivityIntervalIndex::open_end})) == std::vector<int>({3}));
+}
+
+static void test_trigram_short_and_korean_needles() {
+    TrigramIndex index("Club", "club_id", "club_name");
+    index.upsert(1, "Soccer Club");
+    index.upsert(2, "축구 동아리");
+    index.upsert(3, "독서 동아리");
+    index.upsert(4, "ab");
+    index.upsert(5, "아로마");
+
+    // Needles shorter than a gram are verified against every row; ASCII is case-insensitive.
+    CHECK(index.search("") == std::vector<int>({1, 2, 3, 4, 5}));
+    CHECK(index.search("B") == std::vector<int>({1, 4}));
+    CHECK(index.search("AB") == std::vector<int>({4}));
+    CHECK(index.search("zz").empty());
+
+    // One Hangul syllable is exactly one 3-byte gram.
+    CHECK(index.search("축") == std::vector<int>({2}));
+    CHECK(index.search("아") == std::vector<int>({2, 3, 5}));
+    CHECK(index.search("동아리") == std::vector<int>({2, 3}));
+    CHECK(index.search("아리") == std::vector<int>({2, 3}));
+    CHECK(index.search("구 동") == std::vector<int>({2}));
+    CHECK(index.search("soccer CLUB") == std::vector<int>({1}));
+    CHECK(index.search("동아리 축구").empty());
+
+    index.upsert(2, "축구부");
+    index.erase(3);
+    CHECK(index.search("동아리").empty());
+    CHECK(index.search("축구") == std::vector<int>({2}));
+    CHECK(index.size() == 4);
+}
+
+static void test_trigram_collation_folding() {
+    TrigramIndex index("Club", "club_id", "club_name");
+    index.upsert(1, "Café Crème");
+    index.upsert(2, "ＡＢＣ Club");
+    index.upsert(3, "Straße");
+    index.upsert(4, "Cafe\xcc\x81 Noir");
+
+    // Accents, case, full-width forms and expansions compare like utf8mb4_0900_ai_ci.
+    CHECK(index.search("cafe") == std::vector<int>({1, 4}));
+    CHECK(index.search("CAFÉ") == std::vector<int>({1, 4}));
+    CHECK(index.search("creme") == std::vector<int>({1}));
+    CHECK(index.search("abc club") == std::vector<int>({2}));
+    CHECK(index.search("ｃｌｕｂ") == std::vector<int>({2}));
+    CHECK(index.search("STRASSE") == std::vector<int>({3}));
+    CHECK(index.search("é n") == std::vector<int>({4}));
+
+    // Patterns with characters the index does not fold like the collation are left to the server.
+    CHECK(TrigramIndex::covers("Café Ｃｌｕｂ 동아리"));
+    CHECK(!TrigramIndex::covers("Đorđe"));
+    CHECK(!TrigramIndex::covers("Ωmega"));
+    CHECK(!TrigramIndex::covers("ㄱ"));
+    CHECK(!TrigramIndex::covers("50%"));
+}
+
+static void test_digest_normalization() {
+    std::string in_list = normalize_query("SELECT * FROM Club WHERE club_id IN (1, 2, 3)");
+    CHECK(in_list == normalize_query("select *  from Club where club_id in (?,?)"));
+    CHECK(in_list == normalize_query("SELECT * FROM Club WHERE club_id IN ('a', -1, 2.5e3)"));
+    CHECK(in_list != normalize_query("SELECT * FROM Club WHERE club_name IN (1, 2, 3)"));
+    CHECK(normalize_query("INSERT INTO t VALUES (1, 'a'), (2, 'b')") == normalize_query("INSERT INTO t VALUES (3, 'c')"));
+
+    // A minus sign is part of a negative literal, but stays an operator between operands.
+    CHECK(normalize_query("UPDATE Club SET budget = budget + -12.5 WHERE club_id = -3") ==
+          "update club set budget = budget + ? where club_id = ?");
+    CHECK(normalize_query("SELECT a-1, b - 2 FROM t") == "select a - ?, b - ? from t");
+    CHECK(query_fingerprint(in_list) != 0);
+}
+
+static void test_display_width() {
+    CHECK(display_width("") == 0);
+    CHECK(display_width("club") == 4);
+    CHECK(display_width("한글") == 4);
+    CHECK(display_width("a한b") == 4);
+    CHECK(display_width("e\xcc\x81") == 1);
+
+    // Truncation never splits a character, even when a wide one would overflow by one column.
+    TextExtent extent = fit_display_width("한글자", 3);
+    CHECK(extent.width == 2 && extent.bytes == 3);
+    extent = fit_display_width("ab한", 3);
+    CHECK(extent.width == 2 && extent.bytes == 2);
+    extent = fit_display_width("ab한", 4);
+    CHECK(extent.width == 4 && extent.bytes == 5);
+    extent = fit_display_width("한", 1);
+    CHECK(extent.width == 0 && extent.bytes == 0);
+
+    // Combining marks stay with their base character.
+    extent = fit_display_width("e\xcc\x81x", 1);
+    CHECK(extent.width == 1 && extent.bytes == 3);
+}
+
+static std::vector<std::string> first_column(DbResult &res) {
+    std::vector<std::string> values;
+    while (res.next())
+        values.push_back(res.get_string(0));
+    return values;
+}
+
+static void test_memory_in_subquery() {
+    MemoryConnection conn(std::make_shared<MemoryDatabase>());
+    conn.execute_update("INSERT INTO Student (name, department) VALUES (?, ?), (?, ?), (?, ?)", {"a", "x", "b", "y", "c", "z"});
+    conn.execute_update("INSERT INTO Club_Student (club_id, student_id) VALUES (1, 3), (1, 1), (2, 2)");
+
+    const std::string members = "SELECT name FROM Student WHERE student_id IN "
+                                "(SELECT student_id FROM Club_Student WHERE club_id = ?) ORDER BY name";
+    CHECK(first_column(*conn.execute_query(members, {1})) == std::vector<std::string>({"a", "c"}));
+    CHECK(first_column(*conn.execute_query(members, {3})).empty());
+
+    // Placeholders are numbered across the subquery in text order.
+    CHECK(first_column(*conn.execute_query("SELECT name FROM Student WHERE student_id IN "
+                                           "(SELECT student_id FROM Club_Student WHERE club_id = ?) AND name <> ?",
+                                           {1, "a"})) == std::vector<std::string>({"c"}));
+    CHECK(conn.execute_update("DELETE FROM Student WHERE student_id IN (SELECT student_id FROM Club_Student WHERE club_id = ?)",
+                              {1}) == 2);
+    CHECK(first_column(*conn.execute_query("SELECT name FROM Student")) == std::vector<std::string>({"b"}));
+}
+
+int main() {
+    test_roaring_array_bitmap_transitions();
+    test_interval_overlap_with_open_ends();
+    test_trigram_short_and_korean_needles();
+    test_trigram_collation_folding();
+    test_digest_normalization();
+    test_display_width();
+    test_memory_in_subquery();
+
+    if (failures) {
+        std::cerr << failures << " checks failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,245 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <cppconn/exception.h>
+
+#include "../../src/service/ClubTable.h"
+#include "../../src/service/ProfessorTable.h"
+#include "../../src/service/QueryResult.h"
+#include "../../src/service/StudentTable.h"
+#include "../../src/storage/MemoryBackend.h"
+#include "../../src/trace/AllocStats.h"
+#include "../../src/utils.h"
+
+static void usage() {
+    std::cout << "usage: client_bench [options]\n"
+                 "  --scale <n>         students 10000*n, clubs 100*n, about 50 members per club (default 1)\n"
+                 "  --seconds <s>       run each benchmark this long (default 1)\n"
+                 "  --latency-us <n>    add n microseconds to every statement, standing in for the network\n"
+                 "  --spin              busy-wait the added latency instead of sleeping\n"
+                 "  --filter <text>     only run benchmarks whose name contains text\n"
+                 "Runs typical calls of the service classes, and the client side of their statements (building\n"
+                 "SQL, binding, converting and rendering results), against an in-memory copy of the club schema;\n"
+                 "no MySQL server is needed.\n";
+}
+
+/**
+ * @brief Swallows and counts everything written to it, so rendering is measured without a terminal.
+ */
+class NullBuffer : public std::streambuf {
+public:
+    uint64_t bytes = 0;
+
+protected:
+    int overflow(int c) override {
+        ++bytes;
+        return c;
+    }
+
+    std::streamsize xsputn(const char *, std::streamsize n) override {
+        bytes += static_cast<uint64_t>(n);
+        return n;
+    }
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void()> run;
+};
+
+/**
+ * @brief Fills the schema through ordinary multi-row INSERTs.
+ */
+static bool generate(MemoryConnection &conn, int scale, std::mt19937 &random) {
+    static const char *departments[] = {"컴퓨터공학과", "전자공학과", "경영학과", "국어국문학과", "물리학과", "Mathematics"};
+    static const char *family_names[] = {"김", "이", "박", "최", "정", "강", "조", "윤"};
+    static const char *given_names[] = {"민준", "서연", "도윤", "하은", "시우", "지아", "Alex", "Jordan"};
+    const int students = 10000 * scale;
+    const int clubs = 100 * scale;
+    const int batch = 500;
+
+    try {
+        for (int first = 0; first < students; first += batch) {
+            std::string query = "INSERT INTO Student (name, department) VALUES ";
+            std::vector<SqlParam> params;
+            for (int i = first; i < std::min(students, first + batch); ++i) {
+                query += i == first ? "(?, ?)" : ", (?, ?)";
+                params.emplace_back(std::string(family_names[random() % 8]) + given_names[random() % 8]);
+                params.emplace_back(std::string(departments[random() % 6]));
+            }
+            conn.execute_update(query, params);
+        }
+        for (int i = 1; i <= clubs; ++i) {
+            conn.execute_update("INSERT INTO Professor (name) VALUES (?)", {"교수 " + std::to_string(i)});
+            conn.execute_update("INSERT INTO Club (club_name, budget, prof_id) VALUES (?, ?, ?)",
+                                {"동아리 " + std::to_string(i), 1000.0 + i, i});
+            std::string query = "INSERT IGNORE INTO Club_Student (club_id, student_id) VALUES ";
+            std::vector<SqlParam> params;
+            for (int m = 0; m < 50; ++m) {
+                query += m == 0 ? "(?, ?)" : ", (?, ?)";
+                params.emplace_back(i);
+                params.emplace_back(static_cast<int>(random() % students) + 1);
+            }
+            conn.execute_update(query, params);
+        }
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, "Failed to generate the dataset: " + std::string(e.what())).log();
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int scale = 1;
+    double seconds = 1;
+    MemoryLatency latency;
+    std::string filter;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--scale" && has_value && std::atoi(argv[i + 1]) > 0) {
+            scale = std::atoi(argv[++i]);
+        } else if (arg == "--seconds" && has_value && std::atof(argv[i + 1]) > 0) {
+            seconds = std::atof(argv[++i]);
+        } else if (arg == "--latency-us" && has_value) {
+            latency.per_statement = std::chrono::microseconds(std::atoi(argv[++i]));
+        } else if (arg == "--spin") {
+            latency.spin = true;
+        } else if (arg == "--filter" && has_value) {
+            filter = argv[++i];
+        } else {
+            usage();
+            return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    auto db = std::make_shared<MemoryDatabase>();
+    std::mt19937 random(42);
+    {
+        MemoryConnection loader(db);
+        if (!generate(loader, scale, random))
+            return EXIT_FAILURE;
+    }
+    const int students = static_cast<int>(db->row_count("Student"));
+    const int clubs = static_cast<int>(db->row_count("Club"));
+    std::printf("dataset: %d students, %d clubs, %zu memberships\n", students, clubs, db->row_count("Club_Student"));
+
+    // The tables share one connection, as sev's tables share its MySQL session.
+    auto conn = std::make_shared<MemoryConnection>(db, latency);
+    StudentTable student_table(conn);
+    ClubTable club_table(conn);
+    ProfessorTable professor_table(conn);
+    auto any_student = [&] { return static_cast<int>(random() % students) + 1; };
+    auto any_club = [&] { return static_cast<int>(random() % clubs) + 1; };
+
+    std::shared_ptr<const QueryResult> members = club_table.read_members_by_club_id(1);
+    std::unique_ptr<DbResult> all_students_result = student_table.read_all_student();
+    if (!members || !all_students_result) {
+        Logger(ll_error, "Failed to read the dataset through the service classes").log();
+        return EXIT_FAILURE;
+    }
+    std::shared_ptr<const QueryResult> all_students = QueryResult::from_db_result(*all_students_result);
+    std::printf("all students materialized: %zu rows in %zu KiB\n\n", all_students->rows_count(),
+                all_students->memory_usage() / 1024);
+    NullBuffer null_buffer, log_sink;
+
+    std::vector<Benchmark> benchmarks = {
+        {"ClubTable::read_club_by_id", [&] { club_table.read_club_by_id(any_club()); }},
+        {"ProfessorTable::read_professor_by_id", [&] { professor_table.read_professor_by_id(any_club()); }},
+        {"ClubTable::read_members_by_club_id", [&] { club_table.read_members_by_club_id(any_club()); }},
+        {"ClubTable::read_members_by_name_in_club",
+         [&] {
+             std::unique_ptr<DbResult> res = club_table.read_members_by_name_in_club(any_club(), "");
+             if (res)
+                 QueryResult::from_db_result(*res);
+         }},
+        {"StudentTable::read_all_student",
+         [&] {
+             std::unique_ptr<DbResult> res = student_table.read_all_student();
+             if (res)
+                 QueryResult::from_db_result(*res);
+         }},
+        {"club members, render",
+         [&] {
+             std::streambuf *previous = std::cout.rdbuf(&null_buffer);
+             print_result_set(members);
+             std::cout.rdbuf(previous);
+         }},
+        {"all students, render",
+         [&] {
+             std::streambuf *previous = std::cout.rdbuf(&null_buffer);
+             print_result_set(all_students);
+             std::cout.rdbuf(previous);
+         }},
+        {"ClubTable::add_member + delete_member",
+         [&] {
+             // An existing membership makes add_member fail and is left alone.
+             int club = any_club(), student = any_student();
+             if (club_table.add_member(club, student))
+                 club_table.delete_member(club, student);
+         }},
+        {"ClubTable::update_club_budget", [&] { club_table.update_club_budget(any_club(), 1000.0 + static_cast<double>(random() % 1000)); }},
+    };
+
+    if (AllocStats::compiled) {
+        std::printf("%-40s %10s %12s %10s %11s %11s %10s\n", "benchmark", "ops", "ops/s", "ns/op", "allocs/op",
+                    "bytes/op", "out MB/s");
+    } else {
+        std::printf("%-40s %10s %12s %10s %10s\n", "benchmark", "ops", "ops/s", "ns/op", "out MB/s");
+    }
+    AllocStats::reset();
+    for (const auto &benchmark : benchmarks) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+            continue;
+        null_buffer.bytes = 0;
+        // The service classes log to std::cout; keep that out of the report.
+        std::streambuf *console = std::cout.rdbuf(&log_sink);
+        try {
+            AllocCounters allocs_before = AllocStats::thread_counters();
+            auto start = std::chrono::steady_clock::now();
+            auto deadline = start + std::chrono::duration<double>(seconds);
+            uint64_t ops = 0;
+            auto now = start;
+            do {
+                for (int i = 0; i < 64; ++i)
+                    benchmark.run();
+                ops += 64;
+                now = std::chrono::steady_clock::now();
+            } while (now < deadline);
+            AllocCounters allocs_after = AllocStats::thread_counters();
+            std::cout.rdbuf(console);
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            std::printf("%-40s %10llu %12.0f %10.0f", benchmark.name.c_str(), static_cast<unsigned long long>(ops),
+                        static_cast<double>(ops) / elapsed, elapsed * 1e9 / static_cast<double>(ops));
+            if (AllocStats::compiled) {
+                std::printf(" %11.1f %11.0f",
+                            static_cast<double>(allocs_after.allocations - allocs_before.allocations) / static_cast<double>(ops),
+                            static_cast<double>(allocs_after.bytes - allocs_before.bytes) / static_cast<double>(ops));
+            }
+            if (null_buffer.bytes)
+                std::printf(" %10.1f", static_cast<double>(null_buffer.bytes) / elapsed / 1e6);
+            std::printf("\n");
+        } catch (sql::SQLException &e) {
+            std::cout.rdbuf(console);
+            Logger(ll_error, benchmark.name + ": " + std::string(e.what())).log();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (AllocStats::compiled) {
+        std::printf("\nper trace span, inclusive of nested spans:\n");
+        AllocStats::print();
+    } else {
+        std::printf("\npeak RSS: %ld KiB (build with make ALLOC_STATS=1 for allocation counts)\n", AllocStats::peak_rss_kib());
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <chrono>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../src/utils.h"
+#include "DatasetGenerator.h"
+
+static std::string sequence(long long upto) {
+    return "WITH RECURSIVE seq (n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM seq WHERE n < " + std::to_string(upto) + ") ";
+}
+
+DatasetGenerator::DatasetGenerator(std::shared_ptr<sql::Connection> conn) : con(conn) {}
+
+bool DatasetGenerator::generate(int scale) {
+    scale = std::max(scale, 1);
+    const long long professors = 100LL * scale;
+    const long long clubs = 200LL * scale;
+    const long long students = 20000LL * scale;
+    const long long activities = 10000LL * scale;
+    const std::string club_count = std::to_string(clubs);
+    const std::string student_count = std::to_string(students);
+
+    // Activities spread over 2021-2025 (1825 days); one in 23 is open-ended and one in 250 awaits purging.
+    const std::vector<std::pair<std::string, std::string>> steps = {
+        {"Professor", "INSERT INTO Professor (name) " + sequence(professors) + "SELECT CONCAT('professor', n) FROM seq"},
+        {"Club", "INSERT INTO Club (club_name, budget, prof_id) " + sequence(clubs) +
+                     "SELECT CONCAT('club', n), 1000 + n % 97 * 10, IF(n <= " + std::to_string(professors) + ", n, NULL) FROM seq"},
+        {"Location", "INSERT INTO Location (club_id, loc_name) " + sequence(clubs * 2) +
+                         "SELECT (n - 1) % " + club_count + " + 1, CONCAT('loc', n) FROM seq"},
+        {"Student", "INSERT INTO Student (name, department) " + sequence(students) +
+                        "SELECT CONCAT('student', n), CONCAT('dept', n % 40) FROM seq"},
+        {"Club_Student", "INSERT IGNORE INTO Club_Student (club_id, student_id) " + sequence(students) +
+                             "SELECT (n * 7 + k.k * 13) % " + club_count + " + 1, n FROM seq "
+                             "CROSS JOIN (SELECT 0 AS k UNION ALL SELECT 1 UNION ALL SELECT 2) AS k"},
+        {"Activity", "INSERT INTO Activity (club_id, act_title, start_date, end_date, pending_delete) " + sequence(activities) +
+                         "SELECT (n - 1) % " + club_count + " + 1, CONCAT('activity', n), "
+                         "DATE '2021-01-01' + INTERVAL (n * 37) % 1825 DAY, "
+                         "IF(n % 23 = 0, NULL, DATE '2021-01-01' + INTERVAL ((n * 37) % 1825 + n % 15) DAY), n % 250 = 0 FROM seq"},
+        {"Gathering", "INSERT INTO Gathering (act_id, gathering_name) "
+                      "SELECT act_id, CONCAT('gathering', act_id) FROM Activity WHERE act_id % 5 <> 0 ORDER BY act_id"},
+        {"Gathering_Student", "INSERT IGNORE INTO Gathering_Student (gathering_id, student_id) "
+                              "WITH RECURSIVE k (k) AS (SELECT 0 UNION ALL SELECT k + 1 FROM k WHERE k < 9) "
+                              "SELECT g.gathering_id, (g.gathering_id * 31 + k.k * 97) % " + student_count + " + 1 "
+                              "FROM Gathering AS g CROSS JOIN k"},
+        {"Equipment", "INSERT INTO Equipment (equip_name) " + sequence(50) + "SELECT CONCAT('equipment', n) FROM seq"},
+        {"Club_Equipment", "INSERT IGNORE INTO Club_Equipment (club_id, equip_id) " + sequence(clubs) +
+                               "SELECT n, (n * 3 + k.k) % 50 + 1 FROM seq CROSS JOIN (SELECT 0 AS k UNION ALL SELECT 1) AS k"},
+        {"Result", "INSERT INTO Result (club_id, year) "
+                   "WITH RECURSIVE y (year) AS (SELECT 2021 UNION ALL SELECT year + 1 FROM y WHERE year < 2025) "
+                   "SELECT c.club_id, y.year FROM Club AS c CROSS JOIN y ORDER BY c.club_id, y.year"},
+        {"Result_Activity", "INSERT IGNORE INTO Result_Activity (result_id, act_id) "
+                            "SELECT r.result_id, a.act_id FROM Result AS r JOIN Activity AS a ON a.club_id = r.club_id "
+                            "AND a.start_date >= MAKEDATE(r.year, 1) AND a.start_date < MAKEDATE(r.year + 1, 1) "
+                            "WHERE a.pending_delete = 0"},
+        {"Budget_Ledger", "INSERT INTO Budget_Ledger (club_id, delta) " + sequence(clubs * 10) +
+                              "SELECT (n - 1) % " + club_count + " + 1, (n % 21 - 10) * 5 FROM seq"},
+        {"Club_Activity_Rollup", "INSERT INTO Club_Activity_Rollup (club_id, year, activity_count, gathering_count, attendee_count) "
+                                 "SELECT a.club_id, YEAR(a.start_date), COUNT(DISTINCT a.act_id), COUNT(DISTINCT g.gathering_id), "
+                                 "COUNT(gs.student_id) FROM Activity AS a "
+                                 "LEFT JOIN Gathering AS g ON g.act_id = a.act_id "
+                                 "LEFT JOIN Gathering_Student AS gs ON gs.gathering_id = g.gathering_id "
+                                 "WHERE a.club_id IS NOT NULL AND a.pending_delete = 0 "
+                                 "GROUP BY a.club_id, YEAR(a.start_date)"},
+        {"Advisor_Dataset", "CREATE TABLE Advisor_Dataset (scale INT NOT NULL, "
+                            "generated_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP)"},
+        {"Advisor_Dataset", "INSERT INTO Advisor_Dataset (scale) VALUES (" + std::to_string(scale) + ")"},
+    };
+
+    try {
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        {
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                "SELECT (SELECT COUNT(*) FROM Club) + (SELECT COUNT(*) FROM Student) + (SELECT COUNT(*) FROM Activity)"));
+            if (!res->next() || res->getInt64(1) != 0) {
+                Logger(ll_error, "DatasetGenerator needs an empty schema; run db_scripts/club_init.sql first").log();
+                return false;
+            }
+        }
+        stmt->execute("SET SESSION cte_max_recursion_depth = " + std::to_string(students + 1));
+
+        for (const auto &[table, query] : steps) {
+            auto started = std::chrono::steady_clock::now();
+            stmt->execute(query);
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+            Logger(ll_info, "Generated " + table + " in " + std::to_string(elapsed.count()) + " ms").log();
+        }
+        return true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in DatasetGenerator::generate: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+bool DatasetGenerator::is_generated() {
+    try {
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+            "SELECT COUNT(*) FROM information_schema.TABLES WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = 'Advisor_Dataset'"));
+        return res->next() && res->getInt(1) > 0;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in DatasetGenerator::is_generated: " + std::string(e.what())).log();
+        return false;
+    }
+}
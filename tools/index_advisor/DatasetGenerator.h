@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cppconn/connection.h>
+#include <memory>
+
+/**
+ * @brief Fills an empty club schema with a deterministic dataset sized for plan analysis.
+ *
+ * Row counts grow with the scale: 100 professors, 200 clubs, 20000 students and 10000 activities
+ * per unit, with three memberships per student, a gathering for four of five activities and ten
+ * attendees per gathering. IDs are assigned in insertion order, so the sample parameters of the
+ * statement catalog refer to existing rows. Every statement is set-based (INSERT ... SELECT over a
+ * recursive sequence), so the triggers of db_scripts/club_counters.sql keep the counters right.
+ */
+class DatasetGenerator {
+public:
+    /**
+     * @param conn A connection to a schema created by db_scripts/club_init.sql.
+     */
+    explicit DatasetGenerator(std::shared_ptr<sql::Connection> conn);
+
+    /**
+     * @brief Generates the dataset and records it in the Advisor_Dataset marker table.
+     * @param scale Multiplier of the row counts, at least 1.
+     * @return True on success, false if the schema is not empty or a statement failed.
+     */
+    bool generate(int scale);
+
+    /**
+     * @brief Whether the schema holds a generated dataset; IndexAdvisor only adds trial indexes to such a schema.
+     */
+    bool is_generated();
+
+private:
+    std::shared_ptr<sql::Connection> con;
+};
@@ -0,0 +1,67 @@
+#include <iterator>
+#include <optional>
+#include <string>
+
+#include "ExplainPlan.h"
+
+namespace {
+
+void collect(const JsonValue &node, ExplainPlan &plan) {
+    if (node.kind == JsonValue::Kind::array) {
+        for (const auto &item : node.items)
+            collect(item, plan);
+        return;
+    }
+    if (node.kind != JsonValue::Kind::object)
+        return;
+
+    // "ordering_operation", "grouping_operation" and "duplicates_removal" carry these flags.
+    if (node.get_bool("using_filesort"))
+        plan.using_filesort = true;
+    if (node.get_bool("using_temporary_table"))
+        plan.using_temporary_table = true;
+
+    if (node.find("table_name") && node.find("access_type")) {
+        TableAccess access;
+        access.table = node.get_string("table_name");
+        access.access_type = node.get_string("access_type");
+        access.key = node.get_string("key");
+        access.rows_examined = node.get_number("rows_examined_per_scan");
+        access.attached_condition = node.get_string("attached_condition");
+        if (const JsonValue *keys = node.find("possible_keys"))
+            for (const auto &key : keys->items)
+                access.possible_keys.push_back(key.text);
+        plan.tables.push_back(std::move(access));
+    }
+
+    for (const auto &[name, member] : node.members)
+        collect(member, plan);
+}
+
+} // namespace
+
+std::optional<ExplainPlan> parse_explain_plan(const std::string &json) {
+    auto root = parse_json(json);
+    if (!root)
+        return std::nullopt;
+
+    ExplainPlan plan;
+    if (const JsonValue *block = root->find("query_block"))
+        if (const JsonValue *cost = block->find("cost_info"))
+            plan.query_cost = cost->get_number("query_cost");
+    collect(*root, plan);
+    return plan;
+}
+
+int access_type_rank(const std::string &access_type) {
+    static const char *const order[] = {"system", "const", "eq_ref", "ref", "fulltext", "ref_or_null",
+                                        "index_merge", "unique_subquery", "index_subquery", "range", "index", "ALL"};
+    for (int i = 0; i < static_cast<int>(std::size(order)); ++i)
+        if (access_type == order[i])
+            return i;
+    return -1;
+}
+
+bool is_full_scan(const std::string &access_type) {
+    return access_type == "ALL" || access_type == "index";
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Json.h"
+
+/**
+ * @brief How one table (or derived table) is read in a plan.
+ */
+struct TableAccess {
+    /**
+     * @brief The table name as EXPLAIN prints it, i.e. the alias when the statement uses one.
+     */
+    std::string table;
+
+    /**
+     * @brief MySQL's join type: system, const, eq_ref, ref, range, index, ALL, ...
+     */
+    std::string access_type;
+
+    /**
+     * @brief The index used, empty if none.
+     */
+    std::string key;
+    std::vector<std::string> possible_keys;
+    double rows_examined = 0;
+
+    /**
+     * @brief The WHERE part evaluated on this table's rows, as MySQL rewrote it.
+     */
+    std::string attached_condition;
+};
+
+/**
+ * @brief The parts of an EXPLAIN FORMAT=JSON plan the advisor looks at.
+ */
+struct ExplainPlan {
+    std::vector<TableAccess> tables;
+    bool using_filesort = false;
+    bool using_temporary_table = false;
+    double query_cost = 0;
+};
+
+/**
+ * @brief Extracts the table accesses and the filesort/temporary flags from an EXPLAIN FORMAT=JSON document.
+ * @param json The document.
+ * @return The plan, or std::nullopt if the document is not valid JSON.
+ */
+std::optional<ExplainPlan> parse_explain_plan(const std::string &json);
+
+/**
+ * @brief Orders access types from best (0, "system") to worst ("ALL").
+ * @return The rank, or -1 for an access type this tool does not know.
+ */
+int access_type_rank(const std::string &access_type);
+
+/**
+ * @brief Whether an access type reads the whole table or a whole index.
+ */
+bool is_full_scan(const std::string &access_type);
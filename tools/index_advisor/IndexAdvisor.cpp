@@ -0,0 +1,512 @@
+#include <algorithm>
+#include <cctype>
+#include <cppconn/connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <cppconn/statement.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../src/utils.h"
+#include "IndexAdvisor.h"
+
+static const char *const trial_index = "adv_trial";
+
+/**
+ * @brief Replaces the '?' placeholders outside of quotes with the literal parameter values.
+ * EXPLAIN sees the same constants the prepared statement would, so the optimizer can use range estimates.
+ */
+static std::string bind_literals(const std::string &sql, const std::vector<SqlParam> &params) {
+    std::string out;
+    size_t next = 0;
+    char quote = 0;
+    for (char c : sql) {
+        if (quote) {
+            if (c == quote)
+                quote = 0;
+            out += c;
+        } else if (c == '\'' || c == '"' || c == '`') {
+            quote = c;
+            out += c;
+        } else if (c == '?' && next < params.size()) {
+            const SqlParam &param = params[next++];
+            if (const long long *number = std::get_if<long long>(&param)) {
+                out += std::to_string(*number);
+            } else {
+                out += '\'';
+                for (char ch : std::get<std::string>(param)) {
+                    if (ch == '\'' || ch == '\\')
+                        out += ch;
+                    out += ch;
+                }
+                out += '\'';
+            }
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+static std::string upper(std::string text) {
+    for (char &c : text)
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return text;
+}
+
+/**
+ * @brief Maps the names EXPLAIN prints for tables (aliases, or the table itself) to table names.
+ */
+static std::map<std::string, std::string> table_aliases(const std::string &sql) {
+    std::vector<std::string> tokens;
+    for (size_t i = 0; i < sql.size();) {
+        char c = sql[i];
+        if (c == '\'' || c == '"') {
+            size_t end = sql.find(c, i + 1);
+            i = end == std::string::npos ? sql.size() : end + 1;
+        } else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') {
+            size_t begin = i;
+            while (i < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '_'))
+                ++i;
+            tokens.push_back(sql.substr(begin, i - begin));
+        } else {
+            if (c == '(' || c == ')' || c == ',')
+                tokens.emplace_back(1, c);
+            ++i;
+        }
+    }
+
+    static const std::set<std::string> keywords = {"WHERE", "JOIN", "LEFT", "RIGHT", "INNER", "CROSS", "ON", "SET",
+                                                   "ORDER", "GROUP", "LIMIT", "USING", "VALUES", "SELECT", "FOR", "AS"};
+    std::map<std::string, std::string> aliases;
+    for (size_t i = 0; i + 1 < tokens.size(); ++i) {
+        std::string keyword = upper(tokens[i]);
+        if (keyword != "FROM" && keyword != "JOIN" && keyword != "UPDATE" && keyword != "INTO")
+            continue;
+        const std::string &table = tokens[i + 1];
+        if (table == "(" || keywords.count(upper(table)))
+            continue;
+        aliases[table] = table;
+        if (i + 2 < tokens.size()) {
+            std::string following = upper(tokens[i + 2]);
+            if (following == "AS" && i + 3 < tokens.size())
+                aliases[tokens[i + 3]] = table;
+            else if (tokens[i + 2] != "(" && tokens[i + 2] != ")" && tokens[i + 2] != "," && !keywords.count(following))
+                aliases[tokens[i + 2]] = table;
+        }
+    }
+    return aliases;
+}
+
+/**
+ * @brief The worst access of every table name in a plan (a table can be read more than once).
+ */
+static std::map<std::string, TableAccess> worst_accesses(const ExplainPlan &plan) {
+    std::map<std::string, TableAccess> worst;
+    for (const auto &access : plan.tables) {
+        auto it = worst.find(access.table);
+        if (it == worst.end() || access_type_rank(access.access_type) > access_type_rank(it->second.access_type) ||
+            (access.access_type == it->second.access_type && access.rows_examined > it->second.rows_examined))
+            worst[access.table] = access;
+    }
+    return worst;
+}
+
+static std::string describe(const TableAccess &access) {
+    std::ostringstream out;
+    out << access.access_type;
+    if (!access.key.empty())
+        out << " on " << access.key;
+    out << " ~" << static_cast<long long>(access.rows_examined) << " rows";
+    return out.str();
+}
+
+static std::string index_name(const IndexCandidate &candidate) {
+    std::string name = "idx_";
+    for (char c : candidate.table)
+        name += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    for (const auto &column : candidate.columns)
+        name += "_" + column;
+    return name;
+}
+
+static std::string column_list(const std::vector<std::string> &columns) {
+    std::string list;
+    for (size_t i = 0; i < columns.size(); ++i)
+        list += (i == 0 ? "" : ", ") + columns[i];
+    return list;
+}
+
+static bool is_prefix(const std::vector<std::string> &prefix, const std::vector<std::string> &columns) {
+    return prefix.size() <= columns.size() && std::equal(prefix.begin(), prefix.end(), columns.begin());
+}
+
+IndexAdvisor::IndexAdvisor(std::shared_ptr<sql::Connection> conn) : con(conn) {}
+
+void IndexAdvisor::set_min_rows(double rows) {
+    min_rows = rows;
+}
+
+void IndexAdvisor::set_min_gain(double gain) {
+    min_gain = gain;
+}
+
+bool IndexAdvisor::analyze_tables() {
+    try {
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::vector<std::string> tables;
+        {
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+                "SELECT TABLE_NAME FROM information_schema.TABLES WHERE TABLE_SCHEMA = DATABASE() AND TABLE_TYPE = 'BASE TABLE'"));
+            while (res->next())
+                tables.push_back(res->getString(1));
+        }
+        for (const auto &table : tables) {
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("ANALYZE TABLE `" + table + "`"));
+            while (res->next()) {
+            }
+        }
+        Logger(ll_info, "Analyzed " + std::to_string(tables.size()) + " tables").log();
+        return true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in analyze_tables: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+std::optional<ExplainPlan> IndexAdvisor::explain(const CatalogStatement &statement, std::string &error) {
+    try {
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("EXPLAIN FORMAT=JSON " + bind_literals(statement.sql, statement.params)));
+        if (!res->next()) {
+            error = "EXPLAIN returned no rows";
+            return std::nullopt;
+        }
+        auto plan = parse_explain_plan(res->getString(1));
+        if (!plan)
+            error = "EXPLAIN returned malformed JSON";
+        return plan;
+    } catch (const sql::SQLException &e) {
+        error = e.what();
+        return std::nullopt;
+    }
+}
+
+std::vector<StatementReport> IndexAdvisor::explain_all(const std::vector<CatalogStatement> &catalog) {
+    std::vector<StatementReport> reports;
+    for (const auto &statement : catalog) {
+        StatementReport report{&statement, std::nullopt, {}, {}};
+        report.plan = explain(statement, report.error);
+        if (report.plan) {
+            for (const auto &access : report.plan->tables)
+                if (is_full_scan(access.access_type) && access.rows_examined >= min_rows)
+                    report.findings.push_back("full scan of " + access.table + " (" + describe(access) + ")");
+            if (report.plan->using_filesort)
+                report.findings.push_back("filesort");
+            if (report.plan->using_temporary_table)
+                report.findings.push_back("temporary table");
+        }
+        reports.push_back(std::move(report));
+    }
+    return reports;
+}
+
+bool IndexAdvisor::load_existing_indexes() {
+    existing_indexes.clear();
+    try {
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(
+            "SELECT TABLE_NAME, INDEX_NAME, COLUMN_NAME FROM information_schema.STATISTICS "
+            "WHERE TABLE_SCHEMA = DATABASE() ORDER BY TABLE_NAME, INDEX_NAME, SEQ_IN_INDEX"));
+        std::map<std::pair<std::string, std::string>, std::vector<std::string>> columns;
+        std::vector<std::pair<std::string, std::string>> order;
+        while (res->next()) {
+            auto key = std::make_pair(std::string(res->getString(1)), std::string(res->getString(2)));
+            if (!columns.count(key))
+                order.push_back(key);
+            columns[key].push_back(res->getString(3));
+        }
+
+        for (const auto &key : order) {
+            if (key.second == trial_index) {
+                // Left behind by an interrupted run.
+                stmt->execute("ALTER TABLE `" + key.first + "` DROP INDEX " + trial_index);
+                continue;
+            }
+            existing_indexes[key.first].push_back(columns[key]);
+        }
+        return true;
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in load_existing_indexes: " + std::string(e.what())).log();
+        return false;
+    }
+}
+
+bool IndexAdvisor::is_covered(const IndexCandidate &candidate) const {
+    auto it = existing_indexes.find(candidate.table);
+    if (it == existing_indexes.end())
+        return false;
+    return std::any_of(it->second.begin(), it->second.end(),
+                       [&](const std::vector<std::string> &columns) { return is_prefix(candidate.columns, columns); });
+}
+
+std::vector<IndexCandidate> IndexAdvisor::derive_candidates(const StatementReport &report) const {
+    std::vector<IndexCandidate> candidates;
+    auto aliases = table_aliases(report.statement->sql);
+
+    for (const auto &access : report.plan->tables) {
+        if (!is_full_scan(access.access_type) || access.rows_examined < min_rows)
+            continue;
+        auto alias = aliases.find(access.table);
+        if (alias == aliases.end())
+            continue;
+
+        // Conditions read like "(`club`.`a`.`club_id` = 7) and (`club`.`a`.`start_date` <= DATE'2024-05-01')".
+        const std::string &condition = access.attached_condition;
+        const std::string marker = "`" + access.table + "`.`";
+        std::vector<std::string> equalities;
+        std::vector<std::string> ranges;
+        for (size_t pos = condition.find(marker); pos != std::string::npos; pos = condition.find(marker, pos + 1)) {
+            size_t begin = pos + marker.size();
+            size_t end = condition.find('`', begin);
+            if (end == std::string::npos)
+                break;
+            std::string column = condition.substr(begin, end - begin);
+
+            size_t after = condition.find_first_not_of(' ', end + 1);
+            std::string following = after == std::string::npos ? "" : upper(condition.substr(after, 8));
+            size_t start = pos;
+            if (start >= 3 && condition.compare(start - 2, 2, "`.") == 0) {
+                size_t schema = condition.rfind('`', start - 3);
+                if (schema != std::string::npos)
+                    start = schema;
+            }
+            std::string preceding = condition.substr(0, start);
+            while (!preceding.empty() && preceding.back() == ' ')
+                preceding.pop_back();
+            if (preceding.size() > 2)
+                preceding.erase(0, preceding.size() - 2);
+
+            bool equality = (following.starts_with("=") || following.starts_with("IN (") || following.starts_with("IN(")) ||
+                            (preceding.ends_with("=") && !preceding.ends_with("<=") && !preceding.ends_with(">=") &&
+                             !preceding.ends_with("!="));
+            bool range = following.starts_with("<") || following.starts_with(">") || following.starts_with("BETWEEN") ||
+                         preceding.ends_with("<") || preceding.ends_with(">") || preceding.ends_with("<=") ||
+                         preceding.ends_with(">=");
+            if (following.starts_with("<>") || preceding.ends_with("<>"))
+                equality = range = false;
+
+            auto &target = equality ? equalities : ranges;
+            if ((equality || range) && std::find(equalities.begin(), equalities.end(), column) == equalities.end() &&
+                std::find(ranges.begin(), ranges.end(), column) == ranges.end())
+                target.push_back(column);
+        }
+
+        IndexCandidate candidate{alias->second, equalities};
+        candidate.columns.insert(candidate.columns.end(), ranges.begin(), ranges.end());
+        if (candidate.columns.size() > 4)
+            candidate.columns.resize(4);
+        if (!candidate.columns.empty() && std::find(candidates.begin(), candidates.end(), candidate) == candidates.end())
+            candidates.push_back(std::move(candidate));
+    }
+    return candidates;
+}
+
+std::optional<std::string> IndexAdvisor::try_candidate(const StatementReport &report, const IndexCandidate &candidate, bool &failed) {
+    std::optional<ExplainPlan> trial_plan;
+    try {
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::string columns;
+        for (size_t i = 0; i < candidate.columns.size(); ++i)
+            columns += (i == 0 ? "`" : ", `") + candidate.columns[i] + "`";
+        stmt->execute("ALTER TABLE `" + candidate.table + "` ADD INDEX " + trial_index + " (" + columns + ")");
+
+        std::string error;
+        trial_plan = explain(*report.statement, error);
+
+        stmt->execute("ALTER TABLE `" + candidate.table + "` DROP INDEX " + trial_index);
+    } catch (const sql::SQLException &e) {
+        Logger(ll_error, "SQL error in try_candidate: " + std::string(e.what())).log();
+        failed = true;
+        return std::nullopt;
+    }
+    if (!trial_plan)
+        return std::nullopt;
+
+    auto before = worst_accesses(*report.plan);
+    for (const auto &after : trial_plan->tables) {
+        if (after.key != trial_index || !before.count(after.table))
+            continue;
+        const TableAccess &old_access = before[after.table];
+        bool better_type = !is_full_scan(after.access_type) &&
+                           access_type_rank(after.access_type) < access_type_rank(old_access.access_type);
+        bool fewer_rows = after.rows_examined <= old_access.rows_examined * (1 - min_gain);
+        bool cheaper = trial_plan->query_cost > 0 && trial_plan->query_cost <= report.plan->query_cost * (1 - min_gain);
+        if (better_type || fewer_rows || cheaper) {
+            TableAccess renamed = after;
+            renamed.key = index_name(candidate);
+            return report.statement->name + ": " + after.table + " " + describe(old_access) + " -> " + describe(renamed);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::vector<IndexProposal>> IndexAdvisor::propose(const std::vector<StatementReport> &reports) {
+    if (!load_existing_indexes())
+        return std::nullopt;
+
+    std::vector<IndexProposal> proposals;
+    for (const auto &report : reports) {
+        if (!report.plan)
+            continue;
+        std::vector<IndexCandidate> candidates = report.statement->candidates;
+        for (auto &derived : derive_candidates(report))
+            if (std::find(candidates.begin(), candidates.end(), derived) == candidates.end())
+                candidates.push_back(std::move(derived));
+
+        for (const auto &candidate : candidates) {
+            if (is_covered(candidate))
+                continue;
+            bool failed = false;
+            auto improvement = try_candidate(report, candidate, failed);
+            if (failed)
+                return std::nullopt;
+            if (!improvement)
+                continue;
+
+            auto it = std::find_if(proposals.begin(), proposals.end(),
+                                   [&](const IndexProposal &proposal) { return proposal.index == candidate; });
+            if (it == proposals.end())
+                it = proposals.insert(proposals.end(), IndexProposal{candidate, index_name(candidate), {}});
+            it->improvements.push_back(*improvement);
+        }
+    }
+
+    // A proposal that is a prefix of another one on the same table is served by the longer index.
+    std::vector<IndexProposal> kept;
+    for (const auto &proposal : proposals) {
+        auto longer = std::find_if(proposals.begin(), proposals.end(), [&](const IndexProposal &other) {
+            return &other != &proposal && other.index.table == proposal.index.table &&
+                   other.index.columns.size() > proposal.index.columns.size() &&
+                   is_prefix(proposal.index.columns, other.index.columns);
+        });
+        if (longer == proposals.end())
+            kept.push_back(proposal);
+    }
+    for (auto &proposal : kept) {
+        for (const auto &other : proposals) {
+            if (other.index.table == proposal.index.table && other.index.columns.size() < proposal.index.columns.size() &&
+                is_prefix(other.index.columns, proposal.index.columns))
+                proposal.improvements.insert(proposal.improvements.end(), other.improvements.begin(), other.improvements.end());
+        }
+    }
+    return kept;
+}
+
+void IndexAdvisor::print_report(const std::vector<StatementReport> &reports) {
+    size_t flagged = 0;
+    for (const auto &report : reports) {
+        std::cout << "== " << report.statement->name << '\n';
+        if (!report.plan) {
+            std::cout << "   error: " << report.error << '\n';
+            ++flagged;
+            continue;
+        }
+        for (const auto &access : report.plan->tables)
+            std::cout << "   " << access.table << ": " << describe(access) << '\n';
+        for (const auto &finding : report.findings)
+            std::cout << "   ! " << finding << '\n';
+        if (!report.findings.empty())
+            ++flagged;
+    }
+    std::cout << flagged << " of " << reports.size() << " statements flagged\n";
+}
+
+bool IndexAdvisor::write_migration(const std::string &path, const std::vector<IndexProposal> &proposals) {
+    std::ofstream out(path);
+    if (!out) {
+        Logger(ll_error, "Cannot write migration " + path).log();
+        return false;
+    }
+    out << "/* 인덱스 어드바이저(tools/index_advisor)가 제안한 인덱스 추가 (기존 club DB 에 적용) */\n\n";
+    out << "USE club;\n";
+    if (proposals.empty())
+        out << "\n-- 제안할 인덱스 없음\n";
+    for (const auto &proposal : proposals) {
+        out << '\n';
+        for (const auto &improvement : proposal.improvements)
+            out << "-- " << improvement << '\n';
+        out << "ALTER TABLE " << proposal.index.table << " ADD INDEX " << proposal.index_name << " ("
+            << column_list(proposal.index.columns) << ");\n";
+    }
+    return static_cast<bool>(out);
+}
+
+bool IndexAdvisor::write_baseline(const std::string &path, const std::vector<StatementReport> &reports) {
+    std::ofstream out(path);
+    if (!out) {
+        Logger(ll_error, "Cannot write baseline " + path).log();
+        return false;
+    }
+    for (const auto &report : reports) {
+        if (!report.plan) {
+            out << report.statement->name << "\t-\tERROR\n";
+            continue;
+        }
+        for (const auto &[table, access] : worst_accesses(*report.plan))
+            out << report.statement->name << '\t' << table << '\t' << access.access_type << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+std::optional<std::vector<PlanRegression>> IndexAdvisor::check_baseline(const std::string &path,
+                                                                        const std::vector<StatementReport> &reports) {
+    std::ifstream in(path);
+    if (!in) {
+        Logger(ll_error, "Cannot read baseline " + path).log();
+        return std::nullopt;
+    }
+    std::map<std::string, std::map<std::string, std::string>> baseline;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t first = line.find('\t');
+        size_t second = first == std::string::npos ? std::string::npos : line.find('\t', first + 1);
+        if (second == std::string::npos)
+            continue;
+        baseline[line.substr(0, first)][line.substr(first + 1, second - first - 1)] = line.substr(second + 1);
+    }
+
+    std::vector<PlanRegression> regressions;
+    for (const auto &report : reports) {
+        auto recorded = baseline.find(report.statement->name);
+        if (recorded == baseline.end())
+            continue;
+        bool was_error = recorded->second.count("-") && recorded->second.at("-") == "ERROR";
+        if (!report.plan) {
+            if (!was_error)
+                regressions.push_back({report.statement->name, "-", "OK", "ERROR"});
+            continue;
+        }
+        for (const auto &[table, access] : worst_accesses(*report.plan)) {
+            auto old_access = recorded->second.find(table);
+            if (old_access == recorded->second.end()) {
+                if (is_full_scan(access.access_type) && !was_error)
+                    regressions.push_back({report.statement->name, table, "(none)", access.access_type});
+                continue;
+            }
+            int old_rank = access_type_rank(old_access->second);
+            int new_rank = access_type_rank(access.access_type);
+            if (old_rank >= 0 && new_rank > old_rank)
+                regressions.push_back({report.statement->name, table, old_access->second, access.access_type});
+        }
+    }
+    return regressions;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cppconn/connection.h>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ExplainPlan.h"
+#include "StatementCatalog.h"
+
+/**
+ * @brief The plan of one catalog statement and what is wrong with it.
+ */
+struct StatementReport {
+    const CatalogStatement *statement;
+    std::optional<ExplainPlan> plan;
+
+    /**
+     * @brief The server's error when the statement could not be explained.
+     */
+    std::string error;
+
+    /**
+     * @brief Full scans over at least the minimum row count, filesorts and temporary tables.
+     */
+    std::vector<std::string> findings;
+};
+
+/**
+ * @brief An index that measurably improved the plan of at least one statement.
+ */
+struct IndexProposal {
+    IndexCandidate index;
+    std::string index_name;
+
+    /**
+     * @brief "statement: before -> after" for every statement the index helped.
+     */
+    std::vector<std::string> improvements;
+};
+
+/**
+ * @brief A table access of a statement that got worse than in the baseline.
+ */
+struct PlanRegression {
+    std::string statement;
+    std::string table;
+    std::string baseline_access;
+    std::string current_access;
+};
+
+/**
+ * @brief Explains the service layer's statements and tries indexes for the ones that scan.
+ *
+ * Candidate indexes come from the statement catalog and from each flagged table's attached
+ * condition (equality columns first, then range columns). A candidate is proposed only if,
+ * added for real as a trial index, the optimizer uses it and the plan improves: a better access
+ * type, or at least the minimum gain fewer examined rows or lower cost. Trial indexes are
+ * dropped again right away, and only on a schema marked by DatasetGenerator.
+ */
+class IndexAdvisor {
+public:
+    /**
+     * @param conn A connection to the schema holding the generated dataset.
+     */
+    explicit IndexAdvisor(std::shared_ptr<sql::Connection> conn);
+
+    /**
+     * @brief Full scans over fewer rows than this are not reported (default 200).
+     */
+    void set_min_rows(double rows);
+
+    /**
+     * @brief The fraction of examined rows or cost a candidate has to save (default 0.25).
+     */
+    void set_min_gain(double gain);
+
+    /**
+     * @brief Refreshes index statistics of every table so that plans reflect the dataset.
+     * @return True on success, false otherwise.
+     */
+    bool analyze_tables();
+
+    /**
+     * @brief Runs EXPLAIN FORMAT=JSON on every statement.
+     */
+    std::vector<StatementReport> explain_all(const std::vector<CatalogStatement> &catalog);
+
+    /**
+     * @brief Tries the candidate indexes of every report and keeps those that improve a plan.
+     * Candidates that are a prefix of an existing index, or of another proposal, are left out.
+     * @return The proposals, or std::nullopt if a trial index could not be added or dropped.
+     */
+    std::optional<std::vector<IndexProposal>> propose(const std::vector<StatementReport> &reports);
+
+    /**
+     * @brief Prints the plans and findings, one block per statement.
+     */
+    static void print_report(const std::vector<StatementReport> &reports);
+
+    /**
+     * @brief Writes the proposals as a migration in the style of db_scripts.
+     * @return True on success, false if the file could not be written.
+     */
+    static bool write_migration(const std::string &path, const std::vector<IndexProposal> &proposals);
+
+    /**
+     * @brief Saves the worst access type of every statement and table as a baseline, one "statement<TAB>table<TAB>access" per line.
+     * Statements that could not be explained are saved with the access type ERROR.
+     * @return True on success, false if the file could not be written.
+     */
+    static bool write_baseline(const std::string &path, const std::vector<StatementReport> &reports);
+
+    /**
+     * @brief Compares the reports with a baseline; a regression is a table access of a worse type than recorded,
+     * a table access that is new and scans, or a statement that no longer explains.
+     * @return The regressions, or std::nullopt if the baseline could not be read.
+     */
+    static std::optional<std::vector<PlanRegression>> check_baseline(const std::string &path, const std::vector<StatementReport> &reports);
+
+private:
+    std::shared_ptr<sql::Connection> con;
+    double min_rows = 200;
+    double min_gain = 0.25;
+
+    /**
+     * @brief Existing indexes per table, as column lists.
+     */
+    std::map<std::string, std::vector<std::vector<std::string>>> existing_indexes;
+
+    std::optional<ExplainPlan> explain(const CatalogStatement &statement, std::string &error);
+    bool load_existing_indexes();
+    bool is_covered(const IndexCandidate &candidate) const;
+    std::vector<IndexCandidate> derive_candidates(const StatementReport &report) const;
+    std::optional<std::string> try_candidate(const StatementReport &report, const IndexCandidate &candidate, bool &failed);
+};
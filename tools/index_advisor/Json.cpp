@@ -0,0 +1,233 @@
+#include <cctype>
+#include <cstdlib>
+#include <optional>
+#include <string>
+
+#include "Json.h"
+
+namespace {
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string &source) : text(source) {}
+
+    std::optional<JsonValue> parse_document() {
+        JsonValue value;
+        if (!parse_value(value))
+            return std::nullopt;
+        skip_space();
+        if (pos != text.size())
+            return std::nullopt;
+        return value;
+    }
+
+private:
+    const std::string &text;
+    size_t pos = 0;
+    int depth = 0;
+
+    void skip_space() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+            ++pos;
+    }
+
+    bool consume(char c) {
+        skip_space();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool consume_word(const char *word) {
+        size_t length = std::char_traits<char>::length(word);
+        if (text.compare(pos, length, word) != 0)
+            return false;
+        pos += length;
+        return true;
+    }
+
+    static void append_utf8(std::string &out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parse_hex4(unsigned &code) {
+        if (pos + 4 > text.size())
+            return false;
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = text[pos++];
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f') code |= static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') code |= static_cast<unsigned>(c - 'A' + 10);
+            else return false;
+        }
+        return true;
+    }
+
+    bool parse_string(std::string &out) {
+        if (!consume('"'))
+            return false;
+        while (pos < text.size()) {
+            char c = text[pos++];
+            if (c == '"')
+                return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= text.size())
+                return false;
+            char escape = text[pos++];
+            switch (escape) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned code;
+                if (!parse_hex4(code))
+                    return false;
+                if (code >= 0xD800 && code < 0xDC00 && text.compare(pos, 2, "\\u") == 0) {
+                    pos += 2;
+                    unsigned low;
+                    if (!parse_hex4(low) || low < 0xDC00 || low >= 0xE000)
+                        return false;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(out, code);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool parse_value(JsonValue &value) {
+        if (++depth > 256)
+            return false;
+        skip_space();
+        bool ok = false;
+        if (pos >= text.size()) {
+            ok = false;
+        } else if (text[pos] == '{') {
+            ++pos;
+            value.kind = JsonValue::Kind::object;
+            ok = true;
+            if (!consume('}')) {
+                do {
+                    std::string key;
+                    JsonValue member;
+                    skip_space();
+                    if (!parse_string(key) || !consume(':') || !parse_value(member)) {
+                        ok = false;
+                        break;
+                    }
+                    value.members[key] = std::move(member);
+                } while (consume(','));
+                ok = ok && consume('}');
+            }
+        } else if (text[pos] == '[') {
+            ++pos;
+            value.kind = JsonValue::Kind::array;
+            ok = true;
+            if (!consume(']')) {
+                do {
+                    JsonValue item;
+                    if (!parse_value(item)) {
+                        ok = false;
+                        break;
+                    }
+                    value.items.push_back(std::move(item));
+                } while (consume(','));
+                ok = ok && consume(']');
+            }
+        } else if (text[pos] == '"') {
+            value.kind = JsonValue::Kind::string;
+            ok = parse_string(value.text);
+        } else if (consume_word("true")) {
+            value.kind = JsonValue::Kind::boolean;
+            value.boolean = true;
+            ok = true;
+        } else if (consume_word("false")) {
+            value.kind = JsonValue::Kind::boolean;
+            ok = true;
+        } else if (consume_word("null")) {
+            value.kind = JsonValue::Kind::null;
+            ok = true;
+        } else {
+            size_t begin = pos;
+            while (pos < text.size() && (std::isdigit(static_cast<unsigned char>(text[pos])) || text[pos] == '-' ||
+                                         text[pos] == '+' || text[pos] == '.' || text[pos] == 'e' || text[pos] == 'E'))
+                ++pos;
+            value.kind = JsonValue::Kind::number;
+            value.text = text.substr(begin, pos - begin);
+            char *end = nullptr;
+            value.number = std::strtod(value.text.c_str(), &end);
+            ok = !value.text.empty() && end == value.text.c_str() + value.text.size();
+        }
+        --depth;
+        return ok;
+    }
+};
+
+} // namespace
+
+const JsonValue *JsonValue::find(const std::string &key) const {
+    if (kind != Kind::object)
+        return nullptr;
+    auto it = members.find(key);
+    return it == members.end() ? nullptr : &it->second;
+}
+
+std::string JsonValue::get_string(const std::string &key, const std::string &fallback) const {
+    const JsonValue *member = find(key);
+    if (!member || (member->kind != Kind::string && member->kind != Kind::number))
+        return fallback;
+    return member->text;
+}
+
+double JsonValue::get_number(const std::string &key, double fallback) const {
+    const JsonValue *member = find(key);
+    if (!member)
+        return fallback;
+    if (member->kind == Kind::number)
+        return member->number;
+    if (member->kind == Kind::string) {
+        char *end = nullptr;
+        double value = std::strtod(member->text.c_str(), &end);
+        return end != member->text.c_str() ? value : fallback;
+    }
+    return fallback;
+}
+
+bool JsonValue::get_bool(const std::string &key) const {
+    const JsonValue *member = find(key);
+    return member && member->kind == Kind::boolean && member->boolean;
+}
+
+std::optional<JsonValue> parse_json(const std::string &text) {
+    return JsonParser(text).parse_document();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A parsed JSON value, just enough to walk the output of EXPLAIN FORMAT=JSON.
+ */
+struct JsonValue {
+    enum class Kind { null, boolean, number, string, array, object };
+
+    Kind kind = Kind::null;
+    bool boolean = false;
+    double number = 0;
+
+    /**
+     * @brief The string value, or the literal text of a number.
+     */
+    std::string text;
+    std::vector<JsonValue> items;
+    std::map<std::string, JsonValue> members;
+
+    /**
+     * @brief Looks up an object member.
+     * @return The member, or nullptr if this is not an object or has no such member.
+     */
+    const JsonValue *find(const std::string &key) const;
+
+    /**
+     * @brief Reads a member as a string; numbers are returned as their literal text.
+     */
+    std::string get_string(const std::string &key, const std::string &fallback = "") const;
+
+    /**
+     * @brief Reads a member as a number; MySQL prints some numbers as strings ("rows_produced_per_join" etc.).
+     */
+    double get_number(const std::string &key, double fallback = 0) const;
+
+    /**
+     * @brief Reads a member as a boolean.
+     */
+    bool get_bool(const std::string &key) const;
+};
+
+/**
+ * @brief Parses a JSON document.
+ * @param text The document.
+ * @return The root value, or std::nullopt if the document is malformed.
+ */
+std::optional<JsonValue> parse_json(const std::string &text);
@@ -0,0 +1,350 @@
+#include <string>
+#include <vector>
+
+#include "StatementCatalog.h"
+
+// Sample parameters; DatasetGenerator creates rows for all of them.
+static constexpr long long club = 7;
+static constexpr long long student = 42;
+static constexpr long long activity = 12;
+static constexpr long long gathering = 5;
+static constexpr long long result = 3;
+static constexpr long long location = 4;
+static constexpr long long year = 2024;
+static constexpr long long limit = 10;
+
+static const std::string activity_totals = "LEFT JOIN Gathering AS g ON g.act_id = a.act_id "
+                                           "LEFT JOIN Gathering_Student AS gs ON gs.gathering_id = g.gathering_id ";
+static const std::string period_filter = "WHERE (start_date <= ? AND (end_date >= ? OR end_date IS NULL)) AND pending_delete = 0";
+
+static std::vector<CatalogStatement> build_catalog() {
+    const IndexCandidate activity_period{"Activity", {"start_date", "end_date"}};
+    const IndexCandidate club_activity_period{"Activity", {"club_id", "start_date", "end_date"}};
+    const IndexCandidate student_department{"Student", {"department"}};
+    const IndexCandidate activity_pending{"Activity", {"pending_delete"}};
+    const IndexCandidate club_pending{"Club", {"pending_delete"}};
+
+    std::vector<CatalogStatement> catalog = {
+        // BasicTable builds these from column/value maps with inline literals.
+        {"StudentTable::read_student_by_field (name)", "SELECT * FROM Student WHERE name like '%student4%'", {}, {}},
+        {"StudentTable::read_student_by_field (department)", "SELECT * FROM Student WHERE department like '%dept3%'", {}, {}},
+        {"StudentTable::read_student_by_field (trigram index)", "SELECT * FROM Student WHERE student_id IN (?, ?, ?)",
+         {student, student + 1, student + 2}, {}},
+        {"StudentTable::read_all_student", "SELECT * FROM Student", {}, {}},
+        {"StudentTable::delete_student_by_id (club counters)",
+         "UPDATE Club AS c JOIN Club_Student AS cs ON cs.club_id = c.club_id "
+         "SET c.member_count = c.member_count - 1 WHERE cs.student_id = ?",
+         {student}, {}},
+        {"StudentTable::delete_student_by_id", "DELETE FROM Student WHERE student_id = ?", {student}, {}},
+
+        {"ClubTable::read_club_by_id", "SELECT * FROM Club WHERE club_id = '7' AND pending_delete = 0", {}, {}},
+        {"ClubTable::read_club_by_name", "SELECT * FROM Club WHERE club_name LIKE ? AND pending_delete = 0",
+         {std::string("%club1%")}, {}},
+        {"ClubTable::read_club_by_name (trigram index)", "SELECT * FROM Club WHERE club_id IN (?, ?, ?) AND pending_delete = 0",
+         {club, club + 1, club + 2}, {}},
+        {"ClubTable::read_club_by_location_id",
+         "SELECT * FROM Club WHERE club_id IN (SELECT club_id FROM Location WHERE loc_id = ?) AND pending_delete = 0",
+         {location}, {}},
+        {"ClubTable::read_club_by_location_name",
+         "SELECT * FROM Club WHERE club_id IN (SELECT club_id FROM Location WHERE loc_name LIKE ?) AND pending_delete = 0",
+         {std::string("%loc1%")}, {}},
+        {"ClubTable::read_club_by_prof_id", "SELECT * FROM Club WHERE prof_id = ? AND pending_delete = 0", {2LL}, {}},
+        {"ClubTable::read_info", "SELECT c.*, JOIN Location ON c.club_id = Location.club_id FROM Club AS c "
+                                 "WHERE c.club_id = ? AND c.pending_delete = 0",
+         {club}, {}},
+        {"ClubTable::read_members_by_club_id",
+         "SELECT * FROM Student WHERE student_id IN (SELECT student_id FROM Club_Student WHERE club_id = ?)", {club}, {}},
+        {"ClubTable::read_members_by_name_in_club",
+         "SELECT s.* FROM Student AS s JOIN Club_Student AS cs ON s.student_id = cs.student_id "
+         "WHERE cs.club_id = ? AND s.name LIKE ?",
+         {club, std::string("%student1%")}, {}},
+        {"ClubTable::read_members_by_name_in_club (trigram index)",
+         "SELECT s.* FROM Student AS s JOIN Club_Student AS cs ON s.student_id = cs.student_id "
+         "WHERE cs.club_id = ? AND s.student_id IN (?, ?, ?)",
+         {club, student, student + 1, student + 2}, {}},
+        {"ClubTable::adjust_budget", "UPDATE Club SET budget = budget + ? WHERE club_id = ? AND budget + ? >= 0",
+         {std::string("10.00"), club, std::string("10.00")}, {}},
+        {"ClubTable::adjust_budget (budget ledger)",
+         "INSERT INTO Budget_Ledger (club_id, delta) VALUES (?, ?)", {club, std::string("10.00")}, {}},
+        {"ClubTable::read_effective_budget", "SELECT club_id, budget FROM Club WHERE club_id = ?", {club}, {}},
+        {"ClubTable::read_effective_budget (budget ledger)",
+         "SELECT c.club_id, c.budget + "
+         "COALESCE((SELECT SUM(l.delta) FROM Budget_Ledger AS l WHERE l.club_id = c.club_id), 0) AS budget "
+         "FROM Club AS c WHERE c.club_id = ?",
+         {club}, {}},
+        {"ClubTable::add_members_by_department",
+         "INSERT IGNORE INTO Club_Student (club_id, student_id) SELECT ?, s.student_id FROM Student AS s WHERE s.department = ?",
+         {club, std::string("dept3")}, {student_department}},
+        {"ClubTable::delete_members_by_department",
+         "DELETE cs FROM Club_Student AS cs JOIN Student AS s ON s.student_id = cs.student_id "
+         "WHERE cs.club_id = ? AND s.department = ?",
+         {club, std::string("dept3")}, {student_department}},
+        {"ClubTable::delete_club (async purge)", "UPDATE Club SET pending_delete = 1 WHERE club_id = ? AND pending_delete = 0",
+         {club}, {}},
+        {"ClubTable::read_all_club", "SELECT * FROM Club WHERE pending_delete = 0", {}, {}},
+        {"ClubTable::read_club_counts", "SELECT club_id, member_count, activity_count FROM Club WHERE club_id = ? AND pending_delete = 0",
+         {club}, {}},
+        {"ClubTable::read_club_counts (aggregate)",
+         "SELECT c.club_id, "
+         "(SELECT COUNT(*) FROM Club_Student AS cs WHERE cs.club_id = c.club_id) AS member_count, "
+         "(SELECT COUNT(*) FROM Activity AS a WHERE a.club_id = c.club_id AND a.pending_delete = 0) AS activity_count "
+         "FROM Club AS c WHERE c.club_id = ? AND c.pending_delete = 0",
+         {club}, {}},
+        {"ClubTable::read_largest_clubs",
+         "SELECT club_id, club_name, member_count, activity_count FROM Club "
+         "WHERE pending_delete = 0 ORDER BY member_count DESC, club_id DESC LIMIT ?",
+         {limit}, {}},
+        {"ClubTable::read_largest_clubs (aggregate)",
+         "SELECT c.club_id, c.club_name, COUNT(cs.student_id) AS member_count, "
+         "(SELECT COUNT(*) FROM Activity AS a WHERE a.club_id = c.club_id AND a.pending_delete = 0) AS activity_count "
+         "FROM Club AS c LEFT JOIN Club_Student AS cs ON cs.club_id = c.club_id WHERE c.pending_delete = 0 "
+         "GROUP BY c.club_id, c.club_name ORDER BY member_count DESC, c.club_id DESC LIMIT ?",
+         {limit}, {}},
+        {"ClubTable::read_yearly_activity",
+         "SELECT year, activity_count, gathering_count, attendee_count FROM Club_Activity_Rollup "
+         "WHERE club_id = ? AND activity_count > 0 ORDER BY year DESC",
+         {club}, {}},
+        {"ClubTable::read_yearly_activity (aggregate)",
+         "SELECT YEAR(a.start_date) AS year, COUNT(DISTINCT a.act_id) AS activity_count, "
+         "COUNT(DISTINCT g.gathering_id) AS gathering_count, COUNT(gs.student_id) AS attendee_count "
+         "FROM Activity AS a " + activity_totals +
+         "WHERE a.club_id = ? AND a.pending_delete = 0 GROUP BY YEAR(a.start_date) ORDER BY year DESC",
+         {club}, {}},
+
+        {"ClubStudentTable::read_by_student_id", "SELECT * FROM Club_Student WHERE student_id = ?", {student}, {}},
+        {"ClubStudentTable::read_by_club_id", "SELECT * FROM Club_Student WHERE club_id = '7'", {}, {}},
+
+        {"ActivityTable::reindex_period",
+         "SELECT club_id, start_date, end_date FROM Activity WHERE act_id = ? AND pending_delete = 0 AND club_id IS NOT NULL",
+         {activity}, {}},
+        {"ActivityTable::read_activity_by_club_id", "SELECT * FROM Activity WHERE club_id = ? AND pending_delete = 0", {club}, {}},
+        {"ActivityTable::read_activity_by_title", "SELECT * FROM Activity WHERE act_title LIKE ? AND pending_delete = 0",
+         {std::string("%activity1%")}, {}},
+        {"ActivityTable::read_activity_by_title (club)",
+         "SELECT * FROM Activity WHERE act_title LIKE ? AND pending_delete = 0 AND club_id = ?",
+         {std::string("%activity1%"), club}, {}},
+        {"ActivityTable::read_activity_by_title (trigram index)",
+         "SELECT * FROM Activity WHERE act_id IN (?, ?, ?) AND pending_delete = 0 AND club_id = ?",
+         {activity, activity + 1, activity + 2, club}, {}},
+        {"ActivityTable::read_activity_by_period", "SELECT * FROM Activity " + period_filter,
+         {std::string("2024-05-01"), std::string("2024-04-01")}, {activity_period}},
+        {"ActivityTable::read_activity_by_period (club)", "SELECT * FROM Activity " + period_filter + " AND club_id = ?",
+         {std::string("2024-05-01"), std::string("2024-04-01"), club}, {club_activity_period}},
+        {"ActivityTable::read_activity_by_period (interval index)",
+         "SELECT * FROM Activity WHERE act_id IN (?, ?, ?) AND pending_delete = 0", {activity, activity + 1, activity + 2}, {}},
+        {"ActivityTable::read_activity_ids_by_periods", "SELECT act_id FROM Activity " + period_filter + " ORDER BY act_id",
+         {std::string("2024-05-01"), std::string("2024-04-01")}, {activity_period}},
+        {"ActivityTable::read_activity_ids_by_periods (club)",
+         "SELECT act_id FROM Activity " + period_filter + " AND club_id = ? ORDER BY act_id",
+         {std::string("2024-05-01"), std::string("2024-04-01"), club}, {club_activity_period}},
+        {"ActivityTable::read_activity_by_id", "SELECT * FROM Activity WHERE act_id = ? AND pending_delete = 0", {activity}, {}},
+        {"ActivityTable::update_activity", "UPDATE Activity SET act_title = ?, end_date = ? WHERE act_id = ?",
+         {std::string("renamed"), std::string("2024-12-31"), activity}, {}},
+        {"ActivityTable::delete_activity (async purge)",
+         "UPDATE Activity SET pending_delete = 1 WHERE act_id = ? AND pending_delete = 0", {activity}, {}},
+        {"ActivityTable::delete_activity", "DELETE FROM Activity WHERE act_id = ?", {activity}, {}},
+
+        {"GatheringTable::delete_student_from_gathering",
+         "DELETE FROM Gathering_Student WHERE student_id = ? AND gathering_id = ?", {student, gathering}, {}},
+        {"GatheringTable::read_gathering_by_act_id", "SELECT * FROM Gathering WHERE act_id = ?", {activity}, {}},
+        {"GatheringTable::read_gathering_by_name", "SELECT * FROM Gathering WHERE gathering_name LIKE ?",
+         {std::string("%gathering1%")}, {}},
+        {"GatheringTable::read_gathering_by_name (trigram index)", "SELECT * FROM Gathering WHERE gathering_id IN (?, ?, ?)",
+         {gathering, gathering + 1, gathering + 2}, {}},
+        {"GatheringTable::update_gathering_name", "UPDATE Gathering SET gathering_name = ? WHERE gathering_id = ?",
+         {std::string("renamed"), gathering}, {}},
+        {"GatheringTable::delete_gathering (attendee count)", "SELECT COUNT(*) FROM Gathering_Student WHERE gathering_id = ?",
+         {gathering}, {}},
+        {"GatheringTable::delete_gathering", "DELETE FROM Gathering WHERE gathering_id = ?", {gathering}, {}},
+        {"GatheringTable::add_all_club_members",
+         "INSERT IGNORE INTO Gathering_Student (gathering_id, student_id) "
+         "SELECT g.gathering_id, cs.student_id FROM Gathering AS g JOIN Activity AS a ON a.act_id = g.act_id "
+         "JOIN Club_Student AS cs ON cs.club_id = a.club_id WHERE g.gathering_id = ?",
+         {gathering}, {}},
+        {"GatheringTable::delete_non_members",
+         "DELETE gs FROM Gathering_Student AS gs JOIN Gathering AS g ON g.gathering_id = gs.gathering_id "
+         "JOIN Activity AS a ON a.act_id = g.act_id "
+         "LEFT JOIN Club_Student AS cs ON cs.club_id = a.club_id AND cs.student_id = gs.student_id "
+         "WHERE gs.gathering_id = ? AND cs.student_id IS NULL",
+         {gathering}, {}},
+        {"GatheringTable::read_all_students_from_gathering",
+         "SELECT * FROM Student AS s WHERE s.student_id IN "
+         "(SELECT gs.student_id FROM Gathering_Student AS gs WHERE gs.gathering_id = ?)",
+         {gathering}, {}},
+        {"GatheringTable::overlaps_schedule (period)",
+         "SELECT a.start_date, COALESCE(a.end_date, '9999-12-31') FROM Gathering AS g "
+         "JOIN Activity AS a ON a.act_id = g.act_id WHERE g.gathering_id = ?",
+         {gathering}, {}},
+        {"GatheringTable::overlaps_schedule",
+         "SELECT 1 FROM Gathering_Student AS gs "
+         "JOIN Gathering AS og ON og.gathering_id = gs.gathering_id JOIN Activity AS oa ON oa.act_id = og.act_id "
+         "WHERE gs.student_id = ? AND og.gathering_id <> ? AND oa.pending_delete = 0 "
+         "AND oa.start_date <= ? AND COALESCE(oa.end_date, '9999-12-31') >= ? LIMIT 1",
+         {student, gathering, std::string("2024-05-01"), std::string("2024-04-01")}, {}},
+        {"GatheringTable::find_conflicts",
+         "SELECT gs.student_id, gs.gathering_id, TO_DAYS(a.start_date), TO_DAYS(a.end_date) FROM Gathering_Student AS gs "
+         "JOIN Gathering AS g ON g.gathering_id = gs.gathering_id JOIN Activity AS a ON a.act_id = g.act_id "
+         "WHERE gs.student_id = ? AND a.pending_delete = 0",
+         {student}, {}},
+        {"GatheringTable::find_all_conflicts",
+         "SELECT gs.student_id, gs.gathering_id, TO_DAYS(a.start_date), TO_DAYS(a.end_date) FROM Gathering_Student AS gs "
+         "JOIN Gathering AS g ON g.gathering_id = gs.gathering_id JOIN Activity AS a ON a.act_id = g.act_id "
+         "WHERE a.pending_delete = 0",
+         {}, {}},
+        {"GatheringStudentTable::read_all_gathering_students", "SELECT * FROM Gathering_Student", {}, {}},
+
+        {"ProfessorTable::read_professor_by_id", "SELECT * FROM Professor WHERE prof_id = '2'", {}, {}},
+        {"ProfessorTable::read_professor_by_club_id",
+         "SELECT * FROM professor WHERE prof_id IN (SELECT prof_id FROM club WHERE club_id = ?)", {club}, {}},
+
+        {"ResultTable::submit_result (rollup check)",
+         "SELECT activity_count FROM Club_Activity_Rollup WHERE club_id = ? AND year = ?", {club, year}, {}},
+        {"ResultTable::submit_result (link activities)",
+         "INSERT IGNORE INTO Result_Activity (result_id, act_id) SELECT ?, a.act_id FROM Activity AS a "
+         "WHERE a.club_id = ? AND a.start_date >= ? AND a.start_date < ? AND a.pending_delete = 0",
+         {result, club, std::string("2024-01-01"), std::string("2025-01-01")}, {}},
+        {"ResultTable::read_results_by_club",
+         "SELECT r.result_id, r.club_id, r.year, COALESCE(cr.activity_count, 0) AS activities, "
+         "COALESCE(cr.gathering_count, 0) AS gatherings, COALESCE(cr.attendee_count, 0) AS attendees FROM Result AS r "
+         "LEFT JOIN Club_Activity_Rollup AS cr ON cr.club_id = r.club_id AND cr.year = r.year "
+         "WHERE r.club_id = ? ORDER BY r.year DESC",
+         {club}, {}},
+        {"ResultTable::read_results_by_club (aggregate)",
+         "SELECT r.result_id, r.club_id, r.year, COUNT(DISTINCT ra.act_id) AS activities, "
+         "COUNT(DISTINCT g.gathering_id) AS gatherings, COUNT(gs.student_id) AS attendees FROM Result AS r "
+         "LEFT JOIN Result_Activity AS ra ON ra.result_id = r.result_id "
+         "LEFT JOIN Gathering AS g ON g.act_id = ra.act_id "
+         "LEFT JOIN Gathering_Student AS gs ON gs.gathering_id = g.gathering_id "
+         "WHERE r.club_id = ? GROUP BY r.result_id, r.club_id, r.year ORDER BY r.year DESC",
+         {club}, {}},
+        {"ResultTable::read_result_activities",
+         "SELECT a.* FROM Result_Activity AS ra JOIN Activity AS a ON a.act_id = ra.act_id "
+         "WHERE ra.result_id = ? ORDER BY a.start_date",
+         {result}, {}},
+        {"ResultTable::read_year_summary",
+         "SELECT c.club_id, c.club_name, cr.activity_count, cr.gathering_count, cr.attendee_count, r.result_id "
+         "FROM Club_Activity_Rollup AS cr JOIN Club AS c ON c.club_id = cr.club_id "
+         "LEFT JOIN Result AS r ON r.club_id = cr.club_id AND r.year = cr.year "
+         "WHERE cr.year = ? AND cr.activity_count > 0 AND c.pending_delete = 0 "
+         "ORDER BY cr.activity_count DESC LIMIT ?",
+         {year, limit}, {}},
+        {"ResultTable::read_year_summary (aggregate)",
+         "SELECT c.club_id, c.club_name, COUNT(DISTINCT a.act_id) AS activity_count, "
+         "COUNT(DISTINCT g.gathering_id) AS gathering_count, COUNT(gs.student_id) AS attendee_count, "
+         "MAX(r.result_id) AS result_id FROM Activity AS a JOIN Club AS c ON c.club_id = a.club_id " +
+         activity_totals +
+         "LEFT JOIN Result AS r ON r.club_id = a.club_id AND r.year = YEAR(a.start_date) "
+         "WHERE YEAR(a.start_date) = ? AND a.pending_delete = 0 AND c.pending_delete = 0 "
+         "GROUP BY c.club_id, c.club_name ORDER BY activity_count DESC LIMIT ?",
+         {year, limit}, {}},
+        {"ResultBatchJob::run_all", "SELECT club_id FROM Club WHERE pending_delete = 0", {}, {}},
+
+        {"ActivityRollup::rebuild_partition",
+         "SELECT a.club_id, YEAR(a.start_date) AS year, COUNT(DISTINCT a.act_id) AS activity_count, "
+         "COUNT(DISTINCT g.gathering_id) AS gathering_count, COUNT(gs.student_id) AS attendee_count "
+         "FROM Activity AS a " + activity_totals +
+         "WHERE a.club_id BETWEEN ? AND ? AND a.pending_delete = 0 GROUP BY a.club_id, YEAR(a.start_date)",
+         {1LL, 64LL}, {}},
+        {"ActivityRollup::rebuild_partition (clear)", "DELETE FROM Club_Activity_Rollup WHERE club_id BETWEEN ? AND ?",
+         {1LL, 64LL}, {}},
+        {"ActivityRollup::contribution",
+         "SELECT a.club_id, YEAR(a.start_date), COUNT(DISTINCT g.gathering_id), COUNT(gs.student_id) "
+         "FROM Activity AS a " + activity_totals +
+         "WHERE a.act_id = ? AND a.pending_delete = 0 AND a.club_id IS NOT NULL GROUP BY a.club_id, YEAR(a.start_date)",
+         {activity}, {}},
+        {"ActivityRollup::apply_for_gathering",
+         "INSERT INTO Club_Activity_Rollup (club_id, year, activity_count, gathering_count, attendee_count) "
+         "SELECT * FROM (SELECT a.club_id, YEAR(a.start_date) AS year, 0 AS activity_count, "
+         "? AS gathering_count, ? AS attendee_count FROM Gathering AS g JOIN Activity AS a ON a.act_id = g.act_id "
+         "WHERE g.gathering_id = ? AND a.pending_delete = 0 AND a.club_id IS NOT NULL) AS d "
+         "ON DUPLICATE KEY UPDATE gathering_count = Club_Activity_Rollup.gathering_count + d.gathering_count, "
+         "attendee_count = Club_Activity_Rollup.attendee_count + d.attendee_count",
+         {0LL, 1LL, gathering}, {}},
+        {"ActivityRollup::remove_student",
+         "UPDATE Club_Activity_Rollup AS r JOIN "
+         "(SELECT a.club_id, YEAR(a.start_date) AS year, COUNT(*) AS attendances FROM Gathering_Student AS gs "
+         "JOIN Gathering AS g ON g.gathering_id = gs.gathering_id JOIN Activity AS a ON a.act_id = g.act_id "
+         "WHERE gs.student_id = ? AND a.pending_delete = 0 "
+         "GROUP BY a.club_id, YEAR(a.start_date)) AS d ON d.club_id = r.club_id AND d.year = r.year "
+         "SET r.attendee_count = r.attendee_count - d.attendances",
+         {student}, {}},
+        {"ActivityRollup::refresh_for_gathering",
+         "SELECT a.club_id, YEAR(a.start_date) FROM Gathering AS g JOIN Activity AS a ON a.act_id = g.act_id "
+         "WHERE g.gathering_id = ? AND a.pending_delete = 0 AND a.club_id IS NOT NULL",
+         {gathering}, {}},
+        {"ActivityRollup::refresh_for_gathering (recount)",
+         "INSERT INTO Club_Activity_Rollup (club_id, year, activity_count, gathering_count, attendee_count) "
+         "SELECT * FROM (SELECT ? AS club_id, ? AS year, COUNT(DISTINCT a.act_id) AS activity_count, "
+         "COUNT(DISTINCT g.gathering_id) AS gathering_count, COUNT(gs.student_id) AS attendee_count "
+         "FROM Activity AS a " + activity_totals +
+         "WHERE a.club_id = ? AND a.start_date >= ? AND a.start_date < ? AND a.pending_delete = 0) AS d "
+         "ON DUPLICATE KEY UPDATE activity_count = d.activity_count, gathering_count = d.gathering_count, "
+         "attendee_count = d.attendee_count",
+         {club, year, club, std::string("2024-01-01"), std::string("2025-01-01")}, {}},
+
+        {"ClubCounterReconciler::reconcile_chunk (lock)",
+         "SELECT club_id, member_count, activity_count FROM Club WHERE club_id BETWEEN ? AND ? FOR UPDATE", {1LL, 64LL}, {}},
+        {"ClubCounterReconciler::reconcile_chunk (members)",
+         "SELECT club_id, COUNT(*) FROM Club_Student WHERE club_id BETWEEN ? AND ? GROUP BY club_id", {1LL, 64LL}, {}},
+        {"ClubCounterReconciler::reconcile_chunk (activities)",
+         "SELECT club_id, COUNT(*) FROM Activity WHERE club_id BETWEEN ? AND ? AND pending_delete = 0 GROUP BY club_id",
+         {1LL, 64LL}, {}},
+        {"ClubCounterReconciler::reconcile_chunk (repair)",
+         "UPDATE Club SET member_count = ?, activity_count = ? WHERE club_id = ?", {10LL, 10LL, club}, {}},
+
+        {"BudgetLedgerCompactor::compact_once (bound)",
+         "SELECT COUNT(*) AS entries, MAX(entry_id) AS last_entry FROM "
+         "(SELECT entry_id FROM Budget_Ledger ORDER BY entry_id LIMIT ?) AS batch",
+         {1000LL}, {}},
+        {"BudgetLedgerCompactor::compact_once (clubs)",
+         "SELECT DISTINCT club_id FROM Budget_Ledger WHERE entry_id <= ? ORDER BY club_id", {1000LL}, {}},
+        {"BudgetLedgerCompactor::compact_clubs (apply)",
+         "UPDATE Club AS c JOIN (SELECT club_id, SUM(delta) AS total FROM Budget_Ledger WHERE entry_id <= ? "
+         "AND club_id IN (?, ?) GROUP BY club_id) AS l ON c.club_id = l.club_id SET c.budget = c.budget + l.total",
+         {1000LL, club, club + 1}, {}},
+        {"BudgetLedgerCompactor::compact_clubs (delete)", "DELETE FROM Budget_Ledger WHERE entry_id <= ? AND club_id IN (?, ?)",
+         {1000LL, club, club + 1}, {}},
+
+        {"CascadePurger::resume_pending (clubs)", "SELECT club_id FROM Club WHERE pending_delete = 1", {}, {club_pending}},
+        {"CascadePurger::resume_pending (activities)", "SELECT act_id FROM Activity WHERE pending_delete = 1", {}, {activity_pending}},
+    };
+
+    // CascadePurger stages: DELETE FROM <table> WHERE <condition> ORDER BY <order_by> LIMIT ?
+    struct PurgeStage {
+        const char *table;
+        const char *condition;
+        const char *order_by;
+        long long id;
+    };
+    static const PurgeStage purge_stages[] = {
+        {"Result_Activity", "result_id IN (SELECT result_id FROM Result WHERE club_id = ?)", "result_id, act_id", club},
+        {"Result_Activity", "act_id IN (SELECT act_id FROM Activity WHERE club_id = ?)", "result_id, act_id", club},
+        {"Result", "club_id = ?", "result_id", club},
+        {"Gathering_Student", "gathering_id IN (SELECT g.gathering_id FROM Gathering AS g JOIN Activity AS a ON a.act_id = g.act_id WHERE a.club_id = ?)",
+         "gathering_id, student_id", club},
+        {"Gathering", "act_id IN (SELECT act_id FROM Activity WHERE club_id = ?)", "gathering_id", club},
+        {"Activity", "club_id = ?", "act_id", club},
+        {"Club_Student", "club_id = ?", "club_id, student_id", club},
+        {"Club_Equipment", "club_id = ?", "club_id, equip_id", club},
+        {"Location", "club_id = ?", "loc_id", club},
+        {"Budget_Ledger", "club_id = ?", "entry_id", club},
+        {"Club", "club_id = ?", "club_id", club},
+        {"Result_Activity", "act_id = ?", "result_id, act_id", activity},
+        {"Gathering_Student", "gathering_id IN (SELECT gathering_id FROM Gathering WHERE act_id = ?)", "gathering_id, student_id", activity},
+        {"Gathering", "act_id = ?", "gathering_id", activity},
+        {"Activity", "act_id = ?", "act_id", activity},
+    };
+    for (const auto &stage : purge_stages) {
+        catalog.push_back({std::string("CascadePurger::purge (") + stage.table + " WHERE " + stage.condition + ")",
+                           std::string("DELETE FROM ") + stage.table + " WHERE " + stage.condition + " ORDER BY " +
+                               stage.order_by + " LIMIT ?",
+                           {stage.id, 500LL},
+                           {}});
+    }
+    return catalog;
+}
+
+const std::vector<CatalogStatement> &statement_catalog() {
+    static const std::vector<CatalogStatement> catalog = build_catalog();
+    return catalog;
+}
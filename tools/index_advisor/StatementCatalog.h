@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <variant>
+#include <vector>
+
+/**
+ * @brief A parameter value for a '?' placeholder.
+ */
+using SqlParam = std::variant<long long, std::string>;
+
+/**
+ * @brief An index on one table, given by its column list.
+ */
+struct IndexCandidate {
+    std::string table;
+    std::vector<std::string> columns;
+
+    bool operator==(const IndexCandidate &other) const = default;
+};
+
+/**
+ * @brief One statement shape issued by the service layer, with sample parameters for the generated dataset.
+ */
+struct CatalogStatement {
+    /**
+     * @brief Where the statement comes from, "Class::method", plus the variant when a method builds several shapes.
+     */
+    std::string name;
+    std::string sql;
+    std::vector<SqlParam> params;
+
+    /**
+     * @brief Indexes worth trying for this statement besides the ones derived from its plan.
+     */
+    std::vector<IndexCandidate> candidates;
+};
+
+/**
+ * @brief Lists the statement shapes of src/service, one entry per distinct plan.
+ *
+ * Shapes whose only variable part is the length of an IN list are listed once with three IDs.
+ * Statements on the temporary Sync_Roster table and plain INSERT ... VALUES are left out since
+ * they have no access path to choose. When a service method changes a statement, its entry
+ * here has to change with it.
+ */
+const std::vector<CatalogStatement> &statement_catalog();
@@ -0,0 +1,140 @@
+#include <cppconn/driver.h>
+#include <cppconn/exception.h>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../../src/utils.h"
+#include "DatasetGenerator.h"
+#include "IndexAdvisor.h"
+#include "StatementCatalog.h"
+
+static void usage() {
+    std::cout << "usage: index_advisor [options]\n"
+                 "  --generate [scale]       fill the empty schema with a generated dataset first (scale 1 by default)\n"
+                 "  --migration <file>       write proposed indexes as a migration (default advised_indexes.sql)\n"
+                 "  --no-propose             only explain; do not try candidate indexes\n"
+                 "  --write-baseline <file>  save the access type of every statement and table\n"
+                 "  --check <file>           compare with a saved baseline; exit status 1 on a regression,\n"
+                 "                           skipped with a notice if the file does not exist\n"
+                 "  --min-rows <n>           ignore full scans over fewer rows (default 200)\n"
+                 "  --min-gain <fraction>    rows or cost an index has to save to be proposed (default 0.25)\n"
+                 "Connects with MYSQL_SERVER, MYSQL_USER, MYSQL_PASSWORD and MYSQL_DATABASE like sev. Use a scratch\n"
+                 "schema: the dataset is only generated into an empty one, and trial indexes are only added to a\n"
+                 "schema holding a generated dataset.\n";
+}
+
+static std::shared_ptr<sql::Connection> connect_mysql() {
+    sql::Driver *driver = get_driver_instance();
+
+    const char *server = std::getenv("MYSQL_SERVER");
+    const char *user = std::getenv("MYSQL_USER");
+    const char *password = std::getenv("MYSQL_PASSWORD");
+    const char *database = std::getenv("MYSQL_DATABASE");
+    if (!server || !user || !password || !database) {
+        Logger(ll_critical, "MYSQL_SERVER, MYSQL_USER, MYSQL_PASSWORD and MYSQL_DATABASE must be set").log();
+        exit(EXIT_FAILURE);
+    }
+
+    std::shared_ptr<sql::Connection> con;
+    try {
+        con = std::shared_ptr<sql::Connection>(driver->connect(std::string("tcp://") + server, user, password));
+        con->setSchema(database);
+        Logger(ll_info, "Successfully Connected to MySQL").log();
+    } catch (sql::SQLException &e) {
+        Logger(ll_critical, std::string(e.what())).log();
+        exit(EXIT_FAILURE);
+    }
+    return con;
+}
+
+int main(int argc, char **argv) {
+    int scale = 0;
+    bool propose = true;
+    std::string migration = "advised_indexes.sql";
+    std::string write_baseline;
+    std::string check;
+    double min_rows = 200;
+    double min_gain = 0.25;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--generate") {
+            scale = 1;
+            if (has_value && std::atoi(argv[i + 1]) > 0)
+                scale = std::atoi(argv[++i]);
+        } else if (arg == "--migration" && has_value) {
+            migration = argv[++i];
+        } else if (arg == "--no-propose") {
+            propose = false;
+        } else if (arg == "--write-baseline" && has_value) {
+            write_baseline = argv[++i];
+        } else if (arg == "--check" && has_value) {
+            check = argv[++i];
+            propose = false;
+        } else if (arg == "--min-rows" && has_value) {
+            min_rows = std::atof(argv[++i]);
+        } else if (arg == "--min-gain" && has_value) {
+            min_gain = std::atof(argv[++i]);
+        } else {
+            usage();
+            return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (!check.empty() && !std::filesystem::exists(check)) {
+        std::cout << "No plan baseline at " << check << ", skipping the plan check. Record one on a generated dataset with\n"
+                  << "  index_advisor --no-propose --write-baseline " << check << '\n';
+        check.clear();
+        if (write_baseline.empty() && scale == 0 && !propose)
+            return EXIT_SUCCESS;
+    }
+
+    std::shared_ptr<sql::Connection> con = connect_mysql();
+    DatasetGenerator generator(con);
+    if (scale > 0 && !generator.generate(scale))
+        return EXIT_FAILURE;
+
+    IndexAdvisor advisor(con);
+    advisor.set_min_rows(min_rows);
+    advisor.set_min_gain(min_gain);
+    if (!advisor.analyze_tables())
+        return EXIT_FAILURE;
+
+    auto reports = advisor.explain_all(statement_catalog());
+    IndexAdvisor::print_report(reports);
+
+    int status = EXIT_SUCCESS;
+    if (!check.empty()) {
+        auto regressions = IndexAdvisor::check_baseline(check, reports);
+        if (!regressions)
+            return EXIT_FAILURE;
+        for (const auto &regression : *regressions)
+            std::cout << "REGRESSION " << regression.statement << ": " << regression.table << " " << regression.baseline_access
+                      << " -> " << regression.current_access << '\n';
+        std::cout << regressions->size() << " plan regressions against " << check << '\n';
+        if (!regressions->empty())
+            status = EXIT_FAILURE;
+    }
+
+    if (!write_baseline.empty() && !IndexAdvisor::write_baseline(write_baseline, reports))
+        return EXIT_FAILURE;
+
+    if (propose) {
+        if (!generator.is_generated()) {
+            Logger(ll_error, "Refusing to add trial indexes to a schema without a generated dataset (see --generate)").log();
+            return EXIT_FAILURE;
+        }
+        auto proposals = advisor.propose(reports);
+        if (!proposals || !IndexAdvisor::write_migration(migration, *proposals))
+            return EXIT_FAILURE;
+        for (const auto &proposal : *proposals)
+            std::cout << "PROPOSE " << proposal.index.table << " (" << proposal.index_name << "), helps "
+                      << proposal.improvements.size() << " statement(s)\n";
+        std::cout << proposals->size() << " indexes proposed, written to " << migration << '\n';
+    }
+    return status;
+}
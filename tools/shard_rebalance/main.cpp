@@ -0,0 +1,283 @@
+#include <cppconn/connection.h>
+#include <cppconn/datatype.h>
+#include <cppconn/driver.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../src/service/BasicTable.h"
+#include "../../src/service/QueryResult.h"
+#include "../../src/service/ShardMap.h"
+#include "../../src/service/Transaction.h"
+#include "../../src/utils.h"
+
+static void usage() {
+    std::cout << "usage: shard_rebalance --status\n"
+                 "       shard_rebalance --register <shard>\n"
+                 "       shard_rebalance --move <club_id> --to <shard>\n"
+                 "  --status          print how many clubs each shard holds and the directory places there\n"
+                 "  --register s      record every club found on shard s in the directory, e.g. after\n"
+                 "                    loading an existing database as shard 0\n"
+                 "  --move c --to s   copy club c and all rows it owns to shard s, point the directory at\n"
+                 "                    s and delete the club from its old shard\n"
+                 "Shards are numbered by their position in SEV_SHARDS as for sev; the directory (Club_Shard)\n"
+                 "is read from MYSQL_SERVER. Connects with MYSQL_USER, MYSQL_PASSWORD and MYSQL_DATABASE.\n";
+}
+
+/**
+ * @brief A table whose rows belong to one club, with the condition selecting a club's rows.
+ * Listed parents first, so that copying in this order satisfies the foreign keys.
+ */
+struct OwnedTable {
+    const char *name;
+    const char *club_filter;
+};
+
+static const OwnedTable owned_tables[] = {
+    {"Club", "club_id = ?"},
+    {"Location", "club_id = ?"},
+    {"Result", "club_id = ?"},
+    {"Activity", "club_id = ?"},
+    {"Gathering", "act_id IN (SELECT act_id FROM Activity WHERE club_id = ?)"},
+    {"Result_Activity", "result_id IN (SELECT result_id FROM Result WHERE club_id = ?)"},
+    {"Club_Student", "club_id = ?"},
+    {"Gathering_Student",
+     "gathering_id IN (SELECT g.gathering_id FROM Gathering AS g JOIN Activity AS a ON a.act_id = g.act_id "
+     "WHERE a.club_id = ?)"},
+    {"Budget_Ledger", "club_id = ?"},
+    {"Club_Activity_Rollup", "club_id = ?"},
+    {"Club_Equipment", "club_id = ?"},
+};
+
+/**
+ * @throws sql::SQLException if the connection fails.
+ */
+static std::shared_ptr<sql::Connection> connect_server(const std::string &server) {
+    sql::Driver *driver = get_driver_instance();
+
+    const char *user = std::getenv("MYSQL_USER");
+    const char *password = std::getenv("MYSQL_PASSWORD");
+    const char *database = std::getenv("MYSQL_DATABASE");
+
+    std::shared_ptr<sql::Connection> con(driver->connect("tcp://" + server, user, password));
+    con->setSchema(database);
+    return con;
+}
+
+static bool has_table(sql::Connection &conn, const std::string &table) {
+    return BasicTable::execute_query(conn, "SHOW TABLES LIKE ?", {table})->next();
+}
+
+/**
+ * @brief Inserts rows read by QueryResult into the same table on another database, NULLs included.
+ */
+static void insert_rows(sql::Connection &conn, const std::string &table, const QueryResult &rows) {
+    if (rows.rows_count() == 0)
+        return;
+
+    std::string query = "INSERT INTO " + table + " (";
+    std::string placeholders;
+    for (size_t column = 0; column < rows.column_count(); ++column) {
+        query += (column == 0 ? "`" : ", `") + rows.column_names()[column] + "`";
+        placeholders += column == 0 ? "?" : ", ?";
+    }
+    query += ") VALUES (" + placeholders + ")";
+
+    std::unique_ptr<sql::PreparedStatement> pstmt(conn.prepareStatement(query));
+    for (size_t row = 0; row < rows.rows_count(); ++row) {
+        for (size_t column = 0; column < rows.column_count(); ++column) {
+            if (rows.is_null(row, column))
+                pstmt->setNull(static_cast<unsigned int>(column + 1), sql::DataType::VARCHAR);
+            else
+                pstmt->setString(static_cast<unsigned int>(column + 1), std::string(rows.get_string(row, column)));
+        }
+        pstmt->executeUpdate();
+    }
+    Logger(ll_info, "executeUpdate: " + query + " x" + std::to_string(rows.rows_count())).log();
+}
+
+static int print_status(ShardMap &shards, sql::Connection &directory) {
+    try {
+        std::map<int, int> placed;
+        std::unique_ptr<sql::ResultSet> res =
+            BasicTable::execute_query(directory, "SELECT shard_id, COUNT(*) FROM Club_Shard GROUP BY shard_id");
+        while (res->next())
+            placed[res->getInt(1)] = res->getInt(2);
+
+        for (size_t shard = 0; shard < shards.size(); ++shard) {
+            std::unique_ptr<sql::ResultSet> clubs = BasicTable::execute_query(*shards.connection(shard), "SELECT COUNT(*) FROM Club");
+            int count = clubs->next() ? clubs->getInt(1) : 0;
+            std::cout << shard << ". " << shards.server(shard) << ": " << count << " clubs, "
+                      << placed[static_cast<int>(shard)] << " placed in the directory" << std::endl;
+        }
+        return EXIT_SUCCESS;
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, "Error in print_status: " + std::string(e.what())).log();
+        return EXIT_FAILURE;
+    }
+}
+
+static int register_clubs(ShardMap &shards, size_t shard) {
+    int registered = 0, failed = 0;
+    try {
+        std::unique_ptr<sql::ResultSet> res = BasicTable::execute_query(*shards.connection(shard), "SELECT club_id FROM Club");
+        while (res->next()) {
+            if (shards.place_club(res->getInt(1), shard))
+                ++registered;
+            else
+                ++failed;
+        }
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, "Error in register_clubs: " + std::string(e.what())).log();
+        return EXIT_FAILURE;
+    }
+    std::cout << registered << " clubs registered on shard " << shard << ", " << failed << " failed" << std::endl;
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Moves a club to another shard.
+ *
+ * The club's rows stay locked on the source (SELECT ... FOR UPDATE) until the copy is committed on
+ * the target and the directory points there, so writes to the club wait or fail rather than being
+ * lost. Processes following the directory switch over within ShardOptions::placement_ttl; until
+ * then their writes go to the source and fail once the club is gone there.
+ */
+static int move_club(ShardMap &shards, int club_id, size_t target) {
+    size_t source = shards.shard_for_club(club_id);
+    if (source == target) {
+        std::cout << "Club " << club_id << " is already on shard " << target << std::endl;
+        return EXIT_SUCCESS;
+    }
+    std::shared_ptr<sql::Connection> from = shards.connection(source);
+    std::shared_ptr<sql::Connection> to = shards.connection(target);
+
+    try {
+        Transaction source_tx(from);
+        std::vector<std::pair<std::string, std::shared_ptr<QueryResult>>> copied;
+        for (const auto &table : owned_tables) {
+            if (!has_table(*from, table.name))
+                continue;
+            std::string query = std::string("SELECT * FROM ") + table.name + " WHERE " + table.club_filter + " FOR UPDATE";
+            std::unique_ptr<sql::ResultSet> res = BasicTable::execute_query(*from, query, {club_id});
+            copied.emplace_back(table.name, QueryResult::from_result_set(*res));
+        }
+        const QueryResult &club = *copied.front().second;
+        if (club.rows_count() == 0) {
+            Logger(ll_error, "Club " + std::to_string(club_id) + " is not on shard " + std::to_string(source)).log();
+            return EXIT_FAILURE;
+        }
+
+        {
+            Transaction target_tx(to);
+            for (const auto &[table, rows] : copied)
+                insert_rows(*to, table, *rows);
+            // Counter triggers have counted the copied members and activities on top of the copied counters.
+            int member_count = club.column_index("member_count");
+            int activity_count = club.column_index("activity_count");
+            if (member_count >= 0 && activity_count >= 0)
+                BasicTable::execute_update(*to, "UPDATE Club SET member_count = ?, activity_count = ? WHERE club_id = ?",
+                                           {club.get_int(0, member_count), club.get_int(0, activity_count), club_id});
+            target_tx.commit();
+        }
+
+        if (!shards.place_club(club_id, target)) {
+            // The source still holds the club; drop the copy so that it is not read twice.
+            BasicTable::execute_update(*to, "DELETE FROM Club WHERE club_id = ?", {club_id});
+            return EXIT_FAILURE;
+        }
+
+        try {
+            // Deleting the Club row cascades to everything it owns.
+            BasicTable::execute_update(*from, "DELETE FROM Club WHERE club_id = ?", {club_id});
+            source_tx.commit();
+        } catch (sql::SQLException &e) {
+            Logger(ll_critical, "Club " + std::to_string(club_id) + " was moved to shard " + std::to_string(target) +
+                                    " but could not be deleted from shard " + std::to_string(source) +
+                                    "; delete it there by hand: " + std::string(e.what()))
+                .log();
+            return EXIT_FAILURE;
+        }
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, "Error in move_club: " + std::string(e.what())).log();
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Club " << club_id << " moved from shard " << source << " to shard " << target << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    std::string command;
+    int club_id = -1;
+    int shard = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--status") {
+            command = arg;
+        } else if (arg == "--register" && has_value) {
+            command = arg;
+            shard = std::atoi(argv[++i]);
+        } else if (arg == "--move" && has_value) {
+            command = arg;
+            club_id = std::atoi(argv[++i]);
+        } else if (arg == "--to" && has_value) {
+            shard = std::atoi(argv[++i]);
+        } else {
+            usage();
+            return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (command.empty() || (command != "--status" && shard < 0) || (command == "--move" && club_id <= 0)) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    const char *server = std::getenv("MYSQL_SERVER");
+    const char *shard_list = std::getenv("SEV_SHARDS");
+    if (!server || !shard_list || !std::getenv("MYSQL_USER") || !std::getenv("MYSQL_PASSWORD") ||
+        !std::getenv("MYSQL_DATABASE")) {
+        Logger(ll_critical, "MYSQL_SERVER, MYSQL_USER, MYSQL_PASSWORD, MYSQL_DATABASE and SEV_SHARDS must be set").log();
+        return EXIT_FAILURE;
+    }
+    std::vector<std::string> servers;
+    std::istringstream list(shard_list);
+    for (std::string shard_server; std::getline(list, shard_server, ',');) {
+        if (!shard_server.empty())
+            servers.push_back(shard_server);
+    }
+    if (shard >= static_cast<int>(servers.size())) {
+        Logger(ll_critical, "SEV_SHARDS has no shard " + std::to_string(shard)).log();
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<ShardMap> shards;
+    std::shared_ptr<sql::Connection> directory;
+    try {
+        directory = connect_server(server);
+        // Placements are read fresh for every club this tool touches.
+        ShardOptions options;
+        options.placement_ttl = std::chrono::milliseconds(0);
+        shards = std::make_unique<ShardMap>(servers, connect_server, connect_server(server), options);
+    } catch (sql::SQLException &e) {
+        Logger(ll_critical, std::string(e.what())).log();
+        return EXIT_FAILURE;
+    }
+
+    if (command == "--status")
+        return print_status(*shards, *directory);
+    if (command == "--register")
+        return register_clubs(*shards, static_cast<size_t>(shard));
+    return move_club(*shards, club_id, static_cast<size_t>(shard));
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include "../../src/storage/MySqlBackend.h"
+#include "../../src/trace/AllocStats.h"
+#include "../../src/utils.h"
+#include "Replayer.h"
+#include "ServiceDispatcher.h"
+
+/**
+ * @brief The value below which a fraction of the sorted latencies fall (nearest rank).
+ */
+static int64_t percentile(const std::vector<int64_t> &sorted, double fraction) {
+    if (sorted.empty())
+        return 0;
+    size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size()) + 0.999999);
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+Replayer::Replayer(std::function<std::shared_ptr<sql::Connection>()> connect) : connect(std::move(connect)) {}
+
+std::optional<std::vector<ReplayResult>> Replayer::replay(const std::vector<WorkloadCall> &calls, double speed) {
+    std::map<uint32_t, std::vector<size_t>> sessions;
+    for (size_t i = 0; i < calls.size(); ++i)
+        sessions[calls[i].session].push_back(i);
+
+    std::vector<std::shared_ptr<sql::Connection>> connections;
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        std::shared_ptr<sql::Connection> conn = connect();
+        if (!conn)
+            return std::nullopt;
+        connections.push_back(conn);
+    }
+
+    std::vector<ReplayResult> results(calls.size());
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    size_t next = 0;
+    for (const auto &[session, indexes] : sessions) {
+        threads.emplace_back([&, conn = connections[next++], &indexes = indexes] {
+            ServiceDispatcher dispatcher(std::make_shared<MySqlConnection>(conn));
+            for (size_t index : indexes) {
+                const WorkloadCall &call = calls[index];
+                if (speed > 0)
+                    std::this_thread::sleep_until(
+                        start + std::chrono::microseconds(static_cast<int64_t>(static_cast<double>(call.at_us) / speed)));
+
+                auto begin = std::chrono::steady_clock::now();
+                std::optional<int64_t> rows = dispatcher.call(call);
+                auto elapsed = std::chrono::steady_clock::now() - begin;
+                results[index] = {index, call.method,
+                                  std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), rows.value_or(-1)};
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    auto total = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    Logger(ll_info, "Replayed " + std::to_string(calls.size()) + " calls in " + std::to_string(sessions.size()) +
+                        " sessions in " + std::to_string(total.count()) + " ms")
+        .log();
+    return results;
+}
+
+bool Replayer::write_results(const std::string &path, const std::vector<ReplayResult> &results) {
+    std::ofstream file(path);
+    if (!file) {
+        Logger(ll_error, "Failed to create " + path).log();
+        return false;
+    }
+    for (const auto &result : results)
+        file << result.index << '\t' << result.method << '\t' << result.latency_us << '\t' << result.rows << '\n';
+    return static_cast<bool>(file);
+}
+
+std::optional<std::vector<ReplayResult>> Replayer::read_results(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        Logger(ll_error, "Failed to open " + path).log();
+        return std::nullopt;
+    }
+    std::vector<ReplayResult> results;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        ReplayResult result;
+        if (fields >> result.index >> result.method >> result.latency_us >> result.rows)
+            results.push_back(std::move(result));
+    }
+    return results;
+}
+
+std::vector<MethodLatency> Replayer::latencies(const std::vector<ReplayResult> &results) {
+    std::map<std::string, std::vector<int64_t>> by_method;
+    std::map<std::string, size_t> failures;
+    for (const auto &result : results) {
+        by_method[result.method].push_back(result.latency_us);
+        if (result.rows < 0)
+            failures[result.method]++;
+    }
+
+    std::vector<MethodLatency> methods;
+    for (auto &[method, samples] : by_method) {
+        std::sort(samples.begin(), samples.end());
+        methods.push_back({method, samples.size(), failures[method], percentile(samples, 0.50), percentile(samples, 0.95),
+                           percentile(samples, 0.99), samples.back()});
+    }
+    std::sort(methods.begin(), methods.end(),
+              [](const MethodLatency &a, const MethodLatency &b) { return a.p95_us > b.p95_us; });
+    return methods;
+}
+
+std::vector<RowMismatch> Replayer::row_mismatches(const std::vector<ReplayResult> &expected,
+                                                  const std::vector<ReplayResult> &actual) {
+    std::map<size_t, const ReplayResult *> by_index;
+    for (const auto &result : expected)
+        by_index[result.index] = &result;
+
+    std::vector<RowMismatch> mismatches;
+    for (const auto &result : actual) {
+        auto it = by_index.find(result.index);
+        if (it != by_index.end() && it->second->method == result.method && it->second->rows != result.rows)
+            mismatches.push_back({result.index, result.method, it->second->rows, result.rows});
+    }
+    return mismatches;
+}
+
+void Replayer::print_latencies(const std::vector<ReplayResult> &results) {
+    // With make ALLOC_STATS=1 every replayed call's "service" span was counted as well.
+    std::map<std::string, AllocStats::SpanStats> allocs;
+    for (auto &stats : AllocStats::spans("service"))
+        allocs[stats.name] = stats;
+
+    std::printf("%-55s %7s %5s %9s %9s %9s %9s", "method", "calls", "fail", "p50(us)", "p95(us)", "p99(us)", "max(us)");
+    if (AllocStats::compiled)
+        std::printf(" %11s %11s", "allocs/call", "bytes/call");
+    std::printf("\n");
+    for (const auto &m : latencies(results)) {
+        std::printf("%-55s %7zu %5zu %9lld %9lld %9lld %9lld", m.method.c_str(), m.count, m.failures,
+                    static_cast<long long>(m.p50_us), static_cast<long long>(m.p95_us), static_cast<long long>(m.p99_us),
+                    static_cast<long long>(m.max_us));
+        if (AllocStats::compiled) {
+            auto it = allocs.find(m.method);
+            double calls = it == allocs.end() ? 0 : static_cast<double>(it->second.calls);
+            std::printf(" %11.1f %11.0f", calls ? static_cast<double>(it->second.counters.allocations) / calls : 0.0,
+                        calls ? static_cast<double>(it->second.counters.bytes) / calls : 0.0);
+        }
+        std::printf("\n");
+    }
+    if (AllocStats::compiled)
+        std::printf("peak RSS: %ld KiB\n", AllocStats::peak_rss_kib());
+}
+
+size_t Replayer::print_comparison(const std::vector<ReplayResult> &baseline, const std::vector<ReplayResult> &candidate) {
+    std::map<std::string, MethodLatency> before;
+    for (auto &m : latencies(baseline))
+        before[m.method] = m;
+
+    std::printf("%-55s %7s %19s %19s %19s\n", "method", "calls", "p50(us) a -> b", "p95(us) a -> b", "p99(us) a -> b");
+    for (const auto &m : latencies(candidate)) {
+        MethodLatency a = before.contains(m.method) ? before[m.method] : MethodLatency{};
+        std::printf("%-55s %7zu %9lld -> %-6lld %9lld -> %-6lld %9lld -> %-6lld\n", m.method.c_str(), m.count,
+                    static_cast<long long>(a.p50_us), static_cast<long long>(m.p50_us), static_cast<long long>(a.p95_us),
+                    static_cast<long long>(m.p95_us), static_cast<long long>(a.p99_us), static_cast<long long>(m.p99_us));
+    }
+
+    std::vector<RowMismatch> mismatches = row_mismatches(baseline, candidate);
+    for (const auto &mismatch : mismatches)
+        std::cout << "ROWS #" << mismatch.index << ' ' << mismatch.method << ": " << mismatch.expected << " -> "
+                  << mismatch.actual << '\n';
+    std::cout << mismatches.size() << " calls returned a different number of rows\n";
+    return mismatches.size();
+}
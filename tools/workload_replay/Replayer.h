@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <cppconn/connection.h>
+
+#include "../../src/workload/WorkloadLog.h"
+
+/**
+ * @brief The outcome of one replayed call.
+ */
+struct ReplayResult {
+    /**
+     * @brief Position of the call in the capture, which identifies it across runs.
+     */
+    size_t index = 0;
+
+    std::string method;
+    int64_t latency_us = 0;
+
+    /**
+     * @brief ServiceDispatcher::call's result size, -1 if the call failed.
+     */
+    int64_t rows = -1;
+};
+
+/**
+ * @brief Latency distribution of one method in one run.
+ */
+struct MethodLatency {
+    std::string method;
+    size_t count = 0;
+    size_t failures = 0;
+    int64_t p50_us = 0;
+    int64_t p95_us = 0;
+    int64_t p99_us = 0;
+    int64_t max_us = 0;
+};
+
+/**
+ * @brief A call that returned a different number of rows in two runs.
+ */
+struct RowMismatch {
+    size_t index = 0;
+    std::string method;
+    int64_t expected = 0;
+    int64_t actual = 0;
+};
+
+/**
+ * @brief Replays a capture with one thread and one connection per captured session.
+ *
+ * Calls of a session are issued one after another, as they were captured. With a speed of 1
+ * every call waits until its captured time, with a speed of N until its captured time divided
+ * by N; speed 0 issues calls as fast as the sessions can.
+ */
+class Replayer {
+public:
+    /**
+     * @param connect Opens a new connection; called once per session, or nullptr on failure.
+     */
+    explicit Replayer(std::function<std::shared_ptr<sql::Connection>()> connect);
+
+    /**
+     * @brief Replays every call.
+     * @param calls The capture, as read by read_workload().
+     * @param speed Time scale; 0 means as fast as possible.
+     * @return One result per call ordered by index, or std::nullopt if a session could not connect.
+     */
+    std::optional<std::vector<ReplayResult>> replay(const std::vector<WorkloadCall> &calls, double speed);
+
+    /**
+     * @brief Writes results as TSV lines: index, method, latency in microseconds, rows.
+     * @return True on success, false if the file could not be written.
+     */
+    static bool write_results(const std::string &path, const std::vector<ReplayResult> &results);
+
+    /**
+     * @brief Reads results written by write_results().
+     * @return The results, or std::nullopt if the file could not be read.
+     */
+    static std::optional<std::vector<ReplayResult>> read_results(const std::string &path);
+
+    /**
+     * @brief Per-method latency percentiles, slowest p95 first.
+     */
+    static std::vector<MethodLatency> latencies(const std::vector<ReplayResult> &results);
+
+    /**
+     * @brief Calls present in both runs whose row counts differ, by index.
+     */
+    static std::vector<RowMismatch> row_mismatches(const std::vector<ReplayResult> &expected,
+                                                   const std::vector<ReplayResult> &actual);
+
+    /**
+     * @brief Prints latencies() of one run.
+     */
+    static void print_latencies(const std::vector<ReplayResult> &results);
+
+    /**
+     * @brief Prints the latencies of two runs side by side and the row-count mismatches.
+     * @return Number of row-count mismatches.
+     */
+    static size_t print_comparison(const std::vector<ReplayResult> &baseline, const std::vector<ReplayResult> &candidate);
+
+private:
+    std::function<std::shared_ptr<sql::Connection>()> connect;
+};
@@ -0,0 +1,223 @@
+#include <cppconn/exception.h>
+#include <functional>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "../../src/utils.h"
+#include "ServiceDispatcher.h"
+
+namespace {
+
+/**
+ * @brief Typed access to captured arguments; a mismatch throws std::bad_variant_access or std::out_of_range.
+ */
+class Args {
+public:
+    explicit Args(const std::vector<WorkloadValue> &values) : values(values) {}
+
+    int integer(size_t n) const {
+        return static_cast<int>(std::get<int64_t>(values.at(n)));
+    }
+
+    double real(size_t n) const {
+        const WorkloadValue &value = values.at(n);
+        if (const int64_t *number = std::get_if<int64_t>(&value))
+            return static_cast<double>(*number);
+        return std::get<double>(value);
+    }
+
+    const std::string &text(size_t n) const {
+        return std::get<std::string>(values.at(n));
+    }
+
+    std::vector<int> ids(size_t n) const {
+        const auto &numbers = std::get<std::vector<int64_t>>(values.at(n));
+        return std::vector<int>(numbers.begin(), numbers.end());
+    }
+
+    const std::vector<std::pair<std::string, std::string>> &pairs(size_t n) const {
+        return std::get<std::vector<std::pair<std::string, std::string>>>(values.at(n));
+    }
+
+    std::map<std::string, std::string> updates(size_t n) const {
+        const auto &entries = pairs(n);
+        return std::map<std::string, std::string>(entries.begin(), entries.end());
+    }
+
+    std::set<std::string> names(size_t n) const {
+        const auto &texts = std::get<std::vector<std::string>>(values.at(n));
+        return std::set<std::string>(texts.begin(), texts.end());
+    }
+
+private:
+    const std::vector<WorkloadValue> &values;
+};
+
+int64_t result_size(const std::unique_ptr<DbResult> &res) {
+    return res ? static_cast<int64_t>(res->rows_count()) : -1;
+}
+
+int64_t result_size(const std::shared_ptr<const QueryResult> &result) {
+    return result ? static_cast<int64_t>(result->rows_count()) : -1;
+}
+
+int64_t result_size(bool ok) {
+    return ok ? 1 : 0;
+}
+
+int64_t result_size(int count) {
+    return count;
+}
+
+int64_t result_size(const std::optional<ResultSubmission> &submission) {
+    return submission ? submission->linked_activities : -1;
+}
+
+int64_t result_size(const std::optional<std::vector<ScheduleConflict>> &conflicts) {
+    return conflicts ? static_cast<int64_t>(conflicts->size()) : -1;
+}
+
+int64_t result_size(const std::vector<std::vector<int>> &ids) {
+    int64_t total = 0;
+    for (const auto &group : ids)
+        total += static_cast<int64_t>(group.size());
+    return total;
+}
+
+using Handler = std::function<int64_t(ServiceDispatcher &, const Args &)>;
+
+#define SERVICE(name, table, ...)                                                                                       \
+    {                                                                                                                  \
+        name, [](ServiceDispatcher &d, [[maybe_unused]] const Args &a) { return result_size(d.table.__VA_ARGS__); }     \
+    }
+
+const std::map<std::string, Handler> &handlers() {
+    static const std::map<std::string, Handler> table = {
+        SERVICE("ActivityTable::create_activity", activity_table, create_activity(a.integer(0), a.text(1), a.text(2), a.text(3))),
+        SERVICE("ActivityTable::read_activity_by_club_id", activity_table, read_activity_by_club_id(a.integer(0))),
+        SERVICE("ActivityTable::read_activity_by_title", activity_table, read_activity_by_title(a.text(0), a.integer(1))),
+        SERVICE("ActivityTable::read_activity_by_period", activity_table,
+                read_activity_by_period(a.text(0), a.text(1), a.integer(2))),
+        SERVICE("ActivityTable::read_activity_ids_by_periods", activity_table,
+                read_activity_ids_by_periods(a.pairs(0), a.integer(1))),
+        SERVICE("ActivityTable::read_activity_by_id", activity_table, read_activity_by_id(a.integer(0))),
+        SERVICE("ActivityTable::update_activity", activity_table, update_activity(a.integer(0), a.updates(1))),
+        SERVICE("ActivityTable::delete_activity", activity_table, delete_activity(a.integer(0))),
+
+        SERVICE("ClubStudentTable::create_club_student", club_student_table, create_club_student(a.integer(0), a.integer(1))),
+        SERVICE("ClubStudentTable::read_by_student_id", club_student_table, read_by_student_id(a.integer(0))),
+        SERVICE("ClubStudentTable::read_by_club_id", club_student_table, read_by_club_id(a.integer(0))),
+        SERVICE("ClubStudentTable::delete_club_student", club_student_table, delete_club_student(a.integer(0), a.integer(1))),
+
+        SERVICE("ClubTable::create_club", club_table, create_club(a.text(0), a.real(1), a.integer(2))),
+        SERVICE("ClubTable::read_club_by_id", club_table, read_club_by_id(a.integer(0))),
+        SERVICE("ClubTable::read_club_by_name", club_table, read_club_by_name(a.text(0))),
+        SERVICE("ClubTable::read_club_by_location_id", club_table, read_club_by_location_id(a.integer(0))),
+        SERVICE("ClubTable::read_club_by_location_name", club_table, read_club_by_location_name(a.text(0))),
+        SERVICE("ClubTable::read_club_by_prof_id", club_table, read_club_by_prof_id(a.integer(0))),
+        SERVICE("ClubTable::read_info", club_table, read_info(a.integer(0), a.names(1))),
+        SERVICE("ClubTable::read_members_by_club_id", club_table, read_members_by_club_id(a.integer(0))),
+        SERVICE("ClubTable::read_members_by_name_in_club", club_table, read_members_by_name_in_club(a.integer(0), a.text(1))),
+        SERVICE("ClubTable::update_club_name", club_table, update_club_name(a.integer(0), a.text(1))),
+        SERVICE("ClubTable::update_club_budget", club_table, update_club_budget(a.integer(0), a.real(1))),
+        SERVICE("ClubTable::adjust_budget", club_table, adjust_budget(a.integer(0), a.real(1))),
+        SERVICE("ClubTable::read_effective_budget", club_table, read_effective_budget(a.integer(0))),
+        SERVICE("ClubTable::update_club_prof_id", club_table, update_club_prof_id(a.integer(0), a.integer(1))),
+        SERVICE("ClubTable::add_member", club_table, add_member(a.integer(0), a.integer(1))),
+        SERVICE("ClubTable::delete_member", club_table, delete_member(a.integer(0), a.integer(1))),
+        SERVICE("ClubTable::add_members_by_department", club_table, add_members_by_department(a.integer(0), a.text(1))),
+        SERVICE("ClubTable::delete_members_by_department", club_table, delete_members_by_department(a.integer(0), a.text(1))),
+        SERVICE("ClubTable::sync_members", club_table, sync_members(a.integer(0), a.ids(1))),
+        SERVICE("ClubTable::delete_club", club_table, delete_club(a.integer(0))),
+        SERVICE("ClubTable::read_all_club", club_table, read_all_club()),
+        SERVICE("ClubTable::read_club_counts", club_table, read_club_counts(a.integer(0))),
+        SERVICE("ClubTable::read_largest_clubs", club_table, read_largest_clubs(a.integer(0))),
+        SERVICE("ClubTable::read_yearly_activity", club_table, read_yearly_activity(a.integer(0))),
+        SERVICE("ClubTable::create_activity_for_club", club_table,
+                create_activity_for_club(a.integer(0), a.text(1), a.text(2), a.text(3))),
+        SERVICE("ClubTable::read_activities_by_club", club_table, read_activities_by_club(a.integer(0))),
+        SERVICE("ClubTable::read_activity_by_id", club_table, read_activity_by_id(a.integer(0), a.integer(1))),
+        SERVICE("ClubTable::update_activity_for_club", club_table,
+                update_activity_for_club(a.integer(0), a.integer(1), a.updates(2))),
+        SERVICE("ClubTable::delete_activity_for_club", club_table, delete_activity_for_club(a.integer(0), a.integer(1))),
+        SERVICE("ClubTable::validate_activity_belongs_to_club", club_table,
+                validate_activity_belongs_to_club(a.integer(0), a.integer(1))),
+        SERVICE("ClubTable::read_activity_by_title", club_table, read_activity_by_title(a.integer(0), a.text(1))),
+        SERVICE("ClubTable::read_activity_by_period", club_table, read_activity_by_period(a.integer(0), a.text(1), a.text(2))),
+
+        SERVICE("GatheringStudentTable::create_gathering_student", gathering_student_table,
+                create_gathering_student(a.integer(0), a.integer(1))),
+        SERVICE("GatheringStudentTable::read_all_gathering_students", gathering_student_table, read_all_gathering_students()),
+        SERVICE("GatheringStudentTable::delete_gathering_student", gathering_student_table,
+                delete_gathering_student(a.integer(0), a.integer(1))),
+
+        SERVICE("GatheringTable::create_gathering", gathering_table, create_gathering(a.integer(0), a.text(1))),
+        SERVICE("GatheringTable::read_gathering_by_act_id", gathering_table, read_gathering_by_act_id(a.integer(0))),
+        SERVICE("GatheringTable::read_gathering_by_name", gathering_table, read_gathering_by_name(a.text(0))),
+        SERVICE("GatheringTable::update_gathering_name", gathering_table, update_gathering_name(a.integer(0), a.text(1))),
+        SERVICE("GatheringTable::delete_gathering", gathering_table, delete_gathering(a.integer(0))),
+        SERVICE("GatheringTable::add_student_to_gathering", gathering_table, add_student_to_gathering(a.integer(0), a.integer(1))),
+        SERVICE("GatheringTable::add_all_club_members", gathering_table, add_all_club_members(a.integer(0))),
+        SERVICE("GatheringTable::delete_non_members", gathering_table, delete_non_members(a.integer(0))),
+        SERVICE("GatheringTable::read_all_students_from_gathering", gathering_table,
+                read_all_students_from_gathering(a.integer(0))),
+        SERVICE("GatheringTable::delete_student_from_gathering", gathering_table,
+                delete_student_from_gathering(a.integer(0), a.integer(1))),
+        SERVICE("GatheringTable::find_conflicts", gathering_table, find_conflicts(a.integer(0))),
+        SERVICE("GatheringTable::find_all_conflicts", gathering_table, find_all_conflicts(static_cast<unsigned>(a.integer(0)))),
+
+        SERVICE("ProfessorTable::create_professor", professor_table, create_professor(a.text(0))),
+        SERVICE("ProfessorTable::read_professor_by_id", professor_table, read_professor_by_id(a.integer(0))),
+        SERVICE("ProfessorTable::read_professor_by_club_id", professor_table, read_professor_by_club_id(a.integer(0))),
+        SERVICE("ProfessorTable::update_professor_name", professor_table, update_professor_name(a.integer(0), a.text(1))),
+        SERVICE("ProfessorTable::delete_professor", professor_table, delete_professor(a.integer(0))),
+        SERVICE("ProfessorTable::read_all_professor", professor_table, read_all_professor()),
+
+        SERVICE("ResultTable::submit_result", result_table, submit_result(a.integer(0), a.integer(1))),
+        SERVICE("ResultTable::read_results_by_club", result_table, read_results_by_club(a.integer(0))),
+        SERVICE("ResultTable::read_result_activities", result_table, read_result_activities(a.integer(0))),
+        SERVICE("ResultTable::read_year_summary", result_table, read_year_summary(a.integer(0), a.integer(1))),
+        SERVICE("ResultTable::delete_result", result_table, delete_result(a.integer(0))),
+
+        SERVICE("StudentTable::create_student", student_table, create_student(a.text(0), a.text(1))),
+        SERVICE("StudentTable::read_student_by_field", student_table, read_student_by_field(a.text(0), a.text(1))),
+        SERVICE("StudentTable::read_all_student", student_table, read_all_student()),
+        SERVICE("StudentTable::update_student_name", student_table, update_student_name(a.integer(0), a.text(1))),
+        SERVICE("StudentTable::delete_student_by_id", student_table, delete_student_by_id(a.integer(0))),
+    };
+    return table;
+}
+
+#undef SERVICE
+
+} // namespace
+
+ServiceDispatcher::ServiceDispatcher(std::shared_ptr<DbConnection> conn)
+    : student_table(conn), club_table(conn), club_student_table(conn), professor_table(conn), gathering_table(conn),
+      gathering_student_table(conn), activity_table(conn), result_table(conn) {}
+
+bool ServiceDispatcher::knows(const std::string &method) {
+    return handlers().contains(method);
+}
+
+std::optional<int64_t> ServiceDispatcher::call(const WorkloadCall &call) {
+    auto handler = handlers().find(call.method);
+    if (handler == handlers().end()) {
+        Logger(ll_warning, "Cannot replay unknown method " + call.method).log();
+        return std::nullopt;
+    }
+    try {
+        return handler->second(*this, Args(call.args));
+    } catch (sql::SQLException &e) {
+        Logger(ll_error, call.method + ": " + std::string(e.what())).log();
+    } catch (std::bad_variant_access &) {
+        Logger(ll_error, call.method + ": captured arguments do not match the method").log();
+    } catch (std::out_of_range &) {
+        Logger(ll_error, call.method + ": captured arguments do not match the method").log();
+    }
+    return std::nullopt;
+}
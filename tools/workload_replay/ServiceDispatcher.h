@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <cppconn/connection.h>
+
+#include "../../src/service/ActivityTable.h"
+#include "../../src/service/ClubStudentTable.h"
+#include "../../src/service/ClubTable.h"
+#include "../../src/service/GatheringStudentTable.h"
+#include "../../src/service/GatheringTable.h"
+#include "../../src/service/ProfessorTable.h"
+#include "../../src/service/ResultTable.h"
+#include "../../src/service/StudentTable.h"
+#include "../../src/workload/WorkloadLog.h"
+
+/**
+ * @brief Re-issues captured calls against the service tables of one connection.
+ *
+ * Each replay session owns one dispatcher, as each thread of sev owned its tables.
+ * The tables run without the optional SEV_* features, so a replay measures the plain
+ * service layer against whatever schema and indexes the target database has.
+ */
+class ServiceDispatcher {
+public:
+    explicit ServiceDispatcher(std::shared_ptr<DbConnection> conn);
+
+    /**
+     * @brief Whether a method name is one the dispatcher can replay.
+     */
+    static bool knows(const std::string &method);
+
+    /**
+     * @brief Calls the captured method with the captured arguments.
+     * @return The size of the result: rows of a result set, the number of IDs or conflicts
+     * returned, the count returned by bulk writes, or 1/0 for methods returning success.
+     * std::nullopt if the method is unknown, the arguments do not match or the call threw.
+     */
+    std::optional<int64_t> call(const WorkloadCall &call);
+
+    StudentTable student_table;
+    ClubTable club_table;
+    ClubStudentTable club_student_table;
+    ProfessorTable professor_table;
+    GatheringTable gathering_table;
+    GatheringStudentTable gathering_student_table;
+    ActivityTable activity_table;
+    ResultTable result_table;
+};
@@ -0,0 +1,104 @@
+#include <cppconn/driver.h>
+#include <cppconn/exception.h>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../../src/utils.h"
+#include "Replayer.h"
+#include "ServiceDispatcher.h"
+
+static void usage() {
+    std::cout << "usage: workload_replay <capture> [options]\n"
+                 "       workload_replay --compare <baseline.tsv> <candidate.tsv>\n"
+                 "  --speed <n>       replay at n times the captured pace (default 1)\n"
+                 "  --max             replay as fast as possible, keeping the captured sessions\n"
+                 "  --out <file>      write index, method, latency and rows of every call as TSV\n"
+                 "  --compare a b     compare latency percentiles and row counts of two --out files;\n"
+                 "                    exit status 1 if any call returned a different number of rows\n"
+                 "Connects with MYSQL_SERVER, MYSQL_USER, MYSQL_PASSWORD and MYSQL_DATABASE like sev, one\n"
+                 "connection per captured session. Writes are replayed too: restore the database between runs\n"
+                 "that should be compared.\n";
+}
+
+static std::shared_ptr<sql::Connection> connect_mysql() {
+    sql::Driver *driver = get_driver_instance();
+
+    const char *server = std::getenv("MYSQL_SERVER");
+    const char *user = std::getenv("MYSQL_USER");
+    const char *password = std::getenv("MYSQL_PASSWORD");
+    const char *database = std::getenv("MYSQL_DATABASE");
+    if (!server || !user || !password || !database) {
+        Logger(ll_critical, "MYSQL_SERVER, MYSQL_USER, MYSQL_PASSWORD and MYSQL_DATABASE must be set").log();
+        return nullptr;
+    }
+
+    try {
+        std::shared_ptr<sql::Connection> con(driver->connect(std::string("tcp://") + server, user, password));
+        con->setSchema(database);
+        return con;
+    } catch (sql::SQLException &e) {
+        Logger(ll_critical, std::string(e.what())).log();
+        return nullptr;
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string capture;
+    std::string out;
+    std::string baseline, candidate;
+    double speed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--speed" && has_value && std::atof(argv[i + 1]) > 0) {
+            speed = std::atof(argv[++i]);
+        } else if (arg == "--max") {
+            speed = 0;
+        } else if (arg == "--out" && has_value) {
+            out = argv[++i];
+        } else if (arg == "--compare" && i + 2 < argc) {
+            baseline = argv[++i];
+            candidate = argv[++i];
+        } else if (arg.rfind("--", 0) != 0 && capture.empty()) {
+            capture = arg;
+        } else {
+            usage();
+            return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    if (!baseline.empty()) {
+        auto a = Replayer::read_results(baseline);
+        auto b = Replayer::read_results(candidate);
+        if (!a || !b)
+            return EXIT_FAILURE;
+        return Replayer::print_comparison(*a, *b) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (capture.empty()) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    auto calls = read_workload(capture);
+    if (!calls)
+        return EXIT_FAILURE;
+    size_t unknown = 0;
+    for (const auto &call : *calls)
+        unknown += ServiceDispatcher::knows(call.method) ? 0 : 1;
+    if (unknown > 0)
+        Logger(ll_warning, std::to_string(unknown) + " captured calls name methods this build cannot replay").log();
+
+    Replayer replayer(connect_mysql);
+    auto results = replayer.replay(*calls, speed);
+    if (!results)
+        return EXIT_FAILURE;
+
+    Replayer::print_latencies(*results);
+    if (!out.empty() && !Replayer::write_results(out, *results))
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}